@@ -1,10 +1,20 @@
 #version 420 core
 
 // Output to the G-buffer textures
-// layout (location = 0) out vec3 gPosition;
-layout (location = 0) out vec4 gPosition;
-layout (location = 1) out vec3 gNormal;
-layout (location = 2) out vec4 gAlbedoSpec;
+// With the standard layout:
+//      0 - position, and depth in the alpha channel
+//      1 - normal
+//      2 - albedo and specular
+// With the compact layout:
+//      0 - normal, with the octahedral encoding
+//      1 - albedo and specular
+// (the position is reconstructed from the depth buffer)
+// In both layouts, the motion vector is written to the location 3, which is
+// only used with the temporal upscaling
+layout (location = 0) out vec4 gBuffer0;
+layout (location = 1) out vec4 gBuffer1;
+layout (location = 2) out vec4 gBuffer2;
+layout (location = 3) out vec2 gVelocity;
 
 struct Material
 {
@@ -16,21 +26,47 @@ in VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
+    vec4 CurrentClipPos;
+    vec4 PreviousClipPos;
 } fs_in;
 
 uniform Material material;
 
+// Layout of the G-buffer, configured by the renderer
+uniform bool compactGBuffer = false;
+
+// Octahedral encoding of a unit vector in the [0,1] range
+vec2 encodeNormal(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if (n.z < 0.)
+        n.xy = (1. - abs(n.yx)) * vec2(n.x >= 0. ? 1. : -1., n.y >= 0. ? 1. : -1.);
+    return n.xy * 0.5 + 0.5;
+}
+
 void main()
 {
-    // Position of the fragment in world space
-    // gPosition = fs_in.FragPos;
-    // Output also the z value in the alpha channel of the texture
-    // gPosition = vec4(fs_in.FragPos, gl_FragCoord.z);
-    gPosition = vec4(fs_in.FragPos, gl_FragCoord.z / gl_FragCoord.w);
     // Normal of the fragment
-    gNormal = normalize(fs_in.Normal);
-    // Color of the fragment
-    gAlbedoSpec.rgb = material.albedo;
-    // Specular intensity of the fragment
-    gAlbedoSpec.a = material.spec;
+    vec3 normal = normalize(fs_in.Normal);
+    // Color of the fragment, and specular intensity
+    vec4 albedoSpec = vec4(material.albedo, material.spec);
+
+    if (compactGBuffer)
+    {
+        gBuffer0 = vec4(encodeNormal(normal), 0., 0.);
+        gBuffer1 = albedoSpec;
+    }
+    else
+    {
+        // Position of the fragment in world space
+        // Output also the z value in the alpha channel of the texture
+        gBuffer0 = vec4(fs_in.FragPos, gl_FragCoord.z / gl_FragCoord.w);
+        gBuffer1 = vec4(normal, 0.);
+        gBuffer2 = albedoSpec;
+    }
+
+    // Displacement of the fragment on the screen since the previous frame, in
+    // texture coordinates
+    gVelocity = 0.5 * (fs_in.CurrentClipPos.xy / fs_in.CurrentClipPos.w 
+                       - fs_in.PreviousClipPos.xy / fs_in.PreviousClipPos.w);
 }
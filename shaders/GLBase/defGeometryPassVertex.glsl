@@ -8,12 +8,26 @@ out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
+    // Positions in clip space without the jitter, for the motion vectors
+    vec4 CurrentClipPos;
+    vec4 PreviousClipPos;
 } vs_out;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Matrices of the camera without the jitter in this and the previous frame,
+// updated by the renderer
+layout (std140, binding = 1) uniform TemporalMatrices
+{
+    mat4 currentViewProjection;
+    mat4 previousViewProjection;
+};
+// Model matrix of the previous frame, for the objects that move
+uniform bool hasPreviousModel = false;
+uniform mat4 previousModel;
+
 void main()
 {
     vs_out.FragPos = vec3(model * vec4(aPos, 1.));
@@ -21,4 +35,8 @@ void main()
     vs_out.TexCoords = aTexCoords;
 
     gl_Position = projection * view * vec4(vs_out.FragPos, 1.);
+
+    vs_out.CurrentClipPos = currentViewProjection * vec4(vs_out.FragPos, 1.);
+    mat4 lastModel = hasPreviousModel ? previousModel : model;
+    vs_out.PreviousClipPos = previousViewProjection * lastModel * vec4(aPos, 1.);
 }
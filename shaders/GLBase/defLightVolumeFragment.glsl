@@ -0,0 +1,324 @@
+#version 420 core
+
+// Shader used to compute the contribution of a point or spot light to the
+// pixels covered by its volume. The results are added to the target with
+// additive blending.
+
+layout (location = 0) out vec4 FragColor;
+
+// Uniforms with the information from the Geometry pass
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+
+// Layout of the G-buffer. With the compact layout, gPosition is the depth
+// buffer, and the position is reconstructed with the inverse of the
+// view-projection matrix
+uniform bool compactGBuffer = false;
+uniform mat4 invViewProjection;
+
+// Fraction of the G-buffer textures covered by the render resolution, when it
+// is lower than the size they were allocated with
+uniform vec2 gBufferScale = vec2(1., 1.);
+
+// Decode a normal stored with the octahedral encoding
+vec3 decodeNormal(vec2 f)
+{
+    f = f * 2. - 1.;
+    vec3 n = vec3(f.x, f.y, 1. - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0., 1.);
+    n.xy += vec2(n.x >= 0. ? -t : t, n.y >= 0. ? -t : t);
+    return normalize(n);
+}
+
+// Read the data of the G-buffer at some coordinates in the [0,1] range of the
+// rendered area. The depth is the one written by the geometry pass of the
+// standard layout
+void readGBuffer(vec2 screenCoords, out vec3 fragPos, out float depth, out vec3 normal,
+                 out vec3 albedo, out float specular)
+{
+    vec2 texCoords = screenCoords * gBufferScale;
+    vec4 albedoSpec = texture(gAlbedoSpec, texCoords);
+    albedo = albedoSpec.rgb;
+    specular = albedoSpec.a;
+    if (compactGBuffer)
+    {
+        float windowDepth = texture(gPosition, texCoords).r;
+        vec4 position = invViewProjection * vec4(vec3(screenCoords, windowDepth) * 2. - 1., 1.);
+        fragPos = position.xyz / position.w;
+        // The w of the position in clip space is 1 / position.w
+        depth = windowDepth / position.w;
+        normal = decodeNormal(texture(gNormal, texCoords).rg);
+    }
+    else
+    {
+        vec4 positionDepth = texture(gPosition, texCoords);
+        fragPos = positionDepth.rgb;
+        depth = positionDepth.a;
+        normal = normalize(texture(gNormal, texCoords).rgb);
+    }
+}
+
+// Size of the rendered area, to get the coordinates of the fragment
+uniform vec2 screenSize;
+
+// View position
+uniform vec3 viewPos;
+
+// True when drawing the spheres of the point lights
+uniform bool pointLightVolumes;
+
+struct SpotLight
+{
+    vec3 color;
+    vec3 position;
+    vec3 direction;
+
+    float intensity;
+    float kLinear;
+    float kQuadratic;
+
+    float cosAngleInner;
+    float cosAngleOuter;
+    float radiusMax;
+
+    mat4 lightSpaceMatrix;
+    // Tile of the shadow map in the atlas, with the offset in xy and the size
+    // in zw, in texture coordinates. The size is 0 if the light has no shadow
+    vec4 atlasRect;
+    // Filter of the shadow map
+    int shadowFilter;
+};
+
+// Spot light drawn, when not drawing point lights, and atlas with the shadow
+// maps of the spot lights, the same atlas with a comparison sampler, and its
+// moments
+uniform SpotLight spotLight;
+uniform sampler2D spotShadowAtlas;
+uniform sampler2DShadow spotShadowAtlasCompare;
+uniform sampler2D spotShadowMoments;
+
+// Properties of the point light of this instance
+flat in vec4 LightPositionRadius;
+flat in vec3 LightColor;
+flat in vec3 LightAttenuation;
+// Slot of the shadow map of the point light, or -1 if it has no shadow
+flat in int LightShadowSlot;
+
+// Filters of the shadow maps, as in the ShadowFilter enum
+const int SHADOW_FILTER_PCF = 0;
+const int SHADOW_FILTER_HARDWARE_PCF = 1;
+const int SHADOW_FILTER_ESM = 2;
+const int SHADOW_FILTER_VSM = 3;
+
+// Exponent of the exponential shadow maps, as in shadowMomentsFragment.glsl
+const float ESM_EXPONENT = 80.;
+
+// Function to compute the shadow from the filtered moments of an exponential
+// or variance shadow map
+float shadowFromMoments(vec2 moments, float currentDepth, int shadowFilter)
+{
+    if (shadowFilter == SHADOW_FILTER_ESM)
+        return 1. - clamp(moments.x * exp(-ESM_EXPONENT * currentDepth), 0., 1.);
+
+    // Upper bound of the fraction of light given by the Chebyshev inequality,
+    // with its lowest values cut to reduce the light bleeding
+    if (currentDepth <= moments.x)
+        return 0.;
+    float variance = max(moments.y - moments.x * moments.x, 0.00002);
+    float distance = currentDepth - moments.x;
+    float pMax = variance / (variance + distance * distance);
+    return 1. - clamp((pMax - 0.2) / 0.8, 0., 1.);
+}
+
+float shadowComputationSpotLight(vec3 fragPos, vec3 normal)
+{
+    // Lights without a tile in the atlas have no shadow in this frame
+    if (spotLight.atlasRect.z <= 0.)
+        return 0.;
+
+    // Position of the fragment in light space
+    vec4 fragPosLightSpace = spotLight.lightSpaceMatrix * vec4(fragPos, 1.);
+    // Perform perspective divide, and transform to the [0,1] range
+    vec3 projCoordsLightSpace = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoordsLightSpace = projCoordsLightSpace * 0.5 + 0.5;
+    // The fragments outside of the frustum of the light are not in its tile
+    if (fragPosLightSpace.w <= 0. || any(lessThan(projCoordsLightSpace.xy, vec2(0.)))
+        || any(greaterThan(projCoordsLightSpace.xy, vec2(1.))))
+        return 0.;
+
+    // Get the distance from the current fragment to the light
+    float currentDepth = length(fragPos - spotLight.position) / spotLight.radiusMax;
+
+    // Calculate the bias based on the slope
+    float bias = max(0.025 * (1.0 + dot(normal, spotLight.direction)), 0.0025);
+
+    // PCF over the 9 surrounding pixels of the shadow map, clamped to the tile
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / vec2(textureSize(spotShadowAtlas, 0));
+    vec2 atlasCoords = spotLight.atlasRect.xy + projCoordsLightSpace.xy * spotLight.atlasRect.zw;
+    vec2 tileMin = spotLight.atlasRect.xy + 0.5 * texelSize;
+    vec2 tileMax = spotLight.atlasRect.xy + spotLight.atlasRect.zw - 0.5 * texelSize;
+    // The hardware PCF compares the 2x2 closest texels in a single fetch
+    if (spotLight.shadowFilter == SHADOW_FILTER_HARDWARE_PCF)
+        return 1. - texture(spotShadowAtlasCompare, vec3(clamp(atlasCoords, tileMin, tileMax), currentDepth - bias));
+    // The moments have half of the resolution of the atlas
+    if (spotLight.shadowFilter == SHADOW_FILTER_ESM || spotLight.shadowFilter == SHADOW_FILTER_VSM)
+    {
+        vec2 coords = clamp(atlasCoords, spotLight.atlasRect.xy + texelSize,
+                            spotLight.atlasRect.xy + spotLight.atlasRect.zw - texelSize);
+        return shadowFromMoments(texture(spotShadowMoments, coords).rg, currentDepth - bias, spotLight.shadowFilter);
+    }
+    for(int x = -1; x <= 1; ++x)
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            vec2 coords = clamp(atlasCoords + vec2(x, y) * texelSize, tileMin, tileMax);
+            float pcfDepth = texture(spotShadowAtlas, coords).r;
+            shadow += (currentDepth - bias) > pcfDepth ? 1.0 : 0.0;
+        }
+    }
+    shadow /= 9.0;
+
+    return shadow;
+}
+
+// Shadow maps of the point lights, with the six faces of each one in
+// consecutive layers, in the order +X, -X, +Y, -Y, +Z, -Z
+uniform sampler2DArray pointShadowMaps;
+
+// Directions and up vectors of the faces of the shadow maps of the point
+// lights, as in PointLight::computeShadowMap
+const vec3 pointShadowFaceDirections[6] = vec3[](vec3(1., 0., 0.), vec3(-1., 0., 0.), vec3(0., 1., 0.),
+                                                 vec3(0., -1., 0.), vec3(0., 0., 1.), vec3(0., 0., -1.));
+const vec3 pointShadowFaceUps[6] = vec3[](vec3(0., -1., 0.), vec3(0., -1., 0.), vec3(0., 0., 1.),
+                                          vec3(0., 0., -1.), vec3(0., -1., 0.), vec3(0., -1., 0.));
+
+// Function to compute the shadow of a point light, whose shadow map is in the
+// layers starting at 6 * shadowSlot of the array
+float shadowComputationPointLight(vec3 fragPos, vec3 normal, vec3 lightPos, float farPlane, int shadowSlot)
+{
+    // Size of a texel of the shadow map at the distance of the fragment. The
+    // position is moved along the normal by a few texels, so the surface does
+    // not shadow itself at grazing angles
+    vec3 lightToFrag = fragPos - lightPos;
+    vec3 absLightToFrag = abs(lightToFrag);
+    float texelSize = 1.0 / float(textureSize(pointShadowMaps, 0).x);
+    float texelWorldSize = 2. * texelSize * max(absLightToFrag.x, max(absLightToFrag.y, absLightToFrag.z));
+    lightToFrag += normal * 2. * texelWorldSize;
+
+    // Face of the cube with the direction from the light to the fragment
+    absLightToFrag = abs(lightToFrag);
+    int face;
+    if (absLightToFrag.x >= absLightToFrag.y && absLightToFrag.x >= absLightToFrag.z)
+        face = lightToFrag.x > 0. ? 0 : 1;
+    else if (absLightToFrag.y >= absLightToFrag.z)
+        face = lightToFrag.y > 0. ? 2 : 3;
+    else
+        face = lightToFrag.z > 0. ? 4 : 5;
+
+    // Coordinates in the face, with the same basis as the view matrix of the
+    // face, and the field of view of 90 degrees
+    vec3 forward = pointShadowFaceDirections[face];
+    vec3 side = cross(forward, pointShadowFaceUps[face]);
+    vec3 up = cross(side, forward);
+    float distanceForward = dot(lightToFrag, forward);
+    vec2 faceCoords = vec2(dot(lightToFrag, side), dot(lightToFrag, up)) / distanceForward * 0.5 + 0.5;
+    float layer = float(6 * shadowSlot + face);
+
+    // Linear distance to the light, in the range [0,1] as in the shadow map,
+    // with a bias of one texel
+    float currentDepth = length(lightToFrag) / farPlane;
+    float bias = texelWorldSize / farPlane;
+
+    // PCF over the 9 surrounding pixels of the shadow map. The coordinates
+    // are clamped to the face in its own layer
+    float shadow = 0.0;
+    for(int x = -1; x <= 1; ++x)
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            float pcfDepth = texture(pointShadowMaps, vec3(faceCoords + vec2(x, y) * texelSize, layer)).r;
+            shadow += (currentDepth - bias) > pcfDepth ? 1.0 : 0.0;
+        }
+    }
+    shadow /= 9.0;
+
+    return shadow;
+}
+
+void main()
+{
+    // Get the data from the g-buffer textures
+    vec2 TexCoords = gl_FragCoord.xy / screenSize;
+    vec3 FragPos;
+    float Depth;
+    vec3 Normal;
+    vec3 Albedo;
+    float Specular;
+    readGBuffer(TexCoords, FragPos, Depth, Normal, Albedo, Specular);
+
+    // Properties of the light
+    vec3 lightPosition;
+    vec3 lightColor;
+    float intensity;
+    float kLinear;
+    float kQuadratic;
+    float radiusMax;
+    if (pointLightVolumes)
+    {
+        lightPosition = LightPositionRadius.xyz;
+        radiusMax = LightPositionRadius.w;
+        lightColor = LightColor;
+        intensity = LightAttenuation.x;
+        kLinear = LightAttenuation.y;
+        kQuadratic = LightAttenuation.z;
+    }
+    else
+    {
+        lightPosition = spotLight.position;
+        radiusMax = spotLight.radiusMax;
+        lightColor = spotLight.color;
+        intensity = spotLight.intensity;
+        kLinear = spotLight.kLinear;
+        kQuadratic = spotLight.kQuadratic;
+    }
+
+    // Attenuation of the light
+    vec3 fragToLight = lightPosition - FragPos;
+    float distance = length(fragToLight);
+    float attenuation = intensity / (1. + kLinear * distance + kQuadratic * distance * distance);
+    // Fade the light to zero at the maximum radius, where its volume ends
+    attenuation *= 1. - smoothstep(0.9 * radiusMax, radiusMax, distance);
+
+    // Diffuse contribution
+    vec3 lightDirection = normalize(fragToLight);
+    vec3 diffuse = max(dot(lightDirection, Normal), 0.) * Albedo;
+
+    // Specular contribution, with the Blinn-Phong model
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 halfwayDir = normalize(lightDirection + viewDir);
+    float specIntensity = Specular * pow(max(dot(Normal, halfwayDir), 0.), 32.);
+    vec3 specular = specIntensity * Albedo;
+
+    if (pointLightVolumes)
+    {
+        // Compute the shadow, if the light has a shadow map in this frame
+        if (LightShadowSlot >= 0)
+            attenuation *= 1. - shadowComputationPointLight(FragPos, Normal, lightPosition, radiusMax,
+                                                            LightShadowSlot);
+    }
+    else
+    {
+        // Smooth transition to zero between the inner and outer angles
+        float cosTheta = -1. * dot(spotLight.direction, lightDirection);
+        attenuation *= clamp( (cosTheta - spotLight.cosAngleOuter) /
+                              (spotLight.cosAngleInner - spotLight.cosAngleOuter),
+                              0., 1.);
+        // Compute the shadow
+        attenuation *= 1. - shadowComputationSpotLight(FragPos, Normal);
+    }
+
+    // The alpha is not modified by the additive blending
+    FragColor = vec4(attenuation * ( diffuse + specular ) * lightColor, 0.);
+}
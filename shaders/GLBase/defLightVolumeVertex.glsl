@@ -0,0 +1,45 @@
+#version 420 core
+
+// Shader used to draw the volumes of the point and spot lights in the lighting
+// pass. Point lights are drawn as instanced spheres, with the properties of
+// each light as instance attributes. Spot lights are drawn one at a time as
+// cones, with their model matrix as a uniform.
+
+layout (location = 0) in vec3 aPos;
+// Instance attributes of the point lights
+layout (location = 4) in vec4 aLightPositionRadius;
+layout (location = 5) in vec3 aLightColor;
+// Intensity, linear and quadratic attenuation
+layout (location = 6) in vec3 aLightAttenuation;
+// Slot of the shadow map, or -1 if the light has no shadow
+layout (location = 7) in float aLightShadowSlot;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// True when drawing the spheres of the point lights
+uniform bool pointLightVolumes;
+// Scale of the sphere mesh so it contains a sphere of radius 1
+uniform float sphereScale;
+// Model matrix of the cone of a spot light
+uniform mat4 model;
+
+flat out vec4 LightPositionRadius;
+flat out vec3 LightColor;
+flat out vec3 LightAttenuation;
+flat out int LightShadowSlot;
+
+void main()
+{
+    vec4 worldPos;
+    if (pointLightVolumes)
+        worldPos = vec4(aLightPositionRadius.xyz + aPos * sphereScale * aLightPositionRadius.w, 1.);
+    else
+        worldPos = model * vec4(aPos, 1.);
+    gl_Position = projection * view * worldPos;
+
+    LightPositionRadius = aLightPositionRadius;
+    LightColor = aLightColor;
+    LightAttenuation = aLightAttenuation;
+    LightShadowSlot = int(aLightShadowSlot);
+}
@@ -10,6 +10,54 @@ uniform sampler2D gPosition;
 uniform sampler2D gNormal;
 uniform sampler2D gAlbedoSpec;
 
+// Layout of the G-buffer. With the compact layout, gPosition is the depth
+// buffer, and the position is reconstructed with the inverse of the
+// view-projection matrix
+uniform bool compactGBuffer = false;
+uniform mat4 invViewProjection;
+
+// Fraction of the G-buffer textures covered by the render resolution, when it
+// is lower than the size they were allocated with
+uniform vec2 gBufferScale = vec2(1., 1.);
+
+// Decode a normal stored with the octahedral encoding
+vec3 decodeNormal(vec2 f)
+{
+    f = f * 2. - 1.;
+    vec3 n = vec3(f.x, f.y, 1. - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0., 1.);
+    n.xy += vec2(n.x >= 0. ? -t : t, n.y >= 0. ? -t : t);
+    return normalize(n);
+}
+
+// Read the data of the G-buffer at some coordinates in the [0,1] range of the
+// rendered area. The depth is the one written by the geometry pass of the
+// standard layout
+void readGBuffer(vec2 screenCoords, out vec3 fragPos, out float depth, out vec3 normal,
+                 out vec3 albedo, out float specular)
+{
+    vec2 texCoords = screenCoords * gBufferScale;
+    vec4 albedoSpec = texture(gAlbedoSpec, texCoords);
+    albedo = albedoSpec.rgb;
+    specular = albedoSpec.a;
+    if (compactGBuffer)
+    {
+        float windowDepth = texture(gPosition, texCoords).r;
+        vec4 position = invViewProjection * vec4(vec3(screenCoords, windowDepth) * 2. - 1., 1.);
+        fragPos = position.xyz / position.w;
+        // The w of the position in clip space is 1 / position.w
+        depth = windowDepth / position.w;
+        normal = decodeNormal(texture(gNormal, texCoords).rg);
+    }
+    else
+    {
+        vec4 positionDepth = texture(gPosition, texCoords);
+        fragPos = positionDepth.rgb;
+        depth = positionDepth.a;
+        normal = normalize(texture(gNormal, texCoords).rgb);
+    }
+}
+
 // Maximum cascade levels for the directional light
 const int NR_MAX_CASCADE_LEVELS = 8;
 
@@ -25,6 +73,11 @@ struct DirectionalLight
 
     mat4 lightSpaceMatrix;
     sampler2DArray shadowMap;
+    // Same shadow map with a comparison sampler, and its moments
+    sampler2DArrayShadow shadowMapCompare;
+    sampler2DArray shadowMoments;
+    // Filter of the shadow map
+    int shadowFilter;
     // int nrCascadeLevels;
     float cascadeDistances[NR_MAX_CASCADE_LEVELS + 1];
 };
@@ -45,10 +98,19 @@ struct SpotLight
     float radiusMax;
 
     mat4 lightSpaceMatrix;
+    // Tile of the shadow map in the atlas, with the offset in xy and the size
+    // in zw, in texture coordinates. The size is 0 if the light has no shadow
+    vec4 atlasRect;
+    // Filter of the shadow map
+    int shadowFilter;
     /* sampler2D shadowMap; */
 };
 
-uniform sampler2D spotShadowMap;
+// Atlas with the shadow maps of the spot lights, the same atlas with a
+// comparison sampler, and its moments
+uniform sampler2D spotShadowAtlas;
+uniform sampler2DShadow spotShadowAtlasCompare;
+uniform sampler2D spotShadowMoments;
 
 struct PointLight
 {
@@ -61,8 +123,9 @@ struct PointLight
 
     float radiusMax;
 
-    // mat4 lightSpaceMatrix;
-    // sampler2D shadowMap;
+    // Slot of the shadow map in the array of the point lights, or -1 if the
+    // light has no shadow in this frame
+    int shadowSlot;
 };
 
 // Maximum number of lights of each type
@@ -94,9 +157,59 @@ uniform int nrPointLights = 0;
 // View position
 uniform vec3 viewPos;
 
+// Clustered lights
+// ------------------------------
+// If true, the point and spot lights are read from the lists of the clusters
+uniform bool clusteredLights = false;
+// Properties of the lights, in four texels each
+uniform samplerBuffer clusterLightData;
+// Light space matrices of the spot lights, in four texels each, followed by
+// the tile of the shadow atlas in a fifth texel, and the filter of the shadow
+// map in the first component of a sixth one
+uniform samplerBuffer clusterSpotMatrices;
+// Offset and count of the lights of each cluster
+uniform usamplerBuffer clusterGrid;
+// Indices of the lights of all the clusters
+uniform usamplerBuffer clusterLightIndices;
+// Size of the grid of clusters
+uniform int clusterTilesX;
+uniform int clusterTilesY;
+uniform int clusterSlicesZ;
+// Parameters of the exponential distribution of the slices in depth
+uniform float clusterNear;
+uniform float clusterSliceScale;
+// View matrix, to get the depth of the fragments
+uniform mat4 view;
+
 // Color of the ambient light, with a default value
 uniform vec3 ambientLightColor = vec3(0.1, 0.1, 0.1);
 
+// Filters of the shadow maps, as in the ShadowFilter enum
+const int SHADOW_FILTER_PCF = 0;
+const int SHADOW_FILTER_HARDWARE_PCF = 1;
+const int SHADOW_FILTER_ESM = 2;
+const int SHADOW_FILTER_VSM = 3;
+
+// Exponent of the exponential shadow maps, as in shadowMomentsFragment.glsl
+const float ESM_EXPONENT = 80.;
+
+// Function to compute the shadow from the filtered moments of an exponential
+// or variance shadow map
+float shadowFromMoments(vec2 moments, float currentDepth, int shadowFilter)
+{
+    if (shadowFilter == SHADOW_FILTER_ESM)
+        return 1. - clamp(moments.x * exp(-ESM_EXPONENT * currentDepth), 0., 1.);
+
+    // Upper bound of the fraction of light given by the Chebyshev inequality,
+    // with its lowest values cut to reduce the light bleeding
+    if (currentDepth <= moments.x)
+        return 0.;
+    float variance = max(moments.y - moments.x * moments.x, 0.00002);
+    float distance = currentDepth - moments.x;
+    float pMax = variance / (variance + distance * distance);
+    return 1. - clamp((pMax - 0.2) / 0.8, 0., 1.);
+}
+
 // Functions to compute the shadow of a directional light with cascaded shadowmaps
 float shadowComputationDirLight(vec3 fragPos, vec3 normal, float depth, DirectionalLight light)
 // float shadowComputationDirLight(vec3 fragPos, vec3 normal, float depth, int index)
@@ -112,15 +225,32 @@ float shadowComputationDirLight(vec3 fragPos, vec3 normal, float depth, Directio
         }
     }
 
+    // Fragments beyond the last cascade have no shadow
+    if (level < 0)
+        return 0.;
+
     // Position of the fragment in light space, with the corresponding light
     // space matrix
-    /* vec4 fragPosLightSpace = lightSpaceMatrices[level] * vec4(fragPos, 1.); */
-    vec4 fragPosLightSpace = lightSpaceMatrices[level] * vec4(fragPos, 1.);
+    // The cascades are not rendered every frame, so the matrix may be from a
+    // previous frame, when the cascade did not cover all of its subfrustum.
+    // The fragments outside of it use the next cascade instead
+    vec3 projCoordsLightSpace;
+    vec2 texelMargin = 2.0 / vec2(textureSize(light.shadowMap, 0));
+    for (; level < nrCascadeLevels; ++level)
+    {
+        vec4 fragPosLightSpace = lightSpaceMatrices[level] * vec4(fragPos, 1.);
+
+        // Perform perspective divide
+        projCoordsLightSpace = fragPosLightSpace.xyz / fragPosLightSpace.w;
+        // Transform to [0,1] range, to use these as the coordinates of the shadow map texture
+        projCoordsLightSpace = projCoordsLightSpace * 0.5 + 0.5;
+        if (all(greaterThanEqual(projCoordsLightSpace.xy, texelMargin))
+            && all(lessThanEqual(projCoordsLightSpace.xy, 1. - texelMargin)))
+            break;
+    }
+    if (level == nrCascadeLevels)
+        return 0.;
 
-    // Perform perspective divide
-    vec3 projCoordsLightSpace = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    // Transform to [0,1] range, to use these as the coordinates of the shadow map texture
-    projCoordsLightSpace = projCoordsLightSpace * 0.5 + 0.5;
     // Get the closest depth value from the light's perspective at these coodinates
     // in the light's view space
     // float closestDepth = texture(light.shadowMap, projCoordsLightSpace.xy).r; 
@@ -140,6 +270,14 @@ float shadowComputationDirLight(vec3 fragPos, vec3 normal, float depth, Directio
         bias *= 1. / (light.cascadeDistances[level + 1] * 0.5f);
     }
 
+    // The hardware PCF compares the 2x2 closest texels in a single fetch
+    if (light.shadowFilter == SHADOW_FILTER_HARDWARE_PCF)
+        return 1. - texture(light.shadowMapCompare, vec4(projCoordsLightSpace.xy, float(level), currentDepth - bias));
+    // The moments are already filtered
+    if (light.shadowFilter == SHADOW_FILTER_ESM || light.shadowFilter == SHADOW_FILTER_VSM)
+        return shadowFromMoments(texture(light.shadowMoments, vec3(projCoordsLightSpace.xy, float(level))).rg,
+                                 currentDepth - bias, light.shadowFilter);
+
     // PCF (percentage closer filtering)
     // This averages over the 9 surrounding pixels of the shadow map, to make 
     // softer shadows
@@ -160,17 +298,22 @@ float shadowComputationDirLight(vec3 fragPos, vec3 normal, float depth, Directio
 
 float shadowComputationSpotLight(vec3 fragPos, vec3 normal, float depth, SpotLight light)
 {
+    // Lights without a tile in the atlas have no shadow in this frame
+    if (light.atlasRect.z <= 0.)
+        return 0.;
+
     // Position of the fragment in light space, with the corresponding light
     // space matrix
     vec4 fragPosLightSpace = light.lightSpaceMatrix * vec4(fragPos, 1.);
 
     // Perform perspective divide
     vec3 projCoordsLightSpace = fragPosLightSpace.xyz / fragPosLightSpace.w;
-    // Transform to [0,1] range, to use these as the coordinates of the shadow map texture
+    // Transform to [0,1] range, to use these as the coordinates of the tile
     projCoordsLightSpace = projCoordsLightSpace * 0.5 + 0.5;
-    // Get the closest depth value from the light's perspective at these coodinates
-    // in the light's view space
-    float closestDepth = texture(spotShadowMap, projCoordsLightSpace.xy).r;
+    // The fragments outside of the frustum of the light are not in its tile
+    if (fragPosLightSpace.w <= 0. || any(lessThan(projCoordsLightSpace.xy, vec2(0.)))
+        || any(greaterThan(projCoordsLightSpace.xy, vec2(1.))))
+        return 0.;
 
     // Get the distance from the current fragment to the light
     float currentDepth = length(fragPos - light.position) / light.radiusMax;
@@ -180,14 +323,28 @@ float shadowComputationSpotLight(vec3 fragPos, vec3 normal, float depth, SpotLig
 
     // PCF (percentage closer filtering)
     // This averages over the 9 surrounding pixels of the shadow map, to make 
-    // softer shadows
+    // softer shadows. The samples are clamped to the tile of the light
     float shadow = 0.0;
-    vec2 texelSize = 1.0 / vec2(textureSize(spotShadowMap, 0));
+    vec2 texelSize = 1.0 / vec2(textureSize(spotShadowAtlas, 0));
+    vec2 atlasCoords = light.atlasRect.xy + projCoordsLightSpace.xy * light.atlasRect.zw;
+    vec2 tileMin = light.atlasRect.xy + 0.5 * texelSize;
+    vec2 tileMax = light.atlasRect.xy + light.atlasRect.zw - 0.5 * texelSize;
+    // The hardware PCF compares the 2x2 closest texels in a single fetch
+    if (light.shadowFilter == SHADOW_FILTER_HARDWARE_PCF)
+        return 1. - texture(spotShadowAtlasCompare, vec3(clamp(atlasCoords, tileMin, tileMax), currentDepth - bias));
+    // The moments have half of the resolution of the atlas
+    if (light.shadowFilter == SHADOW_FILTER_ESM || light.shadowFilter == SHADOW_FILTER_VSM)
+    {
+        vec2 coords = clamp(atlasCoords, light.atlasRect.xy + texelSize,
+                            light.atlasRect.xy + light.atlasRect.zw - texelSize);
+        return shadowFromMoments(texture(spotShadowMoments, coords).rg, currentDepth - bias, light.shadowFilter);
+    }
     for(int x = -1; x <= 1; ++x)
     {
         for(int y = -1; y <= 1; ++y)
         {
-            float pcfDepth = texture(spotShadowMap, projCoordsLightSpace.xy + vec2(x, y) * texelSize).r; 
+            vec2 coords = clamp(atlasCoords + vec2(x, y) * texelSize, tileMin, tileMax);
+            float pcfDepth = texture(spotShadowAtlas, coords).r; 
             shadow += (currentDepth - bias) > pcfDepth ? 1.0 : 0.0;        
         }    
     }
@@ -196,14 +353,157 @@ float shadowComputationSpotLight(vec3 fragPos, vec3 normal, float depth, SpotLig
     return shadow;
 }
 
+// Shadow maps of the point lights, with the six faces of each one in
+// consecutive layers, in the order +X, -X, +Y, -Y, +Z, -Z
+uniform sampler2DArray pointShadowMaps;
+
+// Directions and up vectors of the faces of the shadow maps of the point
+// lights, as in PointLight::computeShadowMap
+const vec3 pointShadowFaceDirections[6] = vec3[](vec3(1., 0., 0.), vec3(-1., 0., 0.), vec3(0., 1., 0.),
+                                                 vec3(0., -1., 0.), vec3(0., 0., 1.), vec3(0., 0., -1.));
+const vec3 pointShadowFaceUps[6] = vec3[](vec3(0., -1., 0.), vec3(0., -1., 0.), vec3(0., 0., 1.),
+                                          vec3(0., 0., -1.), vec3(0., -1., 0.), vec3(0., -1., 0.));
+
+// Function to compute the shadow of a point light, whose shadow map is in the
+// layers starting at 6 * shadowSlot of the array
+float shadowComputationPointLight(vec3 fragPos, vec3 normal, vec3 lightPos, float farPlane, int shadowSlot)
+{
+    // Size of a texel of the shadow map at the distance of the fragment. The
+    // position is moved along the normal by a few texels, so the surface does
+    // not shadow itself at grazing angles
+    vec3 lightToFrag = fragPos - lightPos;
+    vec3 absLightToFrag = abs(lightToFrag);
+    float texelSize = 1.0 / float(textureSize(pointShadowMaps, 0).x);
+    float texelWorldSize = 2. * texelSize * max(absLightToFrag.x, max(absLightToFrag.y, absLightToFrag.z));
+    lightToFrag += normal * 2. * texelWorldSize;
+
+    // Face of the cube with the direction from the light to the fragment
+    absLightToFrag = abs(lightToFrag);
+    int face;
+    if (absLightToFrag.x >= absLightToFrag.y && absLightToFrag.x >= absLightToFrag.z)
+        face = lightToFrag.x > 0. ? 0 : 1;
+    else if (absLightToFrag.y >= absLightToFrag.z)
+        face = lightToFrag.y > 0. ? 2 : 3;
+    else
+        face = lightToFrag.z > 0. ? 4 : 5;
+
+    // Coordinates in the face, with the same basis as the view matrix of the
+    // face, and the field of view of 90 degrees
+    vec3 forward = pointShadowFaceDirections[face];
+    vec3 side = cross(forward, pointShadowFaceUps[face]);
+    vec3 up = cross(side, forward);
+    float distanceForward = dot(lightToFrag, forward);
+    vec2 faceCoords = vec2(dot(lightToFrag, side), dot(lightToFrag, up)) / distanceForward * 0.5 + 0.5;
+    float layer = float(6 * shadowSlot + face);
+
+    // Linear distance to the light, in the range [0,1] as in the shadow map,
+    // with a bias of one texel
+    float currentDepth = length(lightToFrag) / farPlane;
+    float bias = texelWorldSize / farPlane;
+
+    // PCF over the 9 surrounding pixels of the shadow map. The coordinates
+    // are clamped to the face in its own layer
+    float shadow = 0.0;
+    for(int x = -1; x <= 1; ++x)
+    {
+        for(int y = -1; y <= 1; ++y)
+        {
+            float pcfDepth = texture(pointShadowMaps, vec3(faceCoords + vec2(x, y) * texelSize, layer)).r;
+            shadow += (currentDepth - bias) > pcfDepth ? 1.0 : 0.0;
+        }
+    }
+    shadow /= 9.0;
+
+    return shadow;
+}
+
+// Function to compute the lighting due to the point and spot lights in the
+// cluster of the fragment
+vec3 clusteredLighting(vec3 fragPos, vec3 normal, float depth, vec3 albedo, float specular)
+{
+    // Cluster of the fragment
+    float distance = -(view * vec4(fragPos, 1.)).z;
+    int slice = int(log(distance / clusterNear) * clusterSliceScale);
+    slice = clamp(slice, 0, clusterSlicesZ - 1);
+    int tileX = min(int(TexCoords.x * clusterTilesX), clusterTilesX - 1);
+    int tileY = min(int(TexCoords.y * clusterTilesY), clusterTilesY - 1);
+    uvec2 cluster = texelFetch(clusterGrid, tileX + clusterTilesX * (tileY + clusterTilesY * slice)).rg;
+
+    vec3 viewDir = normalize(viewPos - fragPos);
+    vec3 lighting = vec3(0.);
+    for (uint i = 0u; i < cluster.y; ++i)
+    {
+        int index = 4 * int(texelFetch(clusterLightIndices, int(cluster.x + i)).r);
+        vec4 positionRadius = texelFetch(clusterLightData, index);
+        vec4 colorIntensity = texelFetch(clusterLightData, index + 1);
+        vec4 attenuationAngles = texelFetch(clusterLightData, index + 2);
+        vec4 directionSpot = texelFetch(clusterLightData, index + 3);
+
+        // Attenuation of the light, which fades to zero at the maximum radius so
+        // there is no discontinuity at the border of the clusters
+        vec3 fragToLight = positionRadius.xyz - fragPos;
+        float lightDistance = length(fragToLight);
+        float attenuation = colorIntensity.w / (1. 
+                            + attenuationAngles.x * lightDistance
+                            + attenuationAngles.y * lightDistance * lightDistance);
+        attenuation *= 1. - smoothstep(0.9 * positionRadius.w, positionRadius.w, lightDistance);
+
+        vec3 lightDirection = fragToLight / lightDistance;
+        if (directionSpot.w < 0.)
+        {
+            // Point lights have no direction, and the first component has the
+            // slot of their shadow map
+            int shadowSlot = int(directionSpot.x);
+            if (shadowSlot >= 0 && attenuation > 0.)
+                attenuation *= 1. - shadowComputationPointLight(fragPos, normal, positionRadius.xyz,
+                                                                positionRadius.w, shadowSlot);
+        }
+        else
+        {
+            // Smooth transition to zero between the inner and outer angles
+            float cosTheta = -1. * dot(directionSpot.xyz, lightDirection);
+            attenuation *= clamp( (cosTheta - attenuationAngles.w) / 
+                                  (attenuationAngles.z - attenuationAngles.w),
+                                  0., 1.);
+
+            // Compute the shadow, with the light space matrix of this light
+            if (attenuation > 0.)
+            {
+                int matrixIndex = 6 * int(directionSpot.w);
+                SpotLight light;
+                light.position = positionRadius.xyz;
+                light.direction = directionSpot.xyz;
+                light.radiusMax = positionRadius.w;
+                light.lightSpaceMatrix = mat4(texelFetch(clusterSpotMatrices, matrixIndex),
+                                              texelFetch(clusterSpotMatrices, matrixIndex + 1),
+                                              texelFetch(clusterSpotMatrices, matrixIndex + 2),
+                                              texelFetch(clusterSpotMatrices, matrixIndex + 3));
+                light.atlasRect = texelFetch(clusterSpotMatrices, matrixIndex + 4);
+                light.shadowFilter = int(texelFetch(clusterSpotMatrices, matrixIndex + 5).x);
+                attenuation *= 1. - shadowComputationSpotLight(fragPos, normal, depth, light);
+            }
+        }
+
+        // Diffuse and specular contributions, with the Blinn-Phong model
+        vec3 diffuse = max(dot(lightDirection, normal), 0.) * albedo;
+        vec3 halfwayDir = normalize(lightDirection + viewDir);
+        float specIntensity = specular * pow(max(dot(normal, halfwayDir), 0.), 32.); 
+
+        lighting += attenuation * ( diffuse + specIntensity * albedo ) * colorIntensity.rgb;
+    }
+
+    return lighting;
+}
+
 void main()
 {
     // Get the data from the g-buffer textures
-    vec3 FragPos   = texture(gPosition, TexCoords).rgb;
-    float Depth    = texture(gPosition, TexCoords).a;
-    vec3 Normal    = normalize( texture(gNormal, TexCoords).rgb );
-    vec3 Albedo    = texture(gAlbedoSpec, TexCoords).rgb;
-    float Specular = texture(gAlbedoSpec, TexCoords).a;
+    vec3 FragPos;
+    float Depth;
+    vec3 Normal;
+    vec3 Albedo;
+    float Specular;
+    readGBuffer(TexCoords, FragPos, Depth, Normal, Albedo, Specular);
 
     // Ambient lighting
     vec3 lighting = ambientLightColor * Albedo;
@@ -297,11 +597,21 @@ void main()
         // Color of the specular component
         vec3 specular = specIntensity * Albedo;
 
+        // Compute the shadow, if the light has a shadow map in this frame
+        float shadow = 0.;
+        if (pointLights[i].shadowSlot >= 0)
+            shadow = shadowComputationPointLight(FragPos, Normal, pointLights[i].position,
+                                                 pointLights[i].radiusMax, pointLights[i].shadowSlot);
+
         // Sum the two contributions to the total light, multiplied by the 
         // color of the light
-        lighting += attenuation * ( diffuse + specular ) * pointLights[i].color;
+        lighting += attenuation * (1. - shadow) * ( diffuse + specular ) * pointLights[i].color;
     }
 
+    // Compute the lighting due to the lights in the cluster of the fragment
+    if (clusteredLights)
+        lighting += clusteredLighting(FragPos, Normal, Depth, Albedo, Specular);
+
     // Return the sum of all contributions
     FragColor = vec4(lighting, 1.);
 
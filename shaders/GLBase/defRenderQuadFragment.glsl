@@ -8,7 +8,14 @@ in vec2 TexCoords;
 
 uniform sampler2D screenTexture;
 
+// Fraction of the texture covered by the rendered area, which is upscaled to
+// the whole screen
+uniform vec2 uvScale = vec2(1., 1.);
+
 void main()
 {
-    FragColor = texture(screenTexture, TexCoords);
+    // Keep the bilinear filter inside of the rendered area
+    vec2 halfTexel = 0.5 / vec2(textureSize(screenTexture, 0));
+    vec2 texCoords = clamp(TexCoords * uvScale, halfTexel, uvScale - halfTexel);
+    FragColor = texture(screenTexture, texCoords);
 }
@@ -0,0 +1,79 @@
+#version 330 core
+
+// Shader used to upscale the lit image of the frame to the resolution of the
+// window, accumulating it with the result of the previous frames. The history
+// is reprojected with the motion vectors of the geometry pass, and clamped to
+// the colors around the pixel in this frame to reject the outdated samples.
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+// Lit image of this frame, motion vectors, and result of the previous frame
+uniform sampler2D currentTexture;
+uniform sampler2D velocityTexture;
+uniform sampler2D historyTexture;
+
+// Fraction of the textures of the frame covered by the rendered area
+uniform vec2 uvScale;
+// Jitter of this frame, in texture coordinates of the rendered area
+uniform vec2 jitter;
+// False when the history is not valid, in the first frame or after a resize
+uniform bool historyValid;
+// Weight of this frame in the accumulation
+uniform float currentWeight = 0.1;
+
+// Conversions to the YCoCg color space, where the box of the colors of the
+// neighborhood fits them better than in RGB
+vec3 rgbToYCoCg(vec3 c)
+{
+    return vec3( 0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+                 0.5  * c.r             - 0.5  * c.b,
+                -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+vec3 yCoCgToRgb(vec3 c)
+{
+    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);
+}
+
+void main()
+{
+    // The image of this frame is displaced by the jitter, so it is sampled at
+    // the displaced coordinates to get the color at the center of this pixel
+    vec2 renderCoords = (TexCoords + jitter) * uvScale;
+    vec3 current = texture(currentTexture, renderCoords).rgb;
+
+    // Bounding box of the colors of the 3x3 pixels of the frame around the
+    // sample, inside of the rendered area
+    ivec2 texSize = textureSize(currentTexture, 0);
+    ivec2 maxPixel = ivec2(uvScale * vec2(texSize) + 0.5) - 1;
+    ivec2 centerPixel = ivec2(renderCoords * vec2(texSize));
+    vec3 colorMin = vec3(1e30);
+    vec3 colorMax = vec3(-1e30);
+    for (int x = -1; x <= 1; ++x)
+    {
+        for (int y = -1; y <= 1; ++y)
+        {
+            ivec2 pixel = clamp(centerPixel + ivec2(x, y), ivec2(0), maxPixel);
+            vec3 color = rgbToYCoCg(texelFetch(currentTexture, pixel, 0).rgb);
+            colorMin = min(colorMin, color);
+            colorMax = max(colorMax, color);
+        }
+    }
+
+    // Position of this pixel in the previous frame
+    vec2 velocity = texelFetch(velocityTexture, clamp(centerPixel, ivec2(0), maxPixel), 0).rg;
+    vec2 historyCoords = TexCoords - velocity;
+
+    if (!historyValid || any(lessThan(historyCoords, vec2(0.))) || any(greaterThan(historyCoords, vec2(1.))))
+    {
+        FragColor = vec4(current, 1.);
+        return;
+    }
+
+    // Clamp the history to the colors of this frame
+    vec3 history = rgbToYCoCg(texture(historyTexture, historyCoords).rgb);
+    history = yCoCgToRgb(clamp(history, colorMin, colorMax));
+
+    FragColor = vec4(mix(history, current, currentWeight), 1.);
+}
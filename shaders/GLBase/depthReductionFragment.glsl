@@ -0,0 +1,72 @@
+#version 420 core
+
+// Shader that reduces the depth of the G-buffer to the range of distances to
+// the camera of the visible pixels. Each texel of the result has the minimum
+// and maximum distance of 4x4 texels of the source. The first pass reads the
+// G-buffer, and the next ones the result of the previous pass.
+// The texels without geometry have an empty range, with the minimum larger
+// than the maximum.
+
+layout (location = 0) out vec2 Range;
+
+// Pass: 0 for the one that reads the G-buffer, and 1 for the next ones
+uniform int reductionPass;
+// Source of the pass, and size of its region read, in texels
+uniform sampler2D sourceMap;
+uniform vec2 sourceSize;
+
+// Layout of the G-buffer. With the standard one, the source is the position
+// in world space, and with the compact one the depth buffer
+uniform bool compactGBuffer = false;
+uniform mat4 view;
+uniform mat4 invProjection;
+
+// Empty range
+const vec2 EMPTY_RANGE = vec2(1e30, -1e30);
+
+// Range of a texel of the source
+vec2 readRange(ivec2 texel)
+{
+    if (reductionPass != 0)
+        return texelFetch(sourceMap, texel, 0).rg;
+
+    float distance;
+    if (compactGBuffer)
+    {
+        // The far plane is the background
+        float windowDepth = texelFetch(sourceMap, texel, 0).r;
+        if (windowDepth >= 1.)
+            return EMPTY_RANGE;
+        vec2 screenCoords = (vec2(texel) + 0.5) / sourceSize;
+        vec4 position = invProjection * vec4(vec3(screenCoords, windowDepth) * 2. - 1., 1.);
+        distance = -position.z / position.w;
+    }
+    else
+    {
+        // The background has a depth of 0 in the alpha channel
+        vec4 positionDepth = texelFetch(sourceMap, texel, 0);
+        if (positionDepth.a <= 0.)
+            return EMPTY_RANGE;
+        distance = -(view * vec4(positionDepth.xyz, 1.)).z;
+    }
+    return vec2(distance);
+}
+
+void main()
+{
+    ivec2 texel = 4 * ivec2(gl_FragCoord.xy);
+
+    vec2 range = EMPTY_RANGE;
+    for (int x = 0; x < 4; ++x)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            ivec2 coords = texel + ivec2(x, y);
+            if (any(greaterThanEqual(coords, ivec2(sourceSize))))
+                continue;
+            vec2 texelRange = readRange(coords);
+            range = vec2(min(range.x, texelRange.x), max(range.y, texelRange.y));
+        }
+    }
+    Range = range;
+}
@@ -0,0 +1,8 @@
+#version 420 core
+
+// Triangle that covers the viewport, from the index of its vertices
+void main()
+{
+    vec2 position = vec2(float((gl_VertexID & 1) * 4 - 1), float((gl_VertexID >> 1) * 4 - 1));
+    gl_Position = vec4(position, 0., 1.);
+}
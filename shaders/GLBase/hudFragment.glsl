@@ -0,0 +1,17 @@
+#version 330 core
+
+// Quads of the HUD, with the coverage of the glyphs in the atlas
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+in vec4 Color;
+
+// Atlas of the font, with a solid cell for the quads without text
+uniform sampler2D fontAtlas;
+
+void main()
+{
+    float coverage = texture(fontAtlas, TexCoords).r;
+    FragColor = vec4(Color.rgb, Color.a * coverage);
+}
@@ -0,0 +1,26 @@
+#version 330 core
+
+// Quads of the HUD, one per instance, drawn as a triangle strip of 4 vertices
+
+// Rectangle of the quad in pixels, from the top left corner of the screen,
+// and rectangle of the atlas that it shows
+layout (location = 0) in vec4 aRect;
+layout (location = 1) in vec4 aTexRect;
+layout (location = 2) in vec4 aColor;
+
+out vec2 TexCoords;
+out vec4 Color;
+
+// Size of the screen in pixels
+uniform vec2 screenSize;
+
+void main()
+{
+    // Corners from the bottom, so the triangles are counter-clockwise on the
+    // screen and are not culled
+    vec2 corner = vec2(float(gl_VertexID & 1), float(1 - (gl_VertexID >> 1)));
+    vec2 position = aRect.xy + corner * aRect.zw;
+    gl_Position = vec4(2. * position.x / screenSize.x - 1., 1. - 2. * position.y / screenSize.y, 0., 1.);
+    TexCoords = mix(aTexRect.xy, aTexRect.zw, corner);
+    Color = aColor;
+}
@@ -12,8 +12,15 @@ layout (std140, binding = 0) uniform LightSpaceMatrices
     mat4 lightSpaceMatrices[8];
 };
 
+// Cascades rendered for this object, one bit for each one. The rest keep
+// their shadow map from a previous frame
+uniform int cascadeMask;
+
 void main()
 {
+    if ((cascadeMask & (1 << gl_InvocationID)) == 0)
+        return;
+
     for (int i = 0; i < 3; ++i)
     {
         gl_Position = lightSpaceMatrices[gl_InvocationID] * gl_in[i].gl_Position;
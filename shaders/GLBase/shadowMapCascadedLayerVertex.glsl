@@ -0,0 +1,25 @@
+#version 420 core
+// gl_Layer can only be written in the vertex shader with one of these
+// extensions. The renderer only uses this shader if one of them is supported
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 aPos;
+
+layout (std140, binding = 0) uniform LightSpaceMatrices
+{
+    // This allows for a maximum of 8 cascades
+    mat4 lightSpaceMatrices[8];
+};
+
+uniform mat4 model;
+
+// Cascades where the object is drawn, one for each instance
+uniform int cascades[8];
+
+void main()
+{
+    int cascade = cascades[gl_InstanceID];
+    gl_Position = lightSpaceMatrices[cascade] * model * vec4(aPos, 1.);
+    // Layer of the array that we are writing to
+    gl_Layer = cascade;
+}
@@ -0,0 +1,45 @@
+#version 420 core
+
+// Shader used to render the six faces of the shadow map of a point light in a
+// single pass. Each invocation projects the triangle to one face, and writes it
+// to its layer of the array of shadow maps of the point lights.
+layout (triangles, invocations = 6) in;
+layout (triangle_strip, max_vertices = 3) out;
+
+// Projection to each of the faces, in the order +X, -X, +Y, -Y, +Z, -Z
+uniform mat4 faceMatrices[6];
+// Bit i is set if the object is inside of the frustum of the face i
+uniform int faceMask;
+// Layer of the first face of the light in the array
+uniform int firstLayer;
+
+// Position of the vertex in world space, to compute the distance to the light
+out vec4 fragPos;
+
+void main()
+{
+    // Skip the faces where the object was culled
+    if ((faceMask & (1 << gl_InvocationID)) == 0)
+        return;
+
+    vec4 clipPos[3];
+    for (int i = 0; i < 3; ++i)
+        clipPos[i] = faceMatrices[gl_InvocationID] * gl_in[i].gl_Position;
+
+    // Skip the triangles outside of one of the side planes of the face
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if ((clipPos[0][axis] < -clipPos[0].w && clipPos[1][axis] < -clipPos[1].w && clipPos[2][axis] < -clipPos[2].w)
+            || (clipPos[0][axis] > clipPos[0].w && clipPos[1][axis] > clipPos[1].w && clipPos[2][axis] > clipPos[2].w))
+            return;
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        fragPos = gl_in[i].gl_Position;
+        gl_Position = clipPos[i];
+        gl_Layer = firstLayer + gl_InvocationID;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
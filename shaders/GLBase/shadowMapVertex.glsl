@@ -1,15 +1,11 @@
 #version 420 core
 layout (location = 0) in vec3 aPos;
 
-out vec4 fragPos;
-
-/* out vec4 FragPos; */
-
-uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
 void main()
 {
-    fragPos = lightSpaceMatrix * model * vec4(aPos, 1.);
-    gl_Position = fragPos;
+    // Only do the world space transformation here, the projection to each
+    // face of the shadow map is done in the geometry shader
+    gl_Position = model * vec4(aPos, 1.);
 }
@@ -0,0 +1,83 @@
+#version 420 core
+
+// Shader that computes the moments of the exponential and variance shadow maps
+// from the depth of a shadow map, and blurs them with a separable gaussian.
+// The moments have half of the resolution of the depth. The first pass
+// averages the moments of 2x2 texels of the depth and blurs them horizontally,
+// and the second one blurs the result vertically.
+
+layout (location = 0) out vec2 Moments;
+
+// Pass: 0 for the horizontal one, and 1 for the vertical one
+uniform int blurPass;
+// Depth of the shadow map, in a 2D texture or in a layer of an array. The
+// layer is -1 for the 2D texture
+uniform sampler2D depthMap;
+uniform sampler2DArray depthMapArray;
+uniform int depthLayer;
+// Result of the horizontal pass
+uniform sampler2D momentsMap;
+// Region read, with its offset and size in texels
+uniform vec4 sourceRect;
+// Offset of the region written, in texels
+uniform vec2 targetOffset;
+// True for the exponential shadow maps, and false for the variance ones
+uniform bool exponential;
+
+// Exponent of the exponential shadow maps, as in the lighting shaders
+const float ESM_EXPONENT = 80.;
+
+// Weights of the gaussian, with a radius of 2 texels
+const float weights[5] = float[](0.0625, 0.25, 0.375, 0.25, 0.0625);
+
+// Moments of a depth
+vec2 depthToMoments(float depth)
+{
+    if (exponential)
+        return vec2(exp(ESM_EXPONENT * depth), 0.);
+    return vec2(depth, depth * depth);
+}
+
+// Moments of a texel of the result, from the 2x2 texels of the depth that
+// it covers. The texels outside of the region are clamped to its border
+vec2 readDepthMoments(ivec2 texel)
+{
+    ivec2 offset = ivec2(sourceRect.xy);
+    ivec2 size = ivec2(sourceRect.zw);
+    texel = clamp(texel, ivec2(0), max(size / 2 - 1, ivec2(0)));
+    vec2 moments = vec2(0.);
+    for (int x = 0; x < 2; ++x)
+    {
+        for (int y = 0; y < 2; ++y)
+        {
+            ivec2 coords = offset + min(2 * texel + ivec2(x, y), size - 1);
+            float depth = depthLayer < 0 ? texelFetch(depthMap, coords, 0).r
+                                         : texelFetch(depthMapArray, ivec3(coords, depthLayer), 0).r;
+            moments += depthToMoments(depth);
+        }
+    }
+    return 0.25 * moments;
+}
+
+void main()
+{
+    ivec2 texel = ivec2(gl_FragCoord.xy - targetOffset);
+
+    vec2 moments = vec2(0.);
+    if (blurPass == 0)
+    {
+        for (int i = -2; i <= 2; ++i)
+            moments += weights[i + 2] * readDepthMoments(texel + ivec2(i, 0));
+    }
+    else
+    {
+        ivec2 offset = ivec2(sourceRect.xy);
+        ivec2 size = ivec2(sourceRect.zw);
+        for (int i = -2; i <= 2; ++i)
+        {
+            ivec2 coords = offset + clamp(texel + ivec2(0, i), ivec2(0), size - 1);
+            moments += weights[i + 2] * texelFetch(momentsMap, coords, 0).rg;
+        }
+    }
+    Moments = moments;
+}
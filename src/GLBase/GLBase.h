@@ -11,6 +11,18 @@
 #include <map>
 #include <random>
 #include <ctime>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <chrono>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -21,12 +33,30 @@
 #include <glm/gtx/norm.hpp>
 #include <glm/gtx/string_cast.hpp>
 
+#include "lz4Block.h"
+#include "archive.h"
+#include "virtualFileSystem.h"
+#include "embeddedShaders.h"
 #include "application.h"
 #include "light.h"
+#include "clusteredLights.h"
+#include "shadowAtlas.h"
+#include "shadowMomentsFilter.h"
+#include "depthRangeReducer.h"
+#include "lightVisibility.h"
+#include "gpuProfiler.h"
+#include "glCapture.h"
+#include "cpuProfiler.h"
+#include "renderStats.h"
+#include "performanceHUD.h"
+#include "resolutionController.h"
 #include "deferredRenderer.h"
+#include "frameGraph.h"
 #include "camera.h"
 #include "inputHandler.h"
+#include "inputRecorder.h"
 #include "model.h"
 #include "mesh.h"
+#include "cookedFormats.h"
 #include "shader.h"
 #include "utils.h"
@@ -0,0 +1,27 @@
+# Script run at build time (cmake -P) to embed the shader sources in the
+# library. It writes to OUTPUT a header with a constexpr table of all the files
+# in SHADER_DIR, sorted by their path relative to that directory, which is the
+# name used to find them with the embedded Shader constructor.
+
+file(GLOB_RECURSE SHADER_FILES RELATIVE ${SHADER_DIR} ${SHADER_DIR}/*.glsl)
+list(SORT SHADER_FILES)
+
+set(CONTENT "// Generated by embedShaders.cmake from the files in ${SHADER_DIR}\n")
+string(APPEND CONTENT "// Do not edit this file: it is rewritten when the shaders change.\n\n")
+string(APPEND CONTENT "namespace GLBase\n{\n")
+string(APPEND CONTENT "    constexpr EmbeddedShader EMBEDDED_SHADER_TABLE[]\n    {\n")
+
+foreach(SHADER ${SHADER_FILES})
+    file(READ ${SHADER_DIR}/${SHADER} SOURCE)
+    # The sources are written as raw string literals, so they cannot contain
+    # the delimiter
+    string(FIND "${SOURCE}" ")glsl\"" DELIMITER_POSITION)
+    if(NOT DELIMITER_POSITION EQUAL -1)
+        message(FATAL_ERROR "The shader ${SHADER} contains the sequence )glsl\" and cannot be embedded")
+    endif()
+    string(APPEND CONTENT "        { \"${SHADER}\",\nR\"glsl(${SOURCE})glsl\" },\n")
+endforeach()
+
+string(APPEND CONTENT "    };\n}\n")
+
+file(WRITE ${OUTPUT} "${CONTENT}")
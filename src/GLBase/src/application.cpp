@@ -3,6 +3,15 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#ifdef GLBASE_HEADLESS_EGL
+// The EGL headers must not include the ones of X11, whose macros collide with
+// other names
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 namespace GLBase
 {
     //==============================
@@ -10,9 +19,57 @@ namespace GLBase
     //==============================
 
     // Constructor
-    Application::Application(int width, int height, const char* title) :
-        mWidth { width }, mHeight { height }, mShouldClose { false }
+    Application::Application(int width, int height, const char* title, bool headless) :
+        mShouldClose { false }, mWindow { nullptr }, mCamera { nullptr }, mRenderer { nullptr },
+        mInputHandler { nullptr }, mWidth { width }, mHeight { height }, mHeadless { headless }, mEGLDisplay { nullptr }, mEGLContext { nullptr }, mEGLSurface { nullptr },
+        mStartTime { std::chrono::steady_clock::now() }, mFrameLimit { 0 }, mFrameCounter { 0 }
     {
+        // The environment variables enable the headless mode, with any value,
+        // and limit the number of frames
+        if (std::getenv("GLBASE_HEADLESS") != nullptr)
+            mHeadless = true;
+        const char* framesVariable { std::getenv("GLBASE_HEADLESS_FRAMES") };
+        if (framesVariable != nullptr)
+            mFrameLimit = static_cast<unsigned int>(std::max(0, std::atoi(framesVariable)));
+
+        // The environment variables record the input or replay it
+        const char* replayVariable { std::getenv("GLBASE_REPLAY_INPUT") };
+        const char* recordVariable { std::getenv("GLBASE_RECORD_INPUT") };
+        if (replayVariable != nullptr)
+        {
+            mInputRecorder.startReplay(replayVariable);
+            const char* timestepVariable { std::getenv("GLBASE_REPLAY_TIMESTEP") };
+            if (timestepVariable != nullptr)
+                mInputRecorder.setFixedTimestep(static_cast<float>(std::atof(timestepVariable)));
+        }
+        else if (recordVariable != nullptr)
+            mInputRecorder.startRecording(recordVariable);
+
+        if (mHeadless)
+        {
+            if (createHeadlessContext(width, height))
+            {
+                startGLCapture();
+                // Configure the global state of OpenGL, as with a window
+                glViewport(0, 0, width, height);
+                glEnable(GL_DEPTH_TEST);
+                glEnable(GL_MULTISAMPLE);
+                glEnable(GL_CULL_FACE);
+                glEnable(GL_FRAMEBUFFER_SRGB);
+                return;
+            }
+            // Without EGL, or if it failed, a hidden window is used, which
+            // still needs a display
+#ifndef GLBASE_HEADLESS_EGL
+            std::cout << "ERROR::APPLICATION::HEADLESS_CONTEXT_NOT_AVAILABLE\n"
+                      << "Built without EGL, using a hidden window instead.\n";
+#else
+            std::cout << "ERROR::APPLICATION::HEADLESS_CONTEXT_NOT_CREATED\n"
+                      << "The EGL context could not be created, using a hidden window instead, "
+                      << "which needs a display.\n";
+#endif
+        }
+
         // Initialize GLFW
         glfwInit();
         // Configure GLFW
@@ -29,6 +86,10 @@ namespace GLBase
 
         glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);  
 
+        // The window of the headless mode is never shown
+        if (mHeadless)
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
         // Create a Window object, and check that it was created successfully.
         // GLFWwindow* window { glfwCreateWindow(800, 600, "My title", NULL, NULL) };
         mWindow = glfwCreateWindow(width, height, title, NULL, NULL);
@@ -49,18 +110,24 @@ namespace GLBase
         {
             std::cout << "Failed to initialize GLAD.\n";
         }
+        startGLCapture();
 
         // Tell OpenGL the size of the rendering window
         // The first two parameters are the location of the lower left corner of the window.
         glViewport(0, 0, width, height);
 
-        // Tell GLFW to call this function on every window resize by registering it.
-        glfwSetFramebufferSizeCallback(mWindow, applicationFramebufferSizeCallback);
-        // Set callback functions for mouse movement and scroll
-        glfwSetCursorPosCallback(mWindow, applicationMouseCallback);
-        glfwSetScrollCallback(mWindow, applicationScrollCallback);
-        // tell GLFW to capture our mouse
-        glfwSetInputMode(mWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        if (!mHeadless)
+        {
+            // Tell GLFW to call this function on every window resize by registering it.
+            glfwSetFramebufferSizeCallback(mWindow, applicationFramebufferSizeCallback);
+            // Set callback functions for mouse movement and scroll
+            glfwSetCursorPosCallback(mWindow, applicationMouseCallback);
+            glfwSetScrollCallback(mWindow, applicationScrollCallback);
+            // Set the callback function for the keys
+            glfwSetKeyCallback(mWindow, applicationKeyCallback);
+            // tell GLFW to capture our mouse
+            glfwSetInputMode(mWindow, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        }
 
         // Configure the global state of OpenGL
         // Set depth test (default)
@@ -73,11 +140,130 @@ namespace GLBase
         glEnable(GL_FRAMEBUFFER_SRGB);
     }
 
+    // Method to create the offscreen context of the headless mode
+    bool Application::createHeadlessContext(int width, int height)
+    {
+#ifdef GLBASE_HEADLESS_EGL
+        // Use the surfaceless platform of Mesa, which needs neither a display
+        // nor a GPU, and the default display otherwise
+        EGLDisplay display { EGL_NO_DISPLAY };
+        const char* clientExtensions { eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS) };
+        if (clientExtensions != nullptr && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+        {
+            auto getPlatformDisplay { reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT")) };
+            if (getPlatformDisplay != nullptr)
+                display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+        if (display == EGL_NO_DISPLAY)
+            display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+        {
+            std::cout << "ERROR::APPLICATION::EGL_INITIALIZATION_FAILED\n";
+            return false;
+        }
+        mEGLDisplay = display;
+        eglBindAPI(EGL_OPENGL_API);
+
+        // Configuration with the same buffers as the window
+        const EGLint configAttributes[] {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24, EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint nrConfigs { 0 };
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &nrConfigs) || nrConfigs == 0)
+        {
+            std::cout << "ERROR::APPLICATION::EGL_NO_PBUFFER_CONFIG\n";
+            return false;
+        }
+
+        // Same version and profile as the window
+        const EGLint contextAttributes[] {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+            EGL_NONE
+        };
+        EGLContext context { eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes) };
+        if (context == EGL_NO_CONTEXT)
+        {
+            std::cout << "ERROR::APPLICATION::EGL_CONTEXT_CREATION_FAILED\n";
+            return false;
+        }
+        mEGLContext = context;
+
+        const EGLint surfaceAttributes[] { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        EGLSurface surface { eglCreatePbufferSurface(display, config, surfaceAttributes) };
+        if (surface == EGL_NO_SURFACE)
+        {
+            std::cout << "ERROR::APPLICATION::EGL_PBUFFER_CREATION_FAILED\n";
+            return false;
+        }
+        mEGLSurface = surface;
+
+        if (!eglMakeCurrent(display, surface, surface, context))
+        {
+            std::cout << "ERROR::APPLICATION::EGL_MAKE_CURRENT_FAILED\n";
+            return false;
+        }
+
+        // The core functions are also loaded with eglGetProcAddress
+        if (!gladLoadGLLoader( (GLADloadproc)eglGetProcAddress) )
+        {
+            std::cout << "Failed to initialize GLAD.\n";
+            return false;
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Method to start the capture of the calls to OpenGL
+    void Application::startGLCapture()
+    {
+        const char* captureVariable { std::getenv("GLBASE_CAPTURE_GL") };
+        if (captureVariable == nullptr)
+            return;
+        unsigned int firstFrame { 1 };
+        unsigned int nrFrames { 1 };
+        const char* framesVariable { std::getenv("GLBASE_CAPTURE_GL_FRAMES") };
+        if (framesVariable != nullptr)
+        {
+            firstFrame = static_cast<unsigned int>(std::max(0, std::atoi(framesVariable)));
+            const char* separator { std::strchr(framesVariable, ':') };
+            if (separator != nullptr)
+                nrFrames = static_cast<unsigned int>(std::max(1, std::atoi(separator + 1)));
+        }
+        GLCapture::start(captureVariable, mWidth, mHeight, firstFrame, nrFrames);
+    }
+
     // Destructor
     Application::~Application()
     {
+        // A capture that has not finished keeps the frames captured so far
+        GLCapture::stop();
         std::cout << "Closing application... ";
-        glfwTerminate();
+#ifdef GLBASE_HEADLESS_EGL
+        if (mEGLDisplay != nullptr)
+        {
+            eglMakeCurrent(mEGLDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            if (mEGLSurface != nullptr)
+                eglDestroySurface(mEGLDisplay, mEGLSurface);
+            if (mEGLContext != nullptr)
+                eglDestroyContext(mEGLDisplay, mEGLContext);
+            eglTerminate(mEGLDisplay);
+        }
+#endif
+        if (mWindow != nullptr)
+            glfwTerminate();
         std::cout << "Application closed\n";
     }
 
@@ -91,10 +277,28 @@ namespace GLBase
         return mHeight;
     }
 
+    // Method to get the time in seconds since the application started
+    double Application::getTime()
+    {
+        if (mWindow != nullptr)
+            return glfwGetTime();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - mStartTime).count();
+    }
+
+    // Method to read the pixels of the default framebuffer
+    void Application::readPixels(std::vector<unsigned char>& pixels)
+    {
+        pixels.resize(4 * mWidth * mHeight);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+
     // Method to change the title of the window
     void Application::setTitle(const char* title)
     {
-        glfwSetWindowTitle(mWindow, title);
+        if (mWindow != nullptr)
+            glfwSetWindowTitle(mWindow, title);
     }
 
     // Method to pass a pointer to the camera
@@ -103,6 +307,12 @@ namespace GLBase
         mCamera = camera;
     }
 
+    // Method to pass a pointer to the renderer
+    void Application::setRenderer(DeferredRenderer* renderer)
+    {
+        mRenderer = renderer;
+    }
+
     // Method to pass a pointer to the input handler
     void Application::setInputHandler(InputHandler* inputHandler)
     {
@@ -110,18 +320,29 @@ namespace GLBase
     }
 
     // Process all input
-    void Application::processKeyboardInput(float deltaTime)
+    float Application::processKeyboardInput(float deltaTime)
     {
-        // Process input for the window
-        if (glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-            // glfwSetWindowShouldClose(mWindow, true);
+        // Record the time step of the frame and its events, or replay the ones
+        // of the next recorded frame. The application closes after the last one
+        deltaTime = mInputRecorder.beginFrame(deltaTime, *mInputHandler);
+        if (mInputRecorder.hasFinished())
             mShouldClose = true;
 
-        if (glfwWindowShouldClose(mWindow))
-            mShouldClose = true;
+        // Process input for the window, which there is not in headless mode
+        if (!mHeadless)
+        {
+            if (glfwGetKey(mWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+                // glfwSetWindowShouldClose(mWindow, true);
+                mShouldClose = true;
+
+            if (glfwWindowShouldClose(mWindow))
+                mShouldClose = true;
+        }
 
         // Process input for all the objects in the frame
-        mInputHandler->processKeyboardInput(mWindow, deltaTime);
+        mInputHandler->processKeyboardInput(deltaTime);
+
+        return deltaTime;
     }
 
     // Function to clear the window every frame
@@ -135,10 +356,29 @@ namespace GLBase
     // Function to update the window every frame
     void Application::updateWindow()
     {
-        // Swap the buffers to present the image on the screen
-        glfwSwapBuffers(mWindow);
-        // Poll for IO events
-        glfwPollEvents();
+        // All the calls of the frame have been made
+        GLCapture::endFrame();
+        // The program bound is tracked again from the next frame, so an
+        // error in the count does not carry over
+        Shader::resetCurrentProgram();
+
+        if (mHeadless)
+        {
+            // The pbuffer is not swapped, so wait for the frame to finish
+            // instead, so the frames are not queued without limit
+            glFinish();
+        }
+        else
+        {
+            // Swap the buffers to present the image on the screen
+            glfwSwapBuffers(mWindow);
+            // Poll for IO events
+            glfwPollEvents();
+        }
+
+        ++mFrameCounter;
+        if (mFrameLimit > 0 && mFrameCounter >= mFrameLimit)
+            mShouldClose = true;
     }
 
     //==============================
@@ -154,12 +394,21 @@ namespace GLBase
         // Change the dimensions in the camera
         Application* app { static_cast<Application*>(glfwGetWindowUserPointer(window)) };
         app->mCamera->setDimensions(width, height);
+
+        // Reallocate the render targets of the renderer
+        // The size is zero when the window is minimized
+        if (app->mRenderer != nullptr && width > 0 && height > 0)
+            app->mRenderer->setWindowSize(width, height);
     }
 
     // Function to be called when the mouse is moved
+    // The input of the window is ignored while a recording is replayed
     void applicationMouseCallback(GLFWwindow* window, double xpos, double ypos)
     {
         Application* app { static_cast<Application*>(glfwGetWindowUserPointer(window)) };
+        if (app->mInputRecorder.isReplaying())
+            return;
+        app->mInputRecorder.recordMouse(xpos, ypos);
         app->mInputHandler->processMouseInput(xpos, ypos);
     }
 
@@ -167,6 +416,20 @@ namespace GLBase
     void applicationScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
     {
         Application* app { static_cast<Application*>(glfwGetWindowUserPointer(window)) };
+        if (app->mInputRecorder.isReplaying())
+            return;
+        app->mInputRecorder.recordScroll(xoffset, yoffset);
         app->mInputHandler->processScrollInput(xoffset, yoffset);
     }
+
+    // Function to be called when a key is pressed or released
+    // The repetitions of a key held down do not change its state
+    void applicationKeyCallback(GLFWwindow* window, int key, int, int action, int)
+    {
+        Application* app { static_cast<Application*>(glfwGetWindowUserPointer(window)) };
+        if (app->mInputRecorder.isReplaying() || action == GLFW_REPEAT)
+            return;
+        app->mInputRecorder.recordKey(key, action == GLFW_PRESS);
+        app->mInputHandler->processKeyInput(key, action == GLFW_PRESS);
+    }
 }
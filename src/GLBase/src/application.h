@@ -5,6 +5,8 @@
 
 namespace GLBase
 {
+    class DeferredRenderer;
+
     class Application
     {
         public:
@@ -12,7 +14,23 @@ namespace GLBase
             bool mShouldClose;
 
             // Constructor
-            Application(int width, int height, const char* title);
+            // In headless mode there is no window: the context is created
+            // offscreen with EGL, on the surfaceless platform of Mesa if it is
+            // available, and the frames are rendered to a pbuffer of width x
+            // height pixels, which is the default framebuffer. No input is read.
+            // Setting the environment variable GLBASE_HEADLESS enables it for
+            // any application. If GLBASE_HEADLESS_FRAMES is a number N > 0,
+            // the application closes after N frames
+            // The input can be recorded to a file, or replayed from it, setting
+            // the environment variable GLBASE_RECORD_INPUT or
+            // GLBASE_REPLAY_INPUT to its path. GLBASE_REPLAY_TIMESTEP sets a
+            // fixed time step in seconds for the replay, instead of the
+            // recorded ones. The application closes when the replay finishes
+            // The calls to OpenGL can be captured to a file, to replay them with
+            // the tool glreplay, setting the environment variable
+            // GLBASE_CAPTURE_GL to its path. GLBASE_CAPTURE_GL_FRAMES sets the
+            // frames captured as first:count (default 1:1, the second frame)
+            Application(int width, int height, const char* title, bool headless = false);
             // Destructor
             ~Application();
 
@@ -20,22 +38,55 @@ namespace GLBase
             friend void applicationFramebufferSizeCallback(GLFWwindow* window, int width, int height);
             friend void applicationMouseCallback(GLFWwindow* window, double xpos, double ypos);
             friend void applicationScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+            friend void applicationKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
             // Methods to get witdth and height
             int getWidth();
             int getHeight();
 
+            // Method to check if the application runs without a window
+            bool isHeadless() const
+            {
+                return mHeadless;
+            }
+
+            // Method to get the time in seconds since the application started
+            double getTime();
+
+            // Method to close the application after a number of frames, 0 for
+            // no limit
+            void setFrameLimit(unsigned int frames)
+            {
+                mFrameLimit = frames;
+            }
+
+            // Method to read the pixels of the default framebuffer, with RGBA
+            // and 8 bits per channel, starting from the bottom row
+            void readPixels(std::vector<unsigned char>& pixels);
+
             // Method to change the title of the window
             void setTitle(const char* title);
 
             // Methods to pass pointers to the camera and to input handlers
             void setCamera(Camera* camera);
 
+            // Method to pass a pointer to the renderer, so its render targets
+            // are resized with the window
+            void setRenderer(DeferredRenderer* renderer);
+
             // Method to pass a pointer to the input handler
             void setInputHandler(InputHandler* inputHandler);
 
+            // Method to get the recorder of the input
+            InputRecorder& getInputRecorder()
+            {
+                return mInputRecorder;
+            }
+
             // Function to be called to process input that can modify the window, every frame
-            void processKeyboardInput(float deltaTime);
+            // It returns the time step of the frame, which is the recorded one
+            // when the input is replayed, and deltaTime otherwise
+            float processKeyboardInput(float deltaTime);
 
             // Function to clear the window
             void clearWindow();
@@ -49,12 +100,41 @@ namespace GLBase
             // A pointer to a camera
             Camera* mCamera; 
 
+            // A pointer to the renderer
+            DeferredRenderer* mRenderer;
+
             // Pointer to the input handler
             InputHandler* mInputHandler;
 
+            // Recorder of the input of the frames
+            InputRecorder mInputRecorder;
+
             // Width and height of the window
             int mWidth;
             int mHeight;
+
+            // True if there is no window
+            bool mHeadless;
+            // EGL display, context and pbuffer of the headless mode
+            void* mEGLDisplay;
+            void* mEGLContext;
+            void* mEGLSurface;
+
+            // Start of the clock of the headless mode
+            std::chrono::steady_clock::time_point mStartTime;
+
+            // Number of frames after which the application closes, 0 for no
+            // limit, and number of frames rendered
+            unsigned int mFrameLimit;
+            unsigned int mFrameCounter;
+
+            // Method to create the offscreen context of the headless mode.
+            // Returns false if it could not be created
+            bool createHeadlessContext(int width, int height);
+
+            // Method to start the capture of the calls to OpenGL if it is
+            // enabled by the environment variables
+            void startGLCapture();
     };
 
     // Function to be called when the window is resized
@@ -63,6 +143,8 @@ namespace GLBase
     void applicationMouseCallback(GLFWwindow* window, double xpos, double ypos);
     // Function to be called on scroll
     void applicationScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+    // Function to be called when a key is pressed or released
+    void applicationKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
 }
 
 #endif
@@ -0,0 +1,480 @@
+#include "GLBase.h"
+
+// Headers needed to memory map the archives
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace GLBase
+{
+    // Magic number and version of the archive format
+    const char ARCHIVE_MAGIC[4] { 'G', 'L', 'B', 'A' };
+    constexpr uint32_t ARCHIVE_VERSION { 1 };
+    // Bit set in the block table for blocks stored uncompressed
+    constexpr uint32_t ARCHIVE_BLOCK_RAW_BIT { 0x80000000u };
+    // Largest ratio between the decompressed and compressed sizes of LZ4
+    constexpr uint64_t LZ4_MAX_RATIO { 255 };
+
+    //==============================
+    // Functions for the names of the entries
+    //==============================
+
+    // Normalize a path to the form used as a name in the archives
+    std::string normalizeArchivePath(const std::string& path)
+    {
+        // Split the path in its components, resolving "." and ".."
+        std::vector<std::string> components;
+        std::string current;
+        for (size_t i = 0; i <= path.size(); ++i)
+        {
+            const char c { i < path.size() ? path[i] : '/' };
+            if (c != '/' && c != '\\')
+            {
+                current += c;
+                continue;
+            }
+
+            if (current == "..")
+            {
+                // A ".." at the beginning is dropped, so paths relative to the
+                // build directory match the names in the archive
+                if (!components.empty())
+                    components.pop_back();
+            }
+            else if (!current.empty() && current != ".")
+            {
+                components.push_back(current);
+            }
+            current.clear();
+        }
+
+        // Join the components again
+        std::string normalized;
+        for (size_t i = 0; i < components.size(); ++i)
+        {
+            if (i > 0)
+                normalized += '/';
+            normalized += components[i];
+        }
+        return normalized;
+    }
+
+    // Hash of a normalized name (64 bit FNV-1a)
+    uint64_t hashArchivePath(const std::string& name)
+    {
+        uint64_t hash { 14695981039346656037ull };
+        for (unsigned char c : name)
+        {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        // The value 0 is reserved for the empty buckets of the index
+        return hash == 0 ? 1 : hash;
+    }
+
+    // Check that the data of an entry is inside a file of some size, and that
+    // its sizes are consistent, so a corrupted index does not cause reads out
+    // of the file or huge allocations
+    static bool isEntryValid(const ArchiveIndexEntry& entry, uint32_t blockSize, size_t fileSize)
+    {
+        // Written to avoid overflows with any value in the file
+        if (entry.dataOffset > fileSize || entry.storedSize > fileSize - entry.dataOffset)
+            return false;
+        if (entry.flags == ARCHIVE_ENTRY_RAW)
+            return entry.originalSize <= entry.storedSize;
+        if (entry.flags != ARCHIVE_ENTRY_LZ4)
+            return false;
+        // The block table is inside the stored data, with one block for each
+        // blockSize bytes of the decompressed data
+        return (uint64_t)entry.blockCount * sizeof(uint32_t) <= entry.storedSize &&
+               entry.originalSize <= entry.storedSize * LZ4_MAX_RATIO &&
+               entry.blockCount == (entry.originalSize + blockSize - 1) / blockSize;
+    }
+
+    //==============================
+    // Methods of the Archive class
+    //==============================
+
+    // Constructor
+    Archive::Archive() :
+        mData { nullptr }, mSize { 0 }, mHeader { nullptr }, mIndex { nullptr }
+    {
+    }
+
+    // Destructor
+    Archive::~Archive()
+    {
+        close();
+    }
+
+    // Map an archive from disk
+    bool Archive::open(const std::string& path)
+    {
+        close();
+
+        // Open the file and get its size
+        int fd { ::open(path.c_str(), O_RDONLY) };
+        if (fd < 0)
+        {
+            std::cout << "ERROR::ARCHIVE::FILE_NOT_FOUND " << path << std::endl;
+            return false;
+        }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || (size_t)fileStat.st_size < sizeof(ArchiveHeader))
+        {
+            std::cout << "ERROR::ARCHIVE::INVALID_FILE " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+
+        // Map the whole file. The descriptor is not needed after this
+        void* mapped { mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0) };
+        ::close(fd);
+        if (mapped == MAP_FAILED)
+        {
+            std::cout << "ERROR::ARCHIVE::MMAP_FAILED " << path << std::endl;
+            return false;
+        }
+        mData = static_cast<const unsigned char*>(mapped);
+        mSize = fileStat.st_size;
+        mPath = path;
+
+        // Validate the header and the position of the index
+        mHeader = reinterpret_cast<const ArchiveHeader*>(mData);
+        const bool validHeader { std::memcmp(mHeader->magic, ARCHIVE_MAGIC, 4) == 0 &&
+                                 mHeader->version == ARCHIVE_VERSION &&
+                                 mHeader->blockSize > 0 &&
+                                 mHeader->bucketCount > 0 &&
+                                 (mHeader->bucketCount & (mHeader->bucketCount - 1)) == 0 &&
+                                 mHeader->indexOffset <= mSize &&
+                                 (uint64_t)mHeader->bucketCount * sizeof(ArchiveIndexEntry) <=
+                                     mSize - mHeader->indexOffset &&
+                                 mHeader->namesOffset <= mSize };
+        if (!validHeader)
+        {
+            std::cout << "ERROR::ARCHIVE::INVALID_HEADER " << path << std::endl;
+            close();
+            return false;
+        }
+        mIndex = reinterpret_cast<const ArchiveIndexEntry*>(mData + mHeader->indexOffset);
+
+        // The index is read on every lookup, so ask the kernel to load it now
+        madvise(const_cast<unsigned char*>(mData), mSize, MADV_WILLNEED);
+
+        return true;
+    }
+
+    // Unmap the archive
+    void Archive::close()
+    {
+        if (mData != nullptr)
+            munmap(const_cast<unsigned char*>(mData), mSize);
+        mData = nullptr;
+        mSize = 0;
+        mHeader = nullptr;
+        mIndex = nullptr;
+        mPath.clear();
+    }
+
+    // Method to find the entry of a name in the index
+    const ArchiveIndexEntry* Archive::findEntry(const std::string& name) const
+    {
+        if (mIndex == nullptr)
+            return nullptr;
+
+        const std::string normalized { normalizeArchivePath(name) };
+        const uint64_t hash { hashArchivePath(normalized) };
+
+        // Linear probing, starting at the bucket of the hash
+        const uint32_t mask { mHeader->bucketCount - 1 };
+        for (uint32_t i = 0; i < mHeader->bucketCount; ++i)
+        {
+            const ArchiveIndexEntry& entry { mIndex[(hash + i) & mask] };
+            if (entry.hash == 0)
+                return nullptr;
+            if (entry.hash != hash)
+                continue;
+
+            // Compare the names, to rule out collisions of the hash
+            if (mHeader->namesOffset + entry.nameOffset + entry.nameLength <= mSize &&
+                entry.nameLength == normalized.size() &&
+                std::memcmp(mData + mHeader->namesOffset + entry.nameOffset,
+                            normalized.data(), entry.nameLength) == 0)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+    // Method to check if the archive contains an entry
+    bool Archive::contains(const std::string& name) const
+    {
+        return findEntry(name) != nullptr;
+    }
+
+    // Method to read an entry, decompressing it if needed
+    bool Archive::read(const std::string& name, std::vector<unsigned char>& data) const
+    {
+        const ArchiveIndexEntry* entry { findEntry(name) };
+        if (entry == nullptr)
+            return false;
+        if (!isEntryValid(*entry, mHeader->blockSize, mSize))
+        {
+            std::cout << "ERROR::ARCHIVE::CORRUPTED_ENTRY " << name << std::endl;
+            return false;
+        }
+
+        // Empty entries have nothing to copy, and the data of the vector may
+        // be null
+        data.resize(entry->originalSize);
+        if (entry->originalSize == 0)
+            return true;
+        const unsigned char* stored { mData + entry->dataOffset };
+
+        // Raw entries are copied directly
+        if (entry->flags == ARCHIVE_ENTRY_RAW)
+        {
+            std::memcpy(data.data(), stored, entry->originalSize);
+            return true;
+        }
+
+        // Decompress the blocks one after the other
+        const uint32_t* blockTable { reinterpret_cast<const uint32_t*>(stored) };
+        const unsigned char* block { stored + entry->blockCount * sizeof(uint32_t) };
+        const unsigned char* storedEnd { stored + entry->storedSize };
+        size_t written { 0 };
+        for (uint32_t i = 0; i < entry->blockCount; ++i)
+        {
+            const bool rawBlock { (blockTable[i] & ARCHIVE_BLOCK_RAW_BIT) != 0 };
+            const uint32_t blockSize { blockTable[i] & ~ARCHIVE_BLOCK_RAW_BIT };
+            const size_t expected { std::min<size_t>(mHeader->blockSize, entry->originalSize - written) };
+            if (blockSize > (size_t)(storedEnd - block))
+            {
+                std::cout << "ERROR::ARCHIVE::CORRUPTED_ENTRY " << name << std::endl;
+                return false;
+            }
+
+            if (rawBlock)
+            {
+                if (blockSize != expected)
+                    return false;
+                std::memcpy(data.data() + written, block, blockSize);
+            }
+            else
+            {
+                const int decompressed { LZ4::decompressBlock(block, blockSize,
+                                                              data.data() + written, expected) };
+                if (decompressed != (int)expected)
+                {
+                    std::cout << "ERROR::ARCHIVE::CORRUPTED_ENTRY " << name << std::endl;
+                    return false;
+                }
+            }
+            written += expected;
+            block += blockSize;
+        }
+
+        return written == entry->originalSize;
+    }
+
+    // Method to get a pointer to the data of a raw entry
+    bool Archive::view(const std::string& name, const unsigned char*& data, size_t& size) const
+    {
+        const ArchiveIndexEntry* entry { findEntry(name) };
+        if (entry == nullptr || entry->flags != ARCHIVE_ENTRY_RAW ||
+            !isEntryValid(*entry, mHeader->blockSize, mSize))
+            return false;
+
+        data = mData + entry->dataOffset;
+        size = entry->originalSize;
+        return true;
+    }
+
+    // Method to get the names of all the entries
+    std::vector<std::string> Archive::getEntryNames() const
+    {
+        std::vector<std::string> names;
+        if (mIndex == nullptr)
+            return names;
+
+        names.reserve(mHeader->entryCount);
+        for (uint32_t i = 0; i < mHeader->bucketCount; ++i)
+        {
+            const ArchiveIndexEntry& entry { mIndex[i] };
+            if (entry.hash == 0 ||
+                mHeader->namesOffset + entry.nameOffset + entry.nameLength > mSize)
+                continue;
+            names.emplace_back(reinterpret_cast<const char*>(mData + mHeader->namesOffset +
+                                                             entry.nameOffset),
+                               entry.nameLength);
+        }
+        return names;
+    }
+
+    //==============================
+    // Methods of the ArchiveWriter class
+    //==============================
+
+    // Constructor
+    ArchiveWriter::ArchiveWriter(uint32_t blockSize, uint32_t alignment) :
+        mBlockSize { blockSize }, mAlignment { alignment }
+    {
+    }
+
+    // Method to add an entry from memory
+    void ArchiveWriter::addFile(const std::string& name, const std::vector<unsigned char>& data,
+                                bool compress)
+    {
+        PendingEntry entry;
+        entry.name = normalizeArchivePath(name);
+        entry.originalSize = data.size();
+        entry.flags = ARCHIVE_ENTRY_RAW;
+        entry.blockCount = 0;
+
+        if (compress && !data.empty())
+        {
+            // Compress each block independently
+            const uint32_t nrBlocks { (uint32_t)((data.size() + mBlockSize - 1) / mBlockSize) };
+            std::vector<uint32_t> blockTable(nrBlocks);
+            std::vector<unsigned char> blocks;
+            std::vector<unsigned char> compressed(LZ4::compressBound(mBlockSize));
+            for (uint32_t i = 0; i < nrBlocks; ++i)
+            {
+                const unsigned char* src { data.data() + (size_t)i * mBlockSize };
+                const int srcSize { (int)std::min<size_t>(mBlockSize, data.size() - (size_t)i * mBlockSize) };
+                const int size { LZ4::compressBlock(src, srcSize, compressed.data(), compressed.size()) };
+
+                // Blocks that do not shrink are stored raw
+                if (size == 0 || size >= srcSize)
+                {
+                    blockTable[i] = (uint32_t)srcSize | ARCHIVE_BLOCK_RAW_BIT;
+                    blocks.insert(blocks.end(), src, src + srcSize);
+                }
+                else
+                {
+                    blockTable[i] = (uint32_t)size;
+                    blocks.insert(blocks.end(), compressed.begin(), compressed.begin() + size);
+                }
+            }
+
+            // Keep the compressed version only if it saves at least an eighth of
+            // the size, since raw entries can be read without copies
+            const size_t storedSize { nrBlocks * sizeof(uint32_t) + blocks.size() };
+            if (storedSize < data.size() - data.size() / 8)
+            {
+                entry.flags = ARCHIVE_ENTRY_LZ4;
+                entry.blockCount = nrBlocks;
+                entry.stored.resize(nrBlocks * sizeof(uint32_t));
+                std::memcpy(entry.stored.data(), blockTable.data(), entry.stored.size());
+                entry.stored.insert(entry.stored.end(), blocks.begin(), blocks.end());
+            }
+        }
+
+        if (entry.flags == ARCHIVE_ENTRY_RAW)
+            entry.stored = data;
+
+        // Replace any previous entry with the same name
+        for (auto& other : mEntries)
+        {
+            if (other.name == entry.name)
+            {
+                other = std::move(entry);
+                return;
+            }
+        }
+        mEntries.push_back(std::move(entry));
+    }
+
+    // Method to add an entry from a file in disk
+    bool ArchiveWriter::addFileFromDisk(const std::string& name, const std::string& path,
+                                        bool compress)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::ARCHIVE::FILE_NOT_FOUND " << path << std::endl;
+            return false;
+        }
+        std::vector<unsigned char> data { std::istreambuf_iterator<char>(file),
+                                          std::istreambuf_iterator<char>() };
+        addFile(name, data, compress);
+        return true;
+    }
+
+    // Write the archive to disk
+    bool ArchiveWriter::write(const std::string& path) const
+    {
+        // The index has at least twice as many buckets as entries, so the
+        // probe sequences stay short
+        uint32_t bucketCount { 16 };
+        while (bucketCount < 2 * mEntries.size())
+            bucketCount *= 2;
+
+        ArchiveHeader header {};
+        std::memcpy(header.magic, ARCHIVE_MAGIC, 4);
+        header.version = ARCHIVE_VERSION;
+        header.entryCount = (uint32_t)mEntries.size();
+        header.bucketCount = bucketCount;
+        header.blockSize = mBlockSize;
+        header.alignment = mAlignment;
+
+        // Compute the position of the data of each entry, and build the index
+        // and the names section
+        std::vector<ArchiveIndexEntry> index(bucketCount);
+        std::memset(index.data(), 0, index.size() * sizeof(ArchiveIndexEntry));
+        std::string names;
+        std::vector<uint64_t> offsets(mEntries.size());
+        uint64_t offset { sizeof(ArchiveHeader) };
+        for (size_t i = 0; i < mEntries.size(); ++i)
+        {
+            const PendingEntry& entry { mEntries[i] };
+            offset = (offset + mAlignment - 1) / mAlignment * mAlignment;
+            offsets[i] = offset;
+
+            // Insert in the first free bucket after the one of the hash
+            const uint64_t hash { hashArchivePath(entry.name) };
+            uint32_t bucket { (uint32_t)(hash & (bucketCount - 1)) };
+            while (index[bucket].hash != 0)
+                bucket = (bucket + 1) & (bucketCount - 1);
+
+            ArchiveIndexEntry& indexEntry { index[bucket] };
+            indexEntry.hash = hash;
+            indexEntry.dataOffset = offset;
+            indexEntry.originalSize = entry.originalSize;
+            indexEntry.storedSize = entry.stored.size();
+            indexEntry.nameOffset = (uint32_t)names.size();
+            indexEntry.nameLength = (uint32_t)entry.name.size();
+            indexEntry.flags = entry.flags;
+            indexEntry.blockCount = entry.blockCount;
+            names += entry.name;
+
+            offset += entry.stored.size();
+        }
+        header.indexOffset = (offset + 7) / 8 * 8;
+        header.namesOffset = header.indexOffset + bucketCount * sizeof(ArchiveIndexEntry);
+
+        // Write everything to the file
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "ERROR::ARCHIVE::CANNOT_WRITE " << path << std::endl;
+            return false;
+        }
+        const std::vector<char> padding(std::max<uint32_t>(mAlignment, 8), 0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        uint64_t position { sizeof(ArchiveHeader) };
+        for (size_t i = 0; i < mEntries.size(); ++i)
+        {
+            file.write(padding.data(), offsets[i] - position);
+            file.write(reinterpret_cast<const char*>(mEntries[i].stored.data()),
+                       mEntries[i].stored.size());
+            position = offsets[i] + mEntries[i].stored.size();
+        }
+        file.write(padding.data(), header.indexOffset - position);
+        file.write(reinterpret_cast<const char*>(index.data()),
+                   index.size() * sizeof(ArchiveIndexEntry));
+        file.write(names.data(), names.size());
+
+        return (bool)file;
+    }
+}
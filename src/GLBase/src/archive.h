@@ -0,0 +1,154 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Layout of a GLBase archive (all integers are little endian):
+    //
+    //      ArchiveHeader
+    //      Entry data, each starting at a multiple of the alignment in the header
+    //      Hashed index: bucketCount ArchiveIndexEntry, with open addressing
+    //      Names of the entries, referenced from the index
+    //
+    // The data of an entry is stored either raw, so it can be used directly
+    // from the memory mapped file, or split in blocks of blockSize bytes that
+    // are compressed independently with LZ4. Compressed entries start with a
+    // table of uint32 with the stored size of each block. If the highest bit of
+    // a size is set, that block is stored uncompressed.
+
+    // Flags of the entries of the archive
+    enum ArchiveEntryFlags
+    {
+        ARCHIVE_ENTRY_RAW = 0,
+        ARCHIVE_ENTRY_LZ4 = 1
+    };
+
+    struct ArchiveHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t bucketCount;
+        uint64_t indexOffset;
+        uint64_t namesOffset;
+        uint32_t blockSize;
+        uint32_t alignment;
+        uint32_t reserved[6];
+    };
+
+    struct ArchiveIndexEntry
+    {
+        // Hash of the normalized name. A value of 0 marks an empty bucket
+        uint64_t hash;
+        // Offset of the data from the beginning of the file
+        uint64_t dataOffset;
+        // Size of the entry once decompressed
+        uint64_t originalSize;
+        // Size of the entry in the archive, including the block table
+        uint64_t storedSize;
+        // Name of the entry, in the names section
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        // Compression of the entry (ArchiveEntryFlags)
+        uint32_t flags;
+        // Number of LZ4 blocks
+        uint32_t blockCount;
+    };
+
+    // Read-only archive, memory mapped when it is opened
+    class Archive
+    {
+        public:
+            // Constructor
+            Archive();
+            // Destructor
+            ~Archive();
+
+            Archive(const Archive&) = delete;
+            Archive& operator=(const Archive&) = delete;
+
+            // Map an archive from disk. Returns false if the file is not a valid
+            // archive
+            bool open(const std::string& path);
+            // Unmap the archive
+            void close();
+
+            // Method to check if the archive contains an entry
+            bool contains(const std::string& name) const;
+
+            // Method to read an entry, decompressing it if needed
+            bool read(const std::string& name, std::vector<unsigned char>& data) const;
+
+            // Method to get a pointer to the data of a raw entry, inside the
+            // mapped file. Returns false for compressed entries
+            bool view(const std::string& name, const unsigned char*& data, size_t& size) const;
+
+            // Method to get the names of all the entries
+            std::vector<std::string> getEntryNames() const;
+
+            // Path of the mapped file
+            const std::string& getPath() const
+            {
+                return mPath;
+            }
+
+        private:
+            // Path of the file
+            std::string mPath;
+            // Mapped file
+            const unsigned char* mData;
+            size_t mSize;
+
+            // Header and index inside the mapped file
+            const ArchiveHeader* mHeader;
+            const ArchiveIndexEntry* mIndex;
+
+            // Method to find the entry of a name in the index
+            const ArchiveIndexEntry* findEntry(const std::string& name) const;
+    };
+
+    // Class used to write archives
+    class ArchiveWriter
+    {
+        public:
+            // Constructor
+            ArchiveWriter(uint32_t blockSize = 64 * 1024, uint32_t alignment = 4096);
+
+            // Method to add an entry from memory.
+            // Compressed entries that do not shrink are stored raw.
+            void addFile(const std::string& name, const std::vector<unsigned char>& data,
+                         bool compress = true);
+            // Method to add an entry from a file in disk
+            bool addFileFromDisk(const std::string& name, const std::string& path,
+                                 bool compress = true);
+
+            // Write the archive to disk
+            bool write(const std::string& path) const;
+
+        private:
+            struct PendingEntry
+            {
+                std::string name;
+                uint64_t originalSize;
+                uint32_t flags;
+                uint32_t blockCount;
+                // Block table followed by the blocks, or the raw data
+                std::vector<unsigned char> stored;
+            };
+
+            uint32_t mBlockSize;
+            uint32_t mAlignment;
+            std::vector<PendingEntry> mEntries;
+    };
+
+    // Normalize a path to the form used as a name in the archives: forward
+    // slashes, no "." components and no leading "../" components
+    std::string normalizeArchivePath(const std::string& path);
+
+    // Hash of a normalized name, used in the index of the archives (64 bit FNV-1a)
+    uint64_t hashArchivePath(const std::string& name);
+}
+
+#endif
@@ -16,7 +16,7 @@ namespace GLBase
           mWidth { width }, mHeight { height }, mNear { 0.1 }, mFar { 100. },
           mOrthoHalfWidth { 3.f * (float)width / (float)height }, mOrthoHalfHeight { 3.f },
           mKeyboardHandler(this), mMouseHandler(this), mScrollHandler(this),
-          mIsOrthographic { false }
+          mIsOrthographic { false }, mJitter { 0.f, 0.f }
     {
         updateCameraVectors();
     }
@@ -31,7 +31,7 @@ namespace GLBase
           mWidth { width }, mHeight { height }, mNear { 0.1f }, mFar { 100.f },
           mOrthoHalfWidth { 3.f * (float)width / (float)height }, mOrthoHalfHeight { 3.f },
           mKeyboardHandler(this), mMouseHandler(this), mScrollHandler(this),
-          mIsOrthographic { false }
+          mIsOrthographic { false }, mJitter { 0.f, 0.f }
     {
         updateCameraVectors();
     }
@@ -75,10 +75,30 @@ namespace GLBase
             mProjectionMatrix = glm::ortho(-mOrthoHalfWidth, mOrthoHalfWidth, -mOrthoHalfHeight, mOrthoHalfHeight, mNear, mFar);
         else
             mProjectionMatrix = glm::perspective(glm::radians(Fov), (float)mWidth / (float)mHeight, mNear, mFar);
+
+        // Displace the image by the sub-pixel jitter, after the projection so it
+        // is the same for all depths
+        if (mJitter != glm::vec2(0.f))
+            mProjectionMatrix = glm::translate(glm::mat4(1.f), glm::vec3(mJitter, 0.f)) * mProjectionMatrix;
         
         return mProjectionMatrix;
     }
 
+    // Method to set the sub-pixel jitter of the projection matrix
+    void Camera::setJitter(glm::vec2 jitter)
+    {
+        mJitter = jitter;
+    }
+
+    // Method to point the camera to a position
+    void Camera::lookAt(const glm::vec3& target)
+    {
+        const glm::vec3 direction { glm::normalize(target - Position) };
+        Yaw = glm::degrees(std::atan2(direction.z, direction.x));
+        Pitch = glm::degrees(std::asin(glm::clamp(direction.y, -1.f, 1.f)));
+        updateCameraVectors();
+    }
+
     // Method to obtain the two possible projections
     glm::mat4 Camera::getPerspectiveProjection()
     {
@@ -208,17 +228,17 @@ namespace GLBase
     }
 
     // Method to process input
-    void CameraKeyboardInputHandler::process(GLFWwindow* window, float deltaTime) const
+    void CameraKeyboardInputHandler::process(const InputHandler& input, float deltaTime) const
     {
         // The keys WASD move the camera around the scene
         float cameraSpeed { mCamera->MovementSpeed * deltaTime };
-        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        if (input.isKeyPressed(GLFW_KEY_W))
             mCamera->Position += cameraSpeed * mCamera->Front;
-        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        if (input.isKeyPressed(GLFW_KEY_S))
             mCamera->Position -= cameraSpeed * mCamera->Front;
-        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        if (input.isKeyPressed(GLFW_KEY_A))
             mCamera->Position -= cameraSpeed * mCamera->Right;
-        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        if (input.isKeyPressed(GLFW_KEY_D))
             mCamera->Position += cameraSpeed * mCamera->Right;
     }
     
@@ -26,7 +26,7 @@ namespace GLBase
             CameraKeyboardInputHandler(Camera* camera);
 
             // Method to process input
-            void process(GLFWwindow* window, float deltaTime) const;
+            void process(const InputHandler& input, float deltaTime) const;
 
         private:
             // Pointer to the camera
@@ -118,7 +118,16 @@ namespace GLBase
             // Method to set the dimension of the orthographic projection matrix
             void setOrthographicSize(float size);
 
+            // Method to set the sub-pixel jitter of the projection matrix, as an
+            // offset in normalized device coordinates. It is used by the temporal
+            // upscaling of the renderer, which gives the offset of each frame
+            void setJitter(glm::vec2 jitter);
+
+            // Method to point the camera to a position, changing its Euler angles
+            void lookAt(const glm::vec3& target);
+
             // Method to get the projection matrix
+            // It includes the jitter, if any
             glm::mat4 getProjectionMatrix();
 
             // Compute the view matrix calculated from the Euler angles
@@ -155,6 +164,9 @@ namespace GLBase
             // Bool that says if the camera is orthographic or perspective
             bool mIsOrthographic;
 
+            // Offset of the projection in normalized device coordinates
+            glm::vec2 mJitter;
+
             // Calculate the front vector from the camera's updated Euler angles
             void updateCameraVectors();
             
@@ -0,0 +1,502 @@
+#include "GLBase.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace GLBase
+{
+    // Number of texels of each light in the light data buffer
+    static constexpr unsigned int LIGHT_DATA_TEXELS { 4 };
+    // Number of texels of each spot light in the buffer of the light space matrices
+    static constexpr unsigned int SPOT_DATA_TEXELS { 6 };
+
+    // Values for the padding of the arrays of lights, that never intersect a cluster
+    static constexpr float PADDING_DEPTH { -1e30f };
+
+    // Constructor
+    ClusteredLights::ClusteredLights(unsigned int tilesX, unsigned int tilesY,
+                                     unsigned int slicesZ, unsigned int nrThreads) :
+        mTilesX { tilesX }, mTilesY { tilesY }, mSlicesZ { slicesZ },
+        mProjection { glm::mat4(0.f) }, mNear { 0.f }, mFar { 0.f },
+        mMaxLightsPerCluster { 0 },
+        mLightDataBuffer { 0 }, mLightDataTexture { 0 },
+        mSpotMatricesBuffer { 0 }, mSpotMatricesTexture { 0 },
+        mGridBuffer { 0 }, mGridTexture { 0 },
+        mIndicesBuffer { 0 }, mIndicesTexture { 0 },
+        mJobSize { 0 }, mJobNext { 0 }, mJobWorkersBusy { 0 }, mJobGeneration { 0 },
+        mStopWorkers { false }
+    {
+        mSliceResults.resize(mSlicesZ);
+        mClusterGrid.resize(2 * getNrClusters(), 0);
+
+        // The calling thread also works on the jobs, so it is not added to the pool
+        if (nrThreads == 0)
+            nrThreads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned int i = 1; i < std::min(nrThreads, mSlicesZ); ++i)
+            mWorkers.emplace_back(&ClusteredLights::workerLoop, this);
+    }
+
+    // Destructor
+    ClusteredLights::~ClusteredLights()
+    {
+        // Stop the pool of threads
+        {
+            std::lock_guard<std::mutex> lock(mWorkMutex);
+            mStopWorkers = true;
+        }
+        mWorkStart.notify_all();
+        for (auto& worker : mWorkers)
+            worker.join();
+
+        // Clear the texture buffers, if they were created
+        if (mLightDataBuffer != 0)
+        {
+            unsigned int buffers[4] { mLightDataBuffer, mSpotMatricesBuffer, mGridBuffer, mIndicesBuffer };
+            unsigned int textures[4] { mLightDataTexture, mSpotMatricesTexture, mGridTexture, mIndicesTexture };
+            glDeleteBuffers(4, buffers);
+            glDeleteTextures(4, textures);
+        }
+    }
+
+    // Method to compute the bounding boxes of the clusters of a frustum
+    void ClusteredLights::computeClusterBounds(const glm::mat4& projection)
+    {
+        mProjection = projection;
+
+        // Near and far planes of the perspective projection
+        mNear = projection[3][2] / (projection[2][2] - 1.f);
+        mFar = projection[3][2] / (projection[2][2] + 1.f);
+
+        // Depth of the planes between the slices, distributed exponentially
+        mSliceDepths.resize(mSlicesZ + 1);
+        for (unsigned int k = 0; k <= mSlicesZ; ++k)
+            mSliceDepths[k] = mNear * glm::pow(mFar / mNear, (float)k / mSlicesZ);
+
+        // Each tile is the region between two values of x/d and y/d, where d is
+        // the distance along the view direction. Its bounding box in a slice is
+        // given by the corners in the near and far planes of the slice
+        mClusterBounds.resize(6 * getNrClusters());
+        for (unsigned int k = 0; k < mSlicesZ; ++k)
+        {
+            const float depthNear { mSliceDepths[k] };
+            const float depthFar { mSliceDepths[k + 1] };
+            for (unsigned int j = 0; j < mTilesY; ++j)
+            {
+                const float ndcY0 { -1.f + 2.f * j / mTilesY };
+                const float ndcY1 { -1.f + 2.f * (j + 1) / mTilesY };
+                const float slopeY0 { (ndcY0 + projection[2][1]) / projection[1][1] };
+                const float slopeY1 { (ndcY1 + projection[2][1]) / projection[1][1] };
+                for (unsigned int i = 0; i < mTilesX; ++i)
+                {
+                    const float ndcX0 { -1.f + 2.f * i / mTilesX };
+                    const float ndcX1 { -1.f + 2.f * (i + 1) / mTilesX };
+                    const float slopeX0 { (ndcX0 + projection[2][0]) / projection[0][0] };
+                    const float slopeX1 { (ndcX1 + projection[2][0]) / projection[0][0] };
+
+                    float* bounds { &mClusterBounds[6 * (i + mTilesX * (j + mTilesY * k))] };
+                    bounds[0] = std::min(slopeX0 * depthNear, slopeX0 * depthFar);
+                    bounds[1] = std::min(slopeY0 * depthNear, slopeY0 * depthFar);
+                    bounds[2] = depthNear;
+                    bounds[3] = std::max(slopeX1 * depthNear, slopeX1 * depthFar);
+                    bounds[4] = std::max(slopeY1 * depthNear, slopeY1 * depthFar);
+                    bounds[5] = depthFar;
+                }
+            }
+        }
+    }
+
+    // Method to assign the lights to the clusters of the frustum given by the
+    // view and projection matrices
+    void ClusteredLights::assignLights(const glm::mat4& view, const glm::mat4& projection,
+                                       const std::vector<ClusterLight>& lights)
+    {
+        GLBASE_PROFILE_ZONE("Light clustering");
+        // The bounding boxes only change with the projection
+        if (projection != mProjection)
+            computeClusterBounds(projection);
+
+        // Transform the lights to view space, with the depth as a positive distance.
+        // Flipping the z axis preserves the distances and the angles, so the
+        // tests can be done in this space
+        const unsigned int nrLights { (unsigned int)lights.size() };
+        const unsigned int nrPadded { (nrLights + 3) & ~3u };
+        mLightsX.assign(nrPadded, 0.f);
+        mLightsY.assign(nrPadded, 0.f);
+        mLightsD.assign(nrPadded, PADDING_DEPTH);
+        mLightsR.assign(nrPadded, 0.f);
+        mLightsCone.resize(nrLights);
+        mLightsApex.resize(nrLights);
+        mLightsIsSpot.assign(nrLights, false);
+        for (unsigned int l = 0; l < nrLights; ++l)
+        {
+            const ClusterLight& light { lights[l] };
+            glm::vec3 position { view * glm::vec4(light.position, 1.f) };
+            position.z = -position.z;
+            float radius { light.radius };
+
+            if (light.spotIndex >= 0)
+            {
+                glm::vec3 axis { glm::mat3(view) * light.direction };
+                axis.z = -axis.z;
+                axis = glm::normalize(axis);
+                mLightsIsSpot[l] = true;
+                mLightsCone[l] = glm::vec4(axis, light.cosAngleOuter);
+                mLightsApex[l] = glm::vec4(position, light.radius);
+
+                // Bounding sphere of the cone, which is smaller than the sphere
+                // of a point light with the same radius
+                const float cosAngle { light.cosAngleOuter };
+                const float sinAngle { glm::sqrt(std::max(0.f, 1.f - cosAngle * cosAngle)) };
+                if (cosAngle > 0.7071f)
+                {
+                    radius = light.radius / (2.f * cosAngle);
+                    position += axis * radius;
+                }
+                else if (cosAngle > 0.f)
+                {
+                    position += axis * light.radius * cosAngle;
+                    radius = light.radius * sinAngle;
+                }
+            }
+
+            mLightsX[l] = position.x;
+            mLightsY[l] = position.y;
+            mLightsD[l] = position.z;
+            mLightsR[l] = radius;
+        }
+
+        // Assign the lights to the clusters of each slice in parallel
+        runJob(mSlicesZ, [this](unsigned int slice) { assignSlice(slice); });
+
+        // Merge the results of the slices in a single list
+        unsigned int offset { 0 };
+        mMaxLightsPerCluster = 0;
+        mLightIndices.clear();
+        for (unsigned int k = 0; k < mSlicesZ; ++k)
+        {
+            const SliceResult& result { mSliceResults[k] };
+            for (unsigned int c = 0; c < mTilesX * mTilesY; ++c)
+            {
+                const unsigned int cluster { c + mTilesX * mTilesY * k };
+                mClusterGrid[2 * cluster] = offset;
+                mClusterGrid[2 * cluster + 1] = result.counts[c];
+                offset += result.counts[c];
+                mMaxLightsPerCluster = std::max(mMaxLightsPerCluster, result.counts[c]);
+            }
+            mLightIndices.insert(mLightIndices.end(), result.indices.begin(), result.indices.end());
+        }
+    }
+
+    // Method to assign the lights to the clusters of a slice
+    void ClusteredLights::assignSlice(unsigned int slice)
+    {
+        GLBASE_PROFILE_ZONE("Cluster slice");
+        SliceResult& result { mSliceResults[slice] };
+        result.counts.assign(mTilesX * mTilesY, 0);
+        result.indices.clear();
+
+        // Lights that intersect the depth range of the slice
+        const float depthNear { mSliceDepths[slice] };
+        const float depthFar { mSliceDepths[slice + 1] };
+        result.candidates.clear();
+#if defined(__SSE2__)
+        const __m128 sliceNear { _mm_set1_ps(depthNear) };
+        const __m128 sliceFar { _mm_set1_ps(depthFar) };
+        for (unsigned int l = 0; l < mLightsD.size(); l += 4)
+        {
+            const __m128 d { _mm_loadu_ps(&mLightsD[l]) };
+            const __m128 r { _mm_loadu_ps(&mLightsR[l]) };
+            const __m128 inside { _mm_and_ps(_mm_cmplt_ps(_mm_sub_ps(d, r), sliceFar),
+                                             _mm_cmpgt_ps(_mm_add_ps(d, r), sliceNear)) };
+            int mask { _mm_movemask_ps(inside) };
+            while (mask != 0)
+            {
+                const int bit { __builtin_ctz(mask) };
+                result.candidates.push_back(l + bit);
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (unsigned int l = 0; l < mLightsD.size(); ++l)
+        {
+            if (mLightsD[l] - mLightsR[l] < depthFar && mLightsD[l] + mLightsR[l] > depthNear)
+                result.candidates.push_back(l);
+        }
+#endif
+        if (result.candidates.empty())
+            return;
+
+        for (unsigned int j = 0; j < mTilesY; ++j)
+        {
+            // Lights that intersect the range in y of the row, copied to packed
+            // arrays so the clusters can test them in groups of four
+            const float* rowBounds { &mClusterBounds[6 * mTilesX * (j + mTilesY * slice)] };
+            result.rowCandidates.clear();
+            result.rowX.clear();
+            result.rowY.clear();
+            result.rowD.clear();
+            result.rowR.clear();
+            for (unsigned int l : result.candidates)
+            {
+                if (mLightsY[l] + mLightsR[l] < rowBounds[1] || mLightsY[l] - mLightsR[l] > rowBounds[4])
+                    continue;
+                result.rowCandidates.push_back(l);
+                result.rowX.push_back(mLightsX[l]);
+                result.rowY.push_back(mLightsY[l]);
+                result.rowD.push_back(mLightsD[l]);
+                result.rowR.push_back(mLightsR[l]);
+            }
+            const unsigned int nrRowCandidates { (unsigned int)result.rowCandidates.size() };
+            if (nrRowCandidates == 0)
+                continue;
+            while (result.rowX.size() % 4 != 0)
+            {
+                result.rowX.push_back(0.f);
+                result.rowY.push_back(0.f);
+                result.rowD.push_back(PADDING_DEPTH);
+                result.rowR.push_back(0.f);
+            }
+
+            for (unsigned int i = 0; i < mTilesX; ++i)
+            {
+                const unsigned int clusterInSlice { i + mTilesX * j };
+                const float* bounds { &mClusterBounds[6 * (clusterInSlice + mTilesX * mTilesY * slice)] };
+
+                // Bounding sphere of the cluster, for the test with the cones
+                const glm::vec3 boundsMin { bounds[0], bounds[1], bounds[2] };
+                const glm::vec3 boundsMax { bounds[3], bounds[4], bounds[5] };
+                const glm::vec3 clusterCenter { 0.5f * (boundsMin + boundsMax) };
+                const float clusterRadius { 0.5f * glm::length(boundsMax - boundsMin) };
+
+                // Method to add a light that intersects the bounding box of the
+                // cluster, checking the cone of the spot lights
+                auto addLight = [&](unsigned int index)
+                {
+                    const unsigned int light { result.rowCandidates[index] };
+                    if (mLightsIsSpot[light])
+                    {
+                        // Test of the cone against the bounding sphere of the cluster
+                        const glm::vec3 toCenter { clusterCenter - glm::vec3(mLightsApex[light]) };
+                        const glm::vec3 axis { mLightsCone[light] };
+                        const float cosAngle { mLightsCone[light].w };
+                        const float sinAngle { glm::sqrt(std::max(0.f, 1.f - cosAngle * cosAngle)) };
+                        const float distanceSq { glm::dot(toCenter, toCenter) };
+                        const float distanceAxis { glm::dot(toCenter, axis) };
+                        const float distanceCone { cosAngle * glm::sqrt(std::max(0.f, distanceSq - distanceAxis * distanceAxis))
+                                                   - distanceAxis * sinAngle };
+                        if (distanceCone > clusterRadius || distanceAxis > clusterRadius + mLightsApex[light].w
+                            || distanceAxis < -clusterRadius)
+                            return;
+                    }
+                    result.indices.push_back(light);
+                    ++result.counts[clusterInSlice];
+                };
+
+#if defined(__SSE2__)
+                const __m128 zero { _mm_setzero_ps() };
+                const __m128 minX { _mm_set1_ps(bounds[0]) };
+                const __m128 minY { _mm_set1_ps(bounds[1]) };
+                const __m128 minD { _mm_set1_ps(bounds[2]) };
+                const __m128 maxX { _mm_set1_ps(bounds[3]) };
+                const __m128 maxY { _mm_set1_ps(bounds[4]) };
+                const __m128 maxD { _mm_set1_ps(bounds[5]) };
+                for (unsigned int l = 0; l < nrRowCandidates; l += 4)
+                {
+                    // Distance from the center of each sphere to the box
+                    const __m128 x { _mm_loadu_ps(&result.rowX[l]) };
+                    const __m128 y { _mm_loadu_ps(&result.rowY[l]) };
+                    const __m128 d { _mm_loadu_ps(&result.rowD[l]) };
+                    const __m128 r { _mm_loadu_ps(&result.rowR[l]) };
+                    const __m128 dx { _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero) };
+                    const __m128 dy { _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero) };
+                    const __m128 dd { _mm_max_ps(_mm_max_ps(_mm_sub_ps(minD, d), _mm_sub_ps(d, maxD)), zero) };
+                    const __m128 distanceSq { _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                                         _mm_mul_ps(dd, dd)) };
+                    int mask { _mm_movemask_ps(_mm_cmple_ps(distanceSq, _mm_mul_ps(r, r))) };
+                    while (mask != 0)
+                    {
+                        const int bit { __builtin_ctz(mask) };
+                        addLight(l + bit);
+                        mask &= mask - 1;
+                    }
+                }
+#else
+                for (unsigned int l = 0; l < nrRowCandidates; ++l)
+                {
+                    const float dx { std::max(std::max(bounds[0] - result.rowX[l], result.rowX[l] - bounds[3]), 0.f) };
+                    const float dy { std::max(std::max(bounds[1] - result.rowY[l], result.rowY[l] - bounds[4]), 0.f) };
+                    const float dd { std::max(std::max(bounds[2] - result.rowD[l], result.rowD[l] - bounds[5]), 0.f) };
+                    if (dx * dx + dy * dy + dd * dd <= result.rowR[l] * result.rowR[l])
+                        addLight(l);
+                }
+#endif
+            }
+        }
+    }
+
+    // Method to run a job over a number of items in the pool of threads,
+    // returning when all the items are done
+    void ClusteredLights::runJob(unsigned int size, const std::function<void(unsigned int)>& job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mWorkMutex);
+            mJob = job;
+            mJobSize = size;
+            mJobNext = 0;
+            mJobWorkersBusy = (unsigned int)mWorkers.size();
+            ++mJobGeneration;
+        }
+        mWorkStart.notify_all();
+
+        // This thread also takes items until there are none left
+        for (unsigned int item = mJobNext++; item < size; item = mJobNext++)
+            job(item);
+
+        // Wait for the rest of the threads
+        std::unique_lock<std::mutex> lock(mWorkMutex);
+        mWorkDone.wait(lock, [this]() { return mJobWorkersBusy == 0; });
+    }
+
+    // Method run by each thread of the pool
+    void ClusteredLights::workerLoop()
+    {
+        GLBASE_PROFILE_THREAD("Cluster worker");
+        unsigned int generation { 0 };
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mWorkMutex);
+                mWorkStart.wait(lock, [&]() { return mStopWorkers || mJobGeneration != generation; });
+                if (mStopWorkers)
+                    return;
+                generation = mJobGeneration;
+            }
+
+            for (unsigned int item = mJobNext++; item < mJobSize; item = mJobNext++)
+                mJob(item);
+
+            std::lock_guard<std::mutex> lock(mWorkMutex);
+            if (--mJobWorkersBusy == 0)
+                mWorkDone.notify_one();
+        }
+    }
+
+    // Method to create the texture buffers
+    void ClusteredLights::setupBuffers()
+    {
+        glGenBuffers(1, &mLightDataBuffer);
+        glGenBuffers(1, &mSpotMatricesBuffer);
+        glGenBuffers(1, &mGridBuffer);
+        glGenBuffers(1, &mIndicesBuffer);
+        glGenTextures(1, &mLightDataTexture);
+        glGenTextures(1, &mSpotMatricesTexture);
+        glGenTextures(1, &mGridTexture);
+        glGenTextures(1, &mIndicesTexture);
+    }
+
+    // Method to upload the lights and the result of the last assignment to
+    // the texture buffers
+    void ClusteredLights::upload(const std::vector<ClusterLight>& lights,
+                                 const std::vector<glm::mat4>& spotLightSpaceMatrices,
+                                 const std::vector<glm::vec4>& spotShadowRects,
+                                 const std::vector<int>& spotShadowFilters)
+    {
+        if (mLightDataBuffer == 0)
+            setupBuffers();
+
+        // Properties of each light, in four RGBA texels:
+        //  0 - position, radius
+        //  1 - color, intensity
+        //  2 - linear and quadratic attenuation, cosines of the inner and outer angles
+        //  3 - direction, index of the light space matrix (-1 for point lights)
+        // Point lights have no direction, so their first component is the slot
+        // of their shadow map instead
+        std::vector<float> lightData(std::max(1u, (unsigned int)lights.size()) * 4 * LIGHT_DATA_TEXELS, 0.f);
+        for (unsigned int l = 0; l < lights.size(); ++l)
+        {
+            const ClusterLight& light { lights[l] };
+            float* data { &lightData[4 * LIGHT_DATA_TEXELS * l] };
+            data[0] = light.position.x;
+            data[1] = light.position.y;
+            data[2] = light.position.z;
+            data[3] = light.radius;
+            data[4] = light.color.r;
+            data[5] = light.color.g;
+            data[6] = light.color.b;
+            data[7] = light.intensity;
+            data[8] = light.kLinear;
+            data[9] = light.kQuadratic;
+            data[10] = light.cosAngleInner;
+            data[11] = light.cosAngleOuter;
+            data[12] = light.spotIndex < 0 ? (float)light.shadowSlot : light.direction.x;
+            data[13] = light.direction.y;
+            data[14] = light.direction.z;
+            data[15] = (float)light.spotIndex;
+        }
+
+        // Method to fill a buffer and attach it to its texture
+        auto uploadBuffer = [](unsigned int buffer, unsigned int texture, GLenum format,
+                               const void* data, size_t size)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+            RenderStats::add(RENDER_STAT_BYTES_UPLOADED, size);
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        };
+
+        uploadBuffer(mLightDataBuffer, mLightDataTexture, GL_RGBA32F,
+                     lightData.data(), lightData.size() * sizeof(float));
+        // Each spot light has its light space matrix in four texels, its tile
+        // of the shadow atlas in the fifth one, and the filter of its shadow
+        // map in the first component of the sixth one
+        // There is always at least one spot light and one index, so the buffers
+        // are not empty
+        std::vector<float> spotData(std::max((size_t)1, spotLightSpaceMatrices.size()) * 4 * SPOT_DATA_TEXELS, 0.f);
+        for (unsigned int s = 0; s < spotLightSpaceMatrices.size(); ++s)
+        {
+            float* data { &spotData[4 * SPOT_DATA_TEXELS * s] };
+            std::memcpy(data, glm::value_ptr(spotLightSpaceMatrices[s]), sizeof(glm::mat4));
+            if (s < spotShadowRects.size())
+                std::memcpy(data + 16, glm::value_ptr(spotShadowRects[s]), sizeof(glm::vec4));
+            if (s < spotShadowFilters.size())
+                data[20] = (float)spotShadowFilters[s];
+        }
+        uploadBuffer(mSpotMatricesBuffer, mSpotMatricesTexture, GL_RGBA32F,
+                     spotData.data(), spotData.size() * sizeof(float));
+        uploadBuffer(mGridBuffer, mGridTexture, GL_RG32UI,
+                     mClusterGrid.data(), mClusterGrid.size() * sizeof(unsigned int));
+        const unsigned int noIndex { 0 };
+        uploadBuffer(mIndicesBuffer, mIndicesTexture, GL_R32UI,
+                     mLightIndices.empty() ? &noIndex : mLightIndices.data(),
+                     std::max((size_t)1, mLightIndices.size()) * sizeof(unsigned int));
+
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // Method to bind the texture buffers to four consecutive texture units,
+    // starting in firstTextureUnit, and configure them in a shader
+    void ClusteredLights::configureShader(const Shader& shader, unsigned int firstTextureUnit) const
+    {
+        // The shader must be bound before calling this method
+        const unsigned int textures[4] { mLightDataTexture, mSpotMatricesTexture, mGridTexture, mIndicesTexture };
+        for (unsigned int i = 0; i < 4; ++i)
+        {
+            glActiveTexture(GL_TEXTURE0 + firstTextureUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        }
+
+        shader.setInt("clusterLightData", firstTextureUnit);
+        shader.setInt("clusterSpotMatrices", firstTextureUnit + 1);
+        shader.setInt("clusterGrid", firstTextureUnit + 2);
+        shader.setInt("clusterLightIndices", firstTextureUnit + 3);
+        shader.setInt("clusterTilesX", mTilesX);
+        shader.setInt("clusterTilesY", mTilesY);
+        shader.setInt("clusterSlicesZ", mSlicesZ);
+        // The slice of a distance d is log(d / near) * slicesZ / log(far / near)
+        shader.setFloat("clusterNear", mNear);
+        shader.setFloat("clusterSliceScale", mSlicesZ / glm::log(mFar / mNear));
+    }
+}
@@ -0,0 +1,198 @@
+#ifndef CLUSTEREDLIGHTS_H
+#define CLUSTEREDLIGHTS_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    class Shader;
+
+    // Properties of a point or spot light used for the clustered lighting,
+    // in world space
+    struct ClusterLight
+    {
+        glm::vec3 position;
+        // Maximum distance reached by the light
+        float radius;
+
+        glm::vec3 color;
+        float intensity;
+
+        float kLinear;
+        float kQuadratic;
+        // Cosines of the half angles of a spot light
+        float cosAngleInner;
+        float cosAngleOuter;
+
+        // Direction of a spot light
+        glm::vec3 direction;
+        // Index of the light space matrix of a spot light, or -1 for a point light
+        int spotIndex;
+        // Slot of the shadow map of a point light, or -1 if it has no shadow
+        int shadowSlot;
+    };
+
+    // Clustered light assignment.
+    // The frustum of the camera is divided in a grid of tilesX x tilesY x slicesZ
+    // clusters, with the slices distributed exponentially in depth. Each
+    // frame the lights are assigned to the clusters they intersect on the CPU,
+    // and the compact lists of light indices of each cluster are uploaded to
+    // texture buffers, so the lighting pass only evaluates the lights in the
+    // cluster of each pixel.
+    //
+    // The slices are processed in parallel by a pool of threads. Inside each
+    // slice, the lights are tested in groups of four against the bounding box
+    // of each cluster with SSE when it is available.
+    class ClusteredLights
+    {
+        public:
+            // Constructor
+            // If nrThreads is 0, one thread per hardware thread is used
+            ClusteredLights(unsigned int tilesX = 16, unsigned int tilesY = 9,
+                            unsigned int slicesZ = 24, unsigned int nrThreads = 0);
+
+            // Destructor
+            ~ClusteredLights();
+
+            // Method to assign the lights to the clusters of the frustum given by the
+            // view and projection matrices. This does not use OpenGL
+            void assignLights(const glm::mat4& view, const glm::mat4& projection,
+                              const std::vector<ClusterLight>& lights);
+
+            // Method to upload the lights and the result of the last assignment to
+            // the texture buffers, with the light space matrix of each spot light,
+            // its tile of the shadow atlas, and the filter of its shadow map
+            void upload(const std::vector<ClusterLight>& lights,
+                        const std::vector<glm::mat4>& spotLightSpaceMatrices,
+                        const std::vector<glm::vec4>& spotShadowRects,
+                        const std::vector<int>& spotShadowFilters);
+
+            // Method to bind the texture buffers to four consecutive texture units,
+            // starting in firstTextureUnit, and configure them in a shader
+            void configureShader(const Shader& shader, unsigned int firstTextureUnit) const;
+
+            // Methods to get the results of the last assignment
+            inline unsigned int getNrClusters() const
+            {
+                return mTilesX * mTilesY * mSlicesZ;
+            }
+            inline unsigned int getNrIndices() const
+            {
+                return (unsigned int)mLightIndices.size();
+            }
+            inline unsigned int getMaxLightsPerCluster() const
+            {
+                return mMaxLightsPerCluster;
+            }
+            inline const std::vector<unsigned int>& getClusterGrid() const
+            {
+                return mClusterGrid;
+            }
+            inline const std::vector<unsigned int>& getLightIndices() const
+            {
+                return mLightIndices;
+            }
+            inline unsigned int getNrThreads() const
+            {
+                return (unsigned int)mWorkers.size() + 1;
+            }
+
+        private:
+            // Size of the grid
+            unsigned int mTilesX;
+            unsigned int mTilesY;
+            unsigned int mSlicesZ;
+
+            // Parameters of the frustum used for the last assignment
+            glm::mat4 mProjection;
+            float mNear;
+            float mFar;
+            // Distances to the planes between the slices
+            std::vector<float> mSliceDepths;
+            // Bounding boxes of the clusters in view space, with the depth as a
+            // positive distance. Each one is (minX, minY, minD, maxX, maxY, maxD)
+            std::vector<float> mClusterBounds;
+
+            // Lights in view space, in structure of arrays form so they can be
+            // loaded in groups of four
+            std::vector<float> mLightsX;
+            std::vector<float> mLightsY;
+            std::vector<float> mLightsD;
+            std::vector<float> mLightsR;
+            // Axis and cosine of the outer angle of the spot lights in view space,
+            // for the cone test
+            std::vector<glm::vec4> mLightsCone;
+            // Position of the spot lights in view space, with the depth positive,
+            // and their maximum distance
+            std::vector<glm::vec4> mLightsApex;
+            // True for the spot lights
+            std::vector<bool> mLightsIsSpot;
+
+            // Results of each slice, merged after the assignment
+            struct SliceResult
+            {
+                // Number of lights in each cluster of the slice
+                std::vector<unsigned int> counts;
+                // Indices of the lights of all the clusters of the slice
+                std::vector<unsigned int> indices;
+                // Scratch arrays with the candidate lights of a row
+                std::vector<unsigned int> candidates;
+                std::vector<unsigned int> rowCandidates;
+                std::vector<float> rowX;
+                std::vector<float> rowY;
+                std::vector<float> rowD;
+                std::vector<float> rowR;
+            };
+            std::vector<SliceResult> mSliceResults;
+
+            // Offset and count of the lights of each cluster
+            std::vector<unsigned int> mClusterGrid;
+            // Indices of the lights of all the clusters
+            std::vector<unsigned int> mLightIndices;
+            // Maximum number of lights in one cluster
+            unsigned int mMaxLightsPerCluster;
+
+            // Texture buffers, created the first time they are uploaded
+            unsigned int mLightDataBuffer;
+            unsigned int mLightDataTexture;
+            unsigned int mSpotMatricesBuffer;
+            unsigned int mSpotMatricesTexture;
+            unsigned int mGridBuffer;
+            unsigned int mGridTexture;
+            unsigned int mIndicesBuffer;
+            unsigned int mIndicesTexture;
+
+            // Pool of threads for the assignment
+            std::vector<std::thread> mWorkers;
+            std::mutex mWorkMutex;
+            std::condition_variable mWorkStart;
+            std::condition_variable mWorkDone;
+            // Job run by the pool, and its number of items
+            std::function<void(unsigned int)> mJob;
+            unsigned int mJobSize;
+            // Next item of the job, and number of threads still working on it
+            std::atomic<unsigned int> mJobNext;
+            unsigned int mJobWorkersBusy;
+            // Counter of the jobs started, so the workers detect a new one
+            unsigned int mJobGeneration;
+            bool mStopWorkers;
+
+            // Method to compute the bounding boxes of the clusters of a frustum
+            void computeClusterBounds(const glm::mat4& projection);
+
+            // Method to assign the lights to the clusters of a slice
+            void assignSlice(unsigned int slice);
+
+            // Method to run a job over a number of items in the pool of threads,
+            // returning when all the items are done
+            void runJob(unsigned int size, const std::function<void(unsigned int)>& job);
+
+            // Method run by each thread of the pool
+            void workerLoop();
+
+            // Method to create the texture buffers
+            void setupBuffers();
+    };
+}
+
+#endif
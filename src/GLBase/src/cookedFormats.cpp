@@ -0,0 +1,294 @@
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Magic numbers of the cooked formats
+    const char COOKED_TEXTURE_MAGIC[4] { 'G', 'L', 'T', 'X' };
+    const char COOKED_MODEL_MAGIC[4] { 'G', 'L', 'M', 'D' };
+
+    // Append a value to a buffer
+    template <typename T>
+    inline void appendValue(std::vector<unsigned char>& buffer, const T& value)
+    {
+        const unsigned char* bytes { reinterpret_cast<const unsigned char*>(&value) };
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Append a string to a buffer, preceded by its length
+    inline void appendString(std::vector<unsigned char>& buffer, const std::string& text)
+    {
+        appendValue(buffer, (uint32_t)text.size());
+        buffer.insert(buffer.end(), text.begin(), text.end());
+    }
+
+    // Class used to read values from a buffer, checking its bounds
+    class BufferReader
+    {
+        public:
+            BufferReader(const std::vector<unsigned char>& buffer) :
+                mBuffer { buffer }, mPosition { 0 }
+            {
+            }
+
+            // Read some bytes. Returns false if there are not enough
+            bool readBytes(void* destination, size_t size)
+            {
+                if (size > mBuffer.size() - mPosition)
+                    return false;
+                std::memcpy(destination, mBuffer.data() + mPosition, size);
+                mPosition += size;
+                return true;
+            }
+
+            // Read a value
+            template <typename T>
+            bool readValue(T& value)
+            {
+                return readBytes(&value, sizeof(T));
+            }
+
+            // Read a string preceded by its length
+            bool readString(std::string& text)
+            {
+                uint32_t length;
+                if (!readValue(length) || length > mBuffer.size() - mPosition)
+                    return false;
+                text.assign(reinterpret_cast<const char*>(mBuffer.data() + mPosition), length);
+                mPosition += length;
+                return true;
+            }
+
+            // Number of bytes left to read
+            size_t getRemaining() const
+            {
+                return mBuffer.size() - mPosition;
+            }
+
+        private:
+            const std::vector<unsigned char>& mBuffer;
+            size_t mPosition;
+    };
+
+    //==============================
+    // Cooked textures
+    //==============================
+
+    // Check if some data contains a cooked texture
+    bool isCookedTexture(const std::vector<unsigned char>& data)
+    {
+        return data.size() >= sizeof(CookedTextureHeader) &&
+               std::memcmp(data.data(), COOKED_TEXTURE_MAGIC, 4) == 0;
+    }
+
+    // Write a cooked texture
+    void writeCookedTexture(const unsigned char* pixels, int width, int height, int nrChannels,
+                            std::vector<unsigned char>& output)
+    {
+        CookedTextureHeader header {};
+        std::memcpy(header.magic, COOKED_TEXTURE_MAGIC, 4);
+        header.version = COOKED_FORMAT_VERSION;
+        header.width = width;
+        header.height = height;
+        header.nrChannels = nrChannels;
+
+        output.clear();
+        appendValue(output, header);
+
+        // Store the rows from the bottom to the top, which is the order used by
+        // loadTexture, so it does not need to flip them
+        const size_t rowSize { (size_t)width * nrChannels };
+        output.reserve(output.size() + rowSize * height);
+        for (int row = height - 1; row >= 0; --row)
+        {
+            const unsigned char* rowStart { pixels + row * rowSize };
+            output.insert(output.end(), rowStart, rowStart + rowSize);
+        }
+    }
+
+    // Read the pixels of a cooked texture
+    bool readCookedTexture(const std::vector<unsigned char>& data, bool flipVertically,
+                           int desiredChannels, std::vector<unsigned char>& pixels,
+                           int& width, int& height, int& nrChannels)
+    {
+        if (!isCookedTexture(data))
+            return false;
+
+        CookedTextureHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        // The sizes must fit in the int of the interface
+        const uint32_t maxSize { (uint32_t)std::numeric_limits<int>::max() };
+        if (header.version != COOKED_FORMAT_VERSION || header.nrChannels < 1 || header.nrChannels > 4 ||
+            header.width == 0 || header.width > maxSize || header.height == 0 || header.height > maxSize)
+        {
+            std::cout << "ERROR::COOKED_TEXTURE::INVALID_HEADER" << std::endl;
+            return false;
+        }
+        // Compare the number of rows against the ones in the data, which
+        // cannot overflow
+        const size_t rowSize { (size_t)header.width * header.nrChannels };
+        if (header.height > (data.size() - sizeof(header)) / rowSize)
+        {
+            std::cout << "ERROR::COOKED_TEXTURE::TRUNCATED_DATA" << std::endl;
+            return false;
+        }
+
+        width = header.width;
+        height = header.height;
+        nrChannels = header.nrChannels;
+        const int outChannels { desiredChannels == 0 ? nrChannels : desiredChannels };
+        const size_t outRowSize { (size_t)width * outChannels };
+        pixels.resize(outRowSize * height);
+
+        const unsigned char* source { data.data() + sizeof(header) };
+        for (int row = 0; row < height; ++row)
+        {
+            // The stored rows start at the bottom of the image
+            const unsigned char* in { source + (flipVertically ? row : height - 1 - row) * rowSize };
+            unsigned char* out { pixels.data() + row * outRowSize };
+
+            if (outChannels == nrChannels)
+            {
+                std::memcpy(out, in, rowSize);
+                continue;
+            }
+
+            // Convert the number of channels of each pixel. Gray images
+            // replicate their value in the color channels, and a missing alpha
+            // is opaque
+            for (int x = 0; x < width; ++x)
+            {
+                const unsigned char* p { in + x * nrChannels };
+                unsigned char* q { out + x * outChannels };
+                const bool hasColor { nrChannels >= 3 };
+                const unsigned char alpha { nrChannels == 2 ? p[1] : (nrChannels == 4 ? p[3] : (unsigned char)255) };
+
+                if (outChannels <= 2)
+                {
+                    q[0] = p[0];
+                    if (outChannels == 2)
+                        q[1] = alpha;
+                    continue;
+                }
+                for (int c = 0; c < 3; ++c)
+                    q[c] = hasColor ? p[c] : p[0];
+                if (outChannels == 4)
+                    q[3] = alpha;
+            }
+        }
+        nrChannels = outChannels;
+
+        return true;
+    }
+
+    //==============================
+    // Cooked models
+    //==============================
+
+    // Check if some data contains a cooked model
+    bool isCookedModel(const std::vector<unsigned char>& data)
+    {
+        return data.size() >= sizeof(CookedModelHeader) &&
+               std::memcmp(data.data(), COOKED_MODEL_MAGIC, 4) == 0;
+    }
+
+    // Write the meshes of a cooked model
+    void writeCookedModel(const std::vector<CookedMesh>& meshes, std::vector<unsigned char>& output)
+    {
+        CookedModelHeader header {};
+        std::memcpy(header.magic, COOKED_MODEL_MAGIC, 4);
+        header.version = COOKED_FORMAT_VERSION;
+        header.meshCount = meshes.size();
+
+        output.clear();
+        appendValue(output, header);
+
+        for (const CookedMesh& mesh : meshes)
+        {
+            appendValue(output, (uint32_t)mesh.vertices.size());
+            appendValue(output, (uint32_t)mesh.indices.size());
+            appendValue(output, (uint32_t)mesh.textures.size());
+
+            for (const Vertex& vertex : mesh.vertices)
+            {
+                appendValue(output, vertex.Position);
+                appendValue(output, vertex.Normal);
+                appendValue(output, vertex.TexCoords);
+            }
+            for (unsigned int index : mesh.indices)
+                appendValue(output, (uint32_t)index);
+            for (const CookedTextureReference& texture : mesh.textures)
+            {
+                appendString(output, texture.type);
+                appendString(output, texture.path);
+            }
+        }
+    }
+
+    // Read the meshes of a cooked model
+    bool readCookedModel(const std::vector<unsigned char>& data, std::vector<CookedMesh>& meshes)
+    {
+        if (!isCookedModel(data))
+            return false;
+
+        BufferReader reader { data };
+        CookedModelHeader header;
+        reader.readValue(header);
+        if (header.version != COOKED_FORMAT_VERSION)
+        {
+            std::cout << "ERROR::COOKED_MODEL::INVALID_VERSION" << std::endl;
+            return false;
+        }
+
+        // Each mesh has at least its three counts, so check the number of
+        // meshes against the data left before allocating them
+        meshes.clear();
+        if ((uint64_t)header.meshCount * 3 * sizeof(uint32_t) > reader.getRemaining())
+        {
+            std::cout << "ERROR::COOKED_MODEL::TRUNCATED_DATA" << std::endl;
+            return false;
+        }
+        meshes.resize(header.meshCount);
+        for (CookedMesh& mesh : meshes)
+        {
+            uint32_t vertexCount, indexCount, textureCount;
+            bool valid { reader.readValue(vertexCount) && reader.readValue(indexCount) &&
+                         reader.readValue(textureCount) };
+            // Check the sizes against the data left before allocating anything
+            if (valid && (uint64_t)vertexCount * 8 * sizeof(float) + (uint64_t)indexCount * 4 >
+                             reader.getRemaining())
+                valid = false;
+
+            if (valid)
+            {
+                mesh.vertices.resize(vertexCount);
+                for (Vertex& vertex : mesh.vertices)
+                {
+                    valid = valid && reader.readValue(vertex.Position) &&
+                            reader.readValue(vertex.Normal) && reader.readValue(vertex.TexCoords);
+                }
+                mesh.indices.resize(indexCount);
+                for (unsigned int& index : mesh.indices)
+                {
+                    uint32_t value { 0 };
+                    valid = valid && reader.readValue(value);
+                    index = value;
+                }
+                for (uint32_t i = 0; valid && i < textureCount; ++i)
+                {
+                    CookedTextureReference texture;
+                    valid = reader.readString(texture.type) && reader.readString(texture.path);
+                    mesh.textures.push_back(texture);
+                }
+            }
+
+            if (!valid)
+            {
+                std::cout << "ERROR::COOKED_MODEL::TRUNCATED_DATA" << std::endl;
+                meshes.clear();
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
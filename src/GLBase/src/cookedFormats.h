@@ -0,0 +1,82 @@
+#ifndef COOKEDFORMATS_H
+#define COOKEDFORMATS_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    struct Vertex;
+
+    // Runtime-ready formats produced by the assetcook tool. A cooked asset is
+    // stored under the same name as its source, so the loaders (loadTexture,
+    // loadCubemap and Model) recognize it by the magic number at the beginning
+    // of the data and fall back to the usual decoders otherwise.
+    // All integers are little endian.
+
+    // Version of the cooked formats. Changing it invalidates all cooked assets
+    constexpr uint32_t COOKED_FORMAT_VERSION { 1 };
+
+    // Header of a cooked texture, followed by the pixels as unsigned bytes,
+    // tightly packed, with the first row at the bottom of the image (as
+    // expected by glTexImage2D)
+    struct CookedTextureHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t nrChannels;
+        uint32_t reserved;
+    };
+
+    // Header of a cooked model. It is followed by meshCount meshes, each with:
+    //      uint32 vertexCount, uint32 indexCount, uint32 textureCount
+    //      vertexCount vertices of 8 floats (position, normal, texture coordinates)
+    //      indexCount uint32 indices
+    //      textureCount textures, each one as two strings (type and path)
+    //      stored as a uint32 length followed by the characters
+    struct CookedModelHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t meshCount;
+        uint32_t reserved;
+    };
+
+    // Texture referenced by a cooked mesh, relative to the directory of the model
+    struct CookedTextureReference
+    {
+        std::string type;
+        std::string path;
+    };
+
+    // Mesh of a cooked model, before its buffers are created
+    struct CookedMesh
+    {
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<CookedTextureReference> textures;
+    };
+
+    // Check if some data contains a cooked texture
+    bool isCookedTexture(const std::vector<unsigned char>& data);
+    // Write a cooked texture from pixels with the first row at the top of the
+    // image, as returned by stb_image without flipping
+    void writeCookedTexture(const unsigned char* pixels, int width, int height, int nrChannels,
+                            std::vector<unsigned char>& output);
+    // Read the pixels of a cooked texture. If flipVertically is false, the
+    // first row returned is the top of the image. If desiredChannels is not 0,
+    // the pixels are converted to that number of channels.
+    bool readCookedTexture(const std::vector<unsigned char>& data, bool flipVertically,
+                           int desiredChannels, std::vector<unsigned char>& pixels,
+                           int& width, int& height, int& nrChannels);
+
+    // Check if some data contains a cooked model
+    bool isCookedModel(const std::vector<unsigned char>& data);
+    // Write the meshes of a cooked model
+    void writeCookedModel(const std::vector<CookedMesh>& meshes, std::vector<unsigned char>& output);
+    // Read the meshes of a cooked model
+    bool readCookedModel(const std::vector<unsigned char>& data, std::vector<CookedMesh>& meshes);
+}
+
+#endif
@@ -0,0 +1,475 @@
+#include "cpuProfiler.h"
+
+namespace GLBase
+{
+    // Types of the events of the rings
+    enum CPUProfileEventType : std::uint32_t
+    {
+        CPU_EVENT_BEGIN,
+        CPU_EVENT_END,
+        CPU_EVENT_FRAME
+    };
+
+    // Get the current time in nanoseconds
+    static std::uint64_t getTimeNs()
+    {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Ring of events of a thread. The thread writes the head and the collector
+    // writes the tail, so neither needs a lock
+    struct CPUProfiler::ThreadBuffer
+    {
+        static const std::uint32_t CAPACITY { 1u << 14 };
+
+        struct Event
+        {
+            const char* name;
+            std::uint64_t time;
+            std::uint32_t type;
+        };
+        std::vector<Event> events;
+        std::atomic<std::uint32_t> head;
+        std::atomic<std::uint32_t> tail;
+
+        // Index of the thread
+        unsigned int index;
+
+        // Only used by the thread: zones that are open, with true for the ones
+        // whose start was recorded, and number of them
+        std::vector<bool> openZones;
+        unsigned int nrOpenRecorded;
+
+        // Only used by the collector: zones that are open, with their name and
+        // start
+        std::vector<std::pair<const char*, std::uint64_t>> collectorStack;
+
+        ThreadBuffer(unsigned int threadIndex) :
+            events(CAPACITY), head { 0 }, tail { 0 }, index { threadIndex }, nrOpenRecorded { 0 }
+        {}
+
+        // Method to write an event, if the ring has at least a number of free
+        // events. The starts of the zones leave space for the ends of all the
+        // open ones, so an end is never dropped after its start was recorded
+        bool push(const char* name, std::uint32_t type, unsigned int requiredFree, State& state);
+    };
+
+    // State of the profiler
+    struct CPUProfiler::State
+    {
+        // Time at which the profiler started, which is the start of frame 0
+        std::uint64_t startNs;
+
+        // Rings of the threads, and their names
+        std::mutex threadsMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        std::vector<std::string> threadNames;
+        std::atomic<unsigned int> nrDroppedEvents;
+
+        // Collector thread
+        std::thread collector;
+        std::mutex collectorMutex;
+        std::condition_variable collectorWake;
+        bool stop;
+
+        // Only used by the collector: starts of the frames that are not
+        // complete, zones that have not been assigned to a frame, index of the
+        // next frame, and time at which the last collection started
+        std::vector<std::uint64_t> frameStarts;
+        std::vector<CPUProfileZoneTiming> pendingZones;
+        unsigned int nextFrameIndex;
+        std::uint64_t lastCollectionNs;
+
+        // Frames whose timings are complete, oldest first
+        std::mutex historyMutex;
+        std::vector<CPUProfileFrame> history;
+        unsigned int historySize;
+
+        // Spike detection
+        double spikeThresholdMs;
+        unsigned int spikeNrFrames;
+        std::string spikePathPrefix;
+        // Frame of the last trace written, so consecutive spikes do not write
+        // overlapping traces
+        int lastSpikeFrame;
+
+        State() :
+            startNs { getTimeNs() }, nrDroppedEvents { 0 }, stop { false },
+            frameStarts { startNs }, nextFrameIndex { 0 }, lastCollectionNs { startNs },
+            historySize { 120 }, spikeThresholdMs { 0. }, spikeNrFrames { 30 },
+            spikePathPrefix { "cpuSpike" }, lastSpikeFrame { -1 }
+        {
+            collector = std::thread(&CPUProfiler::collectorLoop, std::ref(*this));
+        }
+
+        ~State()
+        {
+            {
+                std::lock_guard<std::mutex> lock(collectorMutex);
+                stop = true;
+            }
+            collectorWake.notify_all();
+            collector.join();
+        }
+
+        // Method to convert a time to milliseconds since the start
+        double toMs(std::uint64_t timeNs) const
+        {
+            return ((std::int64_t)(timeNs - startNs)) * 1e-6;
+        }
+    };
+
+    // Method to write an event to the ring
+    bool CPUProfiler::ThreadBuffer::push(const char* name, std::uint32_t type, unsigned int requiredFree,
+                                         State& state)
+    {
+        const std::uint32_t currentHead { head.load(std::memory_order_relaxed) };
+        const std::uint32_t used { currentHead - tail.load(std::memory_order_acquire) };
+        if (CAPACITY - used < requiredFree)
+        {
+            state.nrDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        events[currentHead % CAPACITY] = { name, getTimeNs(), type };
+        head.store(currentHead + 1, std::memory_order_release);
+        return true;
+    }
+
+    // State of the profiler, created when it is first used
+    CPUProfiler::State& CPUProfiler::getState()
+    {
+        static State state;
+        return state;
+    }
+
+    // Ring of events of this thread, registered when it is first used
+    CPUProfiler::ThreadBuffer& CPUProfiler::getThreadBuffer()
+    {
+        thread_local ThreadBuffer* buffer { nullptr };
+        if (buffer == nullptr)
+        {
+            State& state { getState() };
+            std::lock_guard<std::mutex> lock(state.threadsMutex);
+            const unsigned int index { (unsigned int)state.buffers.size() };
+            state.buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer(index)));
+            state.threadNames.push_back("Thread " + std::to_string(index));
+            buffer = state.buffers.back().get();
+        }
+        return *buffer;
+    }
+
+    // Method to record the start of a zone
+    void CPUProfiler::beginZone(const char* name)
+    {
+        ThreadBuffer& buffer { getThreadBuffer() };
+        const bool recorded { buffer.push(name, CPU_EVENT_BEGIN, buffer.nrOpenRecorded + 2, getState()) };
+        buffer.openZones.push_back(recorded);
+        if (recorded)
+            ++buffer.nrOpenRecorded;
+    }
+
+    // Method to record the end of the last zone started
+    void CPUProfiler::endZone()
+    {
+        ThreadBuffer& buffer { getThreadBuffer() };
+        if (buffer.openZones.empty())
+            return;
+        const bool recorded { buffer.openZones.back() };
+        buffer.openZones.pop_back();
+        if (recorded)
+        {
+            buffer.push(nullptr, CPU_EVENT_END, 1, getState());
+            --buffer.nrOpenRecorded;
+        }
+    }
+
+    // Method to record the start of a frame
+    void CPUProfiler::markFrame()
+    {
+        ThreadBuffer& buffer { getThreadBuffer() };
+        buffer.push(nullptr, CPU_EVENT_FRAME, buffer.nrOpenRecorded + 1, getState());
+    }
+
+    // Method to set the name of this thread
+    void CPUProfiler::setThreadName(const char* name)
+    {
+        ThreadBuffer& buffer { getThreadBuffer() };
+        State& state { getState() };
+        std::lock_guard<std::mutex> lock(state.threadsMutex);
+        state.threadNames[buffer.index] = name;
+    }
+
+    // Method to set the number of frames of the history
+    void CPUProfiler::setHistorySize(unsigned int frames)
+    {
+        State& state { getState() };
+        std::lock_guard<std::mutex> lock(state.historyMutex);
+        state.historySize = std::max(1u, frames);
+        if (state.history.size() > state.historySize)
+            state.history.erase(state.history.begin(), state.history.end() - state.historySize);
+    }
+
+    // Method to configure the spike detection
+    void CPUProfiler::setSpikeDetection(double thresholdMs, unsigned int nrFrames, const std::string& pathPrefix)
+    {
+        State& state { getState() };
+        std::lock_guard<std::mutex> lock(state.historyMutex);
+        state.spikeThresholdMs = thresholdMs;
+        state.spikeNrFrames = std::max(1u, nrFrames);
+        state.spikePathPrefix = pathPrefix;
+        state.historySize = std::max(state.historySize, state.spikeNrFrames);
+    }
+
+    // Method to get the last frame whose timings are complete
+    bool CPUProfiler::getLastFrame(CPUProfileFrame& frame)
+    {
+        State& state { getState() };
+        std::lock_guard<std::mutex> lock(state.historyMutex);
+        if (state.history.empty())
+            return false;
+        frame = state.history.back();
+        return true;
+    }
+
+    // Number of events dropped because a ring was full
+    unsigned int CPUProfiler::getNrDroppedEvents()
+    {
+        return getState().nrDroppedEvents.load(std::memory_order_relaxed);
+    }
+
+    // Method run by the collector thread
+    void CPUProfiler::collectorLoop(State& state)
+    {
+        std::unique_lock<std::mutex> lock(state.collectorMutex);
+        while (!state.stop)
+        {
+            state.collectorWake.wait_for(lock, std::chrono::milliseconds(1));
+            lock.unlock();
+            collect(state);
+            lock.lock();
+        }
+    }
+
+    // Method to read the events of the rings, and build the frames that are
+    // complete
+    void CPUProfiler::collect(State& state)
+    {
+        const std::uint64_t collectionNs { getTimeNs() };
+
+        std::vector<ThreadBuffer*> buffers;
+        {
+            std::lock_guard<std::mutex> lock(state.threadsMutex);
+            for (const auto& buffer : state.buffers)
+                buffers.push_back(buffer.get());
+        }
+
+        for (ThreadBuffer* buffer : buffers)
+        {
+            std::uint32_t tail { buffer->tail.load(std::memory_order_relaxed) };
+            const std::uint32_t head { buffer->head.load(std::memory_order_acquire) };
+            for (; tail != head; ++tail)
+            {
+                const ThreadBuffer::Event& event { buffer->events[tail % ThreadBuffer::CAPACITY] };
+                if (event.type == CPU_EVENT_BEGIN)
+                    buffer->collectorStack.push_back({ event.name, event.time });
+                else if (event.type == CPU_EVENT_END && !buffer->collectorStack.empty())
+                {
+                    const auto zone { buffer->collectorStack.back() };
+                    buffer->collectorStack.pop_back();
+                    state.pendingZones.push_back({ zone.first, buffer->index,
+                                                   (unsigned int)buffer->collectorStack.size(),
+                                                   state.toMs(zone.second), state.toMs(event.time) });
+                }
+                else if (event.type == CPU_EVENT_FRAME)
+                    state.frameStarts.push_back(event.time);
+            }
+            buffer->tail.store(head, std::memory_order_release);
+        }
+
+        // A frame is complete when it ended before the last collection started,
+        // since all the events recorded before that have been read now
+        while (state.frameStarts.size() >= 2 && state.frameStarts[1] < state.lastCollectionNs)
+        {
+            CPUProfileFrame frame;
+            frame.index = state.nextFrameIndex++;
+            frame.startMs = state.toMs(state.frameStarts[0]);
+            frame.endMs = state.toMs(state.frameStarts[1]);
+            state.frameStarts.erase(state.frameStarts.begin());
+
+            // Zones that started in the frame, or before it if they arrived late
+            auto firstLater { std::stable_partition(state.pendingZones.begin(), state.pendingZones.end(),
+                                                    [&frame](const CPUProfileZoneTiming& zone)
+                                                    { return zone.startMs < frame.endMs; }) };
+            frame.zones.assign(std::make_move_iterator(state.pendingZones.begin()),
+                               std::make_move_iterator(firstLater));
+            state.pendingZones.erase(state.pendingZones.begin(), firstLater);
+            buildNodes(frame);
+
+            std::vector<CPUProfileFrame> spikeFrames;
+            std::string spikePath;
+            {
+                std::lock_guard<std::mutex> lock(state.historyMutex);
+                state.history.push_back(std::move(frame));
+                if (state.history.size() > state.historySize)
+                    state.history.erase(state.history.begin());
+
+                // The frame 0 is the loading, so it is not a spike
+                const CPUProfileFrame& last { state.history.back() };
+                if (state.spikeThresholdMs > 0. && last.index > 0
+                    && last.endMs - last.startMs > state.spikeThresholdMs
+                    && (state.lastSpikeFrame < 0
+                        || last.index >= (unsigned int)state.lastSpikeFrame + state.spikeNrFrames))
+                {
+                    state.lastSpikeFrame = (int)last.index;
+                    const size_t nrFrames { std::min(state.history.size(), (size_t)state.spikeNrFrames) };
+                    spikeFrames.assign(state.history.end() - nrFrames, state.history.end());
+                    spikePath = state.spikePathPrefix + "_" + std::to_string(last.index) + ".json";
+                }
+            }
+
+            // Write the trace of the spike outside of the lock
+            if (!spikeFrames.empty())
+            {
+                std::vector<std::string> threadNames;
+                {
+                    std::lock_guard<std::mutex> lock(state.threadsMutex);
+                    threadNames = state.threadNames;
+                }
+                std::ofstream file(spikePath);
+                if (file)
+                    writeFrames(file, spikeFrames, threadNames);
+                else
+                    std::cout << "ERROR::CPU_PROFILER::FILE_NOT_WRITTEN: " << spikePath << '\n';
+            }
+        }
+
+        state.lastCollectionNs = collectionNs;
+    }
+
+    // Method to build the hierarchy of the zones of a frame
+    void CPUProfiler::buildNodes(CPUProfileFrame& frame)
+    {
+        // With the zones of each thread sorted by their start, the parent of a
+        // zone is the last one before it with one less depth
+        std::sort(frame.zones.begin(), frame.zones.end(),
+                  [](const CPUProfileZoneTiming& a, const CPUProfileZoneTiming& b)
+                  {
+                      if (a.thread != b.thread)
+                          return a.thread < b.thread;
+                      if (a.startMs != b.startMs)
+                          return a.startMs < b.startMs;
+                      return a.depth < b.depth;
+                  });
+
+        frame.nodes.clear();
+        std::vector<int> nodeAtDepth;
+        unsigned int thread { 0 };
+        for (const auto& zone : frame.zones)
+        {
+            if (zone.thread != thread)
+            {
+                thread = zone.thread;
+                nodeAtDepth.clear();
+            }
+
+            // If the parent is not in this frame, the zone is at the top
+            const int parent { zone.depth > 0 && zone.depth <= nodeAtDepth.size()
+                               ? nodeAtDepth[zone.depth - 1] : -1 };
+            int node { -1 };
+            for (int i = (int)frame.nodes.size() - 1; i >= 0; --i)
+            {
+                const CPUProfileNode& candidate { frame.nodes[i] };
+                if (candidate.thread == zone.thread && candidate.parent == parent && candidate.name == zone.name)
+                {
+                    node = i;
+                    break;
+                }
+            }
+            if (node < 0)
+            {
+                frame.nodes.push_back({ zone.name, zone.thread, zone.depth, parent, 0., 0 });
+                node = (int)frame.nodes.size() - 1;
+            }
+            frame.nodes[node].timeMs += zone.endMs - zone.startMs;
+            ++frame.nodes[node].calls;
+
+            nodeAtDepth.resize(zone.depth + 1, -1);
+            nodeAtDepth[zone.depth] = node;
+        }
+    }
+
+    // Method to write frames as a Chrome trace
+    // The frames are in their own track, and each thread in another one
+    void CPUProfiler::writeFrames(std::ostream& out, const std::vector<CPUProfileFrame>& frames,
+                                  const std::vector<std::string>& threadNames)
+    {
+        // Write a name as a string of JSON
+        auto writeName = [&out](const std::string& name)
+        {
+            out << '"';
+            for (char c : name)
+            {
+                if (c == '"' || c == '\\')
+                    out << '\\';
+                out << c;
+            }
+            out << '"';
+        };
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+        for (unsigned int thread = 0; thread < threadNames.size(); ++thread)
+        {
+            out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread + 1
+                << ",\"args\":{\"name\":";
+            writeName(threadNames[thread]);
+            out << "}}";
+        }
+        for (const auto& frame : frames)
+        {
+            out << ",\n{\"name\":\"Frame " << frame.index << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0"
+                << ",\"ts\":" << frame.startMs * 1000. << ",\"dur\":" << (frame.endMs - frame.startMs) * 1000.
+                << '}';
+            for (const auto& zone : frame.zones)
+            {
+                out << ",\n{\"name\":";
+                writeName(zone.name);
+                out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << zone.thread + 1
+                    << ",\"ts\":" << zone.startMs * 1000. << ",\"dur\":" << (zone.endMs - zone.startMs) * 1000.
+                    << '}';
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    // Method to write the frames of the history as a Chrome trace
+    void CPUProfiler::writeChromeTrace(std::ostream& out)
+    {
+        State& state { getState() };
+        std::vector<CPUProfileFrame> frames;
+        std::vector<std::string> threadNames;
+        {
+            std::lock_guard<std::mutex> lock(state.historyMutex);
+            frames = state.history;
+        }
+        {
+            std::lock_guard<std::mutex> lock(state.threadsMutex);
+            threadNames = state.threadNames;
+        }
+        writeFrames(out, frames, threadNames);
+    }
+
+    // Method to write the frames of the history as a Chrome trace to a file
+    void CPUProfiler::saveChromeTrace(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::CPU_PROFILER::FILE_NOT_WRITTEN: " << path << '\n';
+            return;
+        }
+        writeChromeTrace(file);
+    }
+}
@@ -0,0 +1,148 @@
+#ifndef CPUPROFILER_H
+#define CPUPROFILER_H
+
+#include "GLBase.h"
+
+// Macros to instrument the code. They are only compiled when GLBASE_CPU_PROFILER
+// is defined, which CMake does in the builds that are not Release, so in
+// those they cost nothing. The names must be string literals, since only
+// their pointers are recorded
+#ifdef GLBASE_CPU_PROFILER
+    #define GLBASE_PROFILE_CONCAT_IMPL(a, b) a##b
+    #define GLBASE_PROFILE_CONCAT(a, b) GLBASE_PROFILE_CONCAT_IMPL(a, b)
+    // Zone from this line to the end of the block
+    #define GLBASE_PROFILE_ZONE(name) \
+        GLBase::CPUProfileZone GLBASE_PROFILE_CONCAT(cpuProfileZone, __LINE__) { name }
+    // Start of a frame, called once per frame by the thread of the frame loop
+    #define GLBASE_PROFILE_FRAME() GLBase::CPUProfiler::markFrame()
+    // Name of the thread in the timings and traces
+    #define GLBASE_PROFILE_THREAD(name) GLBase::CPUProfiler::setThreadName(name)
+#else
+    #define GLBASE_PROFILE_ZONE(name) ((void)0)
+    #define GLBASE_PROFILE_FRAME() ((void)0)
+    #define GLBASE_PROFILE_THREAD(name) ((void)0)
+#endif
+
+namespace GLBase
+{
+    // Zone of a frame, with the times in milliseconds since the profiler started
+    struct CPUProfileZoneTiming
+    {
+        std::string name;
+        // Index of the thread
+        unsigned int thread;
+        // Number of zones of the thread that contain it
+        unsigned int depth;
+        double startMs;
+        double endMs;
+    };
+
+    // Node of the hierarchy of the zones of a frame. The calls of a zone with
+    // the same name and parent are added in a single node
+    struct CPUProfileNode
+    {
+        std::string name;
+        unsigned int thread;
+        unsigned int depth;
+        // Index of the parent node, or -1 for the zones at the top of a thread
+        int parent;
+        double timeMs;
+        unsigned int calls;
+    };
+
+    // Timings of a frame. The zones are assigned to the frame in which they
+    // start. The frame 0 is the time before the first frame, with the loading
+    struct CPUProfileFrame
+    {
+        unsigned int index;
+        double startMs;
+        double endMs;
+        std::vector<CPUProfileZoneTiming> zones;
+        // Nodes of the hierarchy, each one after its parent
+        std::vector<CPUProfileNode> nodes;
+    };
+
+    // Instrumentation profiler of the CPU.
+    // Each thread records the start and end of its zones in its own ring of
+    // events, which it writes and a collector thread reads without locks. If
+    // the ring is full, the events are dropped. The collector reads the rings
+    // every millisecond, and builds the timings of each frame once all its
+    // events have been read. The frames are kept in a history, which can be
+    // written as a trace in the JSON format of Chrome.
+    // With the spike detection, when a frame takes longer than a threshold,
+    // the last frames of the history are written to a trace file.
+    class CPUProfiler
+    {
+        public:
+            // Methods used by the macros, to record events of this thread
+            static void beginZone(const char* name);
+            static void endZone();
+            static void markFrame();
+            static void setThreadName(const char* name);
+
+            // Method to set the number of frames of the history
+            static void setHistorySize(unsigned int frames);
+
+            // Method to write the last frames to a trace file whenever a frame
+            // takes longer than a threshold in milliseconds. The path of the file
+            // is the prefix followed by the index of the frame. A threshold of 0
+            // disables it
+            static void setSpikeDetection(double thresholdMs, unsigned int nrFrames = 30,
+                                          const std::string& pathPrefix = "cpuSpike");
+
+            // Method to get the last frame whose timings are complete. Returns
+            // false if there is none yet
+            static bool getLastFrame(CPUProfileFrame& frame);
+
+            // Number of events dropped because a ring was full
+            static unsigned int getNrDroppedEvents();
+
+            // Method to write the frames of the history as a Chrome trace
+            static void writeChromeTrace(std::ostream& out);
+            // Same, but writing it to a file
+            static void saveChromeTrace(const std::string& path);
+
+        private:
+            struct State;
+            struct ThreadBuffer;
+
+            // State of the profiler, created when it is first used
+            static State& getState();
+            // Ring of events of this thread, registered when it is first used
+            static ThreadBuffer& getThreadBuffer();
+
+            // Method run by the collector thread
+            static void collectorLoop(State& state);
+            // Method to read the events of the rings, and build the frames that
+            // are complete
+            static void collect(State& state);
+            // Method to build the hierarchy of the zones of a frame
+            static void buildNodes(CPUProfileFrame& frame);
+            // Method to write frames as a Chrome trace
+            static void writeFrames(std::ostream& out, const std::vector<CPUProfileFrame>& frames,
+                                    const std::vector<std::string>& threadNames);
+    };
+
+    // Zone of the CPU profiler, that starts when it is created and ends when it
+    // is destroyed. Used through GLBASE_PROFILE_ZONE
+    class CPUProfileZone
+    {
+        public:
+            // Constructor
+            CPUProfileZone(const char* name)
+            {
+                CPUProfiler::beginZone(name);
+            }
+
+            // Destructor
+            ~CPUProfileZone()
+            {
+                CPUProfiler::endZone();
+            }
+
+            CPUProfileZone(const CPUProfileZone&) = delete;
+            CPUProfileZone& operator=(const CPUProfileZone&) = delete;
+    };
+}
+
+#endif
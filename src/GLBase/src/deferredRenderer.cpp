@@ -11,20 +11,44 @@ namespace GLBase
     // Do this by defining a lower resolution framebuffer, and then blitting
     // its contents to the main one
     // https://community.khronos.org/t/creating-low-resolution-output-using-glblitframebuffer/75682/2
-    DeferredRenderer::DeferredRenderer(int width, int height, float scaling) :
+    DeferredRenderer::DeferredRenderer(int width, int height, float scaling, GBufferLayout layout) :
         mWinWidth { width }, mWinHeight { height }, 
-        mRenderWidth { (int)(width / scaling) }, mRenderHeight { (int)(height / scaling) },
-        mScreenShader("../shaders/GLBase/defRenderQuadVertex.glsl", 
-                      "../shaders/GLBase/defRenderQuadFragment.glsl"),
-        mLightingPassShader("../shaders/GLBase/defLightingPassVertex.glsl", 
-                            "../shaders/GLBase/defLightingPassFragment.glsl"),
-        mShadowMapDirectionalShader("../shaders/GLBase/shadowMapCascadedVertex.glsl", 
-                                    "../shaders/GLBase/shadowMapCascadedFragment.glsl",
-                                    "../shaders/GLBase/shadowMapCascadedGeometry.glsl"),
-        mShadowMapPointShader("../shaders/GLBase/shadowMapVertex.glsl", 
-                                    "../shaders/GLBase/shadowMapFragment.glsl"),
-        mShadowMapSpotShader("../shaders/GLBase/shadowMapSpotVertex.glsl", 
-                                    "../shaders/GLBase/shadowMapSpotFragment.glsl")
+        mTargetWidth { (int)(width / scaling) }, mTargetHeight { (int)(height / scaling) },
+        mRenderWidth { mTargetWidth }, mRenderHeight { mTargetHeight },
+        mMaxRenderScale { 1.f / scaling }, mRenderScale { 1.f / scaling },
+        mTemporalUpscaling { false },
+        mTemporalResolveShader(EMBEDDED_SHADER, "GLBase/defRenderQuadVertex.glsl",
+                               "GLBase/defTemporalResolveFragment.glsl"),
+        mGVelocityTexture { 0 }, mHistoryBuffers { 0, 0 }, mHistoryTextures { 0, 0 },
+        mHistoryIndex { 0 }, mHistoryValid { false },
+        mCurrentViewProjection { glm::mat4(1.f) }, mPreviousViewProjection { glm::mat4(1.f) },
+        mJitter { 0.f, 0.f }, mFrameIndex { 0 },
+        mDynamicResolution { false }, mResolutionController { nullptr },
+        mFrameTimeQueryCount { 0 }, mGPUFrameTime { 0.f },
+        mGBufferLayout { layout }, mDepthRBO { 0 }, mDepthTexture { 0 }, mGPositionTexture { 0 },
+        mScreenShader(EMBEDDED_SHADER, "GLBase/defRenderQuadVertex.glsl", 
+                      "GLBase/defRenderQuadFragment.glsl"),
+        mLightingPassShader(EMBEDDED_SHADER, "GLBase/defLightingPassVertex.glsl", 
+                            "GLBase/defLightingPassFragment.glsl"),
+        mShadowMapDirectionalShader(EMBEDDED_SHADER, "GLBase/shadowMapCascadedVertex.glsl", 
+                                    "GLBase/shadowMapCascadedFragment.glsl",
+                                    "GLBase/shadowMapCascadedGeometry.glsl"),
+        mShadowMapPointShader(EMBEDDED_SHADER, "GLBase/shadowMapVertex.glsl", 
+                                    "GLBase/shadowMapFragment.glsl",
+                                    "GLBase/shadowMapPointGeometry.glsl"),
+        mShadowMapSpotShader(EMBEDDED_SHADER, "GLBase/shadowMapSpotVertex.glsl", 
+                                    "GLBase/shadowMapSpotFragment.glsl"),
+        mShadowMapDirectionalLayerShader { nullptr }, mCascadeRenderPath { CASCADES_GEOMETRY_SHADER },
+        mPointShadowFBO { 0 }, mPointShadowTexture { 0 }, mPointShadowBudget { 4 },
+        mPointShadowResolution { 512 }, mPointShadowPriority { POINT_SHADOW_NEAREST },
+        mSpotShadowAtlas { nullptr }, mShadowMomentsFilter { nullptr }, mShadowTextureUnitsEnd { 7 },
+        mCascadeSplitMode { CASCADE_SPLITS_FIXED }, mDepthRangeReducer { nullptr },
+        mLightVisibility { nullptr }, mGPUProfiler { nullptr },
+        mLightingMode { LIGHTING_FULLSCREEN },
+        mLightVolumeShader(EMBEDDED_SHADER, "GLBase/defLightVolumeVertex.glsl", 
+                           "GLBase/defLightVolumeFragment.glsl"),
+        mView { glm::mat4(1.f) }, mProjection { glm::mat4(1.f) },
+        mClusteredLights { nullptr }, mTextureUnitsExhausted { false }
     {
         // Color to clear the window
         glClearColor(1.f, 0.f, 1.f, 1.0f);
@@ -37,6 +61,46 @@ namespace GLBase
         // Setup the screen quad
         setupScreenQuad();
 
+        // Setup the light volumes
+        setupLightVolumes();
+
+        // Setup the shadow maps of the point lights, and the atlas of the
+        // spot lights
+        setupPointShadowMaps();
+        mSpotShadowAtlas = new ShadowAtlas();
+        mShadowMomentsFilter = new ShadowMomentsFilter();
+
+        // Render the cascades of the directional lights without the geometry
+        // shader if the vertex shader can write the layer
+        if (GLUtils::hasExtension("GL_ARB_shader_viewport_layer_array")
+            || GLUtils::hasExtension("GL_AMD_vertex_shader_layer"))
+        {
+            mShadowMapDirectionalLayerShader = new Shader(EMBEDDED_SHADER,
+                                                          "GLBase/shadowMapCascadedLayerVertex.glsl",
+                                                          "GLBase/shadowMapCascadedFragment.glsl");
+            mCascadeRenderPath = CASCADES_VERTEX_LAYER;
+        }
+
+        // Pass the size of the rendered area to the shaders
+        configureRenderSize();
+
+        // Queries for measuring the frame time
+        glGenQueries(2 * NR_FRAME_TIME_QUERIES, mFrameTimeQueries);
+
+        // Uniform buffer with the matrices for the motion vectors, in the
+        // binding point 1 (the 0 is used by the matrices of the cascades)
+        glGenBuffers(1, &mTemporalMatricesUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, mTemporalMatricesUBO);
+        glBufferData(GL_UNIFORM_BUFFER, 2 * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, 1, mTemporalMatricesUBO);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        // Configure the textures in the shader of the temporal upscaling
+        mTemporalResolveShader.use();
+        mTemporalResolveShader.setInt("currentTexture", 0);
+        mTemporalResolveShader.setInt("velocityTexture", 1);
+        mTemporalResolveShader.setInt("historyTexture", 2);
+
         // Enable and configure stencil testing
         glEnable(GL_STENCIL_TEST);
         glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);  
@@ -45,9 +109,31 @@ namespace GLBase
     // Destructor
     DeferredRenderer::~DeferredRenderer()
     {
-        // Clear the FBOs
-        glDeleteFramebuffers(1, &mTargetBuffer);
-        glDeleteFramebuffers(1, &mGBuffer);
+        // Clear the FBOs and their attachments
+        deleteRenderTargets();
+        // Clear the queries and the controller of the dynamic resolution
+        glDeleteQueries(2 * NR_FRAME_TIME_QUERIES, mFrameTimeQueries);
+        delete mResolutionController;
+        // Clear the buffer of the motion vectors
+        glDeleteBuffers(1, &mTemporalMatricesUBO);
+        // Clear the shadow maps of the point lights
+        glDeleteFramebuffers(1, &mPointShadowFBO);
+        glDeleteTextures(1, &mPointShadowTexture);
+        // Clear the atlas of the spot lights, and the filter of the moments
+        delete mSpotShadowAtlas;
+        delete mShadowMomentsFilter;
+        // Clear the reduction of the depth, and the selection of the lights
+        delete mDepthRangeReducer;
+        delete mLightVisibility;
+        // Clear the shader of the cascades without geometry shader
+        delete mShadowMapDirectionalLayerShader;
+
+        // Clear the light volumes
+        glDeleteBuffers(1, &mPointVolumeInstanceVBO);
+        delete mPointVolume;
+        delete mSpotVolume;
+        // Clear the clustered lights
+        delete mClusteredLights;
     }
 
     // Setup the screen quad
@@ -91,48 +177,107 @@ namespace GLBase
 
         // Generate the texture attachments for the G-buffer
         // ------------------------------
-        // 1 - Position texture
-        // It needs only 3 components per pixel, but I use RGBA for hardware reasons
-        glGenTextures(1, &mGPositionTexture);
-        glBindTexture(GL_TEXTURE_2D, mGPositionTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mRenderWidth, mRenderHeight, 0, 
-                     GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 
-                               mGPositionTexture, 0);
-        // 2 - Normal texture
-        glGenTextures(1, &mGNormalTexture);
-        glBindTexture(GL_TEXTURE_2D, mGNormalTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mRenderWidth, mRenderHeight, 0, 
-                     GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, 
-                               mGNormalTexture, 0);
-        // 3 - Albedo and specular texture
-        glGenTextures(1, &mGAlbedoSpecTexture);
-        glBindTexture(GL_TEXTURE_2D, mGAlbedoSpecTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mRenderWidth, mRenderHeight, 0, 
-                     GL_RGBA, GL_FLOAT, nullptr);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, 
-                               mGAlbedoSpecTexture, 0);
-
-        // Configure these textures to be the color attachments of this Framebuffer
-        unsigned int attachments[3] { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, 
-                                      GL_COLOR_ATTACHMENT2 };
-        glDrawBuffers(3, attachments);
-
-        // Create a renderbuffer object for the depth and stencil attachments of the
-        // target framebuffer.
-        // This same RBO will be shared with the target FBO, which won't write to
-        // it during the lighting pass.
-        glGenRenderbuffers(1, &mDepthRBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, mDepthRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mRenderWidth, mRenderHeight);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthRBO);
+        if (mGBufferLayout == GBUFFER_STANDARD)
+        {
+            // 1 - Position texture
+            // It needs only 3 components per pixel, but I use RGBA for hardware reasons
+            glGenTextures(1, &mGPositionTexture);
+            glBindTexture(GL_TEXTURE_2D, mGPositionTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mTargetWidth, mTargetHeight, 0, 
+                         GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 
+                                   mGPositionTexture, 0);
+            // 2 - Normal texture
+            glGenTextures(1, &mGNormalTexture);
+            glBindTexture(GL_TEXTURE_2D, mGNormalTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mTargetWidth, mTargetHeight, 0, 
+                         GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, 
+                                   mGNormalTexture, 0);
+            // 3 - Albedo and specular texture
+            glGenTextures(1, &mGAlbedoSpecTexture);
+            glBindTexture(GL_TEXTURE_2D, mGAlbedoSpecTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mTargetWidth, mTargetHeight, 0, 
+                         GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, 
+                                   mGAlbedoSpecTexture, 0);
+
+            // Configure these textures to be the color attachments of this Framebuffer
+            // The motion vectors use the fourth one, if there are any
+            unsigned int attachments[4] { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, 
+                                          GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+            glDrawBuffers(mTemporalUpscaling ? 4 : 3, attachments);
+
+            // Create a renderbuffer object for the depth and stencil attachments of the
+            // target framebuffer.
+            // This same RBO will be shared with the target FBO, which won't write to
+            // it during the lighting pass.
+            glGenRenderbuffers(1, &mDepthRBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, mDepthRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mTargetWidth, mTargetHeight);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthRBO);
+        }
+        else
+        {
+            // 1 - Normal texture, with the octahedral encoding in two 16 bit channels
+            glGenTextures(1, &mGNormalTexture);
+            glBindTexture(GL_TEXTURE_2D, mGNormalTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16, mTargetWidth, mTargetHeight, 0, 
+                         GL_RG, GL_UNSIGNED_SHORT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 
+                                   mGNormalTexture, 0);
+            // 2 - Albedo and specular texture
+            // The sRGB encoding keeps more precision in the dark colors. The 
+            // conversion is done when writing with GL_FRAMEBUFFER_SRGB enabled, 
+            // and when sampling
+            glGenTextures(1, &mGAlbedoSpecTexture);
+            glBindTexture(GL_TEXTURE_2D, mGAlbedoSpecTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, mTargetWidth, mTargetHeight, 0, 
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, 
+                                   mGAlbedoSpecTexture, 0);
+
+            // The output 2 of the shader is not used, and the motion vectors use
+            // the fourth attachment, if there are any
+            unsigned int attachments[4] { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, 
+                                          GL_NONE, GL_COLOR_ATTACHMENT3 };
+            glDrawBuffers(mTemporalUpscaling ? 4 : 2, attachments);
+
+            // 3 - Depth and stencil texture
+            // The lighting pass samples it, so the target FBO gets a copy of it
+            // in its own renderbuffer instead of sharing it
+            glGenTextures(1, &mDepthTexture);
+            glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, mTargetWidth, mTargetHeight, 0, 
+                         GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 
+                                   mDepthTexture, 0);
+        }
+
+        // 4 - Motion vectors, in texture coordinates, for the temporal upscaling
+        if (mTemporalUpscaling)
+        {
+            glGenTextures(1, &mGVelocityTexture);
+            glBindTexture(GL_TEXTURE_2D, mGVelocityTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, mTargetWidth, mTargetHeight, 0, 
+                         GL_RG, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, 
+                                   mGVelocityTexture, 0);
+        }
 
         // now that we actually created the framebuffer and added all attachments we want to check if it is actually complete now
         if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
@@ -140,10 +285,32 @@ namespace GLBase
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // Configure the textures in the shader for the lighting pass
+        // With the compact layout, gPosition is the depth texture
         mLightingPassShader.use();
         mLightingPassShader.setInt("gPosition", 0);
         mLightingPassShader.setInt("gNormal", 1);
         mLightingPassShader.setInt("gAlbedoSpec", 2);
+        mLightingPassShader.setBool("compactGBuffer", mGBufferLayout == GBUFFER_COMPACT);
+        // The shadow maps of the point lights use the first unit after them,
+        // and the atlas of the spot lights the next one, followed by the same
+        // atlas with the comparison sampler and its moments
+        mLightingPassShader.setInt("pointShadowMaps", 3);
+        mLightingPassShader.setInt("spotShadowAtlas", 4);
+        mLightingPassShader.setInt("spotShadowAtlasCompare", 5);
+        mLightingPassShader.setInt("spotShadowMoments", 6);
+
+        // The texture buffers of the clusters use the last four texture units, 
+        // since the shadow maps use the ones after the G-buffer. The directional
+        // lights that do not fit between them are skipped in the lighting pass
+        int maxTextureUnits;
+        glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxTextureUnits);
+        mClusterTextureUnit = maxTextureUnits - 4;
+        // Samplers of different types cannot use the same unit, even if they
+        // are not used
+        mLightingPassShader.setInt("clusterLightData", mClusterTextureUnit);
+        mLightingPassShader.setInt("clusterSpotMatrices", mClusterTextureUnit + 1);
+        mLightingPassShader.setInt("clusterGrid", mClusterTextureUnit + 2);
+        mLightingPassShader.setInt("clusterLightIndices", mClusterTextureUnit + 3);
     }
 
     // Setup the target FBO
@@ -158,8 +325,14 @@ namespace GLBase
         glBindTexture(GL_TEXTURE_2D, mTargetTexture);
         // Configure the texture
         // The last 0 means that it is initially empty
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, mRenderWidth, mRenderHeight, 0, 
-                     GL_RGBA, GL_FLOAT, NULL);
+        // The compact layout accumulates the light in a packed float format,
+        // without alpha
+        if (mGBufferLayout == GBUFFER_STANDARD)
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, mTargetWidth, mTargetHeight, 0, 
+                         GL_RGBA, GL_FLOAT, NULL);
+        else
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R11F_G11F_B10F, mTargetWidth, mTargetHeight, 0, 
+                         GL_RGB, GL_FLOAT, NULL);
         // Set the mipmap filtering of the texture
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -172,8 +345,18 @@ namespace GLBase
         unsigned int attachments[1] { GL_COLOR_ATTACHMENT0 };
         glDrawBuffers(1, attachments);
 
-        // Configure the depth and stencil renderbuffer object, created in setupGBuffer()
-        // This is the same RBO for both FBOs
+        // Configure the depth and stencil renderbuffer object
+        // With the standard layout it is the same RBO created in setupGBuffer()
+        // for both FBOs. With the compact layout the depth texture is sampled 
+        // in the lighting pass, so attaching it here would be a feedback loop.
+        // The target FBO has its own RBO instead, where the depth and stencil
+        // are copied after the geometry pass
+        if (mGBufferLayout == GBUFFER_COMPACT)
+        {
+            glGenRenderbuffers(1, &mDepthRBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, mDepthRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, mTargetWidth, mTargetHeight);
+        }
         glBindRenderbuffer(GL_RENDERBUFFER, mDepthRBO);
         glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthRBO);
 
@@ -183,6 +366,315 @@ namespace GLBase
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 
+    // Setup the meshes and the buffers for the light volumes
+    void DeferredRenderer::setupLightVolumes()
+    {
+        // Low resolution meshes are enough, since they are scaled to contain
+        // the whole volume of the light
+        mPointVolume = new GLSphere(8);
+        mSpotVolume = new GLCone(16);
+
+        // Buffer for the per-instance attributes of the point lights, with
+        // space for one light so the attributes are always valid
+        mPointVolumeInstanceCapacity = 1;
+        glGenBuffers(1, &mPointVolumeInstanceVBO);
+        glBindBuffer(GL_ARRAY_BUFFER, mPointVolumeInstanceVBO);
+        glBufferData(GL_ARRAY_BUFFER, 11 * sizeof(float), nullptr, GL_STREAM_DRAW);
+
+        // Add the per-instance attributes to the VAO of the sphere
+        // 4 - Position and radius of the light
+        // 5 - Color of the light
+        // 6 - Intensity, linear and quadratic attenuation
+        // 7 - Slot of the shadow map
+        glBindVertexArray(mPointVolume->getVAO());
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)0);
+        glVertexAttribDivisor(4, 1);
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(4 * sizeof(float)));
+        glVertexAttribDivisor(5, 1);
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(7 * sizeof(float)));
+        glVertexAttribDivisor(6, 1);
+        glEnableVertexAttribArray(7);
+        glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(10 * sizeof(float)));
+        glVertexAttribDivisor(7, 1);
+        glBindVertexArray(0);
+
+        // Configure the textures of the G-buffer in the shader
+        mLightVolumeShader.use();
+        mLightVolumeShader.setInt("gPosition", 0);
+        mLightVolumeShader.setInt("gNormal", 1);
+        mLightVolumeShader.setInt("gAlbedoSpec", 2);
+        mLightVolumeShader.setBool("compactGBuffer", mGBufferLayout == GBUFFER_COMPACT);
+        // The shadow maps of the point lights use the first unit after them, 
+        // and the atlas of the spot lights the next one, followed by the same
+        // atlas with the comparison sampler and its moments
+        mLightVolumeShader.setInt("pointShadowMaps", 3);
+        mLightVolumeShader.setInt("spotShadowAtlas", 4);
+        mLightVolumeShader.setInt("spotShadowAtlasCompare", 5);
+        mLightVolumeShader.setInt("spotShadowMoments", 6);
+    }
+
+    // Setup the array of shadow maps of the point lights
+    void DeferredRenderer::setupPointShadowMaps()
+    {
+        if (mPointShadowBudget == 0)
+            return;
+
+        // Array with the six faces of each light in consecutive layers
+        glGenTextures(1, &mPointShadowTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, mPointShadowTexture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, mPointShadowResolution,
+                     mPointShadowResolution, 6 * mPointShadowBudget, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        // The filtering of each face is clamped to its own layer
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // Attach all the layers to the FBO, so the geometry shader selects the
+        // layer of each face
+        glGenFramebuffers(1, &mPointShadowFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, mPointShadowFBO);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mPointShadowTexture, 0);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Method to configure the shadows of the point lights
+    void DeferredRenderer::setPointShadows(unsigned int budget, PointShadowPriority priority, int resolution)
+    {
+        mPointShadowPriority = priority;
+        if (budget == mPointShadowBudget && resolution == mPointShadowResolution)
+            return;
+
+        // Allocate the array again, and remove the slots of the lights
+        glDeleteFramebuffers(1, &mPointShadowFBO);
+        glDeleteTextures(1, &mPointShadowTexture);
+        mPointShadowFBO = 0;
+        mPointShadowTexture = 0;
+        mPointShadowBudget = budget;
+        mPointShadowResolution = resolution;
+        setupPointShadowMaps();
+        for (auto light : mShadowedPointLights)
+            light->setShadowSlot(-1);
+        mShadowedPointLights.clear();
+    }
+
+    // Method to configure the atlas with the shadow maps of the spot lights
+    void DeferredRenderer::setSpotShadowAtlas(int size, int minTileSize)
+    {
+        delete mSpotShadowAtlas;
+        mSpotShadowAtlas = new ShadowAtlas(size, minTileSize);
+    }
+
+    // Method to choose how the cascades of the directional lights are rendered
+    bool DeferredRenderer::setCascadeRenderPath(CascadeRenderPath path)
+    {
+        if (path == CASCADES_VERTEX_LAYER && mShadowMapDirectionalLayerShader == nullptr)
+        {
+            mCascadeRenderPath = CASCADES_GEOMETRY_SHADER;
+            return false;
+        }
+        mCascadeRenderPath = path;
+        return true;
+    }
+
+    // Setup the history buffers of the temporal upscaling
+    void DeferredRenderer::setupHistoryBuffers()
+    {
+        if (!mTemporalUpscaling)
+            return;
+
+        glGenFramebuffers(2, mHistoryBuffers);
+        glGenTextures(2, mHistoryTextures);
+        for (int i = 0; i < 2; ++i)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, mHistoryBuffers[i]);
+            glBindTexture(GL_TEXTURE_2D, mHistoryTextures[i]);
+            // The history has the resolution of the window
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, mWinWidth, mWinHeight, 0, 
+                         GL_RGBA, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 
+                                   mHistoryTextures[i], 0);
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // The new buffers have no result yet
+        mHistoryValid = false;
+    }
+
+    // Delete the FBOs and their attachments
+    void DeferredRenderer::deleteRenderTargets()
+    {
+        glDeleteFramebuffers(1, &mTargetBuffer);
+        glDeleteFramebuffers(1, &mGBuffer);
+        glDeleteFramebuffers(2, mHistoryBuffers);
+        // The textures that are not used are 0, which is ignored
+        unsigned int textures[8] { mGPositionTexture, mGNormalTexture, mGAlbedoSpecTexture,
+                                   mDepthTexture, mTargetTexture, mGVelocityTexture,
+                                   mHistoryTextures[0], mHistoryTextures[1] };
+        glDeleteTextures(8, textures);
+        glDeleteRenderbuffers(1, &mDepthRBO);
+
+        mTargetBuffer = 0;
+        mGBuffer = 0;
+        mGPositionTexture = 0;
+        mGNormalTexture = 0;
+        mGAlbedoSpecTexture = 0;
+        mDepthTexture = 0;
+        mTargetTexture = 0;
+        mDepthRBO = 0;
+        mGVelocityTexture = 0;
+        for (int i = 0; i < 2; ++i)
+        {
+            mHistoryBuffers[i] = 0;
+            mHistoryTextures[i] = 0;
+        }
+    }
+
+    // Method to change the size of the window, reallocating the render targets
+    void DeferredRenderer::setWindowSize(int width, int height)
+    {
+        if (width == mWinWidth && height == mWinHeight)
+            return;
+        mWinWidth = width;
+        mWinHeight = height;
+
+        // Allocate the targets again for the maximum scale
+        deleteRenderTargets();
+        mTargetWidth = std::max(1, (int)(width * mMaxRenderScale));
+        mTargetHeight = std::max(1, (int)(height * mMaxRenderScale));
+        setupGBuffer();
+        setupTargetBuffer();
+        setupHistoryBuffers();
+
+        // Keep the same scale in the new size
+        setRenderScale(mRenderScale);
+    }
+
+    // Method to enable the temporal upscaling
+    void DeferredRenderer::setTemporalUpscaling(bool enabled)
+    {
+        if (enabled == mTemporalUpscaling)
+            return;
+        mTemporalUpscaling = enabled;
+
+        // Allocate the targets again, with or without the motion vectors
+        deleteRenderTargets();
+        setupGBuffer();
+        setupTargetBuffer();
+        setupHistoryBuffers();
+
+        mJitter = glm::vec2(0.f);
+    }
+
+    // Method to change the fraction of the window resolution that is rendered
+    void DeferredRenderer::setRenderScale(float scale)
+    {
+        mRenderScale = glm::clamp(scale, 0.05f, mMaxRenderScale);
+        mRenderWidth = glm::clamp((int)glm::round(mWinWidth * mRenderScale), 1, mTargetWidth);
+        mRenderHeight = glm::clamp((int)glm::round(mWinHeight * mRenderScale), 1, mTargetHeight);
+        configureRenderSize();
+    }
+
+    // Pass the size of the rendered area to the shaders
+    void DeferredRenderer::configureRenderSize()
+    {
+        const glm::vec2 renderSize { (float)mRenderWidth, (float)mRenderHeight };
+        const glm::vec2 gBufferScale { renderSize / glm::vec2(mTargetWidth, mTargetHeight) };
+
+        mLightingPassShader.use();
+        mLightingPassShader.setVec2("gBufferScale", gBufferScale);
+        mLightVolumeShader.use();
+        mLightVolumeShader.setVec2("gBufferScale", gBufferScale);
+        mLightVolumeShader.setVec2("screenSize", renderSize);
+        mScreenShader.use();
+        mScreenShader.setVec2("uvScale", gBufferScale);
+    }
+
+    // Method to enable the dynamic resolution
+    void DeferredRenderer::setDynamicResolution(bool enabled, float targetFrameTimeMs, float minScale)
+    {
+        mDynamicResolution = enabled;
+        if (!enabled)
+        {
+            setRenderScale(mMaxRenderScale);
+            return;
+        }
+
+        if (mResolutionController == nullptr)
+            mResolutionController = new ResolutionController();
+        mResolutionController->setTargetFrameTime(targetFrameTimeMs);
+        mResolutionController->setScaleRange(std::min(minScale, mMaxRenderScale), mMaxRenderScale);
+        mResolutionController->reset();
+        // The queries of the frames in flight are started again
+        mFrameTimeQueryCount = 0;
+        setRenderScale(mResolutionController->getScale());
+    }
+
+    // Read the GPU time of the oldest frame in flight, and update the render
+    // scale with it
+    void DeferredRenderer::updateDynamicResolution()
+    {
+        // Queries of the frame that is about to be reused
+        const unsigned int index { 2 * (mFrameTimeQueryCount % NR_FRAME_TIME_QUERIES) };
+        if (mFrameTimeQueryCount >= NR_FRAME_TIME_QUERIES)
+        {
+            GLuint64 start;
+            GLuint64 end;
+            glGetQueryObjectui64v(mFrameTimeQueries[index], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(mFrameTimeQueries[index + 1], GL_QUERY_RESULT, &end);
+            mGPUFrameTime = (float)((end - start) * 1e-6);
+            setRenderScale(mResolutionController->update(mGPUFrameTime));
+        }
+    }
+
+    // Method to get the number of bytes per pixel of the render targets
+    // (G-buffer, depth and stencil, and lighting target)
+    unsigned int DeferredRenderer::getBytesPerPixel() const
+    {
+        // Depth and stencil use 4 bytes in both layouts
+        // The motion vectors of the temporal upscaling use 4 more, without
+        // counting the history, which has the resolution of the window
+        const unsigned int velocityBytes { mTemporalUpscaling ? 4u : 0u };
+        if (mGBufferLayout == GBUFFER_STANDARD)
+            return 3 * 8 + 4 + 16 + velocityBytes;
+        else
+            return 4 + 4 + 4 + 4 + velocityBytes;
+    }
+
+    // Method to configure a shader of the geometry pass for the layout of
+    // the G-buffer
+    void DeferredRenderer::configureGeometryShader(Shader& shader) const
+    {
+        shader.use();
+        shader.setBool("compactGBuffer", mGBufferLayout == GBUFFER_COMPACT);
+    }
+
+    // Method to pass the view and projection matrices of the camera,
+    // used to draw the light volumes and to build the clusters
+    void DeferredRenderer::setViewProjection(const glm::mat4& view, const glm::mat4& projection)
+    {
+        mView = view;
+        mProjection = projection;
+
+        // The motion vectors are computed without the jitter
+        const glm::mat4 unjitter { glm::translate(glm::mat4(1.f), glm::vec3(-mJitter, 0.f)) };
+        mCurrentViewProjection = unjitter * projection * view;
+    }
+
     // Method to configure the lights in the shader
     void DeferredRenderer::configureLights(const std::vector<Light*> lights)
     {
@@ -191,33 +683,20 @@ namespace GLBase
         unsigned int countSpotLights { 0 };
         unsigned int countPointLights { 0 };
         // Counter for the index of the shadow map
-        // It starts in 3, because the three first ones correspond to the three textures
-        // of the Geometry pass
-        unsigned int countShadowMap { 3 };
+        // It starts in 7, because the three first ones correspond to the three textures
+        // of the Geometry pass, and the next ones to the shadow maps of the point
+        // lights and the atlas of the spot lights, with its comparison sampler
+        // and its moments
+        unsigned int countShadowMap { 7 };
 
         // Pass all the lights to the shader
         mLightingPassShader.use();
         for (auto light : lights)
         {
-            // Check the type of the shader
-            Shader* shadowShader;
-            switch (light->getLightType())
-            {
-                case LIGHT_DIRECTIONAL:
-                    shadowShader = &mShadowMapDirectionalShader;
-                    break;
-                case LIGHT_POINT:
-                    shadowShader = &mShadowMapPointShader;
-                    break;
-                case LIGHT_SPOT:
-                    shadowShader = &mShadowMapSpotShader;
-                    break;
-            }
-
             // This configures the shader for the lighting pass, and also passes
             // a pointer to the corresponding shader for the shadow pass, so it
             // is stored by the light object
-            light->configureShader(mLightingPassShader, shadowShader, countDirLights, 
+            light->configureShader(mLightingPassShader, getShadowShader(light), countDirLights, 
                                    countSpotLights, countPointLights, countShadowMap);
         }
 
@@ -227,6 +706,50 @@ namespace GLBase
         mLightingPassShader.setInt("nrPointLights", countPointLights);
     }
 
+    // Method to get the shader of the shadow pass for the type of a light
+    Shader* DeferredRenderer::getShadowShader(Light* light)
+    {
+        switch (light->getLightType())
+        {
+            case LIGHT_POINT:
+                return &mShadowMapPointShader;
+            case LIGHT_SPOT:
+                return &mShadowMapSpotShader;
+            default:
+                return &mShadowMapDirectionalShader;
+        }
+    }
+
+    // Method to cull the point and spot lights, and apply the budgets
+    void DeferredRenderer::updateLightVisibility(const std::vector<Light*>& lights)
+    {
+        if (mLightVisibility == nullptr)
+            mLightVisibility = new LightVisibility();
+        mLightVisibility->update(lights, mView, mProjection);
+    }
+
+    // Method to set the budgets of the point and spot lights
+    void DeferredRenderer::setLightBudgets(unsigned int maxShadedLights, unsigned int maxShadowedLights,
+                                           unsigned int fadeFrames)
+    {
+        if (mLightVisibility == nullptr)
+            mLightVisibility = new LightVisibility();
+        mLightVisibility->setBudgets(maxShadedLights, maxShadowedLights);
+        mLightVisibility->setFadeFrames(fadeFrames);
+    }
+
+    // Method to get the factor of the color of a light in this frame
+    float DeferredRenderer::getLightFade(Light* light) const
+    {
+        return mLightVisibility == nullptr ? 1.f : mLightVisibility->getFade(light);
+    }
+
+    // Method to check if a light can cast a shadow in this frame
+    bool DeferredRenderer::isLightShadowed(Light* light) const
+    {
+        return mLightVisibility == nullptr || mLightVisibility->isShadowed(light);
+    }
+
     // Method to call at the beginning of the frame
     void DeferredRenderer::startFrame()
     {
@@ -235,6 +758,24 @@ namespace GLBase
         // of the frametime
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Measure the frame for the dynamic resolution
+        if (mDynamicResolution)
+        {
+            updateDynamicResolution();
+            glQueryCounter(mFrameTimeQueries[2 * (mFrameTimeQueryCount % NR_FRAME_TIME_QUERIES)], 
+                           GL_TIMESTAMP);
+        }
+
+        // Jitter of this frame, following the Halton sequence in bases 2 and 3,
+        // with an offset of up to half a pixel of the render resolution
+        if (mTemporalUpscaling)
+        {
+            const unsigned int index { (mFrameIndex % 8) + 1 };
+            const glm::vec2 offset { GLUtils::getHaltonSequence(index, 2) - 0.5f,
+                                     GLUtils::getHaltonSequence(index, 3) - 0.5f };
+            mJitter = 2.f * offset / glm::vec2(mRenderWidth, mRenderHeight);
+        }
     }
 
     // Method to compute the shadow maps
@@ -246,15 +787,115 @@ namespace GLBase
         // glCullFace(GL_FRONT);
 
         // Compute the shadow map for each light in the provided list
+        // The point lights are computed after, only the ones in the budget,
+        // and the spot lights are rendered to the atlas
+        std::vector<PointLight*> pointLights;
+        std::vector<SpotLight*> spotLights;
+        // The point and spot lights out of the budget of shadows are skipped,
+        // and the ones of the atlas lose their tile
         for (auto light : lightsWithShadow)
         {
-            light->computeShadowMap(camera, objectsWithShadow);
+            if (light->getLightType() != LIGHT_DIRECTIONAL && !isLightShadowed(light))
+            {
+                if (light->getLightType() == LIGHT_SPOT)
+                    static_cast<SpotLight*>(light)->setShadowTile(glm::ivec4(0), mSpotShadowAtlas->getSize());
+                continue;
+            }
+            if (light->getLightType() == LIGHT_POINT)
+                pointLights.push_back(static_cast<PointLight*>(light));
+            else if (light->getLightType() == LIGHT_SPOT)
+                spotLights.push_back(static_cast<SpotLight*>(light));
+            else
+            {
+                // Render the cascades with the path chosen
+                DirectionalLight* dirLight { static_cast<DirectionalLight*>(light) };
+                if (mCascadeRenderPath == CASCADES_VERTEX_LAYER)
+                    dirLight->setCascadeShadowShader(mShadowMapDirectionalLayerShader, true);
+                else
+                    dirLight->setCascadeShadowShader(&mShadowMapDirectionalShader, false);
+                // Place the cascades in the visible range, if there is any
+                float zMin;
+                float zMax;
+                if (mCascadeSplitMode != CASCADE_SPLITS_FIXED && getVisibleDepthRange(zMin, zMax))
+                    dirLight->setVisibleDepthRange(zMin, zMax);
+                else
+                    dirLight->resetVisibleDepthRange();
+                dirLight->computeShadowMap(camera, objectsWithShadow);
+                dirLight->filterShadowMap(*mShadowMomentsFilter);
+            }
+        }
+
+        // Assign the tiles of the atlas to the spot lights, and render the
+        // ones that changed
+        mSpotShadowAtlas->update(camera, spotLights, objectsWithShadow, mView, mProjection, mRenderHeight,
+                                 *mShadowMomentsFilter);
+
+        // Choose the point lights with shadows, and render them to their
+        // slots of the array, cleared once for all of them
+        assignPointShadowSlots(camera, pointLights);
+        if (!mShadowedPointLights.empty())
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, mPointShadowFBO);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            for (auto light : mShadowedPointLights)
+                light->computeShadowMap(camera, objectsWithShadow);
         }
 
         // Restore face culling
         // glCullFace(GL_BACK);
     }
 
+    // Method to choose the point lights with shadows in this frame, and assign
+    // them the slots of the array
+    // Only the lights whose volume intersects the view frustum can shadow a
+    // visible pixel. With the coverage priority, the area of the screen covered
+    // by the volume is estimated from the radius of its projection
+    void DeferredRenderer::assignPointShadowSlots(const Camera& camera,
+                                                  const std::vector<PointLight*>& pointLights)
+    {
+        // Remove the slots of the last frame
+        for (auto light : mShadowedPointLights)
+            light->setShadowSlot(-1);
+        mShadowedPointLights.clear();
+        if (mPointShadowBudget == 0)
+            return;
+
+        glm::vec4 frustumPlanes[6];
+        GLUtils::getFrustumPlanes(mProjection * mView, frustumPlanes);
+
+        // Priority of each light in the frustum, higher first
+        std::vector<std::pair<float, PointLight*>> candidates;
+        for (auto light : pointLights)
+        {
+            const float radius { light->getRadiusMax() };
+            if (!GLUtils::sphereInFrustum(frustumPlanes, light->getPosition(), radius))
+                continue;
+
+            const float distance { glm::length(light->getPosition() - camera.Position) };
+            float priority;
+            if (mPointShadowPriority == POINT_SHADOW_NEAREST)
+                priority = -distance;
+            else if (distance <= radius)
+                priority = std::numeric_limits<float>::max();
+            else
+                priority = GLUtils::getSphereScreenCoverage(light->getPosition(), radius, camera.Position,
+                                                            mProjection);
+            candidates.push_back({ priority, light });
+        }
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const std::pair<float, PointLight*>& a, const std::pair<float, PointLight*>& b)
+                         { return a.first > b.first; });
+
+        // Assign the slots to the first ones
+        const unsigned int count { std::min(mPointShadowBudget, (unsigned int)candidates.size()) };
+        for (unsigned int slot = 0; slot < count; ++slot)
+        {
+            PointLight* light { candidates[slot].second };
+            light->setShadowSlot((int)slot, mPointShadowFBO, mPointShadowTexture, mPointShadowResolution);
+            mShadowedPointLights.push_back(light);
+        }
+    }
+
     // Method to call to start the geometry pass
     void DeferredRenderer::startGeometryPass()
     {
@@ -277,6 +918,28 @@ namespace GLBase
 
         glEnable(GL_STENCIL_TEST);
         glStencilFunc(GL_ALWAYS, 1, 0xFF); // All fragments should pass the stencil test
+
+        // The pixels without geometry have no motion, and pass the matrices for
+        // the motion vectors to the shaders
+        if (mTemporalUpscaling)
+        {
+            const float zeroVelocity[4] { 0.f, 0.f, 0.f, 0.f };
+            glClearBufferfv(GL_COLOR, 3, zeroVelocity);
+
+            // In the first frame there is no previous one
+            if (!mHistoryValid)
+                mPreviousViewProjection = mCurrentViewProjection;
+            glBindBuffer(GL_UNIFORM_BUFFER, mTemporalMatricesUBO);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(glm::mat4), glm::value_ptr(mCurrentViewProjection));
+            glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), 
+                            glm::value_ptr(mPreviousViewProjection));
+            RenderStats::add(RENDER_STAT_BYTES_UPLOADED, 2 * sizeof(glm::mat4));
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+
+        // Convert the albedo to sRGB when writing it to the compact G-buffer
+        if (mGBufferLayout == GBUFFER_COMPACT)
+            glEnable(GL_FRAMEBUFFER_SRGB);
     }
 
     // Configure the lights for the lighting pass
@@ -287,31 +950,112 @@ namespace GLBase
         unsigned int countSpotLights { 0 };
         unsigned int countPointLights { 0 };
         // Counter for the index of the shadow map
-        // It starts in 3, because the three first ones correspond to the three textures
-        // of the Geometry pass
-        unsigned int countShadowMap { 3 };
+        // It starts in 7, because the three first ones correspond to the three textures
+        // of the Geometry pass, and the next ones to the shadow maps of the point
+        // lights and the atlas of the spot lights, with its comparison sampler
+        // and its moments
+        unsigned int countShadowMap { 7 };
 
         // Pass all the lights to the shader
         mLightingPassShader.use();
         for (auto light : lights)
         {
+            // The clustered point lights do not need anything from the arrays
+            // of the shader
+            if (mLightingMode == LIGHTING_CLUSTERED && light->getLightType() == LIGHT_POINT)
+                continue;
+
+            // The lights culled or out of the budget are skipped, so the point
+            // and spot lights take the first free elements of the arrays, and
+            // their properties are passed again, with the color faded
+            const float fade { getLightFade(light) };
+            if (fade == 0.f)
+                continue;
+            if (mLightVisibility != nullptr && light->getLightType() != LIGHT_DIRECTIONAL)
+            {
+                unsigned int indexDirectional { countDirLights };
+                unsigned int indexSpot { countSpotLights };
+                unsigned int indexPoint { countPointLights };
+                unsigned int indexShadow { countShadowMap };
+                light->configureShader(mLightingPassShader, getShadowShader(light), indexDirectional,
+                                       indexSpot, indexPoint, indexShadow);
+                mLightingPassShader.setVec3(Light::getUniformName(light->getLightType(),
+                                                light->getLightType() == LIGHT_POINT ? countPointLights
+                                                                                     : countSpotLights,
+                                                "color"), fade * light->getColor());
+            }
+
+            // Each directional light binds its shadow maps to three texture
+            // units, which must not reach the ones of the clusters
+            if (light->getLightType() == LIGHT_DIRECTIONAL && countShadowMap + 3 > mClusterTextureUnit)
+            {
+                if (!mTextureUnitsExhausted)
+                {
+                    std::cout << "ERROR::DEFERRED_RENDERER::NOT_ENOUGH_TEXTURE_UNITS\n"
+                              << "The directional lights after the first " << countDirLights
+                              << " are not drawn, since their shadow maps need more than the "
+                              << mClusterTextureUnit << " texture units available.\n";
+                    mTextureUnitsExhausted = true;
+                }
+                continue;
+            }
+
             light->configureShaderForLightingPass(mLightingPassShader, countDirLights, countSpotLights, 
                                    countPointLights, countShadowMap);
         }
+        mShadowTextureUnitsEnd = countShadowMap;
 
         // Pass the count of each type of light to the shader
+        // When drawing the light volumes or using the clusters, the screen quad
+        // only computes the ambient and directional lighting from the arrays
+        if (mLightingMode != LIGHTING_FULLSCREEN)
+        {
+            countSpotLights = 0;
+            countPointLights = 0;
+        }
         mLightingPassShader.setInt("nrDirLights", countDirLights);
         mLightingPassShader.setInt("nrSpotLights", countSpotLights);
         mLightingPassShader.setInt("nrPointLights", countPointLights);
     }
 
+    // Method to get the range of distances to the camera of the visible pixels
+    bool DeferredRenderer::getVisibleDepthRange(float& zMin, float& zMax) const
+    {
+        return mDepthRangeReducer != nullptr && mDepthRangeReducer->getRange(zMin, zMax);
+    }
+
     // Method to do the shading pass with the information in the g-buffer
     void DeferredRenderer::processGBuffer(glm::vec3 viewPos, const std::vector<Light*> lights)
     {
+        // Reduce the depth of the G-buffer to its range, for the cascades of
+        // the next frame
+        if (mCascadeSplitMode != CASCADE_SPLITS_FIXED)
+        {
+            GPUProfileScope scope(mGPUProfiler, "Depth range");
+            if (mDepthRangeReducer == nullptr)
+                mDepthRangeReducer = new DepthRangeReducer();
+            mDepthRangeReducer->reduce(mGBufferLayout == GBUFFER_STANDARD ? mGPositionTexture : mDepthTexture,
+                                       mGBufferLayout == GBUFFER_COMPACT, mRenderWidth, mRenderHeight,
+                                       mView, mProjection, mCascadeSplitMode == CASCADE_SPLITS_SDSM);
+            glViewport(0, 0, mRenderWidth, mRenderHeight);
+        }
+
+        // With the compact layout, copy the depth and stencil of the geometry
+        // pass to the target FBO, which does not share them
+        if (mGBufferLayout == GBUFFER_COMPACT)
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, mGBuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mTargetBuffer);
+            glBlitFramebuffer(0, 0, mRenderWidth, mRenderHeight,
+                              0, 0, mRenderWidth, mRenderHeight,
+                              GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT, GL_NEAREST);
+        }
+
         // Bind the lower resolution FBO, and clear it 
         // glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mTargetBuffer);
         // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glBindFramebuffer(GL_FRAMEBUFFER, mTargetBuffer);
+        glDisable(GL_FRAMEBUFFER_SRGB);
         glClear(GL_COLOR_BUFFER_BIT);
 
         // // Enable additive blending, for drawing the differnt light contributions
@@ -328,59 +1072,427 @@ namespace GLBase
         mLightingPassShader.use();
         mLightingPassShader.setVec3("viewPos", viewPos);
         // Bind the textures from the geometry pass
+        // With the compact layout the position is reconstructed from the depth
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, mGPositionTexture);
+        if (mGBufferLayout == GBUFFER_STANDARD)
+            glBindTexture(GL_TEXTURE_2D, mGPositionTexture);
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, mDepthTexture);
+            mLightingPassShader.setMat4("invViewProjection", glm::inverse(mProjection * mView));
+        }
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_2D, mGNormalTexture);
         glActiveTexture(GL_TEXTURE2);
         glBindTexture(GL_TEXTURE_2D, mGAlbedoSpecTexture);
         // glBindTexture(GL_TEXTURE_2D, mDepthRBO);
+        // Bind the shadow maps of the point lights
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, mPointShadowTexture);
+        // Bind the atlas of the spot lights
+        mSpotShadowAtlas->bindTextures(4);
         // Configure the lights
         configureLightsForLightingPass(lights);
+        mLightingPassShader.setBool("clusteredLights", mLightingMode == LIGHTING_CLUSTERED);
+        if (mLightingMode == LIGHTING_CLUSTERED)
+            configureClusteredLights(lights);
         // Draw the screen quad, performing the lighting calculations
         glBindVertexArray(mScreenVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        RenderStats::addDraw(GL_TRIANGLES, 6);
         // Enable depth testing again
         glEnable(GL_DEPTH_TEST);
+        // Add the contribution of the point and spot lights, with the stencil
+        // test still enabled
+        if (mLightingMode == LIGHTING_VOLUMES)
+            renderLightVolumes(viewPos, lights);
         // Disable stencil testing
         glDisable(GL_STENCIL_TEST);
+        // Unbind the comparison samplers, so they do not change how other
+        // textures bound to those units are sampled
+        for (unsigned int unit = 5; unit < mShadowTextureUnitsEnd; ++unit)
+            glBindSampler(unit, 0);
     }
 
-    // Method to call at the end of the frame
-    void DeferredRenderer::endFrame(GLGeometry::GLCubemap* skyMap)
-    // void DeferredRenderer::endFrame(GLGeometry::GLCubemap* skyMap, GLGeometry::GLAuxElements auxElements)
+    // Method to assign the point and spot lights to the clusters, and
+    // configure them in the lighting shader
+    void DeferredRenderer::configureClusteredLights(const std::vector<Light*> lights)
     {
-        // glDepthMask(GL_FALSE);
-        // Enable stencil testing for drawing the skymap
-        glEnable(GL_STENCIL_TEST);
-        // The skymap will be drawn where there is no geometry
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        glStencilMask(0x00); // Disable writing to the stencil buffer
-        // Draw the skymap
-        skyMap->drawFlat();
-        // skyMap->draw(); // If the skymap has textures
-        // glDepthMask(GL_TRUE);
+        if (mClusteredLights == nullptr)
+            mClusteredLights = new ClusteredLights();
 
-        // Change the viewport to the full resolution
-        glViewport(0, 0, mWinWidth, mWinHeight);
-        // Bind the default framebuffer
-        // It was already cleared in startFrame()
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, mTargetBuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        // glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        // Disable depth testing to draw the screen quad
+        // Collect the point and spot lights
+        mClusterLights.clear();
+        mClusterSpotMatrices.clear();
+        mClusterSpotShadowRects.clear();
+        mClusterSpotShadowFilters.clear();
+        for (auto light : lights)
+        {
+            // The lights culled or out of the budget are skipped
+            const float fade { getLightFade(light) };
+            if (fade == 0.f)
+                continue;
+
+            ClusterLight clusterLight;
+            clusterLight.position = light->getPosition();
+            clusterLight.color = fade * light->getColor();
+            clusterLight.intensity = light->getIntensity();
+            clusterLight.kLinear = light->getAttenLinear();
+            clusterLight.kQuadratic = light->getAttenQuadratic();
+            switch (light->getLightType())
+            {
+                case LIGHT_POINT:
+                {
+                    PointLight* pointLight { static_cast<PointLight*>(light) };
+                    clusterLight.radius = pointLight->getRadiusMax();
+                    clusterLight.cosAngleInner = -1.f;
+                    clusterLight.cosAngleOuter = -1.f;
+                    clusterLight.direction = glm::vec3(0.f, -1.f, 0.f);
+                    clusterLight.spotIndex = -1;
+                    clusterLight.shadowSlot = pointLight->getShadowSlot();
+                    break;
+                }
+                case LIGHT_SPOT:
+                {
+                    SpotLight* spotLight { static_cast<SpotLight*>(light) };
+                    clusterLight.radius = spotLight->getRadiusMax();
+                    clusterLight.cosAngleInner = spotLight->getCosAngleInner();
+                    clusterLight.cosAngleOuter = spotLight->getCosAngleOuter();
+                    clusterLight.direction = spotLight->getDirection();
+                    clusterLight.spotIndex = (int)mClusterSpotMatrices.size();
+                    clusterLight.shadowSlot = -1;
+                    mClusterSpotMatrices.push_back(spotLight->getLightSpaceMatrix());
+                    mClusterSpotShadowRects.push_back(spotLight->getShadowAtlasRect());
+                    mClusterSpotShadowFilters.push_back((int)spotLight->getShadowFilter());
+                    break;
+                }
+                default:
+                    continue;
+            }
+            mClusterLights.push_back(clusterLight);
+        }
+
+        // Assign them to the clusters, and pass the result to the shader
+        mClusteredLights->assignLights(mView, mProjection, mClusterLights);
+        mClusteredLights->upload(mClusterLights, mClusterSpotMatrices, mClusterSpotShadowRects,
+                                 mClusterSpotShadowFilters);
+        mClusteredLights->configureShader(mLightingPassShader, mClusterTextureUnit);
+        mLightingPassShader.setMat4("view", mView);
+    }
+
+    // Method to add the contribution of the point and spot lights by
+    // drawing their volumes
+    // The depth buffer of the geometry pass is shared with the target FBO, so 
+    // the faces of the volumes are tested against the geometry of the scene:
+    //  - If the camera is outside of a volume, its front faces are drawn where 
+    //    they are in front of the geometry.
+    //  - If the camera is inside of a volume, its back faces are drawn where 
+    //    they are behind the geometry.
+    // The stencil test still discards the pixels without geometry.
+    void DeferredRenderer::renderLightVolumes(glm::vec3 viewPos, const std::vector<Light*> lights)
+    {
+        // Distance from the camera to the corners of the near plane, to decide
+        // when the camera is inside of a volume
+        const float near { mProjection[3][2] / (mProjection[2][2] - 1.f) };
+        const float tanHalfX { 1.f / mProjection[0][0] };
+        const float tanHalfY { 1.f / mProjection[1][1] };
+        const float margin { 1.1f * near * glm::sqrt(1.f + tanHalfX * tanHalfX + tanHalfY * tanHalfY) };
+
+        // Scale of the meshes so they contain the volume of the lights, since
+        // their faces are inside of the sphere and the cone with the same size
+        const float pointVolumeScale { 1.f / glm::pow(glm::cos(glm::pi<float>() / mPointVolume->getNrVertices()), 2.f) };
+        const float spotVolumeScale { 1.f / glm::cos(glm::pi<float>() / mSpotVolume->getNrVertices()) };
+
+        // Enable additive blending, to add the contribution of each light
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_ONE, GL_ONE);
+        // Do not write to the depth buffer of the geometry pass
+        glDepthMask(GL_FALSE);
+        // Do not clip the volumes with the near and far planes
+        glEnable(GL_DEPTH_CLAMP);
+
+        mLightVolumeShader.use();
+        mLightVolumeShader.setVec3("viewPos", viewPos);
+        mLightVolumeShader.setMat4("view", mView);
+        mLightVolumeShader.setMat4("projection", mProjection);
+        if (mGBufferLayout == GBUFFER_COMPACT)
+            mLightVolumeShader.setMat4("invViewProjection", glm::inverse(mProjection * mView));
+        // Bind the shadow maps of the point lights, and the atlas of the spot
+        // lights
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, mPointShadowTexture);
+        mSpotShadowAtlas->bindTextures(4);
+
+        // Point lights
+        // ------------------------------
+        // Fill the per-instance data, with the lights with the camera outside 
+        // of their volume first
+        mPointVolumeInstanceData.clear();
+        unsigned int countOutside { 0 };
+        std::vector<PointLight*> pointLightsInside;
+        for (auto light : lights)
+        {
+            if (light->getLightType() != LIGHT_POINT || getLightFade(light) == 0.f)
+                continue;
+            PointLight* pointLight { static_cast<PointLight*>(light) };
+            if (glm::length(viewPos - pointLight->getPosition()) 
+                    < pointVolumeScale * pointLight->getRadiusMax() + margin)
+            {
+                pointLightsInside.push_back(pointLight);
+                continue;
+            }
+            addPointVolumeInstance(pointLight, getLightFade(pointLight));
+            ++countOutside;
+        }
+        for (auto pointLight : pointLightsInside)
+            addPointVolumeInstance(pointLight, getLightFade(pointLight));
+        const unsigned int countPoint { (unsigned int)mPointVolumeInstanceData.size() / 11 };
+
+        if (countPoint > 0)
+        {
+            // Upload the data, growing the buffer if needed
+            glBindBuffer(GL_ARRAY_BUFFER, mPointVolumeInstanceVBO);
+            if (countPoint > mPointVolumeInstanceCapacity)
+            {
+                mPointVolumeInstanceCapacity = countPoint;
+                glBufferData(GL_ARRAY_BUFFER, mPointVolumeInstanceData.size() * sizeof(float), 
+                             &mPointVolumeInstanceData[0], GL_STREAM_DRAW);
+            }
+            else
+                glBufferSubData(GL_ARRAY_BUFFER, 0, mPointVolumeInstanceData.size() * sizeof(float),
+                                &mPointVolumeInstanceData[0]);
+            RenderStats::add(RENDER_STAT_BYTES_UPLOADED, mPointVolumeInstanceData.size() * sizeof(float));
+
+            mLightVolumeShader.setBool("pointLightVolumes", true);
+            mLightVolumeShader.setFloat("sphereScale", 2.f * pointVolumeScale);
+
+            // Lights with the camera outside of their volume
+            if (countOutside > 0)
+            {
+                glCullFace(GL_BACK);
+                glDepthFunc(GL_LEQUAL);
+                setPointVolumeInstanceOffset(0);
+                mPointVolume->drawInstanced(countOutside);
+            }
+            // Lights with the camera inside of their volume
+            // The first instance is selected with the offset of the attributes
+            if (countPoint > countOutside)
+            {
+                glCullFace(GL_FRONT);
+                glDepthFunc(GL_GEQUAL);
+                setPointVolumeInstanceOffset(countOutside);
+                mPointVolume->drawInstanced(countPoint - countOutside);
+            }
+        }
+
+        // Spot lights
+        // ------------------------------
+        mLightVolumeShader.setBool("pointLightVolumes", false);
+        for (auto light : lights)
+        {
+            const float fade { getLightFade(light) };
+            if (light->getLightType() != LIGHT_SPOT || fade == 0.f)
+                continue;
+            SpotLight* spotLight { static_cast<SpotLight*>(light) };
+
+            const glm::vec3 position { spotLight->getPosition() };
+            const float radius { spotLight->getRadiusMax() };
+            const float halfAngle { 0.5f * spotLight->getAngleOuter() };
+
+            glm::mat4 model;
+            // Radius of the sphere containing the volume, centered at the light
+            float radiusBounding;
+            if (halfAngle < glm::radians(75.f))
+            {
+                // Cone with the cusp in the light, pointing in its direction
+                const float radiusBase { spotVolumeScale * radius * glm::tan(halfAngle) };
+                radiusBounding = glm::sqrt(radius * radius + radiusBase * radiusBase);
+
+                // Orthonormal basis with the y axis opposite to the light direction
+                const glm::vec3 yAxis { -spotLight->getDirection() };
+                glm::vec3 helper { 0.f, 0.f, 1.f };
+                if (glm::abs(glm::dot(helper, yAxis)) > 0.99f)
+                    helper = glm::vec3(1.f, 0.f, 0.f);
+                const glm::vec3 xAxis { glm::normalize(glm::cross(helper, yAxis)) };
+                const glm::vec3 zAxis { glm::cross(xAxis, yAxis) };
+
+                model = glm::translate(glm::mat4(1.f), position);
+                model = model * glm::mat4(glm::vec4(xAxis, 0.f), glm::vec4(yAxis, 0.f),
+                                          glm::vec4(zAxis, 0.f), glm::vec4(0.f, 0.f, 0.f, 1.f));
+                model = glm::scale(model, glm::vec3(2.f * radiusBase, radius, 2.f * radiusBase));
+                // Move the cusp of the cone to the origin
+                model = glm::translate(model, glm::vec3(0.f, -0.5f, 0.f));
+            }
+            else
+            {
+                // For very wide lights the cone is not much smaller than a sphere
+                radiusBounding = pointVolumeScale * radius;
+                model = glm::translate(glm::mat4(1.f), position);
+                model = glm::scale(model, glm::vec3(2.f * radiusBounding));
+            }
+
+            if (glm::length(viewPos - position) < radiusBounding + margin)
+            {
+                glCullFace(GL_FRONT);
+                glDepthFunc(GL_GEQUAL);
+            }
+            else
+            {
+                glCullFace(GL_BACK);
+                glDepthFunc(GL_LEQUAL);
+            }
+
+            // The shadow map uses the texture unit after the ones of the
+            // G-buffer and the shadow maps of the point lights
+            spotLight->configureShaderForLightVolume(mLightVolumeShader);
+            mLightVolumeShader.setVec3("spotLight.color", fade * spotLight->getColor());
+            mLightVolumeShader.setMat4("model", model);
+            if (halfAngle < glm::radians(75.f))
+                mSpotVolume->draw();
+            else
+                mPointVolume->draw();
+        }
+
+        // Restore the state
+        glCullFace(GL_BACK);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_DEPTH_CLAMP);
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
+    }
+
+    // Method to accumulate the frame in the history, and draw the result to the
+    // screen
+    void DeferredRenderer::resolveTemporal()
+    {
+        const unsigned int nextIndex { 1 - mHistoryIndex };
+
+        // Accumulate the frame in the history buffer that was not used last
+        glBindFramebuffer(GL_FRAMEBUFFER, mHistoryBuffers[nextIndex]);
         glDisable(GL_DEPTH_TEST);
-        // Bind the texture attachment of the render FBO, and setup the shader
+        glDisable(GL_STENCIL_TEST);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, mTargetTexture);
-        // Draw the screen quad
-        mScreenShader.use();
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, mGVelocityTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, mHistoryTextures[mHistoryIndex]);
+        mTemporalResolveShader.use();
+        mTemporalResolveShader.setVec2("uvScale", glm::vec2(mRenderWidth, mRenderHeight) 
+                                                  / glm::vec2(mTargetWidth, mTargetHeight));
+        // The jitter in texture coordinates is half of the one in NDC
+        mTemporalResolveShader.setVec2("jitter", 0.5f * mJitter);
+        mTemporalResolveShader.setBool("historyValid", mHistoryValid);
         glBindVertexArray(mScreenVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
-        // Enable depth testing again
+        RenderStats::addDraw(GL_TRIANGLES, 6);
+
+        // Draw the result to the screen
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mHistoryTextures[nextIndex]);
+        mScreenShader.use();
+        mScreenShader.setVec2("uvScale", glm::vec2(1.f));
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        RenderStats::addDraw(GL_TRIANGLES, 6);
+        // Restore the scale of the rendered area in the shader
+        mScreenShader.setVec2("uvScale", glm::vec2(mRenderWidth, mRenderHeight) 
+                                         / glm::vec2(mTargetWidth, mTargetHeight));
         glEnable(GL_DEPTH_TEST);
-        // Disable stencil testing
-        // glDisable(GL_STENCIL_TEST);
+
+        // The matrices of this frame are the previous ones of the next
+        mHistoryIndex = nextIndex;
+        mHistoryValid = true;
+        mPreviousViewProjection = mCurrentViewProjection;
+        ++mFrameIndex;
+    }
+
+    // Method to add the per-instance data of a point light to the buffer of
+    // the light volumes, with its color multiplied by a factor
+    void DeferredRenderer::addPointVolumeInstance(PointLight* light, float fade)
+    {
+        const glm::vec3 position { light->getPosition() };
+        const glm::vec3 color { fade * light->getColor() };
+        mPointVolumeInstanceData.insert(mPointVolumeInstanceData.end(), {
+            position.x, position.y, position.z, light->getRadiusMax(),
+            color.r, color.g, color.b,
+            light->getIntensity(), light->getAttenLinear(), light->getAttenQuadratic(),
+            (float)light->getShadowSlot() });
+    }
+
+    // Method to set the first instance used from the buffer of the light volumes,
+    // by changing the offset of the per-instance attributes
+    void DeferredRenderer::setPointVolumeInstanceOffset(unsigned int firstInstance)
+    {
+        const size_t offset { firstInstance * 11 * sizeof(float) };
+        glBindVertexArray(mPointVolume->getVAO());
+        glBindBuffer(GL_ARRAY_BUFFER, mPointVolumeInstanceVBO);
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)offset);
+        glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(offset + 4 * sizeof(float)));
+        glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(offset + 7 * sizeof(float)));
+        glVertexAttribPointer(7, 1, GL_FLOAT, GL_FALSE, 11 * sizeof(float), (void*)(offset + 10 * sizeof(float)));
+        glBindVertexArray(0);
+    }
+
+    // Method to call at the end of the frame
+    void DeferredRenderer::endFrame(GLGeometry::GLCubemap* skyMap)
+    // void DeferredRenderer::endFrame(GLGeometry::GLCubemap* skyMap, GLGeometry::GLAuxElements auxElements)
+    {
+        {
+            GPUProfileScope scope(mGPUProfiler, "Sky");
+            // glDepthMask(GL_FALSE);
+            // Enable stencil testing for drawing the skymap
+            glEnable(GL_STENCIL_TEST);
+            // The skymap will be drawn where there is no geometry
+            glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+            glStencilMask(0x00); // Disable writing to the stencil buffer
+            // Draw the skymap
+            skyMap->drawFlat();
+            // skyMap->draw(); // If the skymap has textures
+            // glDepthMask(GL_TRUE);
+        }
+
+        GPUProfileScope scope(mGPUProfiler, "Composite");
+
+        // Change the viewport to the full resolution
+        glViewport(0, 0, mWinWidth, mWinHeight);
+
+        // With the temporal upscaling, the frame is accumulated in the history,
+        // which is drawn to the screen instead
+        if (mTemporalUpscaling)
+            resolveTemporal();
+        else
+        {
+            // Bind the default framebuffer
+            // It was already cleared in startFrame()
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, mTargetBuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            // glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // Disable depth testing to draw the screen quad
+            glDisable(GL_DEPTH_TEST);
+            // Bind the texture attachment of the render FBO, and setup the shader
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, mTargetTexture);
+            // Draw the screen quad
+            mScreenShader.use();
+            glBindVertexArray(mScreenVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+            RenderStats::addDraw(GL_TRIANGLES, 6);
+            // Enable depth testing again
+            glEnable(GL_DEPTH_TEST);
+            // Disable stencil testing
+            // glDisable(GL_STENCIL_TEST);
+        }
+
+        // End the measure of the frame, in both paths so that the dynamic
+        // resolution also works with the temporal upscaling
+        if (mDynamicResolution)
+        {
+            glQueryCounter(mFrameTimeQueries[2 * (mFrameTimeQueryCount % NR_FRAME_TIME_QUERIES) + 1],
+                           GL_TIMESTAMP);
+            ++mFrameTimeQueryCount;
+        }
 
         // // Copy the depth information from the g-buffer to the default buffer
         // // before drawing the skymap
@@ -4,9 +4,84 @@
 #include "GLBase.h"
 #include "GLGeometry.h"
 
+namespace GLGeometry
+{
+    class GLSphere;
+    class GLCone;
+}
+
 namespace GLBase
 {
     class Light;
+    class PointLight;
+    class SpotLight;
+    class ShadowAtlas;
+    class ShadowMomentsFilter;
+    class DepthRangeReducer;
+    class LightVisibility;
+    class GPUProfiler;
+    class ClusteredLights;
+    struct ClusterLight;
+    class ResolutionController;
+
+    // Enum for the layouts of the G-buffer
+    enum GBufferLayout
+    {
+        // Position, normal, and albedo with specular in three RGBA16F textures,
+        // with a RGBA32F target for the lighting
+        GBUFFER_STANDARD,
+        // Position reconstructed from the depth buffer, octahedral normal in
+        // RG16, albedo with specular in SRGB8_ALPHA8, and a R11F_G11F_B10F target
+        GBUFFER_COMPACT
+    };
+
+    // Enum for the ways of rendering the cascades of the directional lights
+    // to the layers of their shadow maps
+    enum CascadeRenderPath
+    {
+        // A geometry shader copies each triangle to the layers of the cascades
+        CASCADES_GEOMETRY_SHADER,
+        // Each cascade is an instance of the object, and the vertex shader
+        // writes its layer. This needs ARB_shader_viewport_layer_array or
+        // AMD_vertex_shader_layer
+        CASCADES_VERTEX_LAYER
+    };
+
+    // Enum for the ways of placing the cascades of the directional lights
+    enum CascadeSplitMode
+    {
+        // Between the near and far planes of the camera
+        CASCADE_SPLITS_FIXED,
+        // In the range of depth of the visible pixels, reduced in the GPU and
+        // read back without waiting, usually with the one of the last frame
+        CASCADE_SPLITS_SDSM,
+        // In the range of depth of the visible pixels, with the last steps of
+        // the reduction in the CPU, waiting for the G-buffer of the last frame
+        CASCADE_SPLITS_SDSM_CPU
+    };
+
+    // Enum for the different ways of computing the lighting pass
+    enum LightingMode
+    {
+        // All lights are computed in a single screen quad
+        LIGHTING_FULLSCREEN,
+        // Point and spot lights are computed only in the pixels covered by
+        // their volumes, drawn with additive blending
+        LIGHTING_VOLUMES,
+        // Point and spot lights are assigned to the clusters of the frustum, and
+        // the screen quad only computes the lights in the cluster of each pixel
+        LIGHTING_CLUSTERED
+    };
+
+    // Enum for the ways of choosing the point lights with shadows, when there
+    // are more than the budget
+    enum PointShadowPriority
+    {
+        // The lights nearest to the camera
+        POINT_SHADOW_NEAREST,
+        // The lights whose volume covers the largest area of the screen
+        POINT_SHADOW_COVERAGE
+    };
 
     class DeferredRenderer
     {
@@ -14,7 +89,11 @@ namespace GLBase
             // Constructor
             // The scaling variable is the relation between the rendering resolution
             // and teh viewport resolution
-            DeferredRenderer(int width, int height, float scaling = 1.f);
+            // The render targets are allocated with this resolution, which is
+            // the maximum one when the render scale changes
+            // The layout of the G-buffer cannot be changed after construction
+            DeferredRenderer(int width, int height, float scaling = 1.f,
+                             GBufferLayout layout = GBUFFER_STANDARD);
 
             // Destructor
             ~DeferredRenderer();
@@ -25,6 +104,170 @@ namespace GLBase
                 return mLightingPassShader;
             }
 
+            // Method to set the way in which the lighting pass is computed
+            void setLightingMode(LightingMode mode)
+            {
+                mLightingMode = mode;
+            }
+
+            // Method to pass the view and projection matrices of the camera,
+            // used to draw the light volumes and to build the clusters
+            // This needs to be called in each frame
+            void setViewProjection(const glm::mat4& view, const glm::mat4& projection);
+
+            // Method to change the size of the window, reallocating the render
+            // targets
+            void setWindowSize(int width, int height);
+
+            // Method to change the fraction of the window resolution that is
+            // rendered, up to the one given in the constructor. The render
+            // targets are not reallocated, only a part of them is used
+            void setRenderScale(float scale);
+
+            // Method to get the fraction of the window resolution rendered
+            float getRenderScale() const
+            {
+                return mRenderScale;
+            }
+
+            // Methods to get the size of the rendered area
+            int getRenderWidth() const
+            {
+                return mRenderWidth;
+            }
+            int getRenderHeight() const
+            {
+                return mRenderHeight;
+            }
+
+            // Method to enable the dynamic resolution. In each frame the render
+            // scale is changed to hold a target GPU frame time, between minScale
+            // and the scale given in the constructor
+            void setDynamicResolution(bool enabled, float targetFrameTimeMs = 16.f,
+                                      float minScale = 0.5f);
+
+            // Method to get the last GPU frame time measured for the dynamic
+            // resolution, in milliseconds
+            float getGPUFrameTime() const
+            {
+                return mGPUFrameTime;
+            }
+
+            // Method to enable the temporal upscaling. The geometry pass writes
+            // motion vectors, and endFrame() accumulates the frames, each one
+            // with a different jitter, in a history buffer with the resolution
+            // of the window. This reallocates the render targets
+            void setTemporalUpscaling(bool enabled);
+
+            // Method to get the jitter of the projection for this frame, in
+            // normalized device coordinates. It must be passed to the camera
+            // before getting its projection matrix
+            glm::vec2 getJitter() const
+            {
+                return mJitter;
+            }
+
+            // Method to configure the shadows of the point lights. In each frame,
+            // at most budget point lights inside of the view frustum get a
+            // shadow map, chosen by the priority. Their six faces are stored in
+            // an array with 6 * budget layers of resolution x resolution
+            void setPointShadows(unsigned int budget, PointShadowPriority priority = POINT_SHADOW_NEAREST,
+                                 int resolution = 512);
+
+            // Method to get the number of point lights with shadows in the last
+            // frame
+            unsigned int getNrShadowedPointLights() const
+            {
+                return (unsigned int)mShadowedPointLights.size();
+            }
+
+            // Method to configure the atlas with the shadow maps of the spot
+            // lights, reallocating it. Its tiles are between minTileSize and
+            // half of the size of the atlas
+            void setSpotShadowAtlas(int size, int minTileSize = 128);
+
+            // Method to get the atlas of the spot lights, to read its statistics
+            const ShadowAtlas* getSpotShadowAtlas() const
+            {
+                return mSpotShadowAtlas;
+            }
+
+            // Method to choose how the cascades of the directional lights are
+            // rendered. Returns false, keeping the geometry shader, if the
+            // vertex shader cannot write the layer in this context
+            bool setCascadeRenderPath(CascadeRenderPath path);
+
+            // Method to get how the cascades of the directional lights are
+            // rendered. By default the layer is written by the vertex shader
+            // if the context supports it
+            CascadeRenderPath getCascadeRenderPath() const
+            {
+                return mCascadeRenderPath;
+            }
+
+            // Method to choose how the cascades of the directional lights are
+            // placed. With the sample distribution, the depth of the G-buffer is
+            // reduced to its range after the geometry pass, and the cascades of
+            // the next frame cover only that range
+            void setCascadeSplitMode(CascadeSplitMode mode)
+            {
+                mCascadeSplitMode = mode;
+            }
+
+            // Method to get how the cascades of the directional lights are placed
+            CascadeSplitMode getCascadeSplitMode() const
+            {
+                return mCascadeSplitMode;
+            }
+
+            // Method to get the range of distances to the camera of the visible
+            // pixels, used for the sample distribution of the cascades. Returns
+            // false if there is none
+            bool getVisibleDepthRange(float& zMin, float& zMax) const;
+
+            // Method to cull the point and spot lights against the view frustum,
+            // and choose the ones that are shaded and cast shadows, up to the
+            // budgets. It must be called in each frame after setViewProjection,
+            // and before computing the shadow maps. Until it is called for the
+            // first time, all the lights are used
+            void updateLightVisibility(const std::vector<Light*>& lights);
+
+            // Method to set the maximum number of point and spot lights that are
+            // shaded and that cast shadows in each frame, and the number of
+            // frames that they take to fade when they enter or leave the budget
+            void setLightBudgets(unsigned int maxShadedLights, unsigned int maxShadowedLights,
+                                 unsigned int fadeFrames = 10);
+
+            // Method to get the selection of the lights, to read its statistics.
+            // It is null until the lights are culled for the first time
+            const LightVisibility* getLightVisibility() const
+            {
+                return mLightVisibility;
+            }
+
+            // Method to set a GPU profiler, to measure the passes of the
+            // renderer that are not passes of the frame graph: the reduction of
+            // the depth, the sky and the composition to the screen. It can be
+            // null
+            void setGPUProfiler(GPUProfiler* profiler)
+            {
+                mGPUProfiler = profiler;
+            }
+
+            // Method to get the layout of the G-buffer
+            GBufferLayout getGBufferLayout() const
+            {
+                return mGBufferLayout;
+            }
+
+            // Method to get the number of bytes per pixel of the render targets
+            // (G-buffer, depth and stencil, and lighting target)
+            unsigned int getBytesPerPixel() const;
+
+            // Method to configure a shader of the geometry pass for the layout of
+            // the G-buffer. It must write its outputs as in defGeometryPassFragment.glsl
+            void configureGeometryShader(Shader& shader) const;
+
             // Method to configure the lights in the shader
             void configureLights(const std::vector<Light*> lights);
             // // Method to configure the light space matrices
@@ -56,13 +299,63 @@ namespace GLBase
             // Size of the window
             int mWinWidth;
             int mWinHeight;
-            // Size of the render target
+            // Size of the render targets, allocated for the maximum scale
+            int mTargetWidth;
+            int mTargetHeight;
+            // Size of the rendered area, in the lower left corner of the targets
             int mRenderWidth;
             int mRenderHeight;
+            // Maximum and current fraction of the window resolution rendered
+            float mMaxRenderScale;
+            float mRenderScale;
+
+            // Data for the temporal upscaling
+            // ------------------------------
+            bool mTemporalUpscaling;
+            // Shader for accumulating the frames in the history
+            Shader mTemporalResolveShader;
+            // Texture with the motion vectors, attached to the G-buffer
+            unsigned int mGVelocityTexture;
+            // Two history buffers with the resolution of the window. Each frame
+            // reads from one and writes to the other
+            unsigned int mHistoryBuffers[2];
+            unsigned int mHistoryTextures[2];
+            // Index of the history buffer with the last result
+            unsigned int mHistoryIndex;
+            // False until the history has a valid result
+            bool mHistoryValid;
+            // Uniform buffer with the view-projection matrices without jitter
+            // of this and the previous frame, for the motion vectors
+            unsigned int mTemporalMatricesUBO;
+            glm::mat4 mCurrentViewProjection;
+            glm::mat4 mPreviousViewProjection;
+            // Jitter of this frame, and number of frames rendered
+            glm::vec2 mJitter;
+            unsigned int mFrameIndex;
+
+            // Data for the dynamic resolution
+            // ------------------------------
+            bool mDynamicResolution;
+            ResolutionController* mResolutionController;
+            // Timestamp queries at the start and end of each frame. There are
+            // several frames in flight, so the results are read without stalls
+            static const unsigned int NR_FRAME_TIME_QUERIES { 3 };
+            unsigned int mFrameTimeQueries[2 * NR_FRAME_TIME_QUERIES];
+            // Number of frames measured
+            unsigned int mFrameTimeQueryCount;
+            // Last GPU frame time measured
+            float mGPUFrameTime;
+
+            // Layout of the G-buffer
+            GBufferLayout mGBufferLayout;
 
             // Renderbuffer object for the depth information, to be used by all 
             // passes
+            // With the compact layout, it is only used by the target FBO
             unsigned int mDepthRBO;
+            // With the compact layout, the depth of the G-buffer is a texture
+            // instead, so the lighting pass can reconstruct the position from it
+            unsigned int mDepthTexture;
 
             // Data for the shadow pass
             // ------------------------------
@@ -70,12 +363,48 @@ namespace GLBase
             Shader mShadowMapDirectionalShader;
             Shader mShadowMapPointShader;
             Shader mShadowMapSpotShader;
+            // Shader for the cascades that writes the layer in the vertex
+            // shader, only created if the context supports it
+            Shader* mShadowMapDirectionalLayerShader;
+            CascadeRenderPath mCascadeRenderPath;
+            // Array with the six faces of the shadow maps of the point lights,
+            // and the FBO with all its layers attached
+            unsigned int mPointShadowFBO;
+            unsigned int mPointShadowTexture;
+            // Maximum number of point lights with shadows, and resolution of
+            // their faces
+            unsigned int mPointShadowBudget;
+            int mPointShadowResolution;
+            PointShadowPriority mPointShadowPriority;
+            // Point lights with a slot of the array in this frame
+            std::vector<PointLight*> mShadowedPointLights;
+            // Atlas with the shadow maps of the spot lights
+            ShadowAtlas* mSpotShadowAtlas;
+            // Filter of the exponential and variance shadow maps
+            ShadowMomentsFilter* mShadowMomentsFilter;
+            // Texture unit after the last one used by the shadow maps in the
+            // lighting pass, to unbind their comparison samplers after it
+            unsigned int mShadowTextureUnitsEnd;
+            // Placement of the cascades, and reduction of the depth of the
+            // G-buffer for the sample distribution, created when it is used
+            CascadeSplitMode mCascadeSplitMode;
+            DepthRangeReducer* mDepthRangeReducer;
+
+            // Data for the selection of the lights
+            // ------------------------------
+            // Culling and budgets of the point and spot lights, created when
+            // they are used
+            LightVisibility* mLightVisibility;
+
+            // Profiler of the passes, not owned by the renderer
+            GPUProfiler* mGPUProfiler;
 
             // Data for the geometry pass
             // ------------------------------
             // G-buffer
             unsigned int mGBuffer;
             // Texture attachments for the G-buffer
+            // The compact layout has no position texture
             unsigned int mGPositionTexture;
             unsigned int mGNormalTexture;
             unsigned int mGAlbedoSpecTexture;
@@ -84,6 +413,42 @@ namespace GLBase
             // ------------------------------
             // Shader for the lighting pass
             Shader mLightingPassShader;
+            // Way in which the lighting pass is computed
+            LightingMode mLightingMode;
+
+            // Data for the light volumes
+            // ------------------------------
+            // Shader for drawing the light volumes
+            Shader mLightVolumeShader;
+            // Meshes used as the volumes of the point and spot lights
+            GLGeometry::GLSphere* mPointVolume;
+            GLGeometry::GLCone* mSpotVolume;
+            // Buffer with the per-instance attributes of the point lights
+            unsigned int mPointVolumeInstanceVBO;
+            // Number of lights that fit in the buffer
+            unsigned int mPointVolumeInstanceCapacity;
+            // Per-instance data of the point lights, in each frame
+            std::vector<float> mPointVolumeInstanceData;
+            // View and projection matrices of the camera
+            glm::mat4 mView;
+            glm::mat4 mProjection;
+
+            // Data for the clustered lights
+            // ------------------------------
+            // Assignment of the lights to the clusters, created when it is used
+            ClusteredLights* mClusteredLights;
+            // Point and spot lights of the frame, and the light space matrices,
+            // tiles of the shadow atlas and shadow filters of the spot lights
+            std::vector<ClusterLight> mClusterLights;
+            std::vector<glm::mat4> mClusterSpotMatrices;
+            std::vector<glm::vec4> mClusterSpotShadowRects;
+            std::vector<int> mClusterSpotShadowFilters;
+            // First of the four texture units of the clusters, after the ones
+            // used by the shadow maps
+            unsigned int mClusterTextureUnit;
+            // True once the lack of texture units for the shadow maps of the
+            // directional lights has been reported
+            bool mTextureUnitsExhausted;
 
             // Data for rendering the screen quad
             // ------------------------------
@@ -105,6 +470,57 @@ namespace GLBase
 
             // Setup the G-buffer
             void setupGBuffer();
+
+            // Setup the history buffers of the temporal upscaling
+            void setupHistoryBuffers();
+
+            // Setup the array of shadow maps of the point lights
+            void setupPointShadowMaps();
+
+            // Method to get the shader of the shadow pass for the type of a light
+            Shader* getShadowShader(Light* light);
+
+            // Methods to get the factor of the color of a light in this frame,
+            // and whether it can cast a shadow, from the selection of the lights
+            float getLightFade(Light* light) const;
+            bool isLightShadowed(Light* light) const;
+
+            // Method to choose the point lights with shadows in this frame, and
+            // assign them the slots of the array
+            void assignPointShadowSlots(const Camera& camera, const std::vector<PointLight*>& pointLights);
+
+            // Delete the FBOs and their attachments
+            void deleteRenderTargets();
+
+            // Method to accumulate the frame in the history, and draw the result
+            // to the screen
+            void resolveTemporal();
+
+            // Pass the size of the rendered area to the shaders
+            void configureRenderSize();
+
+            // Read the GPU time of the oldest frame in flight, and update the
+            // render scale with it
+            void updateDynamicResolution();
+
+            // Setup the meshes and the buffers for the light volumes
+            void setupLightVolumes();
+
+            // Method to add the contribution of the point and spot lights by
+            // drawing their volumes
+            void renderLightVolumes(glm::vec3 viewPos, const std::vector<Light*> lights);
+
+            // Method to assign the point and spot lights to the clusters, and
+            // configure them in the lighting shader
+            void configureClusteredLights(const std::vector<Light*> lights);
+
+            // Method to add the per-instance data of a point light to the buffer
+            // of the light volumes, with its color multiplied by a factor
+            void addPointVolumeInstance(PointLight* light, float fade);
+
+            // Method to set the first instance used from the buffer of the light
+            // volumes, by changing the offset of the per-instance attributes
+            void setPointVolumeInstanceOffset(unsigned int firstInstance);
     };
 }
 
@@ -0,0 +1,179 @@
+#include "depthRangeReducer.h"
+
+namespace GLBase
+{
+    // Constructor
+    DepthRangeReducer::DepthRangeReducer() :
+        mShader(EMBEDDED_SHADER, "GLBase/depthReductionVertex.glsl", "GLBase/depthReductionFragment.glsl"),
+        mFBO { 0 }, mVAO { 0 }, mTextures { 0, 0 }, mTextureSize { 0, 0 },
+        mReadbackBuffers { 0 }, mReadbackFences { nullptr },
+        mNrReadbacksStarted { 0 }, mNrReadbacksFinished { 0 },
+        mHasRange { false }, mRange { 0.f, 0.f }
+    {
+        glGenFramebuffers(1, &mFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // The passes draw a triangle computed from the index of its vertices
+        glGenVertexArrays(1, &mVAO);
+
+        // Pixel buffers for the minimum and maximum of the readbacks
+        glGenBuffers(NR_READBACKS, mReadbackBuffers);
+        for (unsigned int i = 0; i < NR_READBACKS; ++i)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, mReadbackBuffers[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, 2 * sizeof(float), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        mShader.use();
+        mShader.setInt("sourceMap", 0);
+    }
+
+    // Destructor
+    DepthRangeReducer::~DepthRangeReducer()
+    {
+        for (unsigned int i = 0; i < NR_READBACKS; ++i)
+        {
+            if (mReadbackFences[i])
+                glDeleteSync(mReadbackFences[i]);
+        }
+        glDeleteBuffers(NR_READBACKS, mReadbackBuffers);
+        glDeleteFramebuffers(1, &mFBO);
+        glDeleteVertexArrays(1, &mVAO);
+        glDeleteTextures(2, mTextures);
+    }
+
+    // Method to draw a pass, writing width x height texels of a texture
+    void DepthRangeReducer::drawPass(unsigned int target, int width, int height)
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+        glViewport(0, 0, width, height);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        RenderStats::addDraw(GL_TRIANGLES, 3);
+    }
+
+    // Method to reduce the depth of the rendered area of the G-buffer
+    void DepthRangeReducer::reduce(unsigned int gBufferTexture, bool compactGBuffer, int width, int height,
+                                   const glm::mat4& view, const glm::mat4& projection, bool asynchronous)
+    {
+        // Make the textures larger if needed
+        glm::ivec2 size { (width + 3) / 4, (height + 3) / 4 };
+        if (size.x > mTextureSize.x || size.y > mTextureSize.y)
+        {
+            mTextureSize = glm::max(mTextureSize, size);
+            if (mTextures[0] == 0)
+                glGenTextures(2, mTextures);
+            for (unsigned int i = 0; i < 2; ++i)
+            {
+                glBindTexture(GL_TEXTURE_2D, mTextures[i]);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, mTextureSize.x, mTextureSize.y, 0,
+                             GL_RG, GL_FLOAT, nullptr);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            }
+        }
+
+        // Read the results of the previous frames before starting a new one
+        if (asynchronous)
+            collectReadbacks();
+
+        mShader.use();
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glBindVertexArray(mVAO);
+        glActiveTexture(GL_TEXTURE0);
+
+        // First pass, from the G-buffer
+        mShader.setInt("reductionPass", 0);
+        mShader.setBool("compactGBuffer", compactGBuffer);
+        mShader.setMat4("view", view);
+        mShader.setMat4("invProjection", glm::inverse(projection));
+        mShader.setVec2("sourceSize", glm::vec2(width, height));
+        glBindTexture(GL_TEXTURE_2D, gBufferTexture);
+        drawPass(mTextures[0], size.x, size.y);
+
+        unsigned int current { 0 };
+        if (!asynchronous)
+        {
+            // Read the result of the first pass, and reduce it here
+            std::vector<glm::vec2> ranges(size.x * size.y);
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glReadPixels(0, 0, size.x, size.y, GL_RG, GL_FLOAT, ranges.data());
+            glm::vec2 range { 1e30f, -1e30f };
+            for (const auto& texelRange : ranges)
+                range = glm::vec2(std::min(range.x, texelRange.x), std::max(range.y, texelRange.y));
+            setRange(range);
+        }
+        else
+        {
+            // Reduce the result until there is a single texel
+            mShader.setInt("reductionPass", 1);
+            while (size.x > 1 || size.y > 1)
+            {
+                mShader.setVec2("sourceSize", glm::vec2(size));
+                glBindTexture(GL_TEXTURE_2D, mTextures[current]);
+                size = glm::ivec2((size.x + 3) / 4, (size.y + 3) / 4);
+                current = 1 - current;
+                drawPass(mTextures[current], size.x, size.y);
+            }
+
+            // Copy the texel to a free pixel buffer, if there is any, without
+            // waiting for it
+            if (mNrReadbacksStarted - mNrReadbacksFinished < NR_READBACKS)
+            {
+                const unsigned int slot { mNrReadbacksStarted % NR_READBACKS };
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, mReadbackBuffers[slot]);
+                glReadPixels(0, 0, 1, 1, GL_RG, GL_FLOAT, nullptr);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                mReadbackFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                ++mNrReadbacksStarted;
+            }
+        }
+
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // Method to read the results of the readbacks that have finished
+    // They finish in the order in which they were started, so it stops at the
+    // first one that has not
+    void DepthRangeReducer::collectReadbacks()
+    {
+        while (mNrReadbacksFinished < mNrReadbacksStarted)
+        {
+            const unsigned int slot { mNrReadbacksFinished % NR_READBACKS };
+            const GLenum status { glClientWaitSync(mReadbackFences[slot], 0, 0) };
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                break;
+            glDeleteSync(mReadbackFences[slot]);
+            mReadbackFences[slot] = nullptr;
+
+            glm::vec2 range;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, mReadbackBuffers[slot]);
+            glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, sizeof(range), glm::value_ptr(range));
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            setRange(range);
+            ++mNrReadbacksFinished;
+        }
+    }
+
+    // Method to keep a range read back, if there was any geometry
+    void DepthRangeReducer::setRange(const glm::vec2& range)
+    {
+        mHasRange = range.x <= range.y;
+        if (mHasRange)
+            mRange = range;
+    }
+
+    // Method to get the last range read back
+    bool DepthRangeReducer::getRange(float& zMin, float& zMax) const
+    {
+        if (!mHasRange)
+            return false;
+        zMin = mRange.x;
+        zMax = mRange.y;
+        return true;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef DEPTHRANGEREDUCER_H
+#define DEPTHRANGEREDUCER_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Reduction of the depth of the G-buffer to the range of distances to the
+    // camera of the visible pixels, for the sample distribution of the shadow
+    // cascades.
+    // Each pass writes the minimum and maximum of 4x4 texels of the previous
+    // one, until a single texel is left. Its value is read back through a pixel
+    // buffer with a fence, which is checked in the next frames without waiting,
+    // so the range is usually the one of the previous frame. Without the
+    // asynchronous readback, the result of the first pass is read immediately
+    // and reduced in the CPU instead, stalling until the G-buffer is complete.
+    class DepthRangeReducer
+    {
+        public:
+            // Constructor
+            DepthRangeReducer();
+
+            // Destructor
+            ~DepthRangeReducer();
+
+            // Method to reduce the depth of the rendered area of the G-buffer,
+            // of width x height pixels. The texture is the position with the
+            // standard layout, and the depth buffer with the compact one
+            void reduce(unsigned int gBufferTexture, bool compactGBuffer, int width, int height,
+                        const glm::mat4& view, const glm::mat4& projection, bool asynchronous);
+
+            // Method to get the last range read back. Returns false if there is
+            // none yet, or if there was no geometry in the last one
+            bool getRange(float& zMin, float& zMax) const;
+
+        private:
+            // Shader of the passes
+            Shader mShader;
+            // Framebuffer and empty vertex array for drawing the passes
+            unsigned int mFBO;
+            unsigned int mVAO;
+            // Two RG32F textures, each pass reading from one and writing to the
+            // other, with a quarter of the size of the G-buffer in each axis
+            unsigned int mTextures[2];
+            glm::ivec2 mTextureSize;
+
+            // Pixel buffers and fences of the readbacks in flight
+            static const unsigned int NR_READBACKS { 3 };
+            unsigned int mReadbackBuffers[NR_READBACKS];
+            GLsync mReadbackFences[NR_READBACKS];
+            // Number of readbacks started and finished
+            unsigned int mNrReadbacksStarted;
+            unsigned int mNrReadbacksFinished;
+
+            // Last range read back
+            bool mHasRange;
+            glm::vec2 mRange;
+
+            // Method to draw a pass, writing width x height texels of a texture
+            void drawPass(unsigned int target, int width, int height);
+
+            // Method to read the results of the readbacks that have finished
+            void collectReadbacks();
+
+            // Method to keep a range read back, if there was any geometry
+            void setRange(const glm::vec2& range);
+    };
+}
+
+#endif
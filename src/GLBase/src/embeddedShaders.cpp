@@ -0,0 +1,34 @@
+#include "GLBase.h"
+
+// Table with the sources of the shaders, generated at build time by
+// embedShaders.cmake
+#include "embeddedShaderTable.h"
+
+namespace GLBase
+{
+    // Get the source of an embedded shader
+    const char* findEmbeddedShader(const std::string& name)
+    {
+        // The table is sorted by name, so it can be searched with a binary search
+        const EmbeddedShader* begin { std::begin(EMBEDDED_SHADER_TABLE) };
+        const EmbeddedShader* end { std::end(EMBEDDED_SHADER_TABLE) };
+        const EmbeddedShader* shader { std::lower_bound(begin, end, name,
+            [](const EmbeddedShader& shader, const std::string& name)
+            {
+                return std::strcmp(shader.name, name.c_str()) < 0;
+            }) };
+
+        if (shader == end || name != shader->name)
+            return nullptr;
+        return shader->source;
+    }
+
+    // Get the names of all the embedded shaders
+    std::vector<std::string> getEmbeddedShaderNames()
+    {
+        std::vector<std::string> names;
+        for (const EmbeddedShader& shader : EMBEDDED_SHADER_TABLE)
+            names.push_back(shader.name);
+        return names;
+    }
+}
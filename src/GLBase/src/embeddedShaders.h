@@ -0,0 +1,26 @@
+#ifndef EMBEDDEDSHADERS_H
+#define EMBEDDEDSHADERS_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Source of a shader embedded in the library at build time, from the files
+    // in the shaders/ directory of the project.
+    // The name is the path of the file relative to that directory, for
+    // instance "GLBase/defLightingPassFragment.glsl".
+    struct EmbeddedShader
+    {
+        const char* name;
+        const char* source;
+    };
+
+    // Get the source of an embedded shader. Returns nullptr if there is no
+    // shader with that name
+    const char* findEmbeddedShader(const std::string& name);
+
+    // Get the names of all the embedded shaders
+    std::vector<std::string> getEmbeddedShaderNames();
+}
+
+#endif
@@ -0,0 +1,622 @@
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Number of frames that a texture of the pool is kept without being used
+    static const unsigned int POOL_MAX_UNUSED_FRAMES { 60 };
+    // Number of frames in flight of the ring of timestamp queries
+    static const unsigned int NR_QUERY_FRAMES { 4 };
+
+    // Get the format and type of the pixel data for an internal format, to
+    // allocate the textures of the pool
+    static void getPixelFormat(unsigned int internalFormat, GLenum& format, GLenum& type)
+    {
+        switch (internalFormat)
+        {
+            case GL_RGBA16F:
+            case GL_RGBA32F:
+                format = GL_RGBA;
+                type = GL_FLOAT;
+                break;
+            case GL_RGB16F:
+            case GL_RGB32F:
+            case GL_R11F_G11F_B10F:
+                format = GL_RGB;
+                type = GL_FLOAT;
+                break;
+            case GL_RG16F:
+            case GL_RG32F:
+                format = GL_RG;
+                type = GL_FLOAT;
+                break;
+            case GL_R16F:
+            case GL_R32F:
+                format = GL_RED;
+                type = GL_FLOAT;
+                break;
+            case GL_RG16:
+                format = GL_RG;
+                type = GL_UNSIGNED_SHORT;
+                break;
+            case GL_DEPTH24_STENCIL8:
+                format = GL_DEPTH_STENCIL;
+                type = GL_UNSIGNED_INT_24_8;
+                break;
+            case GL_DEPTH_COMPONENT24:
+            case GL_DEPTH_COMPONENT32F:
+                format = GL_DEPTH_COMPONENT;
+                type = GL_FLOAT;
+                break;
+            default:
+                format = GL_RGBA;
+                type = GL_UNSIGNED_BYTE;
+                break;
+        }
+    }
+
+    // Get the name of an internal format, for the graph
+    static std::string getFormatName(unsigned int internalFormat)
+    {
+        switch (internalFormat)
+        {
+            case GL_RGBA8: return "RGBA8";
+            case GL_SRGB8_ALPHA8: return "SRGB8_ALPHA8";
+            case GL_RGBA16F: return "RGBA16F";
+            case GL_RGBA32F: return "RGBA32F";
+            case GL_RGB16F: return "RGB16F";
+            case GL_RGB32F: return "RGB32F";
+            case GL_R11F_G11F_B10F: return "R11F_G11F_B10F";
+            case GL_RG16F: return "RG16F";
+            case GL_RG32F: return "RG32F";
+            case GL_R16F: return "R16F";
+            case GL_R32F: return "R32F";
+            case GL_RG16: return "RG16";
+            case GL_DEPTH24_STENCIL8: return "DEPTH24_STENCIL8";
+            case GL_DEPTH_COMPONENT24: return "DEPTH_COMPONENT24";
+            case GL_DEPTH_COMPONENT32F: return "DEPTH_COMPONENT32F";
+            default:
+            {
+                std::stringstream ss;
+                ss << "0x" << std::hex << internalFormat;
+                return ss.str();
+            }
+        }
+    }
+
+    //==============================
+    // Methods of the FrameGraphBuilder class
+    //==============================
+
+    // Constructor
+    FrameGraphBuilder::FrameGraphBuilder(FrameGraph& graph, unsigned int pass) :
+        mGraph { graph }, mPass { pass }
+    {}
+
+    // Method to create a transient texture, which is written by this pass
+    unsigned int FrameGraphBuilder::create(const std::string& name, const FrameGraphTextureDesc& desc)
+    {
+        const unsigned int resource { mGraph.createTransient(name, desc) };
+        mGraph.mPasses[mPass].creates.push_back(resource);
+        return write(resource);
+    }
+
+    // Method to declare that the pass reads a resource
+    unsigned int FrameGraphBuilder::read(unsigned int resource)
+    {
+        mGraph.mPasses[mPass].reads.push_back(resource);
+        mGraph.mResources[resource].readers.push_back(mPass);
+        return resource;
+    }
+
+    // Method to declare that the pass writes a resource
+    unsigned int FrameGraphBuilder::write(unsigned int resource)
+    {
+        mGraph.mPasses[mPass].writes.push_back(resource);
+        mGraph.mResources[resource].writers.push_back(mPass);
+        return resource;
+    }
+
+    // Method to mark that the pass has effects outside of the graph
+    void FrameGraphBuilder::setSideEffect()
+    {
+        mGraph.mPasses[mPass].sideEffect = true;
+    }
+
+    //==============================
+    // Methods of the FrameGraphResources class
+    //==============================
+
+    // Constructor
+    FrameGraphResources::FrameGraphResources(const FrameGraph& graph) :
+        mGraph { graph }
+    {}
+
+    // Method to get the OpenGL texture of a resource
+    unsigned int FrameGraphResources::getTexture(unsigned int resource) const
+    {
+        const FrameGraph::Resource& res { mGraph.mResources[resource] };
+        if (res.imported)
+            return res.texture;
+        if (res.poolIndex < 0)
+        {
+            std::cout << "ERROR::FRAMEGRAPH::RESOURCE_NOT_ALLOCATED: " << res.name << '\n';
+            return 0;
+        }
+        return mGraph.mPool[res.poolIndex].texture;
+    }
+
+    // Method to get the description of a resource
+    const FrameGraphTextureDesc& FrameGraphResources::getDesc(unsigned int resource) const
+    {
+        return mGraph.mResources[resource].desc;
+    }
+
+    //==============================
+    // Methods of the FrameGraph class
+    //==============================
+
+    // Constructor
+    FrameGraph::FrameGraph() :
+        mFrameIndex { 0 }, mNrTransientTextures { 0 }, mNrPhysicalTextures { 0 },
+        mQueryFrames(NR_QUERY_FRAMES), mNrExecutedFrames { 0 }, mGPUProfiler { nullptr }
+    {
+        for (QueryFrame& frame : mQueryFrames)
+            frame.pending = false;
+    }
+
+    // Destructor
+    FrameGraph::~FrameGraph()
+    {
+        for (const PooledTexture& pooled : mPool)
+            glDeleteTextures(1, &pooled.texture);
+        for (QueryFrame& frame : mQueryFrames)
+        {
+            if (!frame.queries.empty())
+                glDeleteQueries((GLsizei)frame.queries.size(), &frame.queries[0]);
+        }
+    }
+
+    // Method to remove the passes and resources of the last frame
+    void FrameGraph::reset()
+    {
+        mPasses.clear();
+        mResources.clear();
+        mOrder.clear();
+        for (PooledTexture& pooled : mPool)
+            pooled.inUse = false;
+    }
+
+    // Method to add a resource that is not owned by the graph
+    unsigned int FrameGraph::importTexture(const std::string& name, unsigned int texture,
+                                           const FrameGraphTextureDesc& desc)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+        resource.imported = true;
+        resource.output = false;
+        resource.texture = texture;
+        resource.poolIndex = -1;
+        mResources.push_back(resource);
+        return (unsigned int)mResources.size() - 1;
+    }
+
+    // Method to create a transient resource
+    unsigned int FrameGraph::createTransient(const std::string& name, const FrameGraphTextureDesc& desc)
+    {
+        Resource resource;
+        resource.name = name;
+        resource.desc = desc;
+        resource.imported = false;
+        resource.output = false;
+        resource.texture = 0;
+        resource.poolIndex = -1;
+        mResources.push_back(resource);
+        return (unsigned int)mResources.size() - 1;
+    }
+
+    // Method to mark that a resource is used after the frame
+    void FrameGraph::markOutput(unsigned int resource)
+    {
+        mResources[resource].output = true;
+    }
+
+    // Method to add a pass
+    void FrameGraph::addPass(const std::string& name,
+                             const std::function<void(FrameGraphBuilder&)>& setup,
+                             const std::function<void(const FrameGraphResources&)>& execute)
+    {
+        Pass pass;
+        pass.name = name;
+        pass.execute = execute;
+        pass.sideEffect = false;
+        pass.culled = false;
+        mPasses.push_back(pass);
+
+        FrameGraphBuilder builder(*this, (unsigned int)mPasses.size() - 1);
+        setup(builder);
+    }
+
+    // Method to order the passes, cull the unused ones, and allocate the
+    // transient textures
+    bool FrameGraph::compile()
+    {
+        ++mFrameIndex;
+        mOrder.clear();
+
+        computeDependencies();
+        std::vector<unsigned int> order;
+        if (!sortPasses(order))
+        {
+            std::cout << "ERROR::FRAMEGRAPH::CYCLIC_DEPENDENCIES\n";
+            return false;
+        }
+
+        cullPasses(order);
+        for (unsigned int pass : order)
+        {
+            if (!mPasses[pass].culled)
+                mOrder.push_back(pass);
+        }
+
+        allocateTransients();
+        return true;
+    }
+
+    // Method to compute the dependencies between the passes
+    void FrameGraph::computeDependencies()
+    {
+        for (const Resource& resource : mResources)
+        {
+            // The writers run in the order they were added
+            for (unsigned int i = 1; i < resource.writers.size(); ++i)
+            {
+                if (resource.writers[i] != resource.writers[i - 1])
+                    mPasses[resource.writers[i]].dependencies.push_back(resource.writers[i - 1]);
+            }
+            // The passes that only read it run after the last writer
+            if (resource.writers.empty())
+                continue;
+            for (unsigned int reader : resource.readers)
+            {
+                if (std::find(resource.writers.begin(), resource.writers.end(), reader) == resource.writers.end())
+                    mPasses[reader].dependencies.push_back(resource.writers.back());
+            }
+        }
+    }
+
+    // Method to sort the passes so each one runs after its dependencies
+    // Between the passes that are ready at the same time, the one added first
+    // runs first, so the order is stable
+    bool FrameGraph::sortPasses(std::vector<unsigned int>& order) const
+    {
+        const unsigned int nrPasses { (unsigned int)mPasses.size() };
+        std::vector<unsigned int> remaining(nrPasses, 0);
+        std::vector<std::vector<unsigned int>> dependents(nrPasses);
+        for (unsigned int pass = 0; pass < nrPasses; ++pass)
+        {
+            for (unsigned int dependency : mPasses[pass].dependencies)
+            {
+                ++remaining[pass];
+                dependents[dependency].push_back(pass);
+            }
+        }
+
+        // Passes without pending dependencies, sorted by index
+        std::vector<unsigned int> ready;
+        for (unsigned int pass = 0; pass < nrPasses; ++pass)
+        {
+            if (remaining[pass] == 0)
+                ready.push_back(pass);
+        }
+        while (!ready.empty())
+        {
+            const auto first { std::min_element(ready.begin(), ready.end()) };
+            const unsigned int pass { *first };
+            ready.erase(first);
+            order.push_back(pass);
+            for (unsigned int dependent : dependents[pass])
+            {
+                if (--remaining[dependent] == 0)
+                    ready.push_back(dependent);
+            }
+        }
+
+        return order.size() == nrPasses;
+    }
+
+    // Method to cull the passes whose outputs are not used
+    // A pass is needed if it has side effects, if it is the last writer of an
+    // output, or if a needed pass reads what it writes
+    void FrameGraph::cullPasses(const std::vector<unsigned int>& order)
+    {
+        std::vector<bool> needed(mPasses.size(), false);
+        for (unsigned int pass = 0; pass < mPasses.size(); ++pass)
+        {
+            if (mPasses[pass].sideEffect)
+                needed[pass] = true;
+        }
+        for (const Resource& resource : mResources)
+        {
+            if (resource.output && !resource.writers.empty())
+                needed[resource.writers.back()] = true;
+        }
+
+        // The producers come before in the order, so going backwards every pass
+        // is decided before its producers
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            const unsigned int pass { *it };
+            if (!needed[pass])
+                continue;
+            for (unsigned int resourceIndex : mPasses[pass].reads)
+            {
+                const std::vector<unsigned int>& writers { mResources[resourceIndex].writers };
+                const auto self { std::find(writers.begin(), writers.end(), pass) };
+                // A pass that reads and writes a resource uses the result of the
+                // previous writer, and a pass that only reads it the last one
+                if (self == writers.end())
+                {
+                    if (!writers.empty())
+                        needed[writers.back()] = true;
+                }
+                else if (self != writers.begin())
+                    needed[*(self - 1)] = true;
+            }
+        }
+
+        for (unsigned int pass = 0; pass < mPasses.size(); ++pass)
+            mPasses[pass].culled = !needed[pass];
+    }
+
+    // Method to get a texture from the pool with a description, creating it if
+    // there is none free
+    int FrameGraph::acquirePooledTexture(const FrameGraphTextureDesc& desc)
+    {
+        for (unsigned int i = 0; i < mPool.size(); ++i)
+        {
+            if (!mPool[i].inUse && mPool[i].desc == desc)
+            {
+                mPool[i].inUse = true;
+                mPool[i].lastFrame = mFrameIndex;
+                return (int)i;
+            }
+        }
+
+        PooledTexture pooled;
+        pooled.desc = desc;
+        pooled.lastFrame = mFrameIndex;
+        pooled.inUse = true;
+        GLenum format;
+        GLenum type;
+        getPixelFormat(desc.internalFormat, format, type);
+        const bool isDepth { format == GL_DEPTH_STENCIL || format == GL_DEPTH_COMPONENT };
+        glGenTextures(1, &pooled.texture);
+        glBindTexture(GL_TEXTURE_2D, pooled.texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0,
+                     format, type, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, isDepth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, isDepth ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        mPool.push_back(pooled);
+        return (int)mPool.size() - 1;
+    }
+
+    // Method to assign the textures of the pool to the transient resources
+    // The passes are visited in order, taking a texture from the pool in the
+    // first pass that uses each resource, and giving it back after the last one
+    void FrameGraph::allocateTransients()
+    {
+        // Remove the textures of the pool that have not been used for a while
+        for (unsigned int i = 0; i < mPool.size(); )
+        {
+            if (mFrameIndex - mPool[i].lastFrame > POOL_MAX_UNUSED_FRAMES)
+            {
+                glDeleteTextures(1, &mPool[i].texture);
+                mPool.erase(mPool.begin() + i);
+            }
+            else
+                ++i;
+        }
+
+        // First and last position in the order of the passes that use each
+        // transient resource
+        const int nrResources { (int)mResources.size() };
+        std::vector<int> firstUse(nrResources, -1);
+        std::vector<int> lastUse(nrResources, -1);
+        for (unsigned int position = 0; position < mOrder.size(); ++position)
+        {
+            const Pass& pass { mPasses[mOrder[position]] };
+            for (const std::vector<unsigned int>* list : { &pass.reads, &pass.writes })
+            {
+                for (unsigned int resource : *list)
+                {
+                    if (firstUse[resource] < 0)
+                        firstUse[resource] = (int)position;
+                    lastUse[resource] = (int)position;
+                }
+            }
+        }
+
+        mNrTransientTextures = 0;
+        std::vector<bool> physicalUsed(mPool.size(), false);
+        for (unsigned int position = 0; position < mOrder.size(); ++position)
+        {
+            for (int resource = 0; resource < nrResources; ++resource)
+            {
+                if (mResources[resource].imported || firstUse[resource] != (int)position)
+                    continue;
+                mResources[resource].poolIndex = acquirePooledTexture(mResources[resource].desc);
+                ++mNrTransientTextures;
+                if (mResources[resource].poolIndex >= (int)physicalUsed.size())
+                    physicalUsed.resize(mResources[resource].poolIndex + 1, false);
+                physicalUsed[mResources[resource].poolIndex] = true;
+            }
+            for (int resource = 0; resource < nrResources; ++resource)
+            {
+                if (!mResources[resource].imported && lastUse[resource] == (int)position)
+                    mPool[mResources[resource].poolIndex].inUse = false;
+            }
+        }
+        mNrPhysicalTextures = (unsigned int)std::count(physicalUsed.begin(), physicalUsed.end(), true);
+    }
+
+    // Method to execute the passes that were not culled, in order
+    void FrameGraph::execute()
+    {
+        // Without a GPU profiler, the passes are timed with a ring of queries
+        // of the graph, with two timestamp queries for each pass
+        QueryFrame* queryFrame { nullptr };
+        if (mGPUProfiler == nullptr)
+        {
+            collectQueryFrames();
+            queryFrame = &mQueryFrames[mNrExecutedFrames % NR_QUERY_FRAMES];
+            // If the frame of the slot is still not available, it is dropped
+            queryFrame->pending = true;
+            queryFrame->passNames.clear();
+            if (queryFrame->queries.size() < 2 * mOrder.size())
+            {
+                const unsigned int oldSize { (unsigned int)queryFrame->queries.size() };
+                queryFrame->queries.resize(2 * mOrder.size());
+                glGenQueries((GLsizei)(queryFrame->queries.size() - oldSize), &queryFrame->queries[oldSize]);
+            }
+        }
+        ++mNrExecutedFrames;
+
+        FrameGraphResources resources(*this);
+        for (unsigned int position = 0; position < mOrder.size(); ++position)
+        {
+            GPUProfileScope scope(mGPUProfiler, mPasses[mOrder[position]].name);
+            if (queryFrame != nullptr)
+            {
+                queryFrame->passNames.push_back(mPasses[mOrder[position]].name);
+                glQueryCounter(queryFrame->queries[2 * position], GL_TIMESTAMP);
+            }
+            mPasses[mOrder[position]].execute(resources);
+            if (queryFrame != nullptr)
+                glQueryCounter(queryFrame->queries[2 * position + 1], GL_TIMESTAMP);
+        }
+    }
+
+    // Method to read the frames of the ring of queries that are available
+    void FrameGraph::collectQueryFrames()
+    {
+        // From the oldest frame in flight to the newest one
+        for (unsigned int age = NR_QUERY_FRAMES; age > 0; --age)
+        {
+            if (mNrExecutedFrames < age)
+                continue;
+            QueryFrame& frame { mQueryFrames[(mNrExecutedFrames - age) % NR_QUERY_FRAMES] };
+            if (!frame.pending)
+                continue;
+            if (!frame.passNames.empty())
+            {
+                // The last query of the frame is the last one to finish
+                GLuint available;
+                glGetQueryObjectuiv(frame.queries[2 * frame.passNames.size() - 1],
+                                    GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available == GL_FALSE)
+                    return;
+            }
+
+            mPassTimes.clear();
+            for (unsigned int position = 0; position < frame.passNames.size(); ++position)
+            {
+                GLuint64 start;
+                GLuint64 end;
+                glGetQueryObjectui64v(frame.queries[2 * position], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(frame.queries[2 * position + 1], GL_QUERY_RESULT, &end);
+                mPassTimes.emplace_back(frame.passNames[position], (end - start) * 1e-6);
+            }
+            frame.pending = false;
+        }
+    }
+
+    // Method to get the GPU time of a pass in the last frame read
+    double FrameGraph::getPassTime(const std::string& name) const
+    {
+        if (mGPUProfiler != nullptr)
+            return mGPUProfiler->getScopeTime(name);
+        for (const auto& passTime : mPassTimes)
+        {
+            if (passTime.first == name)
+                return passTime.second;
+        }
+        return -1.;
+    }
+
+    // Method to write the graph of the last frame in the Graphviz format
+    void FrameGraph::writeGraphviz(std::ostream& out)
+    {
+        out << "digraph FrameGraph\n{\n";
+        out << "    rankdir=LR;\n";
+        out << "    node [fontname=\"Helvetica\", fontsize=10];\n";
+        out << "    label=\"Frame " << mFrameIndex << ": " << mOrder.size() << " passes, "
+            << getNrCulledPasses() << " culled, " << mNrTransientTextures << " transient textures in "
+            << mNrPhysicalTextures << " physical\";\n";
+
+        // Passes, with their position in the order and their time
+        for (unsigned int pass = 0; pass < mPasses.size(); ++pass)
+        {
+            out << "    pass" << pass << " [shape=box, ";
+            if (mPasses[pass].culled)
+                out << "style=dashed, color=gray, label=\"" << mPasses[pass].name << "\\nculled\"];\n";
+            else
+            {
+                const unsigned int position { (unsigned int)(std::find(mOrder.begin(), mOrder.end(), pass)
+                                                             - mOrder.begin()) };
+                out << "style=filled, fillcolor=\"#ffe0a0\", label=\"#" << position << " "
+                    << mPasses[pass].name << "\\n";
+                // The time is the one of the last frame read, which the CPU
+                // does not wait for
+                const double time { getPassTime(mPasses[pass].name) };
+                if (time >= 0.)
+                    out << std::fixed << std::setprecision(3) << time << " ms";
+                else
+                    out << "n/a";
+                out << "\"];\n";
+            }
+        }
+
+        // Resources, with their description and the texture of the pool
+        for (unsigned int index = 0; index < mResources.size(); ++index)
+        {
+            const Resource& resource { mResources[index] };
+            out << "    res" << index << " [shape=ellipse, label=\"" << resource.name;
+            if (resource.desc.width > 0)
+                out << "\\n" << resource.desc.width << "x" << resource.desc.height;
+            if (resource.desc.internalFormat != 0)
+                out << " " << getFormatName(resource.desc.internalFormat);
+            if (resource.imported)
+                out << "\\nimported\", style=filled, fillcolor=\"#d0d0d0\"];\n";
+            else if (resource.poolIndex >= 0)
+                out << "\\npool texture " << resource.poolIndex << "\", style=filled, fillcolor=\"#a0d0ff\"];\n";
+            else
+                out << "\\nnot allocated\", style=dashed];\n";
+        }
+
+        // Edges of the reads and writes
+        for (unsigned int pass = 0; pass < mPasses.size(); ++pass)
+        {
+            for (unsigned int resource : mPasses[pass].reads)
+                out << "    res" << resource << " -> pass" << pass << ";\n";
+            for (unsigned int resource : mPasses[pass].writes)
+                out << "    pass" << pass << " -> res" << resource << ";\n";
+        }
+        out << "}\n";
+    }
+
+    // Method to write the graph of the last frame to a file
+    void FrameGraph::saveGraphviz(const std::string& path)
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::FRAMEGRAPH::FILE_NOT_WRITTEN: " << path << '\n';
+            return;
+        }
+        writeGraphviz(file);
+    }
+}
@@ -0,0 +1,266 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    class FrameGraph;
+    class GPUProfiler;
+
+    // Description of a texture of the frame graph
+    struct FrameGraphTextureDesc
+    {
+        int width;
+        int height;
+        // Internal format of the texture, like GL_RGBA16F
+        unsigned int internalFormat;
+
+        bool operator==(const FrameGraphTextureDesc& other) const
+        {
+            return width == other.width && height == other.height
+                   && internalFormat == other.internalFormat;
+        }
+    };
+
+    // Object passed to the setup of each pass, to declare the resources that it
+    // reads and writes
+    class FrameGraphBuilder
+    {
+        public:
+            // Constructor
+            FrameGraphBuilder(FrameGraph& graph, unsigned int pass);
+
+            // Method to create a transient texture, which is written by this pass
+            // Its memory is only valid between the first and last passes that
+            // use it, and it may be shared with other transient textures
+            unsigned int create(const std::string& name, const FrameGraphTextureDesc& desc);
+
+            // Method to declare that the pass reads a resource
+            unsigned int read(unsigned int resource);
+
+            // Method to declare that the pass writes a resource
+            unsigned int write(unsigned int resource);
+
+            // Method to mark that the pass has effects outside of the graph, like
+            // drawing to the screen, so it is never culled
+            void setSideEffect();
+
+        private:
+            FrameGraph& mGraph;
+            unsigned int mPass;
+    };
+
+    // Object passed to the execution of each pass, to get its textures
+    class FrameGraphResources
+    {
+        public:
+            // Constructor
+            FrameGraphResources(const FrameGraph& graph);
+
+            // Method to get the OpenGL texture of a resource
+            unsigned int getTexture(unsigned int resource) const;
+
+            // Method to get the description of a resource
+            const FrameGraphTextureDesc& getDesc(unsigned int resource) const;
+
+        private:
+            const FrameGraph& mGraph;
+    };
+
+    // Graph of the passes of a frame.
+    // The graph is built again each frame. The passes declare the resources
+    // that they read and write in their setup, and the graph:
+    //  - orders them so each resource is written before it is read. The
+    //    writers of the same resource run in the order they were added, and
+    //    the passes that only read it run after all of them.
+    //  - culls the passes whose outputs are not used by any other pass, unless
+    //    they have side effects or write a resource marked as an output.
+    //  - allocates the transient textures from a pool, sharing the same texture
+    //    between resources with the same description whose lifetimes do not
+    //    overlap. The pool is kept between frames.
+    //  - measures the GPU time of each pass with timestamp queries.
+    class FrameGraph
+    {
+        friend class FrameGraphBuilder;
+        friend class FrameGraphResources;
+
+        public:
+            // Constructor
+            FrameGraph();
+
+            // Destructor
+            ~FrameGraph();
+
+            // Method to remove the passes and resources of the last frame
+            void reset();
+
+            // Method to add a resource that is not owned by the graph, like the
+            // render targets of the renderer. The texture can be 0 for resources
+            // that only express a dependency
+            unsigned int importTexture(const std::string& name, unsigned int texture,
+                                       const FrameGraphTextureDesc& desc = { 0, 0, 0 });
+
+            // Method to mark that a resource is used after the frame, so the
+            // passes that write it are not culled
+            void markOutput(unsigned int resource);
+
+            // Method to add a pass. The setup is called immediately to declare
+            // its resources, and the execution is called by execute()
+            void addPass(const std::string& name,
+                         const std::function<void(FrameGraphBuilder&)>& setup,
+                         const std::function<void(const FrameGraphResources&)>& execute);
+
+            // Method to order the passes, cull the unused ones, and allocate the
+            // transient textures. Returns false if there are cyclic dependencies
+            bool compile();
+
+            // Method to execute the passes that were not culled, in order
+            void execute();
+
+            // Method to set a GPU profiler, in which each pass executed is a
+            // scope with its name. It can be null
+            void setGPUProfiler(GPUProfiler* profiler)
+            {
+                mGPUProfiler = profiler;
+            }
+
+            // Method to write the graph of the last frame in the Graphviz format,
+            // with the GPU time of each pass in the last frame whose results
+            // have been read, a few frames before. They are taken from the GPU
+            // profiler if there is one, and from a ring of queries of the graph
+            // otherwise. The passes without a time are written as "n/a"
+            void writeGraphviz(std::ostream& out);
+            // Same, but writing it to a file
+            void saveGraphviz(const std::string& path);
+
+            // Methods to get information of the last compilation
+            inline unsigned int getNrPasses() const
+            {
+                return (unsigned int)mPasses.size();
+            }
+            inline unsigned int getNrCulledPasses() const
+            {
+                return (unsigned int)(mPasses.size() - mOrder.size());
+            }
+            inline unsigned int getNrTransientTextures() const
+            {
+                return mNrTransientTextures;
+            }
+            // Number of textures in the pool, used or not by this frame
+            inline unsigned int getNrPooledTextures() const
+            {
+                return (unsigned int)mPool.size();
+            }
+            // Number of textures of the pool used by this frame
+            inline unsigned int getNrPhysicalTextures() const
+            {
+                return mNrPhysicalTextures;
+            }
+
+        private:
+            // Resource of the graph
+            struct Resource
+            {
+                std::string name;
+                FrameGraphTextureDesc desc;
+                // True if the texture is not owned by the graph
+                bool imported;
+                // True if it is used after the frame
+                bool output;
+                // Texture of an imported resource, or index of the texture of
+                // the pool of a transient one
+                unsigned int texture;
+                int poolIndex;
+                // Passes that write and read it, in the order they were added
+                std::vector<unsigned int> writers;
+                std::vector<unsigned int> readers;
+            };
+
+            // Pass of the graph
+            struct Pass
+            {
+                std::string name;
+                std::function<void(const FrameGraphResources&)> execute;
+                std::vector<unsigned int> reads;
+                std::vector<unsigned int> writes;
+                std::vector<unsigned int> creates;
+                bool sideEffect;
+                bool culled;
+                // Passes that must run before this one
+                std::vector<unsigned int> dependencies;
+            };
+
+            // Texture of the pool
+            struct PooledTexture
+            {
+                FrameGraphTextureDesc desc;
+                unsigned int texture;
+                // Last frame in which it was used
+                unsigned int lastFrame;
+                // True while it is used by a resource of this frame
+                bool inUse;
+            };
+
+            // Passes and resources of this frame
+            std::vector<Pass> mPasses;
+            std::vector<Resource> mResources;
+            // Order of execution of the passes that are not culled
+            std::vector<unsigned int> mOrder;
+
+            // Pool of transient textures
+            std::vector<PooledTexture> mPool;
+            // Number of frames compiled
+            unsigned int mFrameIndex;
+            // Statistics of the last compilation
+            unsigned int mNrTransientTextures;
+            unsigned int mNrPhysicalTextures;
+
+            // Frame of the ring of timestamp queries, used when there is no
+            // GPU profiler
+            struct QueryFrame
+            {
+                // Queries at the start and end of each pass executed, and the
+                // names of the passes
+                std::vector<unsigned int> queries;
+                std::vector<std::string> passNames;
+                // True if the frame was executed and has not been read
+                bool pending;
+            };
+            std::vector<QueryFrame> mQueryFrames;
+            // Number of frames executed
+            unsigned int mNrExecutedFrames;
+            // GPU time of the passes of the last frame read from the queries
+            std::vector<std::pair<std::string, double>> mPassTimes;
+
+            // GPU profiler of the passes
+            GPUProfiler* mGPUProfiler;
+
+            // Method to read the frames of the ring of queries whose results
+            // are available. The frames finish in order, so it stops at the
+            // first one that is not
+            void collectQueryFrames();
+
+            // Method to get the GPU time of a pass in the last frame read, or
+            // -1 if there is none
+            double getPassTime(const std::string& name) const;
+
+            // Method to create a transient resource
+            unsigned int createTransient(const std::string& name, const FrameGraphTextureDesc& desc);
+
+            // Method to get a texture from the pool with a description, creating
+            // it if there is none free
+            int acquirePooledTexture(const FrameGraphTextureDesc& desc);
+
+            // Method to compute the dependencies between the passes
+            void computeDependencies();
+            // Method to sort the passes so each one runs after its dependencies
+            bool sortPasses(std::vector<unsigned int>& order) const;
+            // Method to cull the passes whose outputs are not used
+            void cullPasses(const std::vector<unsigned int>& order);
+            // Method to assign the textures of the pool to the transient resources
+            void allocateTransients();
+    };
+}
+
+#endif
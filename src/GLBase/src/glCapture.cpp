@@ -0,0 +1,1952 @@
+#include "GLBase.h"
+
+// Functions of OpenGL that are captured, which are the ones used by the
+// library. Their order gives the identifiers of the calls in the file, so the
+// version of the captures must change when the list changes
+#define GLBASE_CAPTURED_GL_FUNCTIONS(X) \
+    X(ActiveTexture) X(AttachShader) X(BindBuffer) X(BindBufferBase) X(BindFramebuffer) \
+    X(BindRenderbuffer) X(BindSampler) X(BindTexture) X(BindVertexArray) X(BlendEquation) \
+    X(BlendFunc) X(BlitFramebuffer) X(BufferData) X(BufferSubData) X(Clear) X(ClearBufferfv) \
+    X(ClearColor) X(ClearDepth) X(ClientWaitSync) X(CompileShader) X(CreateProgram) \
+    X(CreateShader) X(CullFace) X(DeleteBuffers) X(DeleteFramebuffers) X(DeleteRenderbuffers) \
+    X(DeleteSamplers) X(DeleteShader) X(DeleteSync) X(DeleteTextures) X(DeleteVertexArrays) \
+    X(DepthFunc) X(DepthMask) X(Disable) X(DrawArrays) X(DrawArraysInstanced) X(DrawBuffer) \
+    X(DrawBuffers) X(DrawElements) X(DrawElementsInstanced) X(Enable) \
+    X(EnableVertexAttribArray) X(FenceSync) X(FramebufferRenderbuffer) X(FramebufferTexture) \
+    X(FramebufferTexture2D) X(FramebufferTextureLayer) X(GenBuffers) X(GenFramebuffers) \
+    X(GenRenderbuffers) X(GenSamplers) X(GenTextures) X(GenVertexArrays) X(GenerateMipmap) \
+    X(GetBufferSubData) X(GetUniformLocation) X(LinkProgram) X(PixelStorei) X(ReadBuffer) \
+    X(ReadPixels) X(RenderbufferStorage) X(SamplerParameteri) X(Scissor) X(ShaderSource) \
+    X(StencilFunc) X(StencilMask) X(StencilOp) X(TexBuffer) X(TexImage2D) X(TexImage3D) \
+    X(TexParameterfv) X(TexParameteri) X(Uniform1f) X(Uniform1i) X(Uniform1iv) X(Uniform2fv) \
+    X(Uniform3f) X(Uniform3fv) X(Uniform4f) X(Uniform4fv) X(UniformMatrix2fv) \
+    X(UniformMatrix3fv) X(UniformMatrix4fv) X(UseProgram) X(VertexAttribDivisor) \
+    X(VertexAttribPointer) X(Viewport)
+
+namespace GLBase
+{
+    // Magic number and version of the captures
+    const char GL_CAPTURE_MAGIC[4] { 'G', 'L', 'C', 'P' };
+    constexpr std::uint32_t GL_CAPTURE_VERSION { 1 };
+    // Size of the stream from which it is compressed and written to the file
+    constexpr size_t GL_CAPTURE_BLOCK_SIZE { 1 << 20 };
+    // Largest size of a block accepted when loading. The blocks are larger
+    // than the one above only with the data of a single call
+    constexpr std::uint32_t GL_CAPTURE_MAX_BLOCK_SIZE { 1u << 30 };
+    // Largest ratio between the decompressed and compressed sizes of LZ4
+    constexpr std::uint64_t GL_CAPTURE_LZ4_MAX_RATIO { 255 };
+    // Position of the number of frames in the header, written when it finishes
+    constexpr std::streamoff GL_CAPTURE_NR_FRAMES_OFFSET { 20 };
+
+    // Identifiers of the calls in the stream, followed by the markers
+    enum GLCaptureCall : std::uint16_t
+    {
+#define GLBASE_CAPTURE_CALL_ID(name) CALL_##name,
+        GLBASE_CAPTURED_GL_FUNCTIONS(GLBASE_CAPTURE_CALL_ID)
+#undef GLBASE_CAPTURE_CALL_ID
+        CALL_FRAMES_START,
+        CALL_FRAME_END,
+        CALL_PASS_BEGIN,
+        CALL_PASS_END
+    };
+
+    // Ways in which the data of a call is written
+    enum GLCaptureData : std::uint8_t
+    {
+        // No data, the pointer was null
+        DATA_NONE,
+        // Data written in the stream
+        DATA_STREAM,
+        // Offset in the buffer bound for the pixel transfers
+        DATA_BUFFER_OFFSET
+    };
+
+    // Function pointers of GLAD replaced by the capture
+    struct GLCaptureFunctions
+    {
+#define GLBASE_CAPTURE_POINTER(name) decltype(glad_gl##name) name;
+        GLBASE_CAPTURED_GL_FUNCTIONS(GLBASE_CAPTURE_POINTER)
+#undef GLBASE_CAPTURE_POINTER
+    };
+
+    // State of the capture
+    struct GLCaptureState
+    {
+        bool active { false };
+        // True from the start of the first frame captured
+        bool capturingFrames { false };
+        std::string path;
+        std::ofstream file;
+        // Calls written since the last block
+        std::vector<unsigned char> stream;
+
+        unsigned int firstFrame { 0 };
+        unsigned int nrFrames { 0 };
+        // Number of frames ended since the capture started, and captured
+        unsigned int frameCounter { 0 };
+        unsigned int nrFramesCaptured { 0 };
+
+        // Alignment of the rows of the pixel transfers, and buffers bound for
+        // them
+        GLint packAlignment { 4 };
+        GLint unpackAlignment { 4 };
+        GLuint packBuffer { 0 };
+        GLuint unpackBuffer { 0 };
+
+        // Identifiers of the fences, which are pointers
+        std::map<GLsync, std::uint32_t> syncs;
+        std::uint32_t nrSyncs { 0 };
+
+        // Original functions of GLAD
+        GLCaptureFunctions original;
+    };
+
+    // State of the capture, created when it is first used
+    static GLCaptureState& getCaptureState()
+    {
+        static GLCaptureState state;
+        return state;
+    }
+
+    // Data read by a call, written with its size
+    struct GLCaptureBlob
+    {
+        const void* data;
+        size_t size;
+    };
+
+    // Size in bytes of an image in the memory of the application, with the
+    // rows aligned as set with glPixelStorei
+    static size_t getImageSize(GLenum format, GLenum type, GLsizei width, GLsizei height,
+                               GLsizei depth, GLint alignment)
+    {
+        if (width <= 0 || height <= 0 || depth <= 0)
+            return 0;
+
+        size_t components;
+        switch (format)
+        {
+            case GL_RG:
+            case GL_RG_INTEGER:
+                components = 2;
+                break;
+            case GL_RGB:
+            case GL_BGR:
+            case GL_RGB_INTEGER:
+            case GL_BGR_INTEGER:
+                components = 3;
+                break;
+            case GL_RGBA:
+            case GL_BGRA:
+            case GL_RGBA_INTEGER:
+            case GL_BGRA_INTEGER:
+                components = 4;
+                break;
+            default:
+                components = 1;
+        }
+
+        // The packed types have all the components in a single value
+        size_t pixelSize;
+        switch (type)
+        {
+            case GL_UNSIGNED_BYTE:
+            case GL_BYTE:
+                pixelSize = components;
+                break;
+            case GL_UNSIGNED_SHORT:
+            case GL_SHORT:
+            case GL_HALF_FLOAT:
+                pixelSize = 2 * components;
+                break;
+            case GL_UNSIGNED_INT:
+            case GL_INT:
+            case GL_FLOAT:
+                pixelSize = 4 * components;
+                break;
+            case GL_UNSIGNED_BYTE_3_3_2:
+            case GL_UNSIGNED_BYTE_2_3_3_REV:
+                pixelSize = 1;
+                break;
+            case GL_UNSIGNED_SHORT_5_6_5:
+            case GL_UNSIGNED_SHORT_5_6_5_REV:
+            case GL_UNSIGNED_SHORT_4_4_4_4:
+            case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+            case GL_UNSIGNED_SHORT_5_5_5_1:
+            case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+                pixelSize = 2;
+                break;
+            case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+                pixelSize = 8;
+                break;
+            default:
+                pixelSize = 4;
+        }
+
+        // The last row is not padded
+        const size_t rowSize { width * pixelSize };
+        const size_t alignedRowSize { alignment > 1 ? (rowSize + alignment - 1) / alignment * alignment : rowSize };
+        return alignedRowSize * ((size_t)height * depth - 1) + rowSize;
+    }
+
+    // Methods to write values to the stream
+    template <typename T>
+    static void writeValue(std::vector<unsigned char>& stream, const T& value)
+    {
+        const unsigned char* bytes { reinterpret_cast<const unsigned char*>(&value) };
+        stream.insert(stream.end(), bytes, bytes + sizeof(T));
+    }
+    static void writeValue(std::vector<unsigned char>& stream, const GLCaptureBlob& blob)
+    {
+        writeValue(stream, (std::uint32_t)blob.size);
+        const unsigned char* bytes { static_cast<const unsigned char*>(blob.data) };
+        stream.insert(stream.end(), bytes, bytes + blob.size);
+    }
+    // The strings are written with the null character, so the replay can use
+    // them from the stream
+    static void writeValue(std::vector<unsigned char>& stream, const std::string& string)
+    {
+        writeValue(stream, GLCaptureBlob { string.c_str(), string.size() + 1 });
+    }
+
+    // Method to compress the stream written so far to the file
+    static void flushCapture(GLCaptureState& state)
+    {
+        if (state.stream.empty())
+            return;
+        std::vector<unsigned char> compressed(LZ4::compressBound((int)state.stream.size()));
+        const int compressedSize { LZ4::compressBlock(state.stream.data(), (int)state.stream.size(),
+                                                      compressed.data(), (int)compressed.size()) };
+        const std::uint32_t size { (std::uint32_t)state.stream.size() };
+        state.file.write(reinterpret_cast<const char*>(&size), sizeof(std::uint32_t));
+        // The blocks that do not get smaller are stored as they are
+        if (compressedSize > 0 && (std::uint32_t)compressedSize < size)
+        {
+            const std::uint32_t storedSize { (std::uint32_t)compressedSize };
+            state.file.write(reinterpret_cast<const char*>(&storedSize), sizeof(std::uint32_t));
+            state.file.write(reinterpret_cast<const char*>(compressed.data()), compressedSize);
+        }
+        else
+        {
+            const std::uint32_t storedSize { 0 };
+            state.file.write(reinterpret_cast<const char*>(&storedSize), sizeof(std::uint32_t));
+            state.file.write(reinterpret_cast<const char*>(state.stream.data()), size);
+        }
+        state.stream.clear();
+    }
+
+    // Method to write a call with its parameters
+    template <typename... Args>
+    static void writeCall(GLCaptureCall call, const Args&... args)
+    {
+        GLCaptureState& state { getCaptureState() };
+        writeValue(state.stream, (std::uint16_t)call);
+        const int expand[] { 0, (writeValue(state.stream, args), 0)... };
+        (void)expand;
+        if (state.stream.size() >= GL_CAPTURE_BLOCK_SIZE)
+            flushCapture(state);
+    }
+
+    // Method to write a pointer, which is an offset in a buffer
+    static std::uint64_t getOffset(const void* pointer)
+    {
+        return (std::uint64_t)(std::uintptr_t)pointer;
+    }
+
+    // Method to get the identifier of a fence, or 0 if it was not captured
+    static std::uint32_t getSyncID(GLsync sync)
+    {
+        GLCaptureState& state { getCaptureState() };
+        const auto found { state.syncs.find(sync) };
+        return found == state.syncs.end() ? 0 : found->second;
+    }
+
+    //==============================
+    // Functions that replace the ones of GLAD while capturing
+    //==============================
+
+    static GLCaptureFunctions& getOriginal()
+    {
+        return getCaptureState().original;
+    }
+
+    static void APIENTRY captureActiveTexture(GLenum texture)
+    {
+        writeCall(CALL_ActiveTexture, texture);
+        getOriginal().ActiveTexture(texture);
+    }
+
+    static void APIENTRY captureAttachShader(GLuint program, GLuint shader)
+    {
+        writeCall(CALL_AttachShader, program, shader);
+        getOriginal().AttachShader(program, shader);
+    }
+
+    static void APIENTRY captureBindBuffer(GLenum target, GLuint buffer)
+    {
+        GLCaptureState& state { getCaptureState() };
+        if (target == GL_PIXEL_PACK_BUFFER)
+            state.packBuffer = buffer;
+        else if (target == GL_PIXEL_UNPACK_BUFFER)
+            state.unpackBuffer = buffer;
+        writeCall(CALL_BindBuffer, target, buffer);
+        state.original.BindBuffer(target, buffer);
+    }
+
+    static void APIENTRY captureBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+    {
+        writeCall(CALL_BindBufferBase, target, index, buffer);
+        getOriginal().BindBufferBase(target, index, buffer);
+    }
+
+    static void APIENTRY captureBindFramebuffer(GLenum target, GLuint framebuffer)
+    {
+        writeCall(CALL_BindFramebuffer, target, framebuffer);
+        getOriginal().BindFramebuffer(target, framebuffer);
+    }
+
+    static void APIENTRY captureBindRenderbuffer(GLenum target, GLuint renderbuffer)
+    {
+        writeCall(CALL_BindRenderbuffer, target, renderbuffer);
+        getOriginal().BindRenderbuffer(target, renderbuffer);
+    }
+
+    static void APIENTRY captureBindSampler(GLuint unit, GLuint sampler)
+    {
+        writeCall(CALL_BindSampler, unit, sampler);
+        getOriginal().BindSampler(unit, sampler);
+    }
+
+    static void APIENTRY captureBindTexture(GLenum target, GLuint texture)
+    {
+        writeCall(CALL_BindTexture, target, texture);
+        getOriginal().BindTexture(target, texture);
+    }
+
+    static void APIENTRY captureBindVertexArray(GLuint array)
+    {
+        writeCall(CALL_BindVertexArray, array);
+        getOriginal().BindVertexArray(array);
+    }
+
+    static void APIENTRY captureBlendEquation(GLenum mode)
+    {
+        writeCall(CALL_BlendEquation, mode);
+        getOriginal().BlendEquation(mode);
+    }
+
+    static void APIENTRY captureBlendFunc(GLenum sfactor, GLenum dfactor)
+    {
+        writeCall(CALL_BlendFunc, sfactor, dfactor);
+        getOriginal().BlendFunc(sfactor, dfactor);
+    }
+
+    static void APIENTRY captureBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                                                GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                                                GLbitfield mask, GLenum filter)
+    {
+        writeCall(CALL_BlitFramebuffer, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+        getOriginal().BlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+    }
+
+    static void APIENTRY captureBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage)
+    {
+        if (data == nullptr)
+            writeCall(CALL_BufferData, target, (std::uint64_t)size, usage, DATA_NONE);
+        else
+            writeCall(CALL_BufferData, target, (std::uint64_t)size, usage, DATA_STREAM,
+                      GLCaptureBlob { data, (size_t)size });
+        getOriginal().BufferData(target, size, data, usage);
+    }
+
+    static void APIENTRY captureBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+    {
+        writeCall(CALL_BufferSubData, target, (std::uint64_t)offset, GLCaptureBlob { data, (size_t)size });
+        getOriginal().BufferSubData(target, offset, size, data);
+    }
+
+    static void APIENTRY captureClear(GLbitfield mask)
+    {
+        writeCall(CALL_Clear, mask);
+        getOriginal().Clear(mask);
+    }
+
+    static void APIENTRY captureClearBufferfv(GLenum buffer, GLint drawbuffer, const GLfloat* value)
+    {
+        writeCall(CALL_ClearBufferfv, buffer, drawbuffer,
+                  GLCaptureBlob { value, (buffer == GL_COLOR ? 4 : 1) * sizeof(GLfloat) });
+        getOriginal().ClearBufferfv(buffer, drawbuffer, value);
+    }
+
+    static void APIENTRY captureClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+    {
+        writeCall(CALL_ClearColor, red, green, blue, alpha);
+        getOriginal().ClearColor(red, green, blue, alpha);
+    }
+
+    static void APIENTRY captureClearDepth(GLdouble depth)
+    {
+        writeCall(CALL_ClearDepth, depth);
+        getOriginal().ClearDepth(depth);
+    }
+
+    static GLenum APIENTRY captureClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+    {
+        writeCall(CALL_ClientWaitSync, getSyncID(sync), flags, timeout);
+        return getOriginal().ClientWaitSync(sync, flags, timeout);
+    }
+
+    static void APIENTRY captureCompileShader(GLuint shader)
+    {
+        writeCall(CALL_CompileShader, shader);
+        getOriginal().CompileShader(shader);
+    }
+
+    static GLuint APIENTRY captureCreateProgram()
+    {
+        const GLuint program { getOriginal().CreateProgram() };
+        writeCall(CALL_CreateProgram, program);
+        return program;
+    }
+
+    static GLuint APIENTRY captureCreateShader(GLenum type)
+    {
+        const GLuint shader { getOriginal().CreateShader(type) };
+        writeCall(CALL_CreateShader, type, shader);
+        return shader;
+    }
+
+    static void APIENTRY captureCullFace(GLenum mode)
+    {
+        writeCall(CALL_CullFace, mode);
+        getOriginal().CullFace(mode);
+    }
+
+    static void APIENTRY captureDeleteBuffers(GLsizei n, const GLuint* buffers)
+    {
+        writeCall(CALL_DeleteBuffers, n, GLCaptureBlob { buffers, n * sizeof(GLuint) });
+        getOriginal().DeleteBuffers(n, buffers);
+    }
+
+    static void APIENTRY captureDeleteFramebuffers(GLsizei n, const GLuint* framebuffers)
+    {
+        writeCall(CALL_DeleteFramebuffers, n, GLCaptureBlob { framebuffers, n * sizeof(GLuint) });
+        getOriginal().DeleteFramebuffers(n, framebuffers);
+    }
+
+    static void APIENTRY captureDeleteRenderbuffers(GLsizei n, const GLuint* renderbuffers)
+    {
+        writeCall(CALL_DeleteRenderbuffers, n, GLCaptureBlob { renderbuffers, n * sizeof(GLuint) });
+        getOriginal().DeleteRenderbuffers(n, renderbuffers);
+    }
+
+    static void APIENTRY captureDeleteSamplers(GLsizei count, const GLuint* samplers)
+    {
+        writeCall(CALL_DeleteSamplers, count, GLCaptureBlob { samplers, count * sizeof(GLuint) });
+        getOriginal().DeleteSamplers(count, samplers);
+    }
+
+    static void APIENTRY captureDeleteShader(GLuint shader)
+    {
+        writeCall(CALL_DeleteShader, shader);
+        getOriginal().DeleteShader(shader);
+    }
+
+    static void APIENTRY captureDeleteSync(GLsync sync)
+    {
+        GLCaptureState& state { getCaptureState() };
+        writeCall(CALL_DeleteSync, getSyncID(sync));
+        state.syncs.erase(sync);
+        state.original.DeleteSync(sync);
+    }
+
+    static void APIENTRY captureDeleteTextures(GLsizei n, const GLuint* textures)
+    {
+        writeCall(CALL_DeleteTextures, n, GLCaptureBlob { textures, n * sizeof(GLuint) });
+        getOriginal().DeleteTextures(n, textures);
+    }
+
+    static void APIENTRY captureDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+    {
+        writeCall(CALL_DeleteVertexArrays, n, GLCaptureBlob { arrays, n * sizeof(GLuint) });
+        getOriginal().DeleteVertexArrays(n, arrays);
+    }
+
+    static void APIENTRY captureDepthFunc(GLenum func)
+    {
+        writeCall(CALL_DepthFunc, func);
+        getOriginal().DepthFunc(func);
+    }
+
+    static void APIENTRY captureDepthMask(GLboolean flag)
+    {
+        writeCall(CALL_DepthMask, flag);
+        getOriginal().DepthMask(flag);
+    }
+
+    static void APIENTRY captureDisable(GLenum cap)
+    {
+        writeCall(CALL_Disable, cap);
+        getOriginal().Disable(cap);
+    }
+
+    static void APIENTRY captureDrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        writeCall(CALL_DrawArrays, mode, first, count);
+        getOriginal().DrawArrays(mode, first, count);
+    }
+
+    static void APIENTRY captureDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+    {
+        writeCall(CALL_DrawArraysInstanced, mode, first, count, instancecount);
+        getOriginal().DrawArraysInstanced(mode, first, count, instancecount);
+    }
+
+    static void APIENTRY captureDrawBuffer(GLenum buf)
+    {
+        writeCall(CALL_DrawBuffer, buf);
+        getOriginal().DrawBuffer(buf);
+    }
+
+    static void APIENTRY captureDrawBuffers(GLsizei n, const GLenum* bufs)
+    {
+        writeCall(CALL_DrawBuffers, n, GLCaptureBlob { bufs, n * sizeof(GLenum) });
+        getOriginal().DrawBuffers(n, bufs);
+    }
+
+    // The indices are always in the element buffer, since the core profile
+    // has no arrays in the memory of the application
+    static void APIENTRY captureDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        writeCall(CALL_DrawElements, mode, count, type, getOffset(indices));
+        getOriginal().DrawElements(mode, count, type, indices);
+    }
+
+    static void APIENTRY captureDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices,
+                                                      GLsizei instancecount)
+    {
+        writeCall(CALL_DrawElementsInstanced, mode, count, type, getOffset(indices), instancecount);
+        getOriginal().DrawElementsInstanced(mode, count, type, indices, instancecount);
+    }
+
+    static void APIENTRY captureEnable(GLenum cap)
+    {
+        writeCall(CALL_Enable, cap);
+        getOriginal().Enable(cap);
+    }
+
+    static void APIENTRY captureEnableVertexAttribArray(GLuint index)
+    {
+        writeCall(CALL_EnableVertexAttribArray, index);
+        getOriginal().EnableVertexAttribArray(index);
+    }
+
+    static GLsync APIENTRY captureFenceSync(GLenum condition, GLbitfield flags)
+    {
+        GLCaptureState& state { getCaptureState() };
+        const GLsync sync { state.original.FenceSync(condition, flags) };
+        state.syncs[sync] = ++state.nrSyncs;
+        writeCall(CALL_FenceSync, condition, flags, state.nrSyncs);
+        return sync;
+    }
+
+    static void APIENTRY captureFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget,
+                                                        GLuint renderbuffer)
+    {
+        writeCall(CALL_FramebufferRenderbuffer, target, attachment, renderbuffertarget, renderbuffer);
+        getOriginal().FramebufferRenderbuffer(target, attachment, renderbuffertarget, renderbuffer);
+    }
+
+    static void APIENTRY captureFramebufferTexture(GLenum target, GLenum attachment, GLuint texture, GLint level)
+    {
+        writeCall(CALL_FramebufferTexture, target, attachment, texture, level);
+        getOriginal().FramebufferTexture(target, attachment, texture, level);
+    }
+
+    static void APIENTRY captureFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget,
+                                                     GLuint texture, GLint level)
+    {
+        writeCall(CALL_FramebufferTexture2D, target, attachment, textarget, texture, level);
+        getOriginal().FramebufferTexture2D(target, attachment, textarget, texture, level);
+    }
+
+    static void APIENTRY captureFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture,
+                                                        GLint level, GLint layer)
+    {
+        writeCall(CALL_FramebufferTextureLayer, target, attachment, texture, level, layer);
+        getOriginal().FramebufferTextureLayer(target, attachment, texture, level, layer);
+    }
+
+    // The names are written after they are created
+    static void APIENTRY captureGenBuffers(GLsizei n, GLuint* buffers)
+    {
+        getOriginal().GenBuffers(n, buffers);
+        writeCall(CALL_GenBuffers, n, GLCaptureBlob { buffers, n * sizeof(GLuint) });
+    }
+
+    static void APIENTRY captureGenFramebuffers(GLsizei n, GLuint* framebuffers)
+    {
+        getOriginal().GenFramebuffers(n, framebuffers);
+        writeCall(CALL_GenFramebuffers, n, GLCaptureBlob { framebuffers, n * sizeof(GLuint) });
+    }
+
+    static void APIENTRY captureGenRenderbuffers(GLsizei n, GLuint* renderbuffers)
+    {
+        getOriginal().GenRenderbuffers(n, renderbuffers);
+        writeCall(CALL_GenRenderbuffers, n, GLCaptureBlob { renderbuffers, n * sizeof(GLuint) });
+    }
+
+    static void APIENTRY captureGenSamplers(GLsizei count, GLuint* samplers)
+    {
+        getOriginal().GenSamplers(count, samplers);
+        writeCall(CALL_GenSamplers, count, GLCaptureBlob { samplers, count * sizeof(GLuint) });
+    }
+
+    static void APIENTRY captureGenTextures(GLsizei n, GLuint* textures)
+    {
+        getOriginal().GenTextures(n, textures);
+        writeCall(CALL_GenTextures, n, GLCaptureBlob { textures, n * sizeof(GLuint) });
+    }
+
+    static void APIENTRY captureGenVertexArrays(GLsizei n, GLuint* arrays)
+    {
+        getOriginal().GenVertexArrays(n, arrays);
+        writeCall(CALL_GenVertexArrays, n, GLCaptureBlob { arrays, n * sizeof(GLuint) });
+    }
+
+    static void APIENTRY captureGenerateMipmap(GLenum target)
+    {
+        writeCall(CALL_GenerateMipmap, target);
+        getOriginal().GenerateMipmap(target);
+    }
+
+    static void APIENTRY captureGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void* data)
+    {
+        writeCall(CALL_GetBufferSubData, target, (std::uint64_t)offset, (std::uint64_t)size);
+        getOriginal().GetBufferSubData(target, offset, size, data);
+    }
+
+    // The location is written with the name, so the replay can find the one
+    // of the uniform in its program
+    static GLint APIENTRY captureGetUniformLocation(GLuint program, const GLchar* name)
+    {
+        const GLint location { getOriginal().GetUniformLocation(program, name) };
+        writeCall(CALL_GetUniformLocation, program, location, std::string(name));
+        return location;
+    }
+
+    static void APIENTRY captureLinkProgram(GLuint program)
+    {
+        writeCall(CALL_LinkProgram, program);
+        getOriginal().LinkProgram(program);
+    }
+
+    static void APIENTRY capturePixelStorei(GLenum pname, GLint param)
+    {
+        GLCaptureState& state { getCaptureState() };
+        if (pname == GL_PACK_ALIGNMENT)
+            state.packAlignment = param;
+        else if (pname == GL_UNPACK_ALIGNMENT)
+            state.unpackAlignment = param;
+        writeCall(CALL_PixelStorei, pname, param);
+        state.original.PixelStorei(pname, param);
+    }
+
+    static void APIENTRY captureReadBuffer(GLenum src)
+    {
+        writeCall(CALL_ReadBuffer, src);
+        getOriginal().ReadBuffer(src);
+    }
+
+    // The pixels read to the memory of the application are not written, only
+    // their size, so the replay reads the same
+    static void APIENTRY captureReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format,
+                                           GLenum type, void* pixels)
+    {
+        GLCaptureState& state { getCaptureState() };
+        if (state.packBuffer != 0)
+            writeCall(CALL_ReadPixels, x, y, width, height, format, type, DATA_BUFFER_OFFSET,
+                      getOffset(pixels));
+        else
+            writeCall(CALL_ReadPixels, x, y, width, height, format, type, DATA_STREAM,
+                      (std::uint64_t)getImageSize(format, type, width, height, 1, state.packAlignment));
+        state.original.ReadPixels(x, y, width, height, format, type, pixels);
+    }
+
+    static void APIENTRY captureRenderbufferStorage(GLenum target, GLenum internalformat, GLsizei width,
+                                                    GLsizei height)
+    {
+        writeCall(CALL_RenderbufferStorage, target, internalformat, width, height);
+        getOriginal().RenderbufferStorage(target, internalformat, width, height);
+    }
+
+    static void APIENTRY captureSamplerParameteri(GLuint sampler, GLenum pname, GLint param)
+    {
+        writeCall(CALL_SamplerParameteri, sampler, pname, param);
+        getOriginal().SamplerParameteri(sampler, pname, param);
+    }
+
+    static void APIENTRY captureScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        writeCall(CALL_Scissor, x, y, width, height);
+        getOriginal().Scissor(x, y, width, height);
+    }
+
+    // The strings of the source are written joined
+    static void APIENTRY captureShaderSource(GLuint shader, GLsizei count, const GLchar* const* string,
+                                             const GLint* length)
+    {
+        std::string source;
+        for (GLsizei i = 0; i < count; ++i)
+        {
+            if (length == nullptr || length[i] < 0)
+                source += string[i];
+            else
+                source.append(string[i], length[i]);
+        }
+        writeCall(CALL_ShaderSource, shader, source);
+        getOriginal().ShaderSource(shader, count, string, length);
+    }
+
+    static void APIENTRY captureStencilFunc(GLenum func, GLint ref, GLuint mask)
+    {
+        writeCall(CALL_StencilFunc, func, ref, mask);
+        getOriginal().StencilFunc(func, ref, mask);
+    }
+
+    static void APIENTRY captureStencilMask(GLuint mask)
+    {
+        writeCall(CALL_StencilMask, mask);
+        getOriginal().StencilMask(mask);
+    }
+
+    static void APIENTRY captureStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+    {
+        writeCall(CALL_StencilOp, fail, zfail, zpass);
+        getOriginal().StencilOp(fail, zfail, zpass);
+    }
+
+    static void APIENTRY captureTexBuffer(GLenum target, GLenum internalformat, GLuint buffer)
+    {
+        writeCall(CALL_TexBuffer, target, internalformat, buffer);
+        getOriginal().TexBuffer(target, internalformat, buffer);
+    }
+
+    // Method to write the pixels read by glTexImage2D and glTexImage3D
+    static void writeTexImage(GLCaptureCall call, GLenum target, GLint level, GLint internalformat,
+                              GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format,
+                              GLenum type, const void* pixels)
+    {
+        GLCaptureState& state { getCaptureState() };
+        if (state.unpackBuffer != 0)
+            writeCall(call, target, level, internalformat, width, height, depth, border, format, type,
+                      DATA_BUFFER_OFFSET, getOffset(pixels));
+        else if (pixels == nullptr)
+            writeCall(call, target, level, internalformat, width, height, depth, border, format, type,
+                      DATA_NONE);
+        else
+            writeCall(call, target, level, internalformat, width, height, depth, border, format, type,
+                      DATA_STREAM, GLCaptureBlob { pixels, getImageSize(format, type, width, height, depth,
+                                                                        state.unpackAlignment) });
+    }
+
+    static void APIENTRY captureTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                                           GLsizei height, GLint border, GLenum format, GLenum type,
+                                           const void* pixels)
+    {
+        writeTexImage(CALL_TexImage2D, target, level, internalformat, width, height, 1, border, format, type,
+                      pixels);
+        getOriginal().TexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+    }
+
+    static void APIENTRY captureTexImage3D(GLenum target, GLint level, GLint internalformat, GLsizei width,
+                                           GLsizei height, GLsizei depth, GLint border, GLenum format,
+                                           GLenum type, const void* pixels)
+    {
+        writeTexImage(CALL_TexImage3D, target, level, internalformat, width, height, depth, border, format,
+                      type, pixels);
+        getOriginal().TexImage3D(target, level, internalformat, width, height, depth, border, format, type,
+                                 pixels);
+    }
+
+    static void APIENTRY captureTexParameterfv(GLenum target, GLenum pname, const GLfloat* params)
+    {
+        writeCall(CALL_TexParameterfv, target, pname,
+                  GLCaptureBlob { params, (pname == GL_TEXTURE_BORDER_COLOR ? 4 : 1) * sizeof(GLfloat) });
+        getOriginal().TexParameterfv(target, pname, params);
+    }
+
+    static void APIENTRY captureTexParameteri(GLenum target, GLenum pname, GLint param)
+    {
+        writeCall(CALL_TexParameteri, target, pname, param);
+        getOriginal().TexParameteri(target, pname, param);
+    }
+
+    static void APIENTRY captureUniform1f(GLint location, GLfloat v0)
+    {
+        writeCall(CALL_Uniform1f, location, v0);
+        getOriginal().Uniform1f(location, v0);
+    }
+
+    static void APIENTRY captureUniform1i(GLint location, GLint v0)
+    {
+        writeCall(CALL_Uniform1i, location, v0);
+        getOriginal().Uniform1i(location, v0);
+    }
+
+    static void APIENTRY captureUniform1iv(GLint location, GLsizei count, const GLint* value)
+    {
+        writeCall(CALL_Uniform1iv, location, count, GLCaptureBlob { value, count * sizeof(GLint) });
+        getOriginal().Uniform1iv(location, count, value);
+    }
+
+    static void APIENTRY captureUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        writeCall(CALL_Uniform2fv, location, count, GLCaptureBlob { value, 2 * count * sizeof(GLfloat) });
+        getOriginal().Uniform2fv(location, count, value);
+    }
+
+    static void APIENTRY captureUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+    {
+        writeCall(CALL_Uniform3f, location, v0, v1, v2);
+        getOriginal().Uniform3f(location, v0, v1, v2);
+    }
+
+    static void APIENTRY captureUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        writeCall(CALL_Uniform3fv, location, count, GLCaptureBlob { value, 3 * count * sizeof(GLfloat) });
+        getOriginal().Uniform3fv(location, count, value);
+    }
+
+    static void APIENTRY captureUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+    {
+        writeCall(CALL_Uniform4f, location, v0, v1, v2, v3);
+        getOriginal().Uniform4f(location, v0, v1, v2, v3);
+    }
+
+    static void APIENTRY captureUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        writeCall(CALL_Uniform4fv, location, count, GLCaptureBlob { value, 4 * count * sizeof(GLfloat) });
+        getOriginal().Uniform4fv(location, count, value);
+    }
+
+    static void APIENTRY captureUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose,
+                                                 const GLfloat* value)
+    {
+        writeCall(CALL_UniformMatrix2fv, location, count, transpose,
+                  GLCaptureBlob { value, 4 * count * sizeof(GLfloat) });
+        getOriginal().UniformMatrix2fv(location, count, transpose, value);
+    }
+
+    static void APIENTRY captureUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose,
+                                                 const GLfloat* value)
+    {
+        writeCall(CALL_UniformMatrix3fv, location, count, transpose,
+                  GLCaptureBlob { value, 9 * count * sizeof(GLfloat) });
+        getOriginal().UniformMatrix3fv(location, count, transpose, value);
+    }
+
+    static void APIENTRY captureUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose,
+                                                 const GLfloat* value)
+    {
+        writeCall(CALL_UniformMatrix4fv, location, count, transpose,
+                  GLCaptureBlob { value, 16 * count * sizeof(GLfloat) });
+        getOriginal().UniformMatrix4fv(location, count, transpose, value);
+    }
+
+    static void APIENTRY captureUseProgram(GLuint program)
+    {
+        writeCall(CALL_UseProgram, program);
+        getOriginal().UseProgram(program);
+    }
+
+    static void APIENTRY captureVertexAttribDivisor(GLuint index, GLuint divisor)
+    {
+        writeCall(CALL_VertexAttribDivisor, index, divisor);
+        getOriginal().VertexAttribDivisor(index, divisor);
+    }
+
+    // The pointer is always an offset in the array buffer, as with the indices
+    static void APIENTRY captureVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+                                                    GLsizei stride, const void* pointer)
+    {
+        writeCall(CALL_VertexAttribPointer, index, size, type, normalized, stride, getOffset(pointer));
+        getOriginal().VertexAttribPointer(index, size, type, normalized, stride, pointer);
+    }
+
+    static void APIENTRY captureViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    {
+        writeCall(CALL_Viewport, x, y, width, height);
+        getOriginal().Viewport(x, y, width, height);
+    }
+
+    //==============================
+    // Methods of the GLCapture class
+    //==============================
+
+    // Method to start capturing to a file
+    bool GLCapture::start(const std::string& path, int width, int height,
+                          unsigned int firstFrame, unsigned int nrFrames)
+    {
+        stop();
+        GLCaptureState& state { getCaptureState() };
+        state.file.open(path, std::ios::binary | std::ios::trunc);
+        if (!state.file)
+        {
+            std::cout << "ERROR::GL_CAPTURE::FILE_NOT_WRITTEN: " << path << '\n';
+            return false;
+        }
+
+        // The number of frames is written when the capture finishes
+        const char* renderer { reinterpret_cast<const char*>(glGetString(GL_RENDERER)) };
+        const std::string rendererName { renderer != nullptr ? renderer : "" };
+        std::vector<unsigned char> header(GL_CAPTURE_MAGIC, GL_CAPTURE_MAGIC + 4);
+        writeValue(header, GL_CAPTURE_VERSION);
+        writeValue(header, (std::int32_t)width);
+        writeValue(header, (std::int32_t)height);
+        writeValue(header, (std::uint32_t)firstFrame);
+        writeValue(header, (std::uint32_t)0);
+        writeValue(header, (std::uint32_t)rendererName.size());
+        header.insert(header.end(), rendererName.begin(), rendererName.end());
+        state.file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+        state.active = true;
+        state.path = path;
+        state.firstFrame = firstFrame;
+        state.nrFrames = nrFrames;
+        state.frameCounter = 0;
+        state.nrFramesCaptured = 0;
+        state.packAlignment = 4;
+        state.unpackAlignment = 4;
+        state.packBuffer = 0;
+        state.unpackBuffer = 0;
+        state.syncs.clear();
+        state.nrSyncs = 0;
+        state.capturingFrames = false;
+        if (firstFrame == 0)
+        {
+            state.capturingFrames = true;
+            writeCall(CALL_FRAMES_START);
+        }
+
+        // Replace the functions of GLAD
+#define GLBASE_CAPTURE_INSTALL(name) state.original.name = glad_gl##name; glad_gl##name = capture##name;
+        GLBASE_CAPTURED_GL_FUNCTIONS(GLBASE_CAPTURE_INSTALL)
+#undef GLBASE_CAPTURE_INSTALL
+
+        return true;
+    }
+
+    // Method to finish the capture
+    void GLCapture::stop()
+    {
+        GLCaptureState& state { getCaptureState() };
+        if (!state.active)
+            return;
+
+#define GLBASE_CAPTURE_RESTORE(name) glad_gl##name = state.original.name;
+        GLBASE_CAPTURED_GL_FUNCTIONS(GLBASE_CAPTURE_RESTORE)
+#undef GLBASE_CAPTURE_RESTORE
+
+        flushCapture(state);
+        const std::uint32_t nrFrames { state.nrFramesCaptured };
+        state.file.seekp(GL_CAPTURE_NR_FRAMES_OFFSET);
+        state.file.write(reinterpret_cast<const char*>(&nrFrames), sizeof(std::uint32_t));
+        state.file.close();
+        state.active = false;
+        state.capturingFrames = false;
+        state.stream.clear();
+        state.stream.shrink_to_fit();
+        std::cout << "GL calls of " << nrFrames << " frames captured to " << state.path << '\n';
+    }
+
+    // Method to check if the calls are being captured
+    bool GLCapture::isActive()
+    {
+        return getCaptureState().active;
+    }
+
+    // Method to end a frame
+    void GLCapture::endFrame()
+    {
+        GLCaptureState& state { getCaptureState() };
+        if (!state.active)
+            return;
+
+        ++state.frameCounter;
+        if (state.capturingFrames)
+        {
+            writeCall(CALL_FRAME_END);
+            ++state.nrFramesCaptured;
+            if (state.nrFramesCaptured >= state.nrFrames)
+                stop();
+        }
+        else if (state.frameCounter >= state.firstFrame)
+        {
+            state.capturingFrames = true;
+            writeCall(CALL_FRAMES_START);
+        }
+    }
+
+    // Methods to start and end a pass of the frame
+    void GLCapture::beginPass(const std::string& name)
+    {
+        if (getCaptureState().capturingFrames)
+            writeCall(CALL_PASS_BEGIN, name);
+    }
+
+    void GLCapture::endPass()
+    {
+        if (getCaptureState().capturingFrames)
+            writeCall(CALL_PASS_END);
+    }
+
+    //==============================
+    // Methods of the GLCaptureReplay class
+    //==============================
+
+    // Constructor
+    GLCaptureReplay::GLCaptureReplay() :
+        mWidth { 0 }, mHeight { 0 }, mNrFrames { 0 }, mPosition { 0 }, mFramesPosition { 0 },
+        mGPUProfiler { nullptr }, mFrameIndex { 0 }, mCurrentProgram { 0 }, mNrCalls { 0 }, mNrDraws { 0 }
+    {
+    }
+
+    // Method to load a capture
+    bool GLCaptureReplay::load(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            std::cout << "ERROR::GL_CAPTURE::FILE_NOT_READ: " << path << '\n';
+            return false;
+        }
+        // Size of the file, to check the sizes of the blocks against it
+        const std::uint64_t fileSize { (std::uint64_t)file.tellg() };
+        file.seekg(0);
+
+        char magic[4];
+        std::uint32_t version;
+        std::int32_t width;
+        std::int32_t height;
+        std::uint32_t firstFrame;
+        std::uint32_t nrFrames;
+        std::uint32_t rendererLength;
+        file.read(magic, 4);
+        file.read(reinterpret_cast<char*>(&version), sizeof(std::uint32_t));
+        file.read(reinterpret_cast<char*>(&width), sizeof(std::int32_t));
+        file.read(reinterpret_cast<char*>(&height), sizeof(std::int32_t));
+        file.read(reinterpret_cast<char*>(&firstFrame), sizeof(std::uint32_t));
+        file.read(reinterpret_cast<char*>(&nrFrames), sizeof(std::uint32_t));
+        file.read(reinterpret_cast<char*>(&rendererLength), sizeof(std::uint32_t));
+        if (!file || std::memcmp(magic, GL_CAPTURE_MAGIC, 4) != 0 || version != GL_CAPTURE_VERSION ||
+            rendererLength > 1024)
+        {
+            std::cout << "ERROR::GL_CAPTURE::INVALID_CAPTURE: " << path << '\n';
+            return false;
+        }
+        std::string renderer(rendererLength, '\0');
+        file.read(&renderer[0], rendererLength);
+
+        // Decompress all the blocks
+        std::vector<unsigned char> stream;
+        std::vector<unsigned char> block;
+        std::uint32_t sizes[2];
+        while (file.read(reinterpret_cast<char*>(sizes), sizeof(sizes)))
+        {
+            // Check the sizes against the rest of the file before allocating
+            // anything
+            const std::uint64_t remaining { fileSize - (std::uint64_t)file.tellg() };
+            const std::uint64_t storedSize { sizes[1] == 0 ? sizes[0] : sizes[1] };
+            if (sizes[0] > GL_CAPTURE_MAX_BLOCK_SIZE || storedSize > remaining ||
+                sizes[0] > storedSize * GL_CAPTURE_LZ4_MAX_RATIO)
+            {
+                std::cout << "ERROR::GL_CAPTURE::INVALID_BLOCK_SIZE: " << path << '\n';
+                return false;
+            }
+
+            const size_t start { stream.size() };
+            stream.resize(start + sizes[0]);
+            bool valid;
+            if (sizes[1] == 0)
+                valid = (bool)file.read(reinterpret_cast<char*>(stream.data() + start), sizes[0]);
+            else
+            {
+                block.resize(sizes[1]);
+                valid = file.read(reinterpret_cast<char*>(block.data()), sizes[1]) &&
+                        LZ4::decompressBlock(block.data(), (int)sizes[1], stream.data() + start,
+                                             (int)sizes[0]) == (int)sizes[0];
+            }
+            if (!valid)
+            {
+                std::cout << "ERROR::GL_CAPTURE::INVALID_CAPTURE: " << path << '\n';
+                return false;
+            }
+        }
+
+        mWidth = width;
+        mHeight = height;
+        mNrFrames = nrFrames;
+        mRenderer = renderer;
+        mStream.swap(stream);
+        mPosition = 0;
+        mFramesPosition = mStream.size();
+        mFrameIndex = 0;
+        mPassNames.clear();
+        return true;
+    }
+
+    // Methods to read values of the stream. The capture is assumed to be
+    // valid, so the sizes are only checked against the end of the stream
+    template <typename T>
+    T GLCaptureReplay::read()
+    {
+        T value {};
+        if (mPosition + sizeof(T) <= mStream.size())
+            std::memcpy(&value, mStream.data() + mPosition, sizeof(T));
+        mPosition += sizeof(T);
+        return value;
+    }
+
+    const void* GLCaptureReplay::readData(size_t& size)
+    {
+        size = read<std::uint32_t>();
+        if (mPosition + size > mStream.size())
+        {
+            mPosition = mStream.size();
+            size = 0;
+            return nullptr;
+        }
+        const void* data { mStream.data() + mPosition };
+        mPosition += size;
+        return data;
+    }
+
+    const char* GLCaptureReplay::readString()
+    {
+        size_t size;
+        const char* string { static_cast<const char*>(readData(size)) };
+        return string != nullptr ? string : "";
+    }
+
+    // Method to get the name of the replay of an object of the capture
+    GLuint GLCaptureReplay::mapName(const std::vector<GLuint>& names, GLuint name)
+    {
+        return name < names.size() ? names[name] : 0;
+    }
+
+    // Method to add the names of the objects created in the replay
+    void GLCaptureReplay::addNames(std::vector<GLuint>& names, const GLuint* captured,
+                                   const GLuint* created, GLsizei n)
+    {
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            if (captured[i] >= names.size())
+                names.resize(captured[i] + 1, 0);
+            names[captured[i]] = created[i];
+        }
+    }
+
+    // Method to get the location of the replay of a uniform
+    GLint GLCaptureReplay::mapLocation(GLint location) const
+    {
+        if (location < 0)
+            return location;
+        const auto found { mUniformLocations.find(((std::uint64_t)mCurrentProgram << 32) | (std::uint32_t)location) };
+        return found != mUniformLocations.end() ? found->second : location;
+    }
+
+    // Method to close the passes that are open
+    void GLCaptureReplay::closePasses()
+    {
+        while (!mOpenPasses.empty())
+        {
+            mOpenPasses.pop_back();
+            if (mGPUProfiler != nullptr)
+                mGPUProfiler->endScope();
+        }
+    }
+
+    // Method to play the calls before the first frame
+    void GLCaptureReplay::playSetup()
+    {
+        mPosition = 0;
+        mFramesPosition = mStream.size();
+        play();
+        mFrameIndex = 0;
+    }
+
+    // Method to play the next frame
+    bool GLCaptureReplay::playFrame()
+    {
+        if (mNrFrames == 0)
+            return false;
+        if (mFrameIndex == mNrFrames)
+        {
+            mPosition = mFramesPosition;
+            mFrameIndex = 0;
+        }
+        ++mFrameIndex;
+        return play();
+    }
+
+    // Method to play calls until the end of a frame, the start of the frames
+    // or the end of the stream
+    bool GLCaptureReplay::play()
+    {
+        // Method to read the names of a call that creates or deletes objects
+        auto readNames = [this](std::vector<GLuint>& names)
+        {
+            const GLsizei n { read<GLsizei>() };
+            size_t size;
+            const void* data { readData(size) };
+            names.resize(std::max(0, n));
+            if (data != nullptr && size == names.size() * sizeof(GLuint))
+                std::memcpy(names.data(), data, size);
+            else
+                names.assign(names.size(), 0);
+        };
+        std::vector<GLuint> captured;
+        std::vector<GLuint> created;
+
+        mNrCalls = 0;
+        mNrDraws = 0;
+        while (mPosition < mStream.size())
+        {
+            const std::uint16_t call { read<std::uint16_t>() };
+            ++mNrCalls;
+            switch (call)
+            {
+                case CALL_ActiveTexture:
+                {
+                    glActiveTexture(read<GLenum>());
+                    break;
+                }
+                case CALL_AttachShader:
+                {
+                    const GLuint program { read<GLuint>() };
+                    const GLuint shader { read<GLuint>() };
+                    glAttachShader(mapName(mPrograms, program), mapName(mPrograms, shader));
+                    break;
+                }
+                case CALL_BindBuffer:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLuint buffer { read<GLuint>() };
+                    glBindBuffer(target, mapName(mBuffers, buffer));
+                    break;
+                }
+                case CALL_BindBufferBase:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLuint index { read<GLuint>() };
+                    const GLuint buffer { read<GLuint>() };
+                    glBindBufferBase(target, index, mapName(mBuffers, buffer));
+                    break;
+                }
+                case CALL_BindFramebuffer:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLuint framebuffer { read<GLuint>() };
+                    glBindFramebuffer(target, mapName(mFramebuffers, framebuffer));
+                    break;
+                }
+                case CALL_BindRenderbuffer:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLuint renderbuffer { read<GLuint>() };
+                    glBindRenderbuffer(target, mapName(mRenderbuffers, renderbuffer));
+                    break;
+                }
+                case CALL_BindSampler:
+                {
+                    const GLuint unit { read<GLuint>() };
+                    const GLuint sampler { read<GLuint>() };
+                    glBindSampler(unit, mapName(mSamplers, sampler));
+                    break;
+                }
+                case CALL_BindTexture:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLuint texture { read<GLuint>() };
+                    glBindTexture(target, mapName(mTextures, texture));
+                    break;
+                }
+                case CALL_BindVertexArray:
+                {
+                    glBindVertexArray(mapName(mVertexArrays, read<GLuint>()));
+                    break;
+                }
+                case CALL_BlendEquation:
+                {
+                    glBlendEquation(read<GLenum>());
+                    break;
+                }
+                case CALL_BlendFunc:
+                {
+                    const GLenum sfactor { read<GLenum>() };
+                    const GLenum dfactor { read<GLenum>() };
+                    glBlendFunc(sfactor, dfactor);
+                    break;
+                }
+                case CALL_BlitFramebuffer:
+                {
+                    GLint coordinates[8];
+                    for (unsigned int i = 0; i < 8; ++i)
+                        coordinates[i] = read<GLint>();
+                    const GLbitfield mask { read<GLbitfield>() };
+                    const GLenum filter { read<GLenum>() };
+                    if (isWorkEnabled())
+                        glBlitFramebuffer(coordinates[0], coordinates[1], coordinates[2], coordinates[3],
+                                          coordinates[4], coordinates[5], coordinates[6], coordinates[7],
+                                          mask, filter);
+                    break;
+                }
+                case CALL_BufferData:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const std::uint64_t size { read<std::uint64_t>() };
+                    const GLenum usage { read<GLenum>() };
+                    const void* data { nullptr };
+                    if (read<std::uint8_t>() == DATA_STREAM)
+                    {
+                        size_t dataSize;
+                        data = readData(dataSize);
+                    }
+                    glBufferData(target, (GLsizeiptr)size, data, usage);
+                    break;
+                }
+                case CALL_BufferSubData:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const std::uint64_t offset { read<std::uint64_t>() };
+                    size_t size;
+                    const void* data { readData(size) };
+                    glBufferSubData(target, (GLintptr)offset, (GLsizeiptr)size, data);
+                    break;
+                }
+                case CALL_Clear:
+                {
+                    const GLbitfield mask { read<GLbitfield>() };
+                    if (isWorkEnabled())
+                        glClear(mask);
+                    break;
+                }
+                case CALL_ClearBufferfv:
+                {
+                    const GLenum buffer { read<GLenum>() };
+                    const GLint drawbuffer { read<GLint>() };
+                    size_t size;
+                    const void* data { readData(size) };
+                    GLfloat value[4] {};
+                    std::memcpy(value, data, std::min(size, sizeof(value)));
+                    if (isWorkEnabled())
+                        glClearBufferfv(buffer, drawbuffer, value);
+                    break;
+                }
+                case CALL_ClearColor:
+                {
+                    GLfloat color[4];
+                    for (unsigned int i = 0; i < 4; ++i)
+                        color[i] = read<GLfloat>();
+                    glClearColor(color[0], color[1], color[2], color[3]);
+                    break;
+                }
+                case CALL_ClearDepth:
+                {
+                    glClearDepth(read<GLdouble>());
+                    break;
+                }
+                case CALL_ClientWaitSync:
+                {
+                    const std::uint32_t id { read<std::uint32_t>() };
+                    const GLbitfield flags { read<GLbitfield>() };
+                    const GLuint64 timeout { read<GLuint64>() };
+                    if (id < mSyncs.size() && mSyncs[id] != nullptr)
+                        glClientWaitSync(mSyncs[id], flags, timeout);
+                    break;
+                }
+                case CALL_CompileShader:
+                {
+                    glCompileShader(mapName(mPrograms, read<GLuint>()));
+                    break;
+                }
+                case CALL_CreateProgram:
+                {
+                    const GLuint program { read<GLuint>() };
+                    const GLuint createdProgram { glCreateProgram() };
+                    addNames(mPrograms, &program, &createdProgram, 1);
+                    break;
+                }
+                case CALL_CreateShader:
+                {
+                    const GLenum type { read<GLenum>() };
+                    const GLuint shader { read<GLuint>() };
+                    const GLuint createdShader { glCreateShader(type) };
+                    addNames(mPrograms, &shader, &createdShader, 1);
+                    break;
+                }
+                case CALL_CullFace:
+                {
+                    glCullFace(read<GLenum>());
+                    break;
+                }
+                case CALL_DeleteBuffers:
+                case CALL_DeleteFramebuffers:
+                case CALL_DeleteRenderbuffers:
+                case CALL_DeleteSamplers:
+                case CALL_DeleteTextures:
+                case CALL_DeleteVertexArrays:
+                {
+                    readNames(captured);
+                    std::vector<GLuint>& names { call == CALL_DeleteBuffers ? mBuffers
+                                                 : call == CALL_DeleteFramebuffers ? mFramebuffers
+                                                 : call == CALL_DeleteRenderbuffers ? mRenderbuffers
+                                                 : call == CALL_DeleteSamplers ? mSamplers
+                                                 : call == CALL_DeleteTextures ? mTextures : mVertexArrays };
+                    created.resize(captured.size());
+                    for (size_t i = 0; i < captured.size(); ++i)
+                    {
+                        created[i] = mapName(names, captured[i]);
+                        if (captured[i] < names.size())
+                            names[captured[i]] = 0;
+                    }
+                    const GLsizei n { (GLsizei)created.size() };
+                    if (call == CALL_DeleteBuffers)
+                        glDeleteBuffers(n, created.data());
+                    else if (call == CALL_DeleteFramebuffers)
+                        glDeleteFramebuffers(n, created.data());
+                    else if (call == CALL_DeleteRenderbuffers)
+                        glDeleteRenderbuffers(n, created.data());
+                    else if (call == CALL_DeleteSamplers)
+                        glDeleteSamplers(n, created.data());
+                    else if (call == CALL_DeleteTextures)
+                        glDeleteTextures(n, created.data());
+                    else
+                        glDeleteVertexArrays(n, created.data());
+                    break;
+                }
+                case CALL_DeleteShader:
+                {
+                    const GLuint shader { read<GLuint>() };
+                    glDeleteShader(mapName(mPrograms, shader));
+                    if (shader < mPrograms.size())
+                        mPrograms[shader] = 0;
+                    break;
+                }
+                case CALL_DeleteSync:
+                {
+                    const std::uint32_t id { read<std::uint32_t>() };
+                    if (id < mSyncs.size() && mSyncs[id] != nullptr)
+                    {
+                        glDeleteSync(mSyncs[id]);
+                        mSyncs[id] = nullptr;
+                    }
+                    break;
+                }
+                case CALL_DepthFunc:
+                {
+                    glDepthFunc(read<GLenum>());
+                    break;
+                }
+                case CALL_DepthMask:
+                {
+                    glDepthMask(read<GLboolean>());
+                    break;
+                }
+                case CALL_Disable:
+                {
+                    glDisable(read<GLenum>());
+                    break;
+                }
+                case CALL_DrawArrays:
+                {
+                    const GLenum mode { read<GLenum>() };
+                    const GLint first { read<GLint>() };
+                    const GLsizei count { read<GLsizei>() };
+                    if (isWorkEnabled())
+                    {
+                        glDrawArrays(mode, first, count);
+                        ++mNrDraws;
+                    }
+                    break;
+                }
+                case CALL_DrawArraysInstanced:
+                {
+                    const GLenum mode { read<GLenum>() };
+                    const GLint first { read<GLint>() };
+                    const GLsizei count { read<GLsizei>() };
+                    const GLsizei instancecount { read<GLsizei>() };
+                    if (isWorkEnabled())
+                    {
+                        glDrawArraysInstanced(mode, first, count, instancecount);
+                        ++mNrDraws;
+                    }
+                    break;
+                }
+                case CALL_DrawBuffer:
+                {
+                    glDrawBuffer(read<GLenum>());
+                    break;
+                }
+                case CALL_DrawBuffers:
+                {
+                    const GLsizei n { read<GLsizei>() };
+                    size_t size;
+                    const void* data { readData(size) };
+                    std::vector<GLenum> buffers(std::max(0, n));
+                    std::memcpy(buffers.data(), data, std::min(size, buffers.size() * sizeof(GLenum)));
+                    glDrawBuffers(n, buffers.data());
+                    break;
+                }
+                case CALL_DrawElements:
+                {
+                    const GLenum mode { read<GLenum>() };
+                    const GLsizei count { read<GLsizei>() };
+                    const GLenum type { read<GLenum>() };
+                    const std::uint64_t offset { read<std::uint64_t>() };
+                    if (isWorkEnabled())
+                    {
+                        glDrawElements(mode, count, type, (const void*)(std::uintptr_t)offset);
+                        ++mNrDraws;
+                    }
+                    break;
+                }
+                case CALL_DrawElementsInstanced:
+                {
+                    const GLenum mode { read<GLenum>() };
+                    const GLsizei count { read<GLsizei>() };
+                    const GLenum type { read<GLenum>() };
+                    const std::uint64_t offset { read<std::uint64_t>() };
+                    const GLsizei instancecount { read<GLsizei>() };
+                    if (isWorkEnabled())
+                    {
+                        glDrawElementsInstanced(mode, count, type, (const void*)(std::uintptr_t)offset,
+                                                instancecount);
+                        ++mNrDraws;
+                    }
+                    break;
+                }
+                case CALL_Enable:
+                {
+                    glEnable(read<GLenum>());
+                    break;
+                }
+                case CALL_EnableVertexAttribArray:
+                {
+                    glEnableVertexAttribArray(read<GLuint>());
+                    break;
+                }
+                case CALL_FenceSync:
+                {
+                    const GLenum condition { read<GLenum>() };
+                    const GLbitfield flags { read<GLbitfield>() };
+                    const std::uint32_t id { read<std::uint32_t>() };
+                    if (id >= mSyncs.size())
+                        mSyncs.resize(id + 1, nullptr);
+                    if (isWorkEnabled())
+                        mSyncs[id] = glFenceSync(condition, flags);
+                    break;
+                }
+                case CALL_FramebufferRenderbuffer:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum attachment { read<GLenum>() };
+                    const GLenum renderbuffertarget { read<GLenum>() };
+                    const GLuint renderbuffer { read<GLuint>() };
+                    glFramebufferRenderbuffer(target, attachment, renderbuffertarget,
+                                              mapName(mRenderbuffers, renderbuffer));
+                    break;
+                }
+                case CALL_FramebufferTexture:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum attachment { read<GLenum>() };
+                    const GLuint texture { read<GLuint>() };
+                    const GLint level { read<GLint>() };
+                    glFramebufferTexture(target, attachment, mapName(mTextures, texture), level);
+                    break;
+                }
+                case CALL_FramebufferTexture2D:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum attachment { read<GLenum>() };
+                    const GLenum textarget { read<GLenum>() };
+                    const GLuint texture { read<GLuint>() };
+                    const GLint level { read<GLint>() };
+                    glFramebufferTexture2D(target, attachment, textarget, mapName(mTextures, texture), level);
+                    break;
+                }
+                case CALL_FramebufferTextureLayer:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum attachment { read<GLenum>() };
+                    const GLuint texture { read<GLuint>() };
+                    const GLint level { read<GLint>() };
+                    const GLint layer { read<GLint>() };
+                    glFramebufferTextureLayer(target, attachment, mapName(mTextures, texture), level, layer);
+                    break;
+                }
+                case CALL_GenBuffers:
+                case CALL_GenFramebuffers:
+                case CALL_GenRenderbuffers:
+                case CALL_GenSamplers:
+                case CALL_GenTextures:
+                case CALL_GenVertexArrays:
+                {
+                    readNames(captured);
+                    created.resize(captured.size());
+                    const GLsizei n { (GLsizei)created.size() };
+                    std::vector<GLuint>* names;
+                    if (call == CALL_GenBuffers)
+                    {
+                        glGenBuffers(n, created.data());
+                        names = &mBuffers;
+                    }
+                    else if (call == CALL_GenFramebuffers)
+                    {
+                        glGenFramebuffers(n, created.data());
+                        names = &mFramebuffers;
+                    }
+                    else if (call == CALL_GenRenderbuffers)
+                    {
+                        glGenRenderbuffers(n, created.data());
+                        names = &mRenderbuffers;
+                    }
+                    else if (call == CALL_GenSamplers)
+                    {
+                        glGenSamplers(n, created.data());
+                        names = &mSamplers;
+                    }
+                    else if (call == CALL_GenTextures)
+                    {
+                        glGenTextures(n, created.data());
+                        names = &mTextures;
+                    }
+                    else
+                    {
+                        glGenVertexArrays(n, created.data());
+                        names = &mVertexArrays;
+                    }
+                    addNames(*names, captured.data(), created.data(), n);
+                    break;
+                }
+                case CALL_GenerateMipmap:
+                {
+                    glGenerateMipmap(read<GLenum>());
+                    break;
+                }
+                case CALL_GetBufferSubData:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const std::uint64_t offset { read<std::uint64_t>() };
+                    const std::uint64_t size { read<std::uint64_t>() };
+                    if (isWorkEnabled())
+                    {
+                        mReadback.resize(std::max(mReadback.size(), (size_t)size));
+                        glGetBufferSubData(target, (GLintptr)offset, (GLsizeiptr)size, mReadback.data());
+                    }
+                    break;
+                }
+                case CALL_GetUniformLocation:
+                {
+                    const GLuint program { read<GLuint>() };
+                    const GLint location { read<GLint>() };
+                    const char* name { readString() };
+                    const GLint replayLocation { glGetUniformLocation(mapName(mPrograms, program), name) };
+                    if (location >= 0)
+                        mUniformLocations[((std::uint64_t)program << 32) | (std::uint32_t)location] = replayLocation;
+                    break;
+                }
+                case CALL_LinkProgram:
+                {
+                    glLinkProgram(mapName(mPrograms, read<GLuint>()));
+                    break;
+                }
+                case CALL_PixelStorei:
+                {
+                    const GLenum pname { read<GLenum>() };
+                    const GLint param { read<GLint>() };
+                    glPixelStorei(pname, param);
+                    break;
+                }
+                case CALL_ReadBuffer:
+                {
+                    glReadBuffer(read<GLenum>());
+                    break;
+                }
+                case CALL_ReadPixels:
+                {
+                    GLint rectangle[4];
+                    for (unsigned int i = 0; i < 4; ++i)
+                        rectangle[i] = read<GLint>();
+                    const GLenum format { read<GLenum>() };
+                    const GLenum type { read<GLenum>() };
+                    const std::uint8_t destination { read<std::uint8_t>() };
+                    const std::uint64_t value { read<std::uint64_t>() };
+                    if (!isWorkEnabled())
+                        break;
+                    // The value is the offset in the buffer, or the size of the
+                    // memory of the application
+                    void* pixels { (void*)(std::uintptr_t)value };
+                    if (destination != DATA_BUFFER_OFFSET)
+                    {
+                        mReadback.resize(std::max(mReadback.size(), (size_t)value));
+                        pixels = mReadback.data();
+                    }
+                    glReadPixels(rectangle[0], rectangle[1], rectangle[2], rectangle[3], format, type, pixels);
+                    break;
+                }
+                case CALL_RenderbufferStorage:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum internalformat { read<GLenum>() };
+                    const GLsizei width { read<GLsizei>() };
+                    const GLsizei height { read<GLsizei>() };
+                    glRenderbufferStorage(target, internalformat, width, height);
+                    break;
+                }
+                case CALL_SamplerParameteri:
+                {
+                    const GLuint sampler { read<GLuint>() };
+                    const GLenum pname { read<GLenum>() };
+                    const GLint param { read<GLint>() };
+                    glSamplerParameteri(mapName(mSamplers, sampler), pname, param);
+                    break;
+                }
+                case CALL_Scissor:
+                {
+                    GLint rectangle[4];
+                    for (unsigned int i = 0; i < 4; ++i)
+                        rectangle[i] = read<GLint>();
+                    glScissor(rectangle[0], rectangle[1], rectangle[2], rectangle[3]);
+                    break;
+                }
+                case CALL_ShaderSource:
+                {
+                    const GLuint shader { read<GLuint>() };
+                    const char* source { readString() };
+                    glShaderSource(mapName(mPrograms, shader), 1, &source, nullptr);
+                    break;
+                }
+                case CALL_StencilFunc:
+                {
+                    const GLenum func { read<GLenum>() };
+                    const GLint ref { read<GLint>() };
+                    const GLuint mask { read<GLuint>() };
+                    glStencilFunc(func, ref, mask);
+                    break;
+                }
+                case CALL_StencilMask:
+                {
+                    glStencilMask(read<GLuint>());
+                    break;
+                }
+                case CALL_StencilOp:
+                {
+                    const GLenum fail { read<GLenum>() };
+                    const GLenum zfail { read<GLenum>() };
+                    const GLenum zpass { read<GLenum>() };
+                    glStencilOp(fail, zfail, zpass);
+                    break;
+                }
+                case CALL_TexBuffer:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum internalformat { read<GLenum>() };
+                    const GLuint buffer { read<GLuint>() };
+                    glTexBuffer(target, internalformat, mapName(mBuffers, buffer));
+                    break;
+                }
+                case CALL_TexImage2D:
+                case CALL_TexImage3D:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLint level { read<GLint>() };
+                    const GLint internalformat { read<GLint>() };
+                    const GLsizei width { read<GLsizei>() };
+                    const GLsizei height { read<GLsizei>() };
+                    const GLsizei depth { read<GLsizei>() };
+                    const GLint border { read<GLint>() };
+                    const GLenum format { read<GLenum>() };
+                    const GLenum type { read<GLenum>() };
+                    const void* pixels { nullptr };
+                    const std::uint8_t source { read<std::uint8_t>() };
+                    if (source == DATA_STREAM)
+                    {
+                        size_t size;
+                        pixels = readData(size);
+                    }
+                    else if (source == DATA_BUFFER_OFFSET)
+                        pixels = (const void*)(std::uintptr_t)read<std::uint64_t>();
+                    if (call == CALL_TexImage2D)
+                        glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+                    else
+                        glTexImage3D(target, level, internalformat, width, height, depth, border, format, type,
+                                     pixels);
+                    break;
+                }
+                case CALL_TexParameterfv:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum pname { read<GLenum>() };
+                    size_t size;
+                    const void* data { readData(size) };
+                    GLfloat params[4] {};
+                    std::memcpy(params, data, std::min(size, sizeof(params)));
+                    glTexParameterfv(target, pname, params);
+                    break;
+                }
+                case CALL_TexParameteri:
+                {
+                    const GLenum target { read<GLenum>() };
+                    const GLenum pname { read<GLenum>() };
+                    const GLint param { read<GLint>() };
+                    glTexParameteri(target, pname, param);
+                    break;
+                }
+                case CALL_Uniform1f:
+                {
+                    const GLint location { mapLocation(read<GLint>()) };
+                    glUniform1f(location, read<GLfloat>());
+                    break;
+                }
+                case CALL_Uniform1i:
+                {
+                    const GLint location { mapLocation(read<GLint>()) };
+                    glUniform1i(location, read<GLint>());
+                    break;
+                }
+                case CALL_Uniform3f:
+                {
+                    const GLint location { mapLocation(read<GLint>()) };
+                    GLfloat v[3];
+                    for (unsigned int i = 0; i < 3; ++i)
+                        v[i] = read<GLfloat>();
+                    glUniform3f(location, v[0], v[1], v[2]);
+                    break;
+                }
+                case CALL_Uniform4f:
+                {
+                    const GLint location { mapLocation(read<GLint>()) };
+                    GLfloat v[4];
+                    for (unsigned int i = 0; i < 4; ++i)
+                        v[i] = read<GLfloat>();
+                    glUniform4f(location, v[0], v[1], v[2], v[3]);
+                    break;
+                }
+                case CALL_Uniform1iv:
+                case CALL_Uniform2fv:
+                case CALL_Uniform3fv:
+                case CALL_Uniform4fv:
+                {
+                    const GLint location { mapLocation(read<GLint>()) };
+                    const GLsizei count { read<GLsizei>() };
+                    size_t size;
+                    const void* data { readData(size) };
+                    if (call == CALL_Uniform1iv)
+                        glUniform1iv(location, count, static_cast<const GLint*>(data));
+                    else if (call == CALL_Uniform2fv)
+                        glUniform2fv(location, count, static_cast<const GLfloat*>(data));
+                    else if (call == CALL_Uniform3fv)
+                        glUniform3fv(location, count, static_cast<const GLfloat*>(data));
+                    else
+                        glUniform4fv(location, count, static_cast<const GLfloat*>(data));
+                    break;
+                }
+                case CALL_UniformMatrix2fv:
+                case CALL_UniformMatrix3fv:
+                case CALL_UniformMatrix4fv:
+                {
+                    const GLint location { mapLocation(read<GLint>()) };
+                    const GLsizei count { read<GLsizei>() };
+                    const GLboolean transpose { read<GLboolean>() };
+                    size_t size;
+                    const GLfloat* value { static_cast<const GLfloat*>(readData(size)) };
+                    if (call == CALL_UniformMatrix2fv)
+                        glUniformMatrix2fv(location, count, transpose, value);
+                    else if (call == CALL_UniformMatrix3fv)
+                        glUniformMatrix3fv(location, count, transpose, value);
+                    else
+                        glUniformMatrix4fv(location, count, transpose, value);
+                    break;
+                }
+                case CALL_UseProgram:
+                {
+                    mCurrentProgram = read<GLuint>();
+                    glUseProgram(mapName(mPrograms, mCurrentProgram));
+                    break;
+                }
+                case CALL_VertexAttribDivisor:
+                {
+                    const GLuint index { read<GLuint>() };
+                    const GLuint divisor { read<GLuint>() };
+                    glVertexAttribDivisor(index, divisor);
+                    break;
+                }
+                case CALL_VertexAttribPointer:
+                {
+                    const GLuint index { read<GLuint>() };
+                    const GLint size { read<GLint>() };
+                    const GLenum type { read<GLenum>() };
+                    const GLboolean normalized { read<GLboolean>() };
+                    const GLsizei stride { read<GLsizei>() };
+                    const std::uint64_t offset { read<std::uint64_t>() };
+                    glVertexAttribPointer(index, size, type, normalized, stride, (const void*)(std::uintptr_t)offset);
+                    break;
+                }
+                case CALL_Viewport:
+                {
+                    GLint rectangle[4];
+                    for (unsigned int i = 0; i < 4; ++i)
+                        rectangle[i] = read<GLint>();
+                    glViewport(rectangle[0], rectangle[1], rectangle[2], rectangle[3]);
+                    break;
+                }
+                case CALL_FRAMES_START:
+                {
+                    mFramesPosition = mPosition;
+                    return false;
+                }
+                case CALL_FRAME_END:
+                {
+                    closePasses();
+                    return true;
+                }
+                case CALL_PASS_BEGIN:
+                {
+                    const std::string name { readString() };
+                    if (std::find(mPassNames.begin(), mPassNames.end(), name) == mPassNames.end())
+                        mPassNames.push_back(name);
+                    const bool parentEnabled { !mOpenPasses.empty() && mOpenPasses.back().first };
+                    const bool parentSkipped { !mOpenPasses.empty() && mOpenPasses.back().second };
+                    const bool enabled { mEnabledPasses.empty() || parentEnabled ||
+                                         std::find(mEnabledPasses.begin(), mEnabledPasses.end(), name) != mEnabledPasses.end() };
+                    const bool skipped { parentSkipped ||
+                                         std::find(mSkippedPasses.begin(), mSkippedPasses.end(), name) != mSkippedPasses.end() };
+                    mOpenPasses.push_back({ enabled, skipped });
+                    if (mGPUProfiler != nullptr)
+                        mGPUProfiler->beginScope(name);
+                    break;
+                }
+                case CALL_PASS_END:
+                {
+                    if (!mOpenPasses.empty())
+                    {
+                        mOpenPasses.pop_back();
+                        if (mGPUProfiler != nullptr)
+                            mGPUProfiler->endScope();
+                    }
+                    break;
+                }
+                default:
+                {
+                    std::cout << "ERROR::GL_CAPTURE::UNKNOWN_CALL: " << call << '\n';
+                    mPosition = mStream.size();
+                }
+            }
+        }
+        closePasses();
+        return false;
+    }
+}
@@ -0,0 +1,212 @@
+#ifndef GLCAPTURE_H
+#define GLCAPTURE_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    class GPUProfiler;
+
+    // Capture of the calls to OpenGL of some frames, to replay them where the
+    // application and its assets are not available.
+    // When it starts, the function pointers of GLAD used by the library are
+    // replaced by others that write the calls, with their parameters and the
+    // data of the buffers and textures that they read, and then call the
+    // original ones. Nothing else is added to the calls while it is not
+    // capturing. The capture should start right after the context is created,
+    // so all the objects are created through it.
+    // The calls before the first captured frame are also written, so the
+    // replay can create the objects, with the contents rendered to them in the
+    // previous frames, and the state with which the frames start.
+    // The frames are delimited by endFrame(), and the passes in them by the
+    // scopes of the GPU profiler. The calls that only query the state, and the
+    // queries of the profilers, are not written.
+    // The file starts with a header:
+    //      char[4] magic "GLCP", uint32 version, int32 width, int32 height,
+    //      uint32 first frame, uint32 number of frames, uint32 length and the
+    //      name of the renderer
+    // followed by blocks of the stream of calls, compressed with LZ4, each one
+    // with its uint32 size, and its uint32 compressed size (0 if it is stored
+    // without compressing).
+    class GLCapture
+    {
+        public:
+            // Method to start capturing to a file, with the size of the default
+            // framebuffer. The frames from firstFrame on are captured, counting
+            // the calls to endFrame() from now, and the capture finishes after
+            // nrFrames of them. Returns false if the file cannot be written
+            static bool start(const std::string& path, int width, int height,
+                              unsigned int firstFrame, unsigned int nrFrames);
+            // Method to finish the capture, restoring the function pointers
+            static void stop();
+
+            // Method to check if the calls are being captured
+            static bool isActive();
+
+            // Method to end a frame, called after all its calls
+            static void endFrame();
+
+            // Methods to start and end a pass of the frame
+            static void beginPass(const std::string& name);
+            static void endPass();
+    };
+
+    // Replay of a capture of GLCapture.
+    // The stream of calls is read and decompressed when it is loaded, so the
+    // replay only calls OpenGL. The objects created in the capture are created
+    // again, and their names, and the locations of the uniforms, are mapped to
+    // the ones of the replay. The calls before the first frame are played once,
+    // and then the frames can be played any number of times.
+    // The work of some passes can be skipped, keeping their changes of the
+    // state, so the other passes render the same.
+    class GLCaptureReplay
+    {
+        public:
+            // Constructor
+            GLCaptureReplay();
+
+            // Method to load a capture. Returns false if it cannot be read
+            bool load(const std::string& path);
+
+            // Size of the default framebuffer of the capture, number of frames
+            // and name of the renderer where it was captured
+            int getWidth() const
+            {
+                return mWidth;
+            }
+            int getHeight() const
+            {
+                return mHeight;
+            }
+            unsigned int getNrFrames() const
+            {
+                return mNrFrames;
+            }
+            const std::string& getRenderer() const
+            {
+                return mRenderer;
+            }
+
+            // Method to set the profiler whose scopes are started and ended with
+            // the passes of the frames
+            void setGPUProfiler(GPUProfiler* profiler)
+            {
+                mGPUProfiler = profiler;
+            }
+
+            // Method to replay only the work of the passes with these names, and
+            // of the passes in them. The work outside the passes is always
+            // replayed. Empty to replay all of them
+            void setEnabledPasses(const std::vector<std::string>& names)
+            {
+                mEnabledPasses = names;
+            }
+            // Method to skip the work of the passes with these names, and of the
+            // passes in them
+            void setSkippedPasses(const std::vector<std::string>& names)
+            {
+                mSkippedPasses = names;
+            }
+
+            // Method to play the calls before the first frame, which create the
+            // objects and their contents, and set the state with which the
+            // frames start
+            void playSetup();
+
+            // Method to play the next frame. After the last one, the frames
+            // start again from the first one. Returns false if the capture has
+            // no complete frames
+            bool playFrame();
+
+            // Number of calls and of draws of the last frame played
+            unsigned int getNrCalls() const
+            {
+                return mNrCalls;
+            }
+            unsigned int getNrDraws() const
+            {
+                return mNrDraws;
+            }
+
+            // Names of the passes found in the frames played, in the order in
+            // which they were first found
+            const std::vector<std::string>& getPassNames() const
+            {
+                return mPassNames;
+            }
+
+        private:
+            int mWidth;
+            int mHeight;
+            unsigned int mNrFrames;
+            std::string mRenderer;
+
+            // Stream of calls, position of the next call, and position of the
+            // first frame
+            std::vector<unsigned char> mStream;
+            size_t mPosition;
+            size_t mFramesPosition;
+
+            GPUProfiler* mGPUProfiler;
+            std::vector<std::string> mEnabledPasses;
+            std::vector<std::string> mSkippedPasses;
+            std::vector<std::string> mPassNames;
+            // For each pass open, whether it or a pass that contains it is
+            // enabled, and whether it or one of them is skipped
+            std::vector<std::pair<bool, bool>> mOpenPasses;
+            // Index of the next frame
+            unsigned int mFrameIndex;
+
+            // Names of the objects of the capture, indexed by the name in the
+            // capture. The shaders and the programs share their names
+            std::vector<GLuint> mTextures;
+            std::vector<GLuint> mBuffers;
+            std::vector<GLuint> mFramebuffers;
+            std::vector<GLuint> mRenderbuffers;
+            std::vector<GLuint> mVertexArrays;
+            std::vector<GLuint> mSamplers;
+            std::vector<GLuint> mPrograms;
+            std::vector<GLsync> mSyncs;
+            // Locations of the uniforms, with the program and the location of
+            // the capture as key, and the program in use in the capture
+            std::map<std::uint64_t, GLint> mUniformLocations;
+            GLuint mCurrentProgram;
+
+            // Memory where the pixels and buffers read back are written
+            std::vector<unsigned char> mReadback;
+
+            unsigned int mNrCalls;
+            unsigned int mNrDraws;
+
+            // Method to play calls until the end of a frame, the start of the
+            // frames or the end of the stream. Returns true if the end of a
+            // frame was reached
+            bool play();
+
+            // Method to check if the work of the current pass is replayed
+            bool isWorkEnabled() const
+            {
+                return mOpenPasses.empty() || (mOpenPasses.back().first && !mOpenPasses.back().second);
+            }
+
+            // Method to close the passes that are open
+            void closePasses();
+
+            // Methods to read values of the stream, advancing the position
+            template <typename T>
+            T read();
+            const void* readData(size_t& size);
+            const char* readString();
+
+            // Method to get the name of the replay of an object of the capture
+            static GLuint mapName(const std::vector<GLuint>& names, GLuint name);
+            // Method to add the names of the objects created in the replay for
+            // the ones of the capture
+            static void addNames(std::vector<GLuint>& names, const GLuint* captured,
+                                 const GLuint* created, GLsizei n);
+            // Method to get the location of the replay of a uniform
+            GLint mapLocation(GLint location) const;
+    };
+}
+
+#endif
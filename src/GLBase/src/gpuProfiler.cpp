@@ -0,0 +1,240 @@
+#include "gpuProfiler.h"
+
+namespace GLBase
+{
+    // Constructor
+    GPUProfiler::GPUProfiler(unsigned int nrFramesInFlight, unsigned int historySize) :
+        mEnabled { true }, mSlots(std::max(1u, nrFramesInFlight)), mCurrentSlot { -1 },
+        mFrameIndex { 0 }, mNrDroppedFrames { 0 }, mHistorySize { std::max(1u, historySize) },
+        mStartTime { std::chrono::steady_clock::now() }
+    {
+        for (auto& slot : mSlots)
+        {
+            slot.index = 0;
+            slot.pending = false;
+            slot.nrQueries = 0;
+        }
+    }
+
+    // Destructor
+    GPUProfiler::~GPUProfiler()
+    {
+        for (auto& slot : mSlots)
+        {
+            if (!slot.queries.empty())
+                glDeleteQueries((GLsizei)slot.queries.size(), &slot.queries[0]);
+        }
+    }
+
+    // Method to get the time of the CPU in milliseconds
+    double GPUProfiler::getCPUTime() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
+    }
+
+    // Method to get a query of the current slot, creating it if needed
+    unsigned int GPUProfiler::acquireQuery()
+    {
+        FrameSlot& slot { mSlots[mCurrentSlot] };
+        if (slot.nrQueries == slot.queries.size())
+        {
+            // Create them in blocks, to avoid creating one in each scope of the
+            // first frames
+            const unsigned int oldSize { (unsigned int)slot.queries.size() };
+            slot.queries.resize(std::max(16u, 2 * oldSize));
+            glGenQueries((GLsizei)(slot.queries.size() - oldSize), &slot.queries[oldSize]);
+        }
+        return slot.nrQueries++;
+    }
+
+    // Method to start a frame
+    void GPUProfiler::beginFrame()
+    {
+        if (mCurrentSlot >= 0)
+            endFrame();
+
+        collectFrames();
+
+        if (!mEnabled)
+            return;
+
+        // Take the slot of the oldest frame of the ring. If it has not been
+        // read yet, reading it now would wait for the GPU, so it is dropped
+        mCurrentSlot = (int)(mFrameIndex % mSlots.size());
+        FrameSlot& slot { mSlots[mCurrentSlot] };
+        if (slot.pending)
+            ++mNrDroppedFrames;
+        slot.index = mFrameIndex++;
+        slot.pending = false;
+        slot.nrQueries = 0;
+        slot.scopes.clear();
+        mOpenScopes.clear();
+
+        // The current time of the GPU does not wait for the previous commands
+        // to finish, only for them to reach the GPU
+        glGetInteger64v(GL_TIMESTAMP, &slot.gpuReference);
+        slot.cpuReferenceMs = getCPUTime();
+        slot.cpuStartMs = slot.cpuReferenceMs;
+
+        // The first two queries are the start and end of the frame
+        const unsigned int frameStart { acquireQuery() };
+        acquireQuery();
+        glQueryCounter(slot.queries[frameStart], GL_TIMESTAMP);
+    }
+
+    // Method to end a frame
+    void GPUProfiler::endFrame()
+    {
+        if (mCurrentSlot < 0)
+            return;
+
+        while (!mOpenScopes.empty())
+            endScope();
+
+        FrameSlot& slot { mSlots[mCurrentSlot] };
+        glQueryCounter(slot.queries[1], GL_TIMESTAMP);
+        slot.cpuEndMs = getCPUTime();
+        slot.pending = true;
+        mCurrentSlot = -1;
+    }
+
+    // Method to start a scope of the current frame
+    void GPUProfiler::beginScope(const std::string& name)
+    {
+        if (mCurrentSlot < 0)
+            return;
+
+        const unsigned int query { acquireQuery() };
+        FrameSlot& slot { mSlots[mCurrentSlot] };
+        glQueryCounter(slot.queries[query], GL_TIMESTAMP);
+        slot.scopes.push_back({ name, (unsigned int)mOpenScopes.size(), query, 0, getCPUTime(), 0. });
+        mOpenScopes.push_back((unsigned int)slot.scopes.size() - 1);
+    }
+
+    // Method to end the last scope started
+    void GPUProfiler::endScope()
+    {
+        if (mCurrentSlot < 0 || mOpenScopes.empty())
+            return;
+
+        const unsigned int query { acquireQuery() };
+        FrameSlot& slot { mSlots[mCurrentSlot] };
+        glQueryCounter(slot.queries[query], GL_TIMESTAMP);
+        Scope& scope { slot.scopes[mOpenScopes.back()] };
+        scope.endQuery = query;
+        scope.cpuEndMs = getCPUTime();
+        mOpenScopes.pop_back();
+    }
+
+    // Method to read the pending frames whose queries are available
+    void GPUProfiler::collectFrames()
+    {
+        // Start from the oldest frame of the ring
+        for (unsigned int i = 0; i < mSlots.size(); ++i)
+        {
+            FrameSlot& slot { mSlots[(mFrameIndex + i) % mSlots.size()] };
+            if (!slot.pending)
+                continue;
+
+            // The end of the frame is the last query written
+            GLint available { 0 };
+            glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            slot.pending = false;
+
+            std::vector<GLuint64> timestamps(slot.nrQueries);
+            for (unsigned int query = 0; query < slot.nrQueries; ++query)
+                glGetQueryObjectui64v(slot.queries[query], GL_QUERY_RESULT, &timestamps[query]);
+            auto toCPUTime = [&slot](GLuint64 timestamp)
+            {
+                return slot.cpuReferenceMs + ((GLint64)timestamp - slot.gpuReference) * 1e-6;
+            };
+
+            GPUProfileFrame frame { slot.index, slot.cpuStartMs, slot.cpuEndMs,
+                                    toCPUTime(timestamps[0]), toCPUTime(timestamps[1]), {} };
+            frame.scopes.reserve(slot.scopes.size());
+            for (const auto& scope : slot.scopes)
+            {
+                frame.scopes.push_back({ scope.name, scope.depth, scope.cpuStartMs, scope.cpuEndMs,
+                                         toCPUTime(timestamps[scope.startQuery]),
+                                         toCPUTime(timestamps[scope.endQuery]) });
+            }
+
+            if (mHistory.size() == mHistorySize)
+                mHistory.erase(mHistory.begin());
+            mHistory.push_back(std::move(frame));
+        }
+    }
+
+    // Method to get the GPU time of the scopes with a name in the last frame
+    double GPUProfiler::getScopeTime(const std::string& name) const
+    {
+        if (mHistory.empty())
+            return -1.;
+
+        double time { -1. };
+        for (const auto& scope : mHistory.back().scopes)
+        {
+            if (scope.name == name)
+                time = std::max(time, 0.) + scope.gpuEndMs - scope.gpuStartMs;
+        }
+        return time;
+    }
+
+    // Method to write the frames of the history as a Chrome trace
+    // Each scope is a complete event, with the times in microseconds, and the
+    // CPU and GPU are two threads of the same process
+    void GPUProfiler::writeChromeTrace(std::ostream& out) const
+    {
+        // Write a name as a string of JSON
+        auto writeName = [&out](const std::string& name)
+        {
+            out << '"';
+            for (char c : name)
+            {
+                if (c == '"' || c == '\\')
+                    out << '\\';
+                out << c;
+            }
+            out << '"';
+        };
+        auto writeEvent = [&out, &writeName](const std::string& name, const char* category, int thread,
+                                             double startMs, double endMs)
+        {
+            out << ",\n{\"name\":";
+            writeName(name);
+            out << ",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+                << ",\"ts\":" << startMs * 1000. << ",\"dur\":" << std::max(0., endMs - startMs) * 1000. << '}';
+        };
+
+        out << std::fixed << std::setprecision(3);
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+        for (const auto& frame : mHistory)
+        {
+            const std::string frameName { "Frame " + std::to_string(frame.index) };
+            writeEvent(frameName, "cpu", 1, frame.cpuStartMs, frame.cpuEndMs);
+            writeEvent(frameName, "gpu", 2, frame.gpuStartMs, frame.gpuEndMs);
+            for (const auto& scope : frame.scopes)
+            {
+                writeEvent(scope.name, "cpu", 1, scope.cpuStartMs, scope.cpuEndMs);
+                writeEvent(scope.name, "gpu", 2, scope.gpuStartMs, scope.gpuEndMs);
+            }
+        }
+        out << "\n]}\n";
+    }
+
+    // Method to write the frames of the history as a Chrome trace to a file
+    void GPUProfiler::saveChromeTrace(const std::string& path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::GPU_PROFILER::FILE_NOT_WRITTEN: " << path << '\n';
+            return;
+        }
+        writeChromeTrace(file);
+    }
+}
@@ -0,0 +1,199 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Timing of a scope of a frame, in milliseconds since the profiler was
+    // created. The GPU times are moved to the timeline of the CPU
+    struct GPUProfileScopeTiming
+    {
+        std::string name;
+        // Number of scopes that contain it
+        unsigned int depth;
+        double cpuStartMs;
+        double cpuEndMs;
+        double gpuStartMs;
+        double gpuEndMs;
+    };
+
+    // Timings of a frame
+    struct GPUProfileFrame
+    {
+        unsigned int index;
+        double cpuStartMs;
+        double cpuEndMs;
+        double gpuStartMs;
+        double gpuEndMs;
+        std::vector<GPUProfileScopeTiming> scopes;
+    };
+
+    // Profiler of the GPU time of the passes of the frames.
+    // Each scope writes a timestamp query when it starts and another one when
+    // it ends, so they can be nested, and also keeps the time of the CPU.
+    // The queries of each frame are kept in a ring of frames, and the results
+    // are only read when they are available, some frames later, so the
+    // profiler never waits for the GPU. If the frame that used a slot of the
+    // ring is still not available when the slot is needed again, its results
+    // are dropped.
+    // The frames read are kept in a history, which can be written as a trace
+    // in the JSON format of Chrome (chrome://tracing or Perfetto), with the
+    // CPU and GPU timings in two tracks.
+    class GPUProfiler
+    {
+        public:
+            // Constructor, with the number of frames in flight of the ring and
+            // the number of frames of the history
+            GPUProfiler(unsigned int nrFramesInFlight = 4, unsigned int historySize = 120);
+
+            // Destructor
+            ~GPUProfiler();
+
+            // Method to enable or disable the profiler. When it is disabled,
+            // the scopes do not write any query
+            void setEnabled(bool enabled)
+            {
+                mEnabled = enabled;
+            }
+            bool isEnabled() const
+            {
+                return mEnabled;
+            }
+
+            // Method to start a frame. This also reads the results of the
+            // previous frames that are available
+            void beginFrame();
+            // Method to end a frame, closing the scopes that are still open
+            void endFrame();
+
+            // Methods to start and end a scope of the current frame. The scopes
+            // must be ended in the opposite order in which they were started
+            void beginScope(const std::string& name);
+            void endScope();
+
+            // Method to check if any frame has been read
+            bool hasResults() const
+            {
+                return !mHistory.empty();
+            }
+            // Method to get the last frame read
+            const GPUProfileFrame& getLastFrame() const
+            {
+                return mHistory.back();
+            }
+            // Method to get the frames of the history, from the oldest one
+            const std::vector<GPUProfileFrame>& getHistory() const
+            {
+                return mHistory;
+            }
+            // Method to get the GPU time in milliseconds of the scopes with a
+            // name in the last frame read, or -1 if there is none
+            double getScopeTime(const std::string& name) const;
+
+            // Number of frames whose results were dropped
+            unsigned int getNrDroppedFrames() const
+            {
+                return mNrDroppedFrames;
+            }
+
+            // Method to write the frames of the history as a Chrome trace
+            void writeChromeTrace(std::ostream& out) const;
+            // Same, but writing it to a file
+            void saveChromeTrace(const std::string& path) const;
+
+        private:
+            // Scope of a frame in flight
+            struct Scope
+            {
+                std::string name;
+                unsigned int depth;
+                // Indices of the queries in the slot
+                unsigned int startQuery;
+                unsigned int endQuery;
+                double cpuStartMs;
+                double cpuEndMs;
+            };
+
+            // Slot of the ring, with the queries of a frame
+            struct FrameSlot
+            {
+                unsigned int index;
+                // True if the frame was recorded and has not been read
+                bool pending;
+                // Queries of the slot, and number used by the frame. The first
+                // two are the start and end of the frame
+                std::vector<unsigned int> queries;
+                unsigned int nrQueries;
+                std::vector<Scope> scopes;
+                double cpuStartMs;
+                double cpuEndMs;
+                // Time of the GPU and of the CPU at the start of the frame, to
+                // move the GPU times to the timeline of the CPU
+                GLint64 gpuReference;
+                double cpuReferenceMs;
+            };
+
+            bool mEnabled;
+
+            // Ring of frames in flight
+            std::vector<FrameSlot> mSlots;
+            // Slot of the frame being recorded, or -1 if there is none
+            int mCurrentSlot;
+            // Scopes that are open in the current frame
+            std::vector<unsigned int> mOpenScopes;
+            // Number of frames started
+            unsigned int mFrameIndex;
+            unsigned int mNrDroppedFrames;
+
+            // Frames read, oldest first
+            std::vector<GPUProfileFrame> mHistory;
+            unsigned int mHistorySize;
+
+            // Time of creation of the profiler
+            std::chrono::steady_clock::time_point mStartTime;
+
+            // Method to get the time of the CPU in milliseconds
+            double getCPUTime() const;
+
+            // Method to get a query of the current slot, creating it if needed
+            unsigned int acquireQuery();
+
+            // Method to read the pending frames whose queries are available.
+            // The frames finish in order, so it stops at the first one that is
+            // not
+            void collectFrames();
+    };
+
+    // Scope of the GPU profiler, that starts when it is created and ends when
+    // it is destroyed. The profiler can be null, and then it only marks the
+    // pass in the capture of the calls to OpenGL, if there is one
+    class GPUProfileScope
+    {
+        public:
+            // Constructor
+            GPUProfileScope(GPUProfiler* profiler, const std::string& name) :
+                mProfiler { profiler }
+            {
+                GLCapture::beginPass(name);
+                if (mProfiler != nullptr)
+                    mProfiler->beginScope(name);
+            }
+
+            // Destructor
+            ~GPUProfileScope()
+            {
+                if (mProfiler != nullptr)
+                    mProfiler->endScope();
+                GLCapture::endPass();
+            }
+
+            GPUProfileScope(const GPUProfileScope&) = delete;
+            GPUProfileScope& operator=(const GPUProfileScope&) = delete;
+
+        private:
+            GPUProfiler* mProfiler;
+    };
+}
+
+#endif
@@ -24,13 +24,19 @@ namespace GLBase
     // }
 
     // Methods to process input
-    void InputHandler::processKeyboardInput(GLFWwindow* window, float deltaTime)
+    void InputHandler::processKeyboardInput(float deltaTime)
     {
         for (auto handler : mKeyboardHandlers)
         {
-            handler->process(window, deltaTime);
+            handler->process(*this, deltaTime);
         }
     }
+
+    void InputHandler::processKeyInput(int key, bool pressed)
+    {
+        if (key >= 0 && key <= GLFW_KEY_LAST)
+            mPressedKeys[key] = pressed;
+    }
     
     void InputHandler::processMouseInput(double xpos, double ypos)
     {
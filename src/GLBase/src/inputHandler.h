@@ -5,11 +5,14 @@
 
 namespace GLBase
 {
+    class InputHandler;
+
     class KeyboardInputHandler
     {
         public:
-            // Method to process input
-            virtual void process(GLFWwindow* window, float deltaTime) const = 0;
+            // Method to process input, with the state of the keys kept by the
+            // input handler
+            virtual void process(const InputHandler& input, float deltaTime) const = 0;
     };
 
     class MouseInputHandler
@@ -43,17 +46,29 @@ namespace GLBase
             // void addControllerHandler(ControllerInputHandler* handler);
 
             // Methods to process input
-            void processKeyboardInput(GLFWwindow* window, float deltaTime);
+            void processKeyboardInput(float deltaTime);
+            void processKeyInput(int key, bool pressed);
             void processMouseInput(double xpos, double ypos);
             void processScrollInput(double xoffset, double yoffset);
             // void processControllerInput(float deltaTime);
 
+            // Method to check if a key is pressed, with the GLFW key codes
+            // The state of the keys is given by the events passed to
+            // processKeyInput(), from the window or from a recording
+            bool isKeyPressed(int key) const
+            {
+                return key >= 0 && key <= GLFW_KEY_LAST && mPressedKeys[key];
+            }
+
         private:
             // Vectors of pointers to input handlers
             std::vector<KeyboardInputHandler*> mKeyboardHandlers;
             std::vector<MouseInputHandler*> mMouseHandlers;
             std::vector<ScrollInputHandler*> mScrollHandlers;
             // std::vector<ControllerInputHandler*> mScrollHanders;
+
+            // State of the keys
+            bool mPressedKeys[GLFW_KEY_LAST + 1] {};
     };
 }
 
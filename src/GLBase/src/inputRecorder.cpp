@@ -0,0 +1,206 @@
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Magic number and version of the recordings
+    const char INPUT_RECORDING_MAGIC[4] { 'G', 'L', 'I', 'R' };
+    constexpr uint32_t INPUT_RECORDING_VERSION { 1 };
+
+    // Append a value to the events of a frame
+    template <typename T>
+    static void appendEventValue(std::vector<unsigned char>& events, const T& value)
+    {
+        const unsigned char* bytes { reinterpret_cast<const unsigned char*>(&value) };
+        events.insert(events.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Constructor
+    InputRecorder::InputRecorder() :
+        mMode { MODE_IDLE }, mSeed { static_cast<unsigned int>(std::time(nullptr)) },
+        mFixedTimestep { 0.f }, mNrFrames { 0 }, mFinished { false }, mNrEvents { 0 },
+        mReplayPosition { 0 }
+    {
+    }
+
+    // Destructor
+    InputRecorder::~InputRecorder()
+    {
+        stop();
+    }
+
+    // Method to read a value of the replay, advancing the position
+    template <typename T>
+    bool InputRecorder::readValue(T& value)
+    {
+        if (sizeof(T) > mReplayData.size() - mReplayPosition)
+        {
+            mReplayPosition = mReplayData.size();
+            return false;
+        }
+        std::memcpy(&value, mReplayData.data() + mReplayPosition, sizeof(T));
+        mReplayPosition += sizeof(T);
+        return true;
+    }
+
+    // Method to start recording to a file
+    bool InputRecorder::startRecording(const std::string& path)
+    {
+        stop();
+        mFile.open(path, std::ios::binary | std::ios::trunc);
+        if (!mFile)
+        {
+            std::cout << "ERROR::INPUT_RECORDER::FILE_NOT_WRITTEN: " << path << '\n';
+            return false;
+        }
+        mFile.write(INPUT_RECORDING_MAGIC, 4);
+        mFile.write(reinterpret_cast<const char*>(&INPUT_RECORDING_VERSION), sizeof(uint32_t));
+        const uint32_t seed { mSeed };
+        mFile.write(reinterpret_cast<const char*>(&seed), sizeof(uint32_t));
+
+        mMode = MODE_RECORDING;
+        mPath = path;
+        mNrFrames = 0;
+        mEvents.clear();
+        mNrEvents = 0;
+        return true;
+    }
+
+    // Method to start replaying a file
+    bool InputRecorder::startReplay(const std::string& path)
+    {
+        stop();
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::INPUT_RECORDER::FILE_NOT_READ: " << path << '\n';
+            return false;
+        }
+        mReplayData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        mReplayPosition = 0;
+
+        char magic[4];
+        uint32_t version;
+        uint32_t seed;
+        if (!readValue(magic) || std::memcmp(magic, INPUT_RECORDING_MAGIC, 4) != 0 ||
+            !readValue(version) || version != INPUT_RECORDING_VERSION || !readValue(seed))
+        {
+            std::cout << "ERROR::INPUT_RECORDER::INVALID_RECORDING: " << path << '\n';
+            mReplayData.clear();
+            return false;
+        }
+
+        mMode = MODE_REPLAYING;
+        mPath = path;
+        mSeed = seed;
+        mNrFrames = 0;
+        mFinished = false;
+        return true;
+    }
+
+    // Method to stop recording or replaying
+    void InputRecorder::stop()
+    {
+        if (mMode == MODE_RECORDING)
+        {
+            mFile.close();
+            std::cout << "Input of " << mNrFrames << " frames recorded to " << mPath << '\n';
+        }
+        mMode = MODE_IDLE;
+        mReplayData.clear();
+        mReplayData.shrink_to_fit();
+    }
+
+    // Methods to record the input events of the window
+    void InputRecorder::recordKey(int key, bool pressed)
+    {
+        if (mMode != MODE_RECORDING || key < 0 || key > 0xffff)
+            return;
+        appendEventValue(mEvents, pressed ? EVENT_KEY_PRESS : EVENT_KEY_RELEASE);
+        appendEventValue(mEvents, (uint16_t)key);
+        ++mNrEvents;
+    }
+
+    void InputRecorder::recordMouse(double xpos, double ypos)
+    {
+        if (mMode != MODE_RECORDING)
+            return;
+        appendEventValue(mEvents, EVENT_MOUSE);
+        appendEventValue(mEvents, xpos);
+        appendEventValue(mEvents, ypos);
+        ++mNrEvents;
+    }
+
+    void InputRecorder::recordScroll(double xoffset, double yoffset)
+    {
+        if (mMode != MODE_RECORDING)
+            return;
+        appendEventValue(mEvents, EVENT_SCROLL);
+        appendEventValue(mEvents, xoffset);
+        appendEventValue(mEvents, yoffset);
+        ++mNrEvents;
+    }
+
+    // Method to start a frame
+    float InputRecorder::beginFrame(float deltaTime, InputHandler& inputHandler)
+    {
+        if (mMode == MODE_RECORDING)
+        {
+            const uint32_t nrEvents { mNrEvents };
+            mFile.write(reinterpret_cast<const char*>(&deltaTime), sizeof(float));
+            mFile.write(reinterpret_cast<const char*>(&nrEvents), sizeof(uint32_t));
+            mFile.write(reinterpret_cast<const char*>(mEvents.data()), mEvents.size());
+            mEvents.clear();
+            mNrEvents = 0;
+            ++mNrFrames;
+            return deltaTime;
+        }
+
+        if (mMode != MODE_REPLAYING || mFinished)
+            return deltaTime;
+
+        // A frame cut at the end of the file, if the application that recorded
+        // it did not finish, ends the replay
+        float recordedDeltaTime;
+        uint32_t nrEvents;
+        if (!readValue(recordedDeltaTime) || !readValue(nrEvents))
+        {
+            mFinished = true;
+            std::cout << "Replay of " << mPath << " finished after " << mNrFrames << " frames\n";
+            return deltaTime;
+        }
+        for (uint32_t i = 0; i < nrEvents; ++i)
+        {
+            EventType type;
+            if (!readValue(type))
+                break;
+            if (type == EVENT_KEY_PRESS || type == EVENT_KEY_RELEASE)
+            {
+                uint16_t key;
+                if (!readValue(key))
+                    break;
+                inputHandler.processKeyInput(key, type == EVENT_KEY_PRESS);
+            }
+            else
+            {
+                double x;
+                double y;
+                if (!readValue(x) || !readValue(y))
+                    break;
+                if (type == EVENT_MOUSE)
+                    inputHandler.processMouseInput(x, y);
+                else
+                    inputHandler.processScrollInput(x, y);
+            }
+        }
+        ++mNrFrames;
+
+        // The replay finishes with the last frame of the file
+        if (mReplayPosition >= mReplayData.size())
+        {
+            mFinished = true;
+            std::cout << "Replay of " << mPath << " finished after " << mNrFrames << " frames\n";
+        }
+
+        return mFixedTimestep > 0.f ? mFixedTimestep : recordedDeltaTime;
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    class InputHandler;
+
+    // Recorder of the input events and the time step of each frame, which can
+    // be replayed later through an InputHandler to reproduce the same frames.
+    // While replaying, the input of the window is ignored and the time step of
+    // each frame is the recorded one, or a fixed one, so the replay does not
+    // depend on the time that the frames take. The seed of the random numbers
+    // is stored with the recording, so the scene can be built the same way.
+    // The file is binary, with all values little endian:
+    //      char[4] magic "GLIR", uint32 version, uint32 seed
+    //      For each frame: float time step, uint32 number of events, and the
+    //      events, each one as a uint8 type followed by:
+    //          key pressed or released: uint16 key
+    //          mouse moved or scroll: two doubles
+    class InputRecorder
+    {
+        public:
+            // Constructor
+            InputRecorder();
+
+            // Destructor, which finishes the recording
+            ~InputRecorder();
+
+            // Method to start recording to a file. Returns false if it cannot
+            // be written
+            bool startRecording(const std::string& path);
+
+            // Method to start replaying a file. Returns false if it cannot be
+            // read
+            bool startReplay(const std::string& path);
+
+            // Method to stop recording or replaying
+            void stop();
+
+            // Methods to check the mode of the recorder
+            bool isRecording() const
+            {
+                return mMode == MODE_RECORDING;
+            }
+            bool isReplaying() const
+            {
+                return mMode == MODE_REPLAYING;
+            }
+
+            // Method to check if all the frames of the replay have been played
+            bool hasFinished() const
+            {
+                return mFinished;
+            }
+
+            // Method to set the time step of the replayed frames, in seconds,
+            // instead of the recorded ones, or 0 to use the recorded ones
+            void setFixedTimestep(float timestep)
+            {
+                mFixedTimestep = timestep;
+            }
+
+            // Seed of the random numbers. It is the recorded one while
+            // replaying, and one taken from the clock otherwise, which is
+            // stored when recording
+            unsigned int getSeed() const
+            {
+                return mSeed;
+            }
+
+            // Number of frames recorded or replayed
+            unsigned int getNrFrames() const
+            {
+                return mNrFrames;
+            }
+
+            // Methods to record the input events of the window. They do nothing
+            // unless recording
+            void recordKey(int key, bool pressed);
+            void recordMouse(double xpos, double ypos);
+            void recordScroll(double xoffset, double yoffset);
+
+            // Method to start a frame, with the time since the previous one.
+            // When recording, the time step is stored with the events received
+            // since the previous frame. When replaying, the events of the next
+            // recorded frame are passed to the input handler, and its time step
+            // is returned. Otherwise the time step is returned unchanged
+            float beginFrame(float deltaTime, InputHandler& inputHandler);
+
+        private:
+            // Modes of the recorder
+            enum Mode
+            {
+                MODE_IDLE,
+                MODE_RECORDING,
+                MODE_REPLAYING
+            };
+
+            // Types of the events
+            enum EventType : unsigned char
+            {
+                EVENT_KEY_PRESS,
+                EVENT_KEY_RELEASE,
+                EVENT_MOUSE,
+                EVENT_SCROLL
+            };
+
+            Mode mMode;
+            std::string mPath;
+            unsigned int mSeed;
+            float mFixedTimestep;
+            unsigned int mNrFrames;
+            bool mFinished;
+
+            // File being recorded, and events received since the last frame,
+            // encoded as in the file
+            std::ofstream mFile;
+            std::vector<unsigned char> mEvents;
+            unsigned int mNrEvents;
+
+            // Contents of the file being replayed, and position of the next
+            // frame in it
+            std::vector<unsigned char> mReplayData;
+            size_t mReplayPosition;
+
+            // Method to read a value of the replay, advancing the position.
+            // Returns false if the file ends before it
+            template <typename T>
+            bool readValue(T& value);
+    };
+}
+
+#endif
@@ -15,13 +15,27 @@ namespace GLBase
         mLightType { lightType },
         mColor { color }, mPosition { position },
         mIntensity { intensity }, mAttenLinear { attenLinear },
-        mAttenQuadratic { attenQuadratic }, mShadowMapResolution { shadowRes }
+        mAttenQuadratic { attenQuadratic }, mShadowMapResolution { shadowRes },
+        mShadowFilter { SHADOW_FILTER_PCF }
 
     {
         // // Configure the FBO and the texture for the shadowmap
         // setupShadowMap();
     }
 
+    // Method to get the name of a member of a light in the arrays of the
+    // lighting shader
+    std::string Light::getUniformName(LightType type, unsigned int index, const char* member)
+    {
+        const char* array { type == LIGHT_DIRECTIONAL ? "dirLights[" :
+                            (type == LIGHT_SPOT ? "spotLights[" : "pointLights[") };
+        std::string name { array };
+        name += std::to_string(index);
+        name += "].";
+        name += member;
+        return name;
+    }
+
     //==============================
     // Methods of the DirectionalLight class
     //==============================
@@ -35,6 +49,10 @@ namespace GLBase
         mNrShadowCascadeLevels { nrShadowCascadeLevels },
         mLightSpaceMatrices(nrShadowCascadeLevels),
         mShadowCascadeDistances(nrShadowCascadeLevels + 1),
+        mStaggeredCascades { true }, mMaxCascadePeriod { 8 }, mFrameIndex { 0 },
+        mCascadeRendered(nrShadowCascadeLevels, false), mNrCascadesUpdated { 0 },
+        mCascadesUpdatedMask { 0 }, mShadowMomentsTexture { 0 }, mMomentsFilter { SHADOW_FILTER_PCF },
+        mVertexLayerCascades { false }, mHasVisibleDepthRange { false }, mVisibleDepthRange { 0.f, 0.f },
         Light( color, position, intensity, attenLinear, attenQuadratic, shadowRes,
                LIGHT_DIRECTIONAL )
     {
@@ -59,8 +77,9 @@ namespace GLBase
         setupShadowMap();
     }
 
-    // Initialize the UBO for the light matrices
+    // Initialize the UBO for the light matrices, and the comparison sampler
     unsigned int DirectionalLight::mLightMatricesUBO = 0;
+    unsigned int DirectionalLight::mCompareSampler = 0;
 
     // Method to configure the shadow map framebuffer and texture
     void DirectionalLight::setupShadowMap()
@@ -117,16 +136,43 @@ namespace GLBase
             glBindBufferBase(GL_UNIFORM_BUFFER, 0, mLightMatricesUBO);
             glBindBuffer(GL_UNIFORM_BUFFER, 0);
         }
+
+        // Create the sampler for the hardware PCF, which interpolates the result
+        // of comparing the depth of the four closest texels
+        if (mCompareSampler == 0)
+        {
+            glGenSamplers(1, &mCompareSampler);
+            glSamplerParameteri(mCompareSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glSamplerParameteri(mCompareSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glSamplerParameteri(mCompareSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(mCompareSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glSamplerParameteri(mCompareSampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glSamplerParameteri(mCompareSampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
     }
 
     // Method to compute the light space matrix from a camera
     // Following https://learnopengl.com/Guest-Articles/2021/CSM
+    // The projection is stabilized, so the shadows do not shimmer when the camera
+    // moves or rotates:
+    //  - It covers the bounding sphere of the subfrustum, whose radius does not
+    //    change with the orientation of the camera.
+    //  - Its center is snapped to the texels of the shadow map, so it only
+    //    moves in whole texels.
     void DirectionalLight::computeLightSpaceMatrix(const Camera& camera, int index)
     {
-        // Get the position of the eight corners of the frustum
-        // Store also the z value of the near plane of the current subfrustum
-        std::vector<glm::vec4> corners { camera.getFrustumCornersWorldSpace(mShadowCascadeDistances[index],
-                                                                            mShadowCascadeDistances[index + 1]) };
+        mLightSpaceMatrices[index] = computeLightSpaceMatrix(camera, mShadowCascadeDistances[index],
+                                                             mShadowCascadeDistances[index + 1], mDirection,
+                                                             mUpDirection, mShadowMapResolution);
+    }
+
+    // Method to compute the light space matrix of a subfrustum of a camera
+    glm::mat4 DirectionalLight::computeLightSpaceMatrix(const Camera& camera, float zNear, float zFar,
+                                                        const glm::vec3& direction, const glm::vec3& upDirection,
+                                                        int shadowRes)
+    {
+        // Get the position of the eight corners of the subfrustum
+        std::vector<glm::vec4> corners { camera.getFrustumCornersWorldSpace(zNear, zFar) };
 
         // Compute the center of the frustum
         glm::vec3 center { 0., 0., 0. };
@@ -136,108 +182,236 @@ namespace GLBase
         }
         center /= corners.size();
 
-        // Compute the light view matrix
-        const glm::mat4 lightView { glm::lookAt( center - mDirection,          // Position of the light
-                                                 center,                       // Center of the frustum 
-                                                 mUpDirection ) }; // Up vector
-
-        // Get the maximum and minimum coordinates of the corners of the frustum in
-        // the light's coordinate system
-        float minX { std::numeric_limits<float>::max() };
-        float minY { std::numeric_limits<float>::max() };
-        float minZ { std::numeric_limits<float>::max() };
-        float maxX { std::numeric_limits<float>::min() };
-        float maxY { std::numeric_limits<float>::min() };
-        float maxZ { std::numeric_limits<float>::min() };
+        // Radius of the bounding sphere around the center, rounded up so it
+        // does not change with the numerical error
+        float radius { 0.f };
         for (const auto& v : corners)
         {
-            // Project the current corner to light space
-            const glm::vec4 vLightSpace { lightView * v };
-            // Compare its coordinates to the ones stored
-            minX = std::min(vLightSpace.x, minX);
-            minY = std::min(vLightSpace.y, minY);
-            minZ = std::min(vLightSpace.z, minZ);
-            maxX = std::max(vLightSpace.x, maxX);
-            maxY = std::max(vLightSpace.y, maxY);
-            maxZ = std::max(vLightSpace.z, maxZ);
+            radius = std::max(radius, glm::length(glm::vec3(v) - center));
         }
+        radius = glm::ceil(radius * 16.f) / 16.f;
+
+        // Snap the center to the texels, in a light space with a fixed origin
+        const glm::mat4 lightRotation { glm::lookAt( glm::vec3(0.f), direction, upDirection ) };
+        const float texelsPerUnit { shadowRes / (2.f * radius) };
+        glm::vec3 centerLightSpace { lightRotation * glm::vec4(center, 1.f) };
+        centerLightSpace.x = glm::floor(centerLightSpace.x * texelsPerUnit) / texelsPerUnit;
+        centerLightSpace.y = glm::floor(centerLightSpace.y * texelsPerUnit) / texelsPerUnit;
+        center = glm::vec3(glm::inverse(lightRotation) * glm::vec4(centerLightSpace, 1.f));
+
+        // Compute the light view matrix
+        const glm::mat4 lightView { glm::lookAt( center,                       // Position of the light
+                                                 center + direction,           // Center of the frustum 
+                                                 upDirection ) };              // Up vector
 
-        // Increase the size of the light frustum in the Z direction
-        // constexpr float zMult { 10.f };
+        // Increase the size of the light frustum in the Z direction, towards
+        // the light, to include the casters outside of the subfrustum
         constexpr float zMult { 5.f };
-        if (minZ < 0)
-            minZ *= zMult;
-        else
-            minZ /= zMult;
-        if (maxZ < 0)
-            maxZ /= zMult;
-        else
-            maxZ *= zMult;
 
         // Compute the projection matrix of the light
-        const glm::mat4 lightProjection { glm::ortho(minX, maxX, minY, maxY, 
-                                                     minZ, maxZ) };
+        const glm::mat4 lightProjection { glm::ortho(-radius, radius, -radius, radius, 
+                                                     -zMult * radius, radius) };
 
         // Compute the lightSpaceMatrix
-        mLightSpaceMatrices[index] = lightProjection * lightView;
+        return lightProjection * lightView;
+    }
+
+    // Method to check if a cascade must be rendered in this frame
+    // The cascade i is rendered when the frame index is 2^(i-1) modulo 2^i, so
+    // the cascades after the first one are never rendered in the same frame
+    bool DirectionalLight::isCascadeDue(unsigned int index) const
+    {
+        if (!mStaggeredCascades || !mCascadeRendered[index])
+            return true;
+        const unsigned int period { std::min(1u << std::min(index, 31u), mMaxCascadePeriod) };
+        return mFrameIndex % period == period / 2;
     }
 
     // Method to compute the shadow map
     void DirectionalLight::computeShadowMap(const Camera& camera,
                                             const std::vector<GLElemObject*> objectsWithShadow)
     {
+        // Get the near and far plane from the camera
+        float zNear;
+        float zFar;
+        camera.getNearFarPlanes(zNear, zFar);
+
         // Check if the frustums have not been computed yet
-        if (mShadowCascadeDistances[0] < -100.)
+        bool placeCascades { mShadowCascadeDistances[0] < -100. };
+        float rangeNear { zNear };
+        float rangeFar { zFar };
+        if (mHasVisibleDepthRange)
         {
-            // Get the near and far plane from the camera
-            float zNear;
-            float zFar;
-            camera.getNearFarPlanes(zNear, zFar);
+            // Visible range, with a margin for the movement of the camera until
+            // the next one is measured
+            const float visibleNear { glm::clamp(mVisibleDepthRange.x, zNear, zFar) };
+            const float visibleFar { glm::clamp(mVisibleDepthRange.y, visibleNear, zFar) };
+            const float margin { 0.1f * (visibleFar - visibleNear) + 0.01f * visibleFar };
+            rangeNear = std::max(zNear, visibleNear - margin);
+            rangeFar = std::min(zFar, visibleFar + margin);
+
+            // Place the cascades again if they do not contain the visible range,
+            // or if they cover a much longer one
+            const float currentNear { mShadowCascadeDistances[0] };
+            const float currentFar { mShadowCascadeDistances[mNrShadowCascadeLevels] };
+            if (visibleNear < currentNear || visibleFar > currentFar
+                || currentFar - currentNear > 1.5f * (rangeFar - rangeNear))
+                placeCascades = true;
+        }
 
+        if (placeCascades)
+        {
             // Set the position of the first and last planes
-            mShadowCascadeDistances[0] = zNear;
-            mShadowCascadeDistances[mNrShadowCascadeLevels] = zFar;
+            mShadowCascadeDistances[0] = rangeNear;
+            mShadowCascadeDistances[mNrShadowCascadeLevels] = rangeFar;
 
             // Compute the distances of the rest of the planes
             for (int i = mNrShadowCascadeLevels - 1; i > 0; --i)
             {
-                mShadowCascadeDistances[i] = (mShadowCascadeDistances[i + 1] - zNear) / 2. + zNear;
+                mShadowCascadeDistances[i] = (mShadowCascadeDistances[i + 1] - rangeNear) / 2. + rangeNear;
             }
+
+            // All the cascades are rendered again with the new planes
+            std::fill(mCascadeRendered.begin(), mCascadeRendered.end(), false);
         }
 
-        // Compute the differnt light space matrices
-        for (int i = 0; i < mNrShadowCascadeLevels; ++i)
+        // Compute the light space matrices of the cascades rendered in this
+        // frame. The rest keep the last ones, with which they were rendered
+        unsigned int cascadeMask { 0 };
+        mNrCascadesUpdated = 0;
+        for (unsigned int i = 0; i < mNrShadowCascadeLevels; ++i)
         {
+            if (!isCascadeDue(i))
+                continue;
             computeLightSpaceMatrix(camera, i);
+            mCascadeRendered[i] = true;
+            cascadeMask |= 1u << i;
+            ++mNrCascadesUpdated;
         }
+        ++mFrameIndex;
+        mCascadesUpdatedMask = cascadeMask;
+        if (cascadeMask == 0)
+            return;
 
-        // Pass the lightSpaceMatrices to the UBO
-        // const auto lightMatrices = getLightSpaceMatrices();
+        // Pass the lightSpaceMatrices of these cascades to the UBO
         glBindBuffer(GL_UNIFORM_BUFFER, mLightMatricesUBO);
         for (size_t i = 0; i < mNrShadowCascadeLevels; ++i)
         {
-            glBufferSubData(GL_UNIFORM_BUFFER, i * sizeof(glm::mat4x4), sizeof(glm::mat4x4), &mLightSpaceMatrices[i]);
+            if (cascadeMask & (1u << i))
+                glBufferSubData(GL_UNIFORM_BUFFER, i * sizeof(glm::mat4x4), sizeof(glm::mat4x4), &mLightSpaceMatrices[i]);
         }
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, mNrCascadesUpdated * sizeof(glm::mat4x4));
+        RenderStats::add(RENDER_STAT_SHADOW_MAP_RENDERS, mNrCascadesUpdated);
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
         // Use the shader
         mShadowShader->use();
 
         // Bind the FBO, whose depth attachment is the shadow map texture
+        // Only the layers of the cascades rendered are cleared, attaching them
+        // one by one, and then the whole array is attached again
         glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFBO);
-        glFramebufferTexture(GL_FRAMEBUFFER, GL_TEXTURE_2D_ARRAY, mShadowMapTexture, 0);
-        // glBindTexture(GL_TEXTURE_2D_ARRAY, mShadowMapTexture);
         // Change the size of the viewport
         glViewport(0, 0, mShadowMapResolution, mShadowMapResolution);
-        glClear(GL_DEPTH_BUFFER_BIT);
+        for (unsigned int i = 0; i < mNrShadowCascadeLevels; ++i)
+        {
+            if (!(cascadeMask & (1u << i)))
+                continue;
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mShadowMapTexture, 0, i);
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mShadowMapTexture, 0);
 
-        // Draw each object in the scene
+        // Frustums of the cascades rendered
+        std::vector<glm::vec4> frustumPlanes(6 * mNrShadowCascadeLevels);
+        for (unsigned int i = 0; i < mNrShadowCascadeLevels; ++i)
+        {
+            if (cascadeMask & (1u << i))
+                GLUtils::getFrustumPlanes(mLightSpaceMatrices[i], &frustumPlanes[6 * i]);
+        }
+
+        // Draw each object in the scene, only to the cascades rendered whose
+        // frustum contains its bounding sphere
+        // With the geometry shader, each object is drawn once and the shader
+        // skips the cascades that are not in its mask. With the layer written
+        // by the vertex shader, each of its cascades is an instance
+        int cascades[8];
         for (auto object : objectsWithShadow)
         {
-            // Set the model matrix of the object in the shader
+            glm::vec3 center;
+            float radius;
+            object->getBoundingSphere(center, radius);
+            unsigned int objectMask { 0 };
+            for (unsigned int i = 0; i < mNrShadowCascadeLevels; ++i)
+            {
+                if ((cascadeMask & (1u << i)) && GLUtils::sphereInFrustum(&frustumPlanes[6 * i], center, radius))
+                    objectMask |= 1u << i;
+            }
+            if (objectMask == 0)
+                continue;
+
+            // Set the model matrix of the object in the shader, and the cascades
+            // where it is drawn
             mShadowShader->setMat4("model", object->getModelMatrix());
-            // Draw the object
-            object->draw();
+            if (mVertexLayerCascades)
+            {
+                int nrInstances { 0 };
+                for (unsigned int i = 0; i < mNrShadowCascadeLevels && i < 8; ++i)
+                {
+                    if (objectMask & (1u << i))
+                        cascades[nrInstances++] = (int)i;
+                }
+                mShadowShader->setIntArray("cascades", nrInstances, cascades);
+                // Draw one instance of the object for each cascade
+                object->drawInstanced(nrInstances);
+            }
+            else
+            {
+                mShadowShader->setInt("cascadeMask", (int)objectMask);
+                // Draw the object
+                object->draw();
+            }
+        }
+    }
+
+    // Method to compute the moments of the cascades rendered in the last shadow
+    // map, if the light uses the exponential or variance filter
+    void DirectionalLight::filterShadowMap(ShadowMomentsFilter& filter)
+    {
+        if (mShadowFilter != SHADOW_FILTER_ESM && mShadowFilter != SHADOW_FILTER_VSM)
+            return;
+
+        // Create the moments the first time they are needed
+        const int momentsResolution { std::max(1, mShadowMapResolution / 2) };
+        if (mShadowMomentsTexture == 0)
+        {
+            glGenTextures(1, &mShadowMomentsTexture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, mShadowMomentsTexture);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RG32F, momentsResolution, momentsResolution,
+                         mNrShadowCascadeLevels, 0, GL_RG, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        // All the cascades rendered are filtered again if the filter changed
+        unsigned int cascadeMask { mCascadesUpdatedMask };
+        if (mMomentsFilter != mShadowFilter)
+        {
+            for (unsigned int i = 0; i < mNrShadowCascadeLevels; ++i)
+            {
+                if (mCascadeRendered[i])
+                    cascadeMask |= 1u << i;
+            }
+            mMomentsFilter = mShadowFilter;
+        }
+
+        for (unsigned int i = 0; i < mNrShadowCascadeLevels; ++i)
+        {
+            if (cascadeMask & (1u << i))
+                filter.filter(mShadowMapTexture, i, glm::ivec4(0, 0, mShadowMapResolution, mShadowMapResolution),
+                              mShadowMomentsTexture, i, mShadowFilter == SHADOW_FILTER_ESM);
         }
     }
 
@@ -254,13 +428,13 @@ namespace GLBase
 
         // Pass the light properties to the shader
         // The shader must be bound before calling this method
-        lightingShader.setVec3("dirLights[" + std::to_string(indexDirectional) + "].color", mColor);
-        lightingShader.setVec3("dirLights[" + std::to_string(indexDirectional) + "].position", mPosition);
-        lightingShader.setVec3("dirLights[" + std::to_string(indexDirectional) + "].direction", mDirection);
+        lightingShader.setVec3(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "color"), mColor);
+        lightingShader.setVec3(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "position"), mPosition);
+        lightingShader.setVec3(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "direction"), mDirection);
 
-        lightingShader.setFloat("dirLights[" + std::to_string(indexDirectional) + "].intensity", mIntensity);
-        lightingShader.setFloat("dirLights[" + std::to_string(indexDirectional) + "].kLinear", mAttenLinear);
-        lightingShader.setFloat("dirLights[" + std::to_string(indexDirectional) + "].kQuadratic", mAttenQuadratic);
+        lightingShader.setFloat(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "intensity"), mIntensity);
+        lightingShader.setFloat(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "kLinear"), mAttenLinear);
+        lightingShader.setFloat(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "kQuadratic"), mAttenQuadratic);
 
         // Increase the counter of the directiona lights
         indexDirectional++;
@@ -271,27 +445,37 @@ namespace GLBase
                                            unsigned int& indexSpot, unsigned int& indexPoint,
                                            unsigned int& indexShadow) const
     {
-        // Bind the shadowmap texture to the corresponding texture unit
+        // Bind the shadowmap texture to the corresponding texture unit, the
+        // same texture with the comparison sampler to the next one, and the
+        // moments to the one after it
         glActiveTexture(GL_TEXTURE0 + indexShadow);
         glBindTexture(GL_TEXTURE_2D_ARRAY, mShadowMapTexture);
+        glActiveTexture(GL_TEXTURE0 + indexShadow + 1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, mShadowMapTexture);
+        glBindSampler(indexShadow + 1, mCompareSampler);
+        glActiveTexture(GL_TEXTURE0 + indexShadow + 2);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, mShadowMomentsTexture);
 
         // Pass also the index of the texture unit for the shadowmap, and the 
         // light space matrix
-        shader.setMat4("dirLights[" + std::to_string(indexDirectional) + "].lightSpaceMatrix", mLightSpaceMatrix);
-        shader.setInt("dirLights[" + std::to_string(indexDirectional) + "].shadowMap", indexShadow);
+        shader.setMat4(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "lightSpaceMatrix"), mLightSpaceMatrix);
+        shader.setInt(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "shadowMap"), indexShadow);
+        shader.setInt(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "shadowMapCompare"), indexShadow + 1);
+        shader.setInt(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "shadowMoments"), indexShadow + 2);
+        shader.setInt(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "shadowFilter"), (int)mShadowFilter);
         // shader.setInt("dirLights[" + std::to_string(indexDirectional) + "].nrCascadeLevels", mNrShadowCascadeLevels);
         shader.setInt("nrCascadeLevels", mNrShadowCascadeLevels);
         for (int i = 0; i < mNrShadowCascadeLevels + 1; ++i)
         {
-            shader.setFloat("dirLights[" + std::to_string(indexDirectional) + "].cascadeDistances["
-                             + std::to_string(i) + "]", mShadowCascadeDistances[i]);
+            shader.setFloat(getUniformName(LIGHT_DIRECTIONAL, indexDirectional, "cascadeDistances")
+                            + "[" + std::to_string(i) + "]", mShadowCascadeDistances[i]);
         }
 
         // Increase the counter of the directiona lights
         indexDirectional++;
         // Increase the counter of the shadow maps
         // indexShadow++;
-        indexShadow += mNrShadowCascadeLevels;
+        indexShadow += 3;
         // indexShadow += 10;
     }
 
@@ -334,40 +518,50 @@ namespace GLBase
 
         // Configure the FBO and the texture for the shadowmap
         setupShadowMap();
+        // Compute the light space matrix, so the renderer can use it before
+        // the first shadow map
+        computeLightSpaceMatrix();
     }
 
     // Method to configure the shadow map framebuffer and texture
+    // The light has no shadow until the renderer assigns it a tile of the
+    // atlas of the spot lights
     void SpotLight::setupShadowMap()
     {
-         // Generate the framebuffer and bind it
-        glGenFramebuffers(1, &mShadowMapFBO);
-
-        // Generate the texture
-        glGenTextures(1, &mShadowMapTexture);
-        glBindTexture(GL_TEXTURE_2D, mShadowMapTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F,
-             mShadowMapResolution, mShadowMapResolution, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER); 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-        float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);  
-
-        // Use the texture as the depth attachment of the FBO
-        glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFBO);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, mShadowMapTexture, 0);
-        glDrawBuffer(GL_NONE);
-        glReadBuffer(GL_NONE);
+        mShadowMapFBO = 0;
+        mShadowMapTexture = 0;
+        mShadowTile = glm::ivec4(0);
+        mShadowAtlasRect = glm::vec4(0.f);
+    }
 
-        // Check if the framebuffer is complete
-        int status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE)
+    // Method to get the smallest sphere containing the cone reached by the light
+    // For narrow cones the sphere passes through the tip and the circle of the
+    // base, and for wide ones it is centered in the base
+    void SpotLight::getBoundingSphere(glm::vec3& center, float& radius) const
+    {
+        const float halfAngle { 0.5f * mAngleOuter };
+        if (halfAngle >= 0.5f * glm::pi<float>())
         {
-            std::cout << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!" << std::endl;
-            throw 0;
+            center = mPosition;
+            radius = mRadiusMax;
         }
-        // glBindFramebuffer(GL_FRAMEBUFFER, 0);  
+        else if (halfAngle > 0.25f * glm::pi<float>())
+        {
+            center = mPosition + mDirection * (mRadiusMax * glm::cos(halfAngle));
+            radius = mRadiusMax * glm::sin(halfAngle);
+        }
+        else
+        {
+            radius = mRadiusMax / (2.f * glm::cos(halfAngle));
+            center = mPosition + mDirection * radius;
+        }
+    }
+
+    // Method to assign a tile of the atlas of shadow maps to this light
+    void SpotLight::setShadowTile(const glm::ivec4& tile, int atlasSize)
+    {
+        mShadowTile = tile;
+        mShadowAtlasRect = glm::vec4(tile) / (float)atlasSize;
     }
 
     // Method to compute the light space matrix
@@ -394,26 +588,25 @@ namespace GLBase
     void SpotLight::computeShadowMap(const Camera& camera,
                                      const std::vector<GLElemObject*> objectsWithShadow)
     {
+        // Nothing to do without a tile in the atlas
+        if (mShadowTile.z == 0)
+            return;
+
         // Compute the light space matrix
         computeLightSpaceMatrix();
+        RenderStats::add(RENDER_STAT_SHADOW_MAP_RENDERS);
 
-        // Change the size of the viewport
-        glViewport(0, 0, mShadowMapResolution, mShadowMapResolution);
+        // Change the viewport to the tile of the light. The framebuffer of the
+        // atlas was bound before this function call
+        glViewport(mShadowTile.x, mShadowTile.y, mShadowTile.z, mShadowTile.w);
 
-        // Bind the FBO, whose depth attachment is the shadow map texture
-        glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-
-        // Pass the lightSpaceMatrix to the shader (which was already bound before
-        // this function call)
+        // Pass the lightSpaceMatrix to the shader
         mShadowShader->use();
         mShadowShader->setMat4("lightSpaceMatrix", mLightSpaceMatrix);
         // Pass the position of the light and the far plane of its frustum to the shader
         mShadowShader->setFloat("farPlane", mRadiusMax);
         mShadowShader->setVec3("lightPos", mPosition);
 
-        // // Set face culling to the front faces
-        // glCullFace(GL_FRONT);
         // Draw each object in the scene
         for (auto object : objectsWithShadow)
         {
@@ -422,8 +615,6 @@ namespace GLBase
             // Draw the object
             object->draw();
         }
-        // // Restore face culling
-        // glCullFace(GL_BACK);
     }
 
     // Method to pass the light to a shader
@@ -439,42 +630,59 @@ namespace GLBase
 
         // Pass the light properties to the shader
         // The shader must be bound before calling this method
-        lightingShader.setVec3("spotLights[" + std::to_string(indexSpot) + "].color", mColor);
-        lightingShader.setVec3("spotLights[" + std::to_string(indexSpot) + "].position", mPosition);
-        lightingShader.setVec3("spotLights[" + std::to_string(indexSpot) + "].direction", mDirection);
-        lightingShader.setVec3("spotLights[" + std::to_string(indexSpot) + "].upDirection", mUpDirection);
+        lightingShader.setVec3(getUniformName(LIGHT_SPOT, indexSpot, "color"), mColor);
+        lightingShader.setVec3(getUniformName(LIGHT_SPOT, indexSpot, "position"), mPosition);
+        lightingShader.setVec3(getUniformName(LIGHT_SPOT, indexSpot, "direction"), mDirection);
+        lightingShader.setVec3(getUniformName(LIGHT_SPOT, indexSpot, "upDirection"), mUpDirection);
 
-        lightingShader.setFloat("spotLights[" + std::to_string(indexSpot) + "].intensity", mIntensity);
-        lightingShader.setFloat("spotLights[" + std::to_string(indexSpot) + "].kLinear", mAttenLinear);
-        lightingShader.setFloat("spotLights[" + std::to_string(indexSpot) + "].kQuadratic", mAttenQuadratic);
+        lightingShader.setFloat(getUniformName(LIGHT_SPOT, indexSpot, "intensity"), mIntensity);
+        lightingShader.setFloat(getUniformName(LIGHT_SPOT, indexSpot, "kLinear"), mAttenLinear);
+        lightingShader.setFloat(getUniformName(LIGHT_SPOT, indexSpot, "kQuadratic"), mAttenQuadratic);
 
-        lightingShader.setFloat("spotLights[" + std::to_string(indexSpot) + "].cosAngleInner", mCosAngleInner);
-        lightingShader.setFloat("spotLights[" + std::to_string(indexSpot) + "].cosAngleOuter", mCosAngleOuter);
-        lightingShader.setFloat("spotLights[" + std::to_string(indexSpot) + "].radiusMax", mRadiusMax);
+        lightingShader.setFloat(getUniformName(LIGHT_SPOT, indexSpot, "cosAngleInner"), mCosAngleInner);
+        lightingShader.setFloat(getUniformName(LIGHT_SPOT, indexSpot, "cosAngleOuter"), mCosAngleOuter);
+        lightingShader.setFloat(getUniformName(LIGHT_SPOT, indexSpot, "radiusMax"), mRadiusMax);
 
         // Increase the counter of the spot lights
         indexSpot++;
     }
 
-    // Method to pass the lightSpaceMatrix to a shader
+    // Method to pass the lightSpaceMatrix and the tile of the atlas to a shader
     void SpotLight::configureShaderForLightingPass(const Shader& shader, unsigned int& indexDirectional, 
                                            unsigned int& indexSpot, unsigned int& indexPoint,
                                            unsigned int& indexShadow) const
     {
-        // Bind the shadowmap texture to the corresponding texture unit
-        glActiveTexture(GL_TEXTURE0 + indexShadow);
-        glBindTexture(GL_TEXTURE_2D, mShadowMapTexture);
-
-        // Pass also the index of the texture unit for the shadowmap, and the 
-        // light space matrix
-        shader.setMat4("spotLights[" + std::to_string(indexSpot) + "].lightSpaceMatrix", mLightSpaceMatrix);
-        // shader.setInt("spotLights[" + std::to_string(indexSpot) + "].shadowMap", indexShadow);
-        shader.setInt("spotShadowMap", indexShadow);
+        // Pass the light space matrix, and the tile of the shadow map in the
+        // atlas, which is bound by the renderer
+        shader.setMat4(getUniformName(LIGHT_SPOT, indexSpot, "lightSpaceMatrix"), mLightSpaceMatrix);
+        shader.setVec4(getUniformName(LIGHT_SPOT, indexSpot, "atlasRect"), mShadowAtlasRect);
+        shader.setInt(getUniformName(LIGHT_SPOT, indexSpot, "shadowFilter"), (int)mShadowFilter);
 
         // Increase the counter of the spot lights
         indexSpot++;
-        // Increase the counter of the shadow maps
-        indexShadow++;
+    }
+
+    // Method to pass the light to the shader that draws its volume in
+    // the lighting pass
+    void SpotLight::configureShaderForLightVolume(const Shader& shader) const
+    {
+        // Pass the light properties to the shader
+        // The shader must be bound before calling this method
+        shader.setVec3("spotLight.color", mColor);
+        shader.setVec3("spotLight.position", mPosition);
+        shader.setVec3("spotLight.direction", mDirection);
+
+        shader.setFloat("spotLight.intensity", mIntensity);
+        shader.setFloat("spotLight.kLinear", mAttenLinear);
+        shader.setFloat("spotLight.kQuadratic", mAttenQuadratic);
+
+        shader.setFloat("spotLight.cosAngleInner", mCosAngleInner);
+        shader.setFloat("spotLight.cosAngleOuter", mCosAngleOuter);
+        shader.setFloat("spotLight.radiusMax", mRadiusMax);
+
+        shader.setMat4("spotLight.lightSpaceMatrix", mLightSpaceMatrix);
+        shader.setVec4("spotLight.atlasRect", mShadowAtlasRect);
+        shader.setInt("spotLight.shadowFilter", (int)mShadowFilter);
     }
 
     //==============================
@@ -491,27 +699,111 @@ namespace GLBase
         // becomes 5/256 times its value at d = 0
         float disc { mAttenLinear * mAttenLinear - 4.f * mAttenQuadratic * ( 1.f - mIntensity * 256.f / 5.f ) };
         mRadiusMax = ( - mAttenLinear + glm::sqrt(disc) ) / (2.f * mAttenQuadratic);
-        
+
+        // Configure the shadow map, without a slot until the renderer assigns one
+        setupShadowMap();
     }
 
     // Method to configure the shadow map framebuffer and texture
+    // The FBO and the texture are the ones of the array shared by all the point
+    // lights, which are passed with the slot
     void PointLight::setupShadowMap()
     {
-        
+        mShadowSlot = -1;
+        mShadowMapFBO = 0;
+        mShadowMapTexture = 0;
+    }
+
+    // Method to assign a slot of the array of shadow maps of the point lights
+    void PointLight::setShadowSlot(int slot, unsigned int shadowMapFBO, unsigned int shadowMapTexture,
+                                   int shadowRes)
+    {
+        mShadowSlot = slot;
+        mShadowMapFBO = shadowMapFBO;
+        mShadowMapTexture = shadowMapTexture;
+        if (shadowRes > 0)
+            mShadowMapResolution = shadowRes;
+    }
+
+    // Method to compute the matrices of the faces of the shadow map
+    // The faces have a field of view of 90 degrees, and their directions and
+    // up vectors are the ones used to sample them in the lighting shaders
+    void PointLight::computeFaceMatrices()
+    {
+        static const glm::vec3 directions[6] { { 1.f, 0.f, 0.f }, { -1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f },
+                                               { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f }, { 0.f, 0.f, -1.f } };
+        static const glm::vec3 ups[6] { { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f }, { 0.f, 0.f, 1.f },
+                                        { 0.f, 0.f, -1.f }, { 0.f, -1.f, 0.f }, { 0.f, -1.f, 0.f } };
+
+        const glm::mat4 lightProjection { glm::perspective(glm::radians(90.f), 1.f, 0.05f, mRadiusMax) };
+        for (int face = 0; face < 6; ++face)
+            mFaceMatrices[face] = lightProjection * glm::lookAt(mPosition, mPosition + directions[face], ups[face]);
     }
 
     // Method to compute the shadow map
     void PointLight::computeShadowMap(const Camera& camera,
                                       const std::vector<GLElemObject*> objectsWithShadow)
     {
+        if (mShadowSlot < 0)
+            return;
+
+        // Compute the matrices of the faces
+        computeFaceMatrices();
+        RenderStats::add(RENDER_STAT_SHADOW_MAP_RENDERS);
+
+        // Bind the FBO, whose depth attachment is the whole array of shadow
+        // maps, and change the size of the viewport
+        glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFBO);
+        glViewport(0, 0, mShadowMapResolution, mShadowMapResolution);
+
+        // Pass the matrices, the position of the light and the far plane of its
+        // frustum to the shader
+        mShadowShader->use();
+        for (int face = 0; face < 6; ++face)
+            mShadowShader->setMat4("faceMatrices[" + std::to_string(face) + "]", mFaceMatrices[face]);
+        mShadowShader->setInt("firstLayer", 6 * mShadowSlot);
+        mShadowShader->setFloat("farPlane", mRadiusMax);
+        mShadowShader->setVec3("lightPos", mPosition);
 
-        // // Bind the FBO, whose depth attachment is the shadow map texture
-        // glBindFramebuffer(GL_FRAMEBUFFER, mShadowMapFBO);
-        // glClear(GL_DEPTH_BUFFER_BIT);
-        //
-        // // Use the shader
-        // mShadowShader->use();
+        // Draw each object in the scene, only to the faces whose frustum
+        // contains its bounding sphere
+        // The frustum of a face is bounded by the four planes through the light
+        // at 45 degrees from its direction, and by the radius of the light
+        const float sqrtHalf { glm::sqrt(0.5f) };
+        for (auto object : objectsWithShadow)
+        {
+            glm::vec3 center;
+            float radius;
+            object->getBoundingSphere(center, radius);
+            const glm::vec3 lightToCenter { center - mPosition };
+            if (glm::length(lightToCenter) > mRadiusMax + radius)
+                continue;
+
+            int faceMask { 0 };
+            for (int face = 0; face < 6; ++face)
+            {
+                // Axis of the face, and the two other axes
+                const int axis { face / 2 };
+                const float sign { face % 2 == 0 ? 1.f : -1.f };
+                const float forward { sign * lightToCenter[axis] };
+                bool inside { true };
+                for (int other = 1; other < 3 && inside; ++other)
+                {
+                    const float side { lightToCenter[(axis + other) % 3] };
+                    inside = sqrtHalf * (forward - side) >= -radius && sqrtHalf * (forward + side) >= -radius;
+                }
+                if (inside)
+                    faceMask |= 1 << face;
+            }
+            if (faceMask == 0)
+                continue;
 
+            // Set the model matrix of the object and its faces in the shader
+            mShadowShader->setMat4("model", object->getModelMatrix());
+            mShadowShader->setInt("faceMask", faceMask);
+            // Draw the object
+            object->draw();
+        }
     }
 
     // Method to pass the light to a shader
@@ -522,40 +814,33 @@ namespace GLBase
                                      unsigned int& indexPoint,
                                      unsigned int& indexShadow)
     {
-        // // Copy the pointer to the shader
-        // mShadowShader = shadowShader;
+        // Copy the pointer to the shader
+        mShadowShader = shadowShader;
 
         // Pass the light properties to the shader
         // The shader must be bound before calling this method
-        lightingShader.setVec3("pointLights[" + std::to_string(indexPoint) + "].color", mColor);
-        lightingShader.setVec3("pointLights[" + std::to_string(indexPoint) + "].position", mPosition);
+        lightingShader.setVec3(getUniformName(LIGHT_POINT, indexPoint, "color"), mColor);
+        lightingShader.setVec3(getUniformName(LIGHT_POINT, indexPoint, "position"), mPosition);
 
-        lightingShader.setFloat("pointLights[" + std::to_string(indexPoint) + "].intensity", mIntensity);
-        lightingShader.setFloat("pointLights[" + std::to_string(indexPoint) + "].kLinear", mAttenLinear);
-        lightingShader.setFloat("pointLights[" + std::to_string(indexPoint) + "].kQuadratic", mAttenQuadratic);
-        lightingShader.setFloat("pointLights[" + std::to_string(indexPoint) + "].radiusMax", mRadiusMax);
+        lightingShader.setFloat(getUniformName(LIGHT_POINT, indexPoint, "intensity"), mIntensity);
+        lightingShader.setFloat(getUniformName(LIGHT_POINT, indexPoint, "kLinear"), mAttenLinear);
+        lightingShader.setFloat(getUniformName(LIGHT_POINT, indexPoint, "kQuadratic"), mAttenQuadratic);
+        lightingShader.setFloat(getUniformName(LIGHT_POINT, indexPoint, "radiusMax"), mRadiusMax);
 
         // Increase the count of the point lights
         indexPoint++;
     }
 
-    // Method to pass the lightSpaceMatrix to a shader
+    // Method to pass the slot of the shadow map to a shader
     void PointLight::configureShaderForLightingPass(const Shader& shader, unsigned int& indexDirectional, 
                                            unsigned int& indexSpot, unsigned int& indexPoint,
                                            unsigned int& indexShadow) const
     {
-        // // Bind the shadowmap texture to the corresponding texture unit
-        // glActiveTexture(GL_TEXTURE0 + indexShadow);
-        // glBindTexture(GL_TEXTURE_2D, mShadowMapTexture);
-
-        // Pass also the index of the texture unit for the shadowmap, and the 
-        // light space matrix
-        shader.setMat4("pointLights[" + std::to_string(indexPoint) + "].lightSpaceMatrix", mLightSpaceMatrix);
-        shader.setInt("pointLights[" + std::to_string(indexPoint) + "].shadowMap", indexShadow++);
+        // The array of shadow maps is bound by the renderer, so only the slot
+        // of this light is needed, and no texture unit is used
+        shader.setInt(getUniformName(LIGHT_POINT, indexPoint, "shadowSlot"), mShadowSlot);
 
         // Increase the count of the point lights
         indexPoint++;
-        // // Increase the counter of the shadow maps
-        // indexShadow++;
     }
 }
@@ -14,6 +14,25 @@ namespace GLBase
         LIGHT_SPOT
     };
 
+    // Enum for the filters of the shadow maps of the directional and spot
+    // lights. The point lights always use PCF
+    enum ShadowFilter
+    {
+        // Percentage closer filtering over 3x3 texels of the depth
+        SHADOW_FILTER_PCF,
+        // Percentage closer filtering over 2x2 texels done by the texture
+        // unit, with a single fetch through a comparison sampler
+        SHADOW_FILTER_HARDWARE_PCF,
+        // Exponential shadow map, with the exponential of the depth blurred
+        // after rendering it, and read with a single fetch
+        SHADOW_FILTER_ESM,
+        // Variance shadow map, with the depth and its square blurred after
+        // rendering it, and read with a single fetch
+        SHADOW_FILTER_VSM
+    };
+
+    class ShadowMomentsFilter;
+
     class Light
     {
         protected:
@@ -47,11 +66,22 @@ namespace GLBase
             int mShadowMapResolution;
             // Light space matrix
             glm::mat4 mLightSpaceMatrix;
+            // Filter of the shadow map
+            ShadowFilter mShadowFilter;
 
             // Method to configure the shadow map framebuffer and texture
             virtual void setupShadowMap() = 0;
 
         public:
+            // Destructor, virtual so the lights can be deleted through a
+            // pointer to this class
+            virtual ~Light() {};
+
+            // Method to get the name of a member of a light in the arrays of
+            // the lighting shader, like "spotLights[2].color". It does not need
+            // an OpenGL context
+            static std::string getUniformName(LightType type, unsigned int index, const char* member);
+
             // Method to get the position of the light
             inline glm::vec3 getPosition()
             {
@@ -64,6 +94,40 @@ namespace GLBase
                 return mLightType;
             }
 
+            // Methods to get the color and the attenuation constants of the light
+            inline glm::vec3 getColor()
+            {
+                return mColor;
+            }
+            inline float getIntensity()
+            {
+                return mIntensity;
+            }
+            inline float getAttenLinear()
+            {
+                return mAttenLinear;
+            }
+            inline float getAttenQuadratic()
+            {
+                return mAttenQuadratic;
+            }
+
+            // Method to get the resolution of the shadow map
+            inline int getShadowMapResolution()
+            {
+                return mShadowMapResolution;
+            }
+
+            // Methods to set and get the filter of the shadow map
+            inline void setShadowFilter(ShadowFilter filter)
+            {
+                mShadowFilter = filter;
+            }
+            inline ShadowFilter getShadowFilter()
+            {
+                return mShadowFilter;
+            }
+
             // // Method to set the pointer to the shader
             // void setShadowShader(Shader* shader)
             // {
@@ -106,22 +170,121 @@ namespace GLBase
             // Distances of the near plane of the different levels of the cascade
             std::vector<float> mShadowCascadeDistances;
 
+            // Staggered updates of the cascades
+            bool mStaggeredCascades;
+            // Maximum number of frames between the updates of a cascade
+            unsigned int mMaxCascadePeriod;
+            // Number of shadow maps computed
+            unsigned int mFrameIndex;
+            // True for the cascades that have been rendered at least once
+            std::vector<bool> mCascadeRendered;
+            // Number of cascades rendered in the last shadow map, one bit for
+            // each one
+            unsigned int mNrCascadesUpdated;
+            unsigned int mCascadesUpdatedMask;
+
+            // Moments of the cascades for the exponential and variance shadow
+            // maps, with half of the resolution of the shadow map. They are
+            // created the first time they are needed, and the filter with which
+            // they were computed is kept to compute them again when it changes
+            unsigned int mShadowMomentsTexture;
+            ShadowFilter mMomentsFilter;
+            // Sampler that compares the depth for the hardware PCF, shared by
+            // all the directional lights
+            static unsigned int mCompareSampler;
+
+            // True if the layers of the cascades are written by the vertex
+            // shader, drawing an instance for each one, instead of by a
+            // geometry shader
+            bool mVertexLayerCascades;
+
+            // Range of distances to the camera of the visible pixels, from the
+            // depth of the G-buffer, used to place the cascades instead of the
+            // near and far planes of the camera
+            bool mHasVisibleDepthRange;
+            glm::vec2 mVisibleDepthRange;
+
             // Method to configure the shadow map framebuffer and texture
             void setupShadowMap();
 
             // Method to compute the light space matrix from a camera
             void computeLightSpaceMatrix(const Camera& camera, int index);
 
+            // Method to check if a cascade must be rendered in this frame
+            bool isCascadeDue(unsigned int index) const;
+
         public:
             // Constructor
             DirectionalLight(glm::vec3 color, glm::vec3 position, glm::vec3 direction,
                              float intensity, float attenLinear, float attenQuadratic,
                              int shadowRes = 2048, unsigned int nrShadowCascadeLevels = 4);
 
+            // Method to enable the staggered updates of the cascades. The first
+            // cascade is rendered every frame, and the cascade i every 2^i
+            // frames up to maxPeriod, so at most two cascades are rendered in a
+            // frame. The lighting pass uses the last matrix rendered of each one
+            void setStaggeredCascades(bool enabled, unsigned int maxPeriod = 8)
+            {
+                mStaggeredCascades = enabled;
+                mMaxCascadePeriod = std::max(1u, maxPeriod);
+            }
+
+            // Method to compute the light space matrix of the subfrustum of a
+            // camera between two distances, for a light with a direction and a
+            // shadow map of a resolution. It does not need an OpenGL context
+            static glm::mat4 computeLightSpaceMatrix(const Camera& camera, float zNear, float zFar,
+                                                     const glm::vec3& direction, const glm::vec3& upDirection,
+                                                     int shadowRes);
+
+            // Method to get the number of cascades rendered in the last frame
+            inline unsigned int getNrCascadesUpdated()
+            {
+                return mNrCascadesUpdated;
+            }
+
+            // Method to set the shader that renders the cascades, and whether
+            // it writes the layer in the vertex shader or in a geometry shader
+            void setCascadeShadowShader(Shader* shadowShader, bool vertexLayer)
+            {
+                mShadowShader = shadowShader;
+                mVertexLayerCascades = vertexLayer;
+            }
+
+            // Method to set the range of distances to the camera of the visible
+            // pixels, for the sample distribution of the cascades. They are
+            // placed in the range only when it does not contain the visible one
+            // or it is much larger, so they are not rendered again every frame
+            void setVisibleDepthRange(float zMin, float zMax)
+            {
+                mHasVisibleDepthRange = true;
+                mVisibleDepthRange = glm::vec2(zMin, zMax);
+            }
+
+            // Method to place the cascades again between the near and far planes
+            // of the camera
+            void resetVisibleDepthRange()
+            {
+                if (!mHasVisibleDepthRange)
+                    return;
+                mHasVisibleDepthRange = false;
+                mShadowCascadeDistances[0] = -101.f;
+            }
+
+            // Method to get the distances of the planes between the cascades,
+            // from the near plane of the first to the far plane of the last
+            inline const std::vector<float>& getCascadeDistances() const
+            {
+                return mShadowCascadeDistances;
+            }
+
             // Method to compute the shadow map
             void computeShadowMap(const Camera& camera,
                                   const std::vector<GLGeometry::GLElemObject*> objectsWithShadow);
 
+            // Method to compute the moments of the cascades rendered in the last
+            // shadow map, if the light uses the exponential or variance filter
+            void filterShadowMap(ShadowMomentsFilter& filter);
+
             // Method to pass the light to a shader
             void configureShader(const Shader& lightingShader, 
                                  Shader* shadowShader, 
@@ -131,6 +294,8 @@ namespace GLBase
                                  unsigned int& indexShadow);
 
             // Method to pass the lightSpaceMatrix to a shader
+            // The light uses three texture units from indexShadow: the shadow
+            // map, the same texture with the comparison sampler, and the moments
             void configureShaderForLightingPass(const Shader& shader, unsigned int& indexDirectional, 
                                                    unsigned int& indexSpot, unsigned int& indexPoint,
                                                    unsigned int& indexShadow) const;
@@ -154,7 +319,15 @@ namespace GLBase
             // Light space matrix
             glm::mat4 mLightSpaceMatrix;
 
+            // Tile of the shadow map in the atlas of the spot lights, with its
+            // offset and size in texels, and the same in texture coordinates
+            // of the atlas. The size is 0 when the light has no shadow
+            glm::ivec4 mShadowTile;
+            glm::vec4 mShadowAtlasRect;
+
             // Method to configure the shadow map framebuffer and texture
+            // The atlas of shadow maps is shared by the spot lights, and each
+            // frame the renderer assigns their tiles with setShadowTile()
             void setupShadowMap();
 
             // Method to compute the light space matrix
@@ -168,7 +341,59 @@ namespace GLBase
                       float intensity, float attenLinear, float attenQuadratic,
                       int shadowRes = 2048);
 
+            // Method to get the direction of the light
+            inline glm::vec3 getDirection()
+            {
+                return mDirection;
+            }
+
+            // Method to get the outer angle of the light, in radians
+            inline float getAngleOuter()
+            {
+                return mAngleOuter;
+            }
+
+            // Methods to get the cosines of the half of the inner and outer angles
+            inline float getCosAngleInner()
+            {
+                return mCosAngleInner;
+            }
+            inline float getCosAngleOuter()
+            {
+                return mCosAngleOuter;
+            }
+
+            // Method to get the light space matrix of the last shadow map
+            inline glm::mat4 getLightSpaceMatrix()
+            {
+                return mLightSpaceMatrix;
+            }
+
+            // Method to get the maximum distance reached by the light
+            inline float getRadiusMax()
+            {
+                return mRadiusMax;
+            }
+
+            // Method to get the smallest sphere containing the cone reached by
+            // the light
+            void getBoundingSphere(glm::vec3& center, float& radius) const;
+
+            // Method to assign a tile of the atlas of shadow maps to this light,
+            // with its offset and size in texels, or a size of 0 to disable
+            // its shadow
+            void setShadowTile(const glm::ivec4& tile, int atlasSize);
+
+            // Method to get the tile of the shadow map in texture coordinates
+            // of the atlas, with the offset in xy and the size in zw
+            inline glm::vec4 getShadowAtlasRect()
+            {
+                return mShadowAtlasRect;
+            }
+
             // Method to compute the shadow map
+            // It is rendered to the tile of the light, in the framebuffer of the
+            // atlas that is bound, which must be cleared before
             void computeShadowMap(const Camera& camera,
                                   const std::vector<GLGeometry::GLElemObject*> objectsWithShadow);
 
@@ -180,10 +405,15 @@ namespace GLBase
                                  unsigned int& indexPoint,
                                  unsigned int& indexShadow);
 
-            // Method to pass the lightSpaceMatrix to a shader
+            // Method to pass the lightSpaceMatrix and the tile of the atlas to
+            // a shader
             void configureShaderForLightingPass(const Shader& shader, unsigned int& indexDirectional, 
                                                    unsigned int& indexSpot, unsigned int& indexPoint,
                                                    unsigned int& indexShadow) const;
+
+            // Method to pass the light to the shader that draws its volume in
+            // the lighting pass
+            void configureShaderForLightVolume(const Shader& shader) const;
     };
 
     class PointLight : public Light
@@ -192,11 +422,20 @@ namespace GLBase
             // Maximum distance reached by the light
             float mRadiusMax;
 
+            // Slot of the shadow map in the array of shadow maps of the point
+            // lights, with its six faces in the layers starting at 6 * slot.
+            // It is -1 when the light has no shadow in this frame
+            int mShadowSlot;
+            // Projection and view matrices of the six faces of the shadow map
+            glm::mat4 mFaceMatrices[6];
+
             // Method to configure the shadow map framebuffer and texture
+            // The array of shadow maps is shared by the point lights, and each
+            // frame the renderer assigns its slots with setShadowSlot()
             void setupShadowMap();
-            //
-            // // Method to compute the light space matrix from a camera
-            // void computeLightSpaceMatrix(const Camera& camera);
+
+            // Method to compute the matrices of the faces of the shadow map
+            void computeFaceMatrices();
 
         public:
             // Constructor
@@ -204,7 +443,27 @@ namespace GLBase
                        float intensity, float attenLinear, float attenQuadratic,
                        int shadowRes = 1024);
 
+            // Method to get the maximum distance reached by the light
+            inline float getRadiusMax()
+            {
+                return mRadiusMax;
+            }
+
+            // Method to assign a slot of the array of shadow maps of the point
+            // lights to this light, or -1 to disable its shadow
+            void setShadowSlot(int slot, unsigned int shadowMapFBO = 0, unsigned int shadowMapTexture = 0,
+                               int shadowRes = 0);
+
+            // Method to get the slot of the shadow map, or -1 if it has none
+            inline int getShadowSlot()
+            {
+                return mShadowSlot;
+            }
+
             // Method to compute the shadow map
+            // The six faces are rendered in a single pass, to the layers of its
+            // slot, with the distance to the light as depth. The array must be
+            // cleared before, since it is shared with the other lights
             void computeShadowMap(const Camera& camera,
                                   const std::vector<GLGeometry::GLElemObject*> objectsWithShadow);
 
@@ -216,7 +475,7 @@ namespace GLBase
                                  unsigned int& indexPoint,
                                  unsigned int& indexShadow);
 
-            // Method to pass the lightSpaceMatrix to a shader
+            // Method to pass the slot of the shadow map to a shader
             void configureShaderForLightingPass(const Shader& shader, unsigned int& indexDirectional, 
                                                    unsigned int& indexSpot, unsigned int& indexPoint,
                                                    unsigned int& indexShadow) const;
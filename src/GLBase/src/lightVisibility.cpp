@@ -0,0 +1,136 @@
+#include "lightVisibility.h"
+
+namespace GLBase
+{
+    // Constructor
+    LightVisibility::LightVisibility() :
+        mMaxShadedLights { std::numeric_limits<unsigned int>::max() },
+        mMaxShadowedLights { std::numeric_limits<unsigned int>::max() },
+        mFadeFrames { 10 }, mFrameIndex { 0 },
+        mNrCulled { 0 }, mNrShaded { 0 }, mNrFading { 0 }, mNrShadowed { 0 }
+    {}
+
+    // Method to cull and score the lights, and apply the budgets
+    void LightVisibility::update(const std::vector<Light*>& lights, const glm::mat4& view,
+                                 const glm::mat4& projection)
+    {
+        ++mFrameIndex;
+        mNrCulled = 0;
+        mNrShaded = 0;
+        mNrFading = 0;
+        mNrShadowed = 0;
+
+        glm::vec4 frustumPlanes[6];
+        GLUtils::getFrustumPlanes(projection * view, frustumPlanes);
+        const glm::vec3 cameraPosition { glm::inverse(view)[3] };
+
+        // Score of each light in the frustum
+        std::vector<std::pair<float, Light*>> candidates;
+        for (auto light : lights)
+        {
+            glm::vec3 center;
+            float radius;
+            if (light->getLightType() == LIGHT_POINT)
+            {
+                center = light->getPosition();
+                radius = static_cast<PointLight*>(light)->getRadiusMax();
+            }
+            else if (light->getLightType() == LIGHT_SPOT)
+                static_cast<SpotLight*>(light)->getBoundingSphere(center, radius);
+            else
+                continue;
+
+            auto it { mStates.find(light) };
+            if (it == mStates.end())
+                it = mStates.insert({ light, { 0.f, false, false, mFrameIndex } }).first;
+            LightState& state { it->second };
+            state.lastFrame = mFrameIndex;
+
+            // The lights outside of the frustum do not reach any visible pixel,
+            // so they are removed without fading
+            if (!GLUtils::sphereInFrustum(frustumPlanes, center, radius))
+            {
+                state.fade = 0.f;
+                state.visible = false;
+                state.shadowed = false;
+                ++mNrCulled;
+                continue;
+            }
+
+            const glm::vec3 color { light->getColor() };
+            const float luminance { glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f)) };
+            const float score { GLUtils::getSphereScreenCoverage(center, radius, cameraPosition, projection)
+                                * luminance * light->getIntensity() };
+            candidates.push_back({ score, light });
+        }
+
+        // Remove the lights that are not in the list anymore
+        for (auto it = mStates.begin(); it != mStates.end();)
+        {
+            if (it->second.lastFrame == mFrameIndex)
+                ++it;
+            else
+                it = mStates.erase(it);
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const std::pair<float, Light*>& a, const std::pair<float, Light*>& b)
+                         { return a.first > b.first; });
+
+        // The lights in the budget fade in, and the rest fade out. The ones
+        // that were outside of the frustum in the last frame are not visible
+        // yet, so they start with their final factor
+        const float fadeStep { mFadeFrames == 0 ? 1.f : 1.f / (float)mFadeFrames };
+        std::vector<std::pair<float, Light*>> shadowCandidates;
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            LightState& state { mStates[candidates[i].second] };
+            const bool inBudget { i < mMaxShadedLights };
+            if (!state.visible)
+                state.fade = inBudget ? 1.f : 0.f;
+            else if (inBudget)
+                state.fade = std::min(1.f, state.fade + fadeStep);
+            else
+                state.fade = std::max(0.f, state.fade - fadeStep);
+            state.visible = true;
+
+            if (state.fade > 0.f)
+                ++mNrShaded;
+            if (state.fade > 0.f && state.fade < 1.f)
+                ++mNrFading;
+
+            // Only the lights in the budget of shaded ones can cast shadows,
+            // and the ones that already did are preferred
+            if (inBudget)
+                shadowCandidates.push_back({ state.shadowed ? 1.25f * candidates[i].first : candidates[i].first,
+                                             candidates[i].second });
+            else
+                state.shadowed = false;
+        }
+
+        std::stable_sort(shadowCandidates.begin(), shadowCandidates.end(),
+                         [](const std::pair<float, Light*>& a, const std::pair<float, Light*>& b)
+                         { return a.first > b.first; });
+        for (size_t i = 0; i < shadowCandidates.size(); ++i)
+        {
+            LightState& state { mStates[shadowCandidates[i].second] };
+            state.shadowed = i < mMaxShadowedLights;
+            if (state.shadowed)
+                ++mNrShadowed;
+        }
+    }
+
+    // Method to get the factor of the color of a light in this frame
+    float LightVisibility::getFade(Light* light) const
+    {
+        const auto it { mStates.find(light) };
+        return it == mStates.end() ? 1.f : it->second.fade;
+    }
+
+    // Method to check if a light can cast a shadow in this frame
+    bool LightVisibility::isShadowed(Light* light) const
+    {
+        const auto it { mStates.find(light) };
+        return it == mStates.end() || it->second.shadowed;
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef LIGHTVISIBILITY_H
+#define LIGHTVISIBILITY_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    class Light;
+
+    // Selection of the point and spot lights used in each frame.
+    // The lights whose volume is outside of the view frustum are culled, with
+    // the bounding sphere of the point lights and of the cone of the spot lights.
+    // The rest are scored by the area of the screen covered by their volume
+    // times their intensity, and only the ones with the highest scores are
+    // shaded and cast shadows, up to the budgets.
+    //
+    // The lights that enter or leave the budget of shaded lights fade in or out
+    // in some frames, with a factor that multiplies their color, instead of
+    // appearing or disappearing at once. The shadows cannot fade, so a light
+    // keeps its shadow until another one has a score 25% higher.
+    // The directional lights are always shaded and cast shadows.
+    class LightVisibility
+    {
+        public:
+            // Constructor
+            LightVisibility();
+
+            // Method to set the maximum number of point and spot lights that are
+            // shaded and that cast shadows in each frame
+            void setBudgets(unsigned int maxShadedLights, unsigned int maxShadowedLights)
+            {
+                mMaxShadedLights = maxShadedLights;
+                mMaxShadowedLights = maxShadowedLights;
+            }
+
+            // Method to set the number of frames that the lights take to fade in
+            // or out when they enter or leave the budget. With 0 they do not fade
+            void setFadeFrames(unsigned int frames)
+            {
+                mFadeFrames = frames;
+            }
+
+            // Method to cull and score the lights for the frustum given by the
+            // view and projection matrices, and apply the budgets
+            void update(const std::vector<Light*>& lights, const glm::mat4& view, const glm::mat4& projection);
+
+            // Method to get the factor of the color of a light in this frame,
+            // which is 0 if it is not shaded. The lights that were not in the
+            // last update are not managed, and have 1
+            float getFade(Light* light) const;
+
+            // Method to check if a light can cast a shadow in this frame
+            bool isShadowed(Light* light) const;
+
+            // Methods to get information of the last update
+            // Number of point and spot lights culled by the frustum
+            inline unsigned int getNrCulled() const
+            {
+                return mNrCulled;
+            }
+            // Number of point and spot lights shaded, including the ones that
+            // are fading
+            inline unsigned int getNrShaded() const
+            {
+                return mNrShaded;
+            }
+            // Number of point and spot lights that are fading in or out
+            inline unsigned int getNrFading() const
+            {
+                return mNrFading;
+            }
+            // Number of point and spot lights that can cast a shadow
+            inline unsigned int getNrShadowed() const
+            {
+                return mNrShadowed;
+            }
+
+        private:
+            // State of a light
+            struct LightState
+            {
+                // Factor of the color
+                float fade;
+                // True if it was in the frustum, and if it could cast a shadow
+                bool visible;
+                bool shadowed;
+                // Last update in which the light was in the list
+                unsigned int lastFrame;
+            };
+            std::map<Light*, LightState> mStates;
+
+            // Budgets, and frames of the fades
+            unsigned int mMaxShadedLights;
+            unsigned int mMaxShadowedLights;
+            unsigned int mFadeFrames;
+
+            // Number of updates
+            unsigned int mFrameIndex;
+
+            // Information of the last update
+            unsigned int mNrCulled;
+            unsigned int mNrShaded;
+            unsigned int mNrFading;
+            unsigned int mNrShadowed;
+    };
+}
+
+#endif
@@ -0,0 +1,228 @@
+#include "GLBase.h"
+
+namespace GLBase
+{
+    namespace LZ4
+    {
+        // Constants of the block format
+        // Minimum length of a match
+        constexpr int MIN_MATCH { 4 };
+        // The last 5 bytes of a block are always literals
+        constexpr int LAST_LITERALS { 5 };
+        // The last match must start at least 12 bytes before the end of the block
+        constexpr int MF_LIMIT { 12 };
+        // Maximum offset of a match
+        constexpr int MAX_DISTANCE { 65535 };
+        // Number of bits of the hash table used to find matches
+        constexpr int HASH_LOG { 12 };
+
+        // Read 4 bytes from a position of the input
+        inline uint32_t read32(const unsigned char* p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        // Hash of a sequence of 4 bytes, used to index the hash table
+        inline uint32_t hashSequence(uint32_t sequence)
+        {
+            return (sequence * 2654435761u) >> (32 - HASH_LOG);
+        }
+
+        // Write a length that does not fit in the 4 bits of the token, as a
+        // sequence of bytes of value 255 followed by the remainder
+        inline bool writeLength(int length, unsigned char*& op, const unsigned char* opEnd)
+        {
+            while (length >= 255)
+            {
+                if (op >= opEnd)
+                    return false;
+                *op++ = 255;
+                length -= 255;
+            }
+            if (op >= opEnd)
+                return false;
+            *op++ = (unsigned char)length;
+            return true;
+        }
+
+        // Emit a sequence made of the literals in [anchor, anchor + nrLiterals)
+        // followed by a match (only if matchLength > 0)
+        inline bool writeSequence(const unsigned char* anchor, int nrLiterals,
+                                  int offset, int matchLength,
+                                  unsigned char*& op, const unsigned char* opEnd)
+        {
+            // Token with the two lengths
+            unsigned char* token { op++ };
+            if (token >= opEnd)
+                return false;
+            *token = (unsigned char)( (nrLiterals >= 15 ? 15 : nrLiterals) << 4 );
+            if (nrLiterals >= 15 && !writeLength(nrLiterals - 15, op, opEnd))
+                return false;
+
+            // Copy the literals
+            if (op + nrLiterals > opEnd)
+                return false;
+            std::memcpy(op, anchor, nrLiterals);
+            op += nrLiterals;
+
+            // The last sequence of a block has no match
+            if (matchLength == 0)
+                return true;
+
+            // Offset of the match, in little endian
+            if (op + 2 > opEnd)
+                return false;
+            *op++ = (unsigned char)(offset & 0xFF);
+            *op++ = (unsigned char)(offset >> 8);
+
+            // Length of the match
+            int lengthCode { matchLength - MIN_MATCH };
+            *token |= (unsigned char)(lengthCode >= 15 ? 15 : lengthCode);
+            if (lengthCode >= 15 && !writeLength(lengthCode - 15, op, opEnd))
+                return false;
+
+            return true;
+        }
+
+        // Compress a block of data
+        int compressBlock(const unsigned char* src, int srcSize,
+                          unsigned char* dst, int dstCapacity)
+        {
+            unsigned char* op { dst };
+            const unsigned char* opEnd { dst + dstCapacity };
+
+            // Start of the literals that have not been written yet
+            int anchor { 0 };
+            int ip { 0 };
+
+            // Blocks too small to contain a match are stored as a single sequence
+            // of literals
+            if (srcSize >= MF_LIMIT + 1)
+            {
+                // Hash table with the last position where each sequence was found
+                std::vector<int> table(1 << HASH_LOG, -1);
+
+                // Matches cannot extend into the last literals
+                const int matchLimit { srcSize - LAST_LITERALS };
+
+                while (ip + MF_LIMIT <= srcSize)
+                {
+                    // Look for a previous occurrence of the current 4 bytes
+                    const uint32_t sequence { read32(src + ip) };
+                    const uint32_t h { hashSequence(sequence) };
+                    const int ref { table[h] };
+                    table[h] = ip;
+
+                    if (ref < 0 || ip - ref > MAX_DISTANCE || read32(src + ref) != sequence)
+                    {
+                        ++ip;
+                        continue;
+                    }
+
+                    // Extend the match forward as far as possible
+                    int matchLength { MIN_MATCH };
+                    while (ip + matchLength < matchLimit &&
+                           src[ref + matchLength] == src[ip + matchLength])
+                        ++matchLength;
+
+                    // Write the literals before the match, and the match itself
+                    if (!writeSequence(src + anchor, ip - anchor, ip - ref, matchLength, op, opEnd))
+                        return 0;
+
+                    ip += matchLength;
+                    anchor = ip;
+                }
+            }
+
+            // Write the remaining literals
+            if (!writeSequence(src + anchor, srcSize - anchor, 0, 0, op, opEnd))
+                return 0;
+
+            return (int)(op - dst);
+        }
+
+        // Decompress a block of data
+        int decompressBlock(const unsigned char* src, int srcSize,
+                            unsigned char* dst, int dstCapacity)
+        {
+            const unsigned char* ip { src };
+            const unsigned char* ipEnd { src + srcSize };
+            unsigned char* op { dst };
+            const unsigned char* opEnd { dst + dstCapacity };
+
+            while (ip < ipEnd)
+            {
+                // Read the token
+                const unsigned char token { *ip++ };
+
+                // Length of the literals
+                size_t nrLiterals { (size_t)(token >> 4) };
+                if (nrLiterals == 15)
+                {
+                    unsigned char s;
+                    do
+                    {
+                        if (ip >= ipEnd)
+                            return -1;
+                        s = *ip++;
+                        nrLiterals += s;
+                    } while (s == 255);
+                }
+
+                // Copy the literals
+                if (nrLiterals > (size_t)(ipEnd - ip) || nrLiterals > (size_t)(opEnd - op))
+                    return -1;
+                std::memcpy(op, ip, nrLiterals);
+                ip += nrLiterals;
+                op += nrLiterals;
+
+                // The last sequence ends after the literals
+                if (ip >= ipEnd)
+                    break;
+
+                // Offset of the match
+                if (ipEnd - ip < 2)
+                    return -1;
+                const size_t offset { (size_t)ip[0] | ((size_t)ip[1] << 8) };
+                ip += 2;
+                if (offset == 0 || offset > (size_t)(op - dst))
+                    return -1;
+
+                // Length of the match
+                size_t matchLength { (size_t)(token & 0x0F) };
+                if (matchLength == 15)
+                {
+                    unsigned char s;
+                    do
+                    {
+                        if (ip >= ipEnd)
+                            return -1;
+                        s = *ip++;
+                        matchLength += s;
+                    } while (s == 255);
+                }
+                matchLength += MIN_MATCH;
+                if (matchLength > (size_t)(opEnd - op))
+                    return -1;
+
+                // Copy the match. The regions can overlap, so this is done byte
+                // by byte unless the offset is large enough
+                const unsigned char* match { op - offset };
+                if (offset >= matchLength)
+                {
+                    std::memcpy(op, match, matchLength);
+                    op += matchLength;
+                }
+                else
+                {
+                    for (size_t i = 0; i < matchLength; ++i)
+                        *op++ = *match++;
+                }
+            }
+
+            return (int)(op - dst);
+        }
+    }
+}
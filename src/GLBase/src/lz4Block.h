@@ -0,0 +1,35 @@
+#ifndef LZ4BLOCK_H
+#define LZ4BLOCK_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Minimal implementation of the LZ4 block format, used to compress the
+    // entries of the asset archives.
+    // The format is the one described in
+    //      https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+    // so the blocks can also be produced or read with the reference library.
+    namespace LZ4
+    {
+        // Maximum size of the compressed data for an input of the given size
+        inline int compressBound(int inputSize)
+        {
+            return inputSize + inputSize / 255 + 16;
+        }
+
+        // Compress a block of data.
+        // Returns the size of the compressed data, or 0 if it does not fit in
+        // the destination buffer.
+        int compressBlock(const unsigned char* src, int srcSize,
+                          unsigned char* dst, int dstCapacity);
+
+        // Decompress a block of data.
+        // Returns the size of the decompressed data, or -1 if the input is
+        // malformed or the output does not fit in the destination buffer.
+        int decompressBlock(const unsigned char* src, int srcSize,
+                            unsigned char* dst, int dstCapacity);
+    }
+}
+
+#endif
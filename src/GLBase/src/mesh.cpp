@@ -44,6 +44,7 @@ namespace GLBase
 
             // Set the current texture locator to the corresponding uniform
             glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+            RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
             // Bind the texture
             glBindTexture(GL_TEXTURE_2D, textures[i].id);
         }
@@ -51,6 +52,7 @@ namespace GLBase
         // Draw the mesh
         glBindVertexArray(VAO); // This also binds the corresponding EBO
         glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        RenderStats::addDraw(GL_TRIANGLES, indices.size());
         glBindVertexArray(0);
 
         // Set everything back to defaults.
@@ -79,6 +81,8 @@ namespace GLBase
         // Add the data to the EBO
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
                      &indices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED,
+                         vertices.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int));
 
         // Set the vertex attribute pointers
         // Vertex positions
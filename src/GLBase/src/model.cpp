@@ -2,6 +2,110 @@
 
 namespace GLBase
 {
+    //====================
+    // Methods of the VFSAssimpStream class
+    //====================
+
+    // Constructor, taking the whole content of the file
+    VFSAssimpStream::VFSAssimpStream(std::vector<unsigned char>&& data) :
+        mData { std::move(data) }, mPosition { 0 }
+    {
+    }
+
+    // Read count elements of the given size
+    size_t VFSAssimpStream::Read(void* buffer, size_t size, size_t count)
+    {
+        if (size == 0)
+            return 0;
+        // Only whole elements are read
+        const size_t nrElements { std::min(count, (mData.size() - mPosition) / size) };
+        std::memcpy(buffer, mData.data() + mPosition, nrElements * size);
+        mPosition += nrElements * size;
+        return nrElements;
+    }
+
+    // The streams are read only
+    size_t VFSAssimpStream::Write(const void*, size_t, size_t)
+    {
+        return 0;
+    }
+
+    // Move the current position
+    aiReturn VFSAssimpStream::Seek(size_t offset, aiOrigin origin)
+    {
+        size_t newPosition;
+        switch (origin)
+        {
+            case aiOrigin_SET:
+                newPosition = offset;
+                break;
+            case aiOrigin_CUR:
+                newPosition = mPosition + offset;
+                break;
+            case aiOrigin_END:
+                newPosition = mData.size() - offset;
+                break;
+            default:
+                return aiReturn_FAILURE;
+        }
+        if (newPosition > mData.size())
+            return aiReturn_FAILURE;
+        mPosition = newPosition;
+        return aiReturn_SUCCESS;
+    }
+
+    // Get the current position
+    size_t VFSAssimpStream::Tell() const
+    {
+        return mPosition;
+    }
+
+    // Get the size of the file
+    size_t VFSAssimpStream::FileSize() const
+    {
+        return mData.size();
+    }
+
+    // Nothing to flush in a read only stream
+    void VFSAssimpStream::Flush()
+    {
+    }
+
+    //====================
+    // Methods of the VFSAssimpIOSystem class
+    //====================
+
+    // Check if a file exists in the archives or in the disk
+    bool VFSAssimpIOSystem::Exists(const char* path) const
+    {
+        return VirtualFileSystem::exists(path);
+    }
+
+    // Separator of the paths
+    char VFSAssimpIOSystem::getOsSeparator() const
+    {
+        return '/';
+    }
+
+    // Open a file, reading it completely through the virtual file system
+    Assimp::IOStream* VFSAssimpIOSystem::Open(const char* path, const char* mode)
+    {
+        // Writing is not supported
+        if (std::strchr(mode, 'w') != nullptr || std::strchr(mode, 'a') != nullptr)
+            return nullptr;
+
+        std::vector<unsigned char> data;
+        if (!VirtualFileSystem::readFile(path, data))
+            return nullptr;
+        return new VFSAssimpStream(std::move(data));
+    }
+
+    // Close a file opened with Open
+    void VFSAssimpIOSystem::Close(Assimp::IOStream* stream)
+    {
+        delete stream;
+    }
+
     //====================
     // Methods of the Model class
     //====================
@@ -9,6 +113,7 @@ namespace GLBase
     // Constructor
     Model::Model(const std::string& path, bool gamma) : gammaCorrection { gamma }
     {
+        GLBASE_PROFILE_ZONE("Model loading");
         std::cout << "Loading model...\n";
         // Load the model from the path given
         loadModel(path);
@@ -26,8 +131,23 @@ namespace GLBase
     // Function to load a model using Assimp's functions
     void Model::loadModel(std::string path)
     {
+        // Retrieve the directory path of the given file path
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // Models cooked by the assetcook tool are loaded directly, without Assimp
+        std::vector<unsigned char> fileData;
+        if (VirtualFileSystem::readFile(path, fileData) && isCookedModel(fileData))
+        {
+            loadCookedModel(fileData);
+            return;
+        }
+        fileData.clear();
+
         // Declare an importer from Assimp
         Assimp::Importer importer;
+        // Read the model and the files it references through the virtual file
+        // system. The importer takes ownership of the IO system
+        importer.SetIOHandler(new VFSAssimpIOSystem());
         // Read the model from a path with several directives, some of which are:
         //      aiProcess_Triangulate: convert the entire mesh to triangles if they are not
         //      aiProcess_FlipUVs: flip the texture coordinates on the y axis
@@ -42,8 +162,6 @@ namespace GLBase
             std::cout << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
             return;
         }
-        // Retrieve the directory path of the given file path
-        directory = path.substr(0, path.find_last_of('/'));
 
         // Pass the first node to the recursive processNode function
         processNode(scene->mRootNode, scene);
@@ -78,6 +196,48 @@ namespace GLBase
         std::vector<unsigned int> indices;
         std::vector<Texture> textures;
 
+        // Process the vertices and the indices
+        convertMesh(mesh, vertices, indices);
+
+        // Process the material
+        // A mesh can contain an index to a material object from the scene
+        if (mesh->mMaterialIndex >= 0)
+        {
+            // Retrieve the material object from the scene
+            aiMaterial* material { scene->mMaterials[mesh->mMaterialIndex] };
+
+            // Load the diffuse textures
+            std::vector<Texture> diffuseMaps { loadMaterialTextures(material, aiTextureType_DIFFUSE,
+                                                               "texture_diffuse") };
+            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+            // Load the specular textures
+            std::vector<Texture> specularMaps { loadMaterialTextures(material, aiTextureType_SPECULAR,
+                                                               "texture_specular") };
+            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+            // Load the normal map textures
+            std::vector<Texture> normalMaps { loadMaterialTextures(material, aiTextureType_HEIGHT,
+                                                               "texture_normal") };
+            textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+            // Load the height map textures
+            std::vector<Texture> heightMaps { loadMaterialTextures(material, aiTextureType_AMBIENT,
+                                                               "texture_height") };
+            textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        }
+
+        // Return the created mesh object
+        return Mesh(vertices, indices, textures);
+    }
+
+    // Method to convert the vertices and the faces of an aiMesh to the vertices
+    // and indices of a mesh
+    // The faces are read in place, since copying an aiFace copies its indices
+    void Model::convertMesh(const aiMesh* mesh, std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+    {
+        vertices.clear();
+        indices.clear();
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(3 * mesh->mNumFaces);
+
         // Process the vertices
         for (int i = 0; i < mesh->mNumVertices; ++i)
         {
@@ -119,7 +279,7 @@ namespace GLBase
         // reading the mesh, these will be triangles)
         for (int i = 0; i < mesh->mNumFaces; ++i)
         {
-            aiFace face { mesh->mFaces[i] };
+            const aiFace& face { mesh->mFaces[i] };
             // Read all the vertices in the face, and store them
             for (int j = 0; j < face.mNumIndices; ++j)
             {
@@ -127,34 +287,6 @@ namespace GLBase
                 indices.push_back(face.mIndices[j]);
             }
         }
-
-        // Process the material
-        // A mesh can contain an index to a material object from the scene
-        if (mesh->mMaterialIndex >= 0)
-        {
-            // Retrieve the material object from the scene
-            aiMaterial* material { scene->mMaterials[mesh->mMaterialIndex] };
-
-            // Load the diffuse textures
-            std::vector<Texture> diffuseMaps { loadMaterialTextures(material, aiTextureType_DIFFUSE,
-                                                               "texture_diffuse") };
-            textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-            // Load the specular textures
-            std::vector<Texture> specularMaps { loadMaterialTextures(material, aiTextureType_SPECULAR,
-                                                               "texture_specular") };
-            textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-            // Load the normal map textures
-            std::vector<Texture> normalMaps { loadMaterialTextures(material, aiTextureType_HEIGHT,
-                                                               "texture_normal") };
-            textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-            // Load the height map textures
-            std::vector<Texture> heightMaps { loadMaterialTextures(material, aiTextureType_AMBIENT,
-                                                               "texture_height") };
-            textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-        }
-
-        // Return the created mesh object
-        return Mesh(vertices, indices, textures);
     }
 
     // Load all the textures of a determined type in the given material
@@ -169,32 +301,54 @@ namespace GLBase
             aiString str;
             // Get the path of the current texture
             material->GetTexture(type, i, &str);
-            // Check if the texture was loaded before
-            bool skip { false };
-            for (int j = 0; j < texturesLoaded.size(); ++j)
-            {
-                // Check if the current texture is already in the vector of textures loaded
-                if (std::strcmp(texturesLoaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    // Add the loaded texture to the vector of textures
-                    textures.push_back(texturesLoaded[j]);
-                    skip = true;
-                    break;
-                }
-            }
-            if (!skip)
+            // Get the texture, loading it if needed
+            textures.push_back(getTexture(str.C_Str(), typeName));
+        }
+        return textures;
+    }
+
+    // Method to create the meshes of a model cooked by the assetcook tool
+    void Model::loadCookedModel(const std::vector<unsigned char>& data)
+    {
+        std::vector<CookedMesh> cookedMeshes;
+        if (!readCookedModel(data, cookedMeshes))
+            return;
+
+        for (const CookedMesh& cookedMesh : cookedMeshes)
+        {
+            // Get the textures of the mesh, loading them if needed
+            std::vector<Texture> textures;
+            for (const CookedTextureReference& reference : cookedMesh.textures)
+                textures.push_back(getTexture(reference.path.c_str(), reference.type));
+
+            meshes.push_back(Mesh(cookedMesh.vertices, cookedMesh.indices, textures));
+        }
+    }
+
+    // Method to get a texture of the model, loading it only the first time
+    Texture Model::getTexture(const char* path, const std::string& typeName)
+    {
+        // Check if the texture was loaded before
+        for (int j = 0; j < texturesLoaded.size(); ++j)
+        {
+            // Check if the current texture is already in the vector of textures loaded
+            if (std::strcmp(texturesLoaded[j].path.data(), path) == 0)
             {
-                // If the texture has not been loaded yet, load it now
-                Texture texture;
-                texture.id = loadTextureFromDirectory(str.C_Str(), this->directory);
+                // Use the loaded texture, with the type requested
+                Texture texture { texturesLoaded[j] };
                 texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                // Store it also in the vector of loaded textures
-                texturesLoaded.push_back(texture);
+                return texture;
             }
         }
-        return textures;
+
+        // If the texture has not been loaded yet, load it now
+        Texture texture;
+        texture.id = loadTextureFromDirectory(path, this->directory);
+        texture.type = typeName;
+        texture.path = path;
+        // Store it also in the vector of loaded textures
+        texturesLoaded.push_back(texture);
+        return texture;
     }
 
     // Function to load a texture with a path inside a directory
@@ -221,8 +375,19 @@ namespace GLBase
         // an image is at the upper left, while for OpenGL it is at the lower left. 
         // Fix this
         stbi_set_flip_vertically_on_load(true);
-        // Load the first texture
-        unsigned char* data { stbi_load(path, &width, &height, &nrChannels, 0) };
+        // Read the file through the virtual file system, and decode it
+        // Textures cooked by the assetcook tool are already decoded
+        std::vector<unsigned char> fileData;
+        std::vector<unsigned char> cookedPixels;
+        unsigned char* data { nullptr };
+        if (VirtualFileSystem::readFile(path, fileData))
+        {
+            if (readCookedTexture(fileData, true, 0, cookedPixels, width, height, nrChannels))
+                data = cookedPixels.data();
+            else
+                data = stbi_load_from_memory(fileData.data(), (int)fileData.size(), &width, &height,
+                                             &nrChannels, 0);
+        }
         // Check if the data was loaded successfully
         if (data)
         {
@@ -261,6 +426,7 @@ namespace GLBase
             // The 8th argument specifies the datatype of the source. In this case
             // unsigned chars, which are bytes.
             glTexImage2D(GL_TEXTURE_2D, 0, colorFormatIn, width, height, 0, colorFormatOut, GL_UNSIGNED_BYTE, data);
+            RenderStats::add(RENDER_STAT_BYTES_UPLOADED, (std::uint64_t)width * height * nrChannels);
             glGenerateMipmap(GL_TEXTURE_2D);
 
             if (hasAlpha)
@@ -281,7 +447,8 @@ namespace GLBase
         {
             std::cout << "Failed to load the texture.\n";
         }
-        stbi_image_free(data);
+        if (data != cookedPixels.data())
+            stbi_image_free(data);
          
         // Reture the ID of the generated texture
         return textureID;
@@ -302,17 +469,35 @@ namespace GLBase
         //  right - left - top - bottom - back - front
         int width, height, nrChannels;
         unsigned char* data;
+        std::vector<unsigned char> fileData;
+        std::vector<unsigned char> cookedPixels;
         // The textures should not be flipped, since cubemap images are expected to 
         // start at the top left, instead of the bottom left.
         stbi_set_flip_vertically_on_load(false);
         // Iterate over the faces
         for (int i = 0; i < faces.size(); ++i)
         {
-            // Load the data in each face
-            data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+            // Load the data in each face, through the virtual file system
+            data = nullptr;
+            if (VirtualFileSystem::readFile(faces[i], fileData))
+            {
+                if (readCookedTexture(fileData, false, 3, cookedPixels, width, height, nrChannels))
+                    data = cookedPixels.data();
+                else
+                    data = stbi_load_from_memory(fileData.data(), (int)fileData.size(), &width, &height,
+                                                 &nrChannels, 3);
+            }
+            if (data == nullptr)
+            {
+                std::cout << "Failed to load the cubemap face " << faces[i] << ".\n";
+                continue;
+            }
             // Generate the texture from the loaded data, in the corresponding face
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height,
                          0, GL_RGB, GL_UNSIGNED_BYTE, data);
+            RenderStats::add(RENDER_STAT_BYTES_UPLOADED, (std::uint64_t)width * height * 3);
+            if (data != cookedPixels.data())
+                stbi_image_free(data);
         }
         // Specify the wrapping and filtering methods for the cubemap texture.
         // The R dimension corresponds to the tird dimension, z.
@@ -9,9 +9,44 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/IOSystem.hpp>
+#include <assimp/IOStream.hpp>
 
 namespace GLBase
 {
+    // Stream of a file read through the virtual file system, used by Assimp
+    class VFSAssimpStream : public Assimp::IOStream
+    {
+        public:
+            // Constructor, taking the whole content of the file
+            VFSAssimpStream(std::vector<unsigned char>&& data);
+
+            // Methods of the Assimp::IOStream interface
+            size_t Read(void* buffer, size_t size, size_t count);
+            size_t Write(const void* buffer, size_t size, size_t count);
+            aiReturn Seek(size_t offset, aiOrigin origin);
+            size_t Tell() const;
+            size_t FileSize() const;
+            void Flush();
+
+        private:
+            // Content of the file and current position in it
+            std::vector<unsigned char> mData;
+            size_t mPosition;
+    };
+
+    // File system used by Assimp to open a model and the files it references
+    // (materials, buffers...) through the virtual file system
+    class VFSAssimpIOSystem : public Assimp::IOSystem
+    {
+        public:
+            // Methods of the Assimp::IOSystem interface
+            bool Exists(const char* path) const;
+            char getOsSeparator() const;
+            Assimp::IOStream* Open(const char* path, const char* mode = "rb");
+            void Close(Assimp::IOStream* stream);
+    };
+
     class Model
     {
         public:
@@ -28,6 +63,11 @@ namespace GLBase
             // Draw function
             void draw(Shader& shader);
 
+            // Method to convert the vertices and the faces of an aiMesh to the
+            // vertices and indices of a mesh, without creating its buffers
+            static void convertMesh(const aiMesh* mesh, std::vector<Vertex>& vertices,
+                                    std::vector<unsigned int>& indices);
+
         private:
 
             // Functions to process Assimp's import routine
@@ -39,6 +79,11 @@ namespace GLBase
             Mesh processMesh(aiMesh* mesh, const aiScene* scene);
             std::vector<Texture> loadMaterialTextures(aiMaterial* material, aiTextureType type,
                                                       std::string typeName);
+
+            // Method to create the meshes of a model cooked by the assetcook tool
+            void loadCookedModel(const std::vector<unsigned char>& data);
+            // Method to get a texture of the model, loading it only the first time
+            Texture getTexture(const char* path, const std::string& typeName);
     };
 
     // Function to load a texture with a path inside a directory
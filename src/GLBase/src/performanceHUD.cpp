@@ -0,0 +1,583 @@
+#include "performanceHUD.h"
+
+// Header needed to get the size of the pages of memory
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace GLBase
+{
+    // Glyphs of the font for the characters from ' ' to '~', with 5x7 pixels.
+    // Each byte is a row from the top, and the bit 4 is the leftmost pixel
+    static const unsigned char FONT_GLYPHS[95][7] {
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+        { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // '!'
+        { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 }, // '"'
+        { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A }, // '#'
+        { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 }, // '$'
+        { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 }, // '%'
+        { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D }, // '&'
+        { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 }, // '\''
+        { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // '('
+        { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // ')'
+        { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 }, // '*'
+        { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // '+'
+        { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, // ','
+        { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // '-'
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // '.'
+        { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // '/'
+        { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // '0'
+        { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // '1'
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // '2'
+        { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // '3'
+        { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // '4'
+        { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // '5'
+        { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // '6'
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // '7'
+        { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // '8'
+        { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // '9'
+        { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // ':'
+        { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 }, // ';'
+        { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 }, // '<'
+        { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 }, // '='
+        { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 }, // '>'
+        { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // '?'
+        { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E }, // '@'
+        { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // 'A'
+        { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // 'B'
+        { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // 'C'
+        { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // 'D'
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // 'E'
+        { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // 'F'
+        { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // 'G'
+        { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // 'H'
+        { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 'I'
+        { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // 'J'
+        { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // 'K'
+        { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // 'L'
+        { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // 'M'
+        { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // 'N'
+        { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // 'O'
+        { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // 'P'
+        { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // 'Q'
+        { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // 'R'
+        { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // 'S'
+        { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // 'T'
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // 'U'
+        { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // 'V'
+        { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // 'W'
+        { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // 'X'
+        { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // 'Y'
+        { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }, // 'Z'
+        { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E }, // '['
+        { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 }, // '\\'
+        { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E }, // ']'
+        { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 }, // '^'
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F }, // '_'
+        { 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 }, // '`'
+        { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F }, // 'a'
+        { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E }, // 'b'
+        { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E }, // 'c'
+        { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F }, // 'd'
+        { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E }, // 'e'
+        { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 }, // 'f'
+        { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E }, // 'g'
+        { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 }, // 'h'
+        { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E }, // 'i'
+        { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C }, // 'j'
+        { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 }, // 'k'
+        { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 'l'
+        { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 }, // 'm'
+        { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 }, // 'n'
+        { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E }, // 'o'
+        { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 }, // 'p'
+        { 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 }, // 'q'
+        { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 }, // 'r'
+        { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E }, // 's'
+        { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 }, // 't'
+        { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D }, // 'u'
+        { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // 'v'
+        { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A }, // 'w'
+        { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 }, // 'x'
+        { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E }, // 'y'
+        { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F }, // 'z'
+        { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 }, // '{'
+        { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // '|'
+        { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 }, // '}'
+        { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 }, // '~'
+    };
+
+    // Size of the glyphs, and of their cells in the atlas. The atlas has 16x6
+    // cells, and the last one is solid, for the quads without text
+    static const int GLYPH_WIDTH { 5 };
+    static const int GLYPH_HEIGHT { 7 };
+    static const int ATLAS_CELL { 8 };
+    static const int ATLAS_COLUMNS { 16 };
+    static const int ATLAS_ROWS { 6 };
+    static const int SOLID_CELL { ATLAS_COLUMNS * ATLAS_ROWS - 1 };
+    // Distance between glyphs and lines, in pixels of the font
+    static const int GLYPH_ADVANCE { 6 };
+    static const int LINE_HEIGHT { 10 };
+
+    // Layout of the HUD: distance from the corner of the screen in pixels, and
+    // sizes in pixels of the font
+    static const float PANEL_MARGIN { 8.f };
+    static const float PANEL_PADDING { 4.f };
+    // Number of lines of text above the graphs
+    static const int NR_STAT_LINES { 7 };
+    static const float GRAPH_HEIGHT { 32.f };
+    static const float GRAPH_GAP { 8.f };
+    static const float PASS_NAME_LENGTH { 16.f };
+    static const float PASS_BAR_WIDTH { 80.f };
+
+    // Budget of the cost of the HUD, in milliseconds
+    static const double HUD_BUDGET_MS { 0.1 };
+    // Weight of each frame in the averages of the cost
+    static const double COST_AVERAGE_WEIGHT { 0.05 };
+
+    // Frame times of the references in the graphs, for 60 and 30 FPS
+    static const float FRAME_TIME_60 { 1000.f / 60.f };
+    static const float FRAME_TIME_30 { 1000.f / 30.f };
+
+    // Constants of the extensions with the memory of the GPU, in KB
+    static const GLenum GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX { 0x9048 };
+    static const GLenum GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX { 0x9049 };
+    static const GLenum TEXTURE_FREE_MEMORY_ATI { 0x87FC };
+
+    // Colors of the HUD
+    static const glm::vec4 PANEL_COLOR { 0.f, 0.f, 0.f, 0.6f };
+    static const glm::vec4 GRAPH_BACKGROUND_COLOR { 0.15f, 0.15f, 0.15f, 0.8f };
+    static const glm::vec4 TEXT_COLOR { 1.f, 1.f, 1.f, 1.f };
+    static const glm::vec4 LABEL_COLOR { 0.6f, 0.8f, 1.f, 1.f };
+    static const glm::vec4 GOOD_COLOR { 0.3f, 0.9f, 0.3f, 1.f };
+    static const glm::vec4 WARNING_COLOR { 1.f, 0.8f, 0.2f, 1.f };
+    static const glm::vec4 BAD_COLOR { 1.f, 0.3f, 0.3f, 1.f };
+    static const glm::vec4 REFERENCE_COLOR { 1.f, 1.f, 1.f, 0.35f };
+    static const glm::vec4 BAR_COLOR { 0.4f, 0.6f, 1.f, 1.f };
+
+    // Color of a frame time, green at 60 FPS, yellow at 30 and red below
+    static const glm::vec4& getFrameTimeColor(float timeMs)
+    {
+        if (timeMs <= FRAME_TIME_60 * 1.05f)
+            return GOOD_COLOR;
+        if (timeMs <= FRAME_TIME_30 * 1.05f)
+            return WARNING_COLOR;
+        return BAD_COLOR;
+    }
+
+    // Memory used by the process in MB, or -1 if it is not known
+    static double getProcessMemory()
+    {
+#ifdef __linux__
+        // The second field is the number of pages resident in memory
+        std::ifstream statm("/proc/self/statm");
+        long pages { 0 };
+        long residentPages { 0 };
+        if (statm >> pages >> residentPages)
+            return (double)residentPages * sysconf(_SC_PAGESIZE) / (1024. * 1024.);
+#endif
+        return -1.;
+    }
+
+    // Constructor
+    PerformanceHUD::PerformanceHUD(unsigned int scale) :
+        mEnabled { true }, mScale { std::max(1u, scale) },
+        mShader(EMBEDDED_SHADER, "GLBase/hudVertex.glsl", "GLBase/hudFragment.glsl"),
+        mVAO { 0 }, mVBO { 0 }, mAtlas { 0 }, mBufferCapacity { 0 }, mGPUProfiler { nullptr },
+        mPanelSize { 0.f, 0.f }, mFrameTimes {}, mGPUFrameTimes {}, mNrFrames { 0 },
+        mTimerQueries { 0 }, mNrQueriesStarted { 0 }, mNrQueriesRead { 0 },
+        mCPUTime { 0. }, mGPUTime { -1. }, mNVXMemoryInfo { false }, mATIMemInfo { false }
+    {
+        createAtlas();
+
+        // Vertex array with the attributes of the instances
+        glGenVertexArrays(1, &mVAO);
+        glGenBuffers(1, &mVBO);
+        glBindVertexArray(mVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              (void*)offsetof(Instance, rect));
+        glVertexAttribDivisor(0, 1);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+                              (void*)offsetof(Instance, texRect));
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Instance),
+                              (void*)offsetof(Instance, color));
+        glVertexAttribDivisor(2, 1);
+        glBindVertexArray(0);
+
+        glGenQueries(NR_TIMER_QUERIES, mTimerQueries);
+
+        // Look for the extensions with the memory of the GPU
+        GLint nrExtensions { 0 };
+        glGetIntegerv(GL_NUM_EXTENSIONS, &nrExtensions);
+        for (GLint i = 0; i < nrExtensions; ++i)
+        {
+            const char* extension { (const char*)glGetStringi(GL_EXTENSIONS, i) };
+            if (std::strcmp(extension, "GL_NVX_gpu_memory_info") == 0)
+                mNVXMemoryInfo = true;
+            else if (std::strcmp(extension, "GL_ATI_meminfo") == 0)
+                mATIMemInfo = true;
+        }
+
+        mShader.use();
+        mShader.setInt("fontAtlas", 0);
+    }
+
+    // Destructor
+    PerformanceHUD::~PerformanceHUD()
+    {
+        glDeleteQueries(NR_TIMER_QUERIES, mTimerQueries);
+        glDeleteBuffers(1, &mVBO);
+        glDeleteVertexArrays(1, &mVAO);
+        glDeleteTextures(1, &mAtlas);
+    }
+
+    // Method to bake the font in the atlas
+    // The texture has the coverage of each texel, 0 or 255
+    void PerformanceHUD::createAtlas()
+    {
+        const int width { ATLAS_COLUMNS * ATLAS_CELL };
+        const int height { ATLAS_ROWS * ATLAS_CELL };
+        std::vector<unsigned char> texels(width * height, 0);
+        for (int glyph = 0; glyph < 95; ++glyph)
+        {
+            const int x0 { (glyph % ATLAS_COLUMNS) * ATLAS_CELL };
+            const int y0 { (glyph / ATLAS_COLUMNS) * ATLAS_CELL };
+            for (int y = 0; y < GLYPH_HEIGHT; ++y)
+            {
+                for (int x = 0; x < GLYPH_WIDTH; ++x)
+                {
+                    if (FONT_GLYPHS[glyph][y] & (1 << (GLYPH_WIDTH - 1 - x)))
+                        texels[(y0 + y) * width + x0 + x] = 255;
+                }
+            }
+        }
+        // Solid cell
+        const int x0 { (SOLID_CELL % ATLAS_COLUMNS) * ATLAS_CELL };
+        const int y0 { (SOLID_CELL / ATLAS_COLUMNS) * ATLAS_CELL };
+        for (int y = 0; y < ATLAS_CELL; ++y)
+            std::fill_n(&texels[(y0 + y) * width + x0], ATLAS_CELL, 255);
+
+        glGenTextures(1, &mAtlas);
+        glBindTexture(GL_TEXTURE_2D, mAtlas);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, &texels[0]);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, texels.size());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // Method to add a solid quad
+    void PerformanceHUD::addRect(std::vector<Instance>& instances, float x, float y, float width,
+                                 float height, const glm::vec4& color)
+    {
+        // Sample the center of the solid cell
+        const float u { ((SOLID_CELL % ATLAS_COLUMNS) + 0.5f) / ATLAS_COLUMNS };
+        const float v { ((SOLID_CELL / ATLAS_COLUMNS) + 0.5f) / ATLAS_ROWS };
+        instances.push_back({ { x, y, width, height }, { u, v, u, v },
+                              { (unsigned char)(color.r * 255.f), (unsigned char)(color.g * 255.f),
+                                (unsigned char)(color.b * 255.f), (unsigned char)(color.a * 255.f) } });
+    }
+
+    // Method to add the quads of a text
+    void PerformanceHUD::addText(std::vector<Instance>& instances, glm::vec2& position, const char* text,
+                                 const glm::vec4& color)
+    {
+        const float scale { (float)mScale };
+        const unsigned char r { (unsigned char)(color.r * 255.f) };
+        const unsigned char g { (unsigned char)(color.g * 255.f) };
+        const unsigned char b { (unsigned char)(color.b * 255.f) };
+        const unsigned char a { (unsigned char)(color.a * 255.f) };
+        for (const char* c = text; *c; ++c)
+        {
+            // The spaces have no quad, and the characters out of the font are
+            // shown as '?'
+            if (*c != ' ')
+            {
+                const int glyph { (*c > ' ' && *c <= '~') ? *c - ' ' : '?' - ' ' };
+                const float u { (float)((glyph % ATLAS_COLUMNS) * ATLAS_CELL) / (ATLAS_COLUMNS * ATLAS_CELL) };
+                const float v { (float)((glyph / ATLAS_COLUMNS) * ATLAS_CELL) / (ATLAS_ROWS * ATLAS_CELL) };
+                instances.push_back({ { position.x, position.y, GLYPH_WIDTH * scale, GLYPH_HEIGHT * scale },
+                                      { u, v, u + (float)GLYPH_WIDTH / (ATLAS_COLUMNS * ATLAS_CELL),
+                                        v + (float)GLYPH_HEIGHT / (ATLAS_ROWS * ATLAS_CELL) },
+                                      { r, g, b, a } });
+            }
+            position.x += GLYPH_ADVANCE * scale;
+        }
+    }
+
+    // Method to build the quads of the text and the bars
+    // The lines of statistics are followed by the space of the graphs, and by
+    // the bars of the passes
+    void PerformanceHUD::buildText()
+    {
+        mTextInstances.clear();
+        const float scale { (float)mScale };
+        const float left { PANEL_MARGIN + PANEL_PADDING * scale };
+        float maxX { 0.f };
+        glm::vec2 position { left, PANEL_MARGIN + PANEL_PADDING * scale };
+        char line[128];
+        auto newLine = [&]()
+        {
+            maxX = std::max(maxX, position.x);
+            position = { left, position.y + LINE_HEIGHT * scale };
+        };
+
+        // Average frame time of the last frames
+        const unsigned int nrFrames { mNrFrames < TEXT_PERIOD ? mNrFrames : TEXT_PERIOD };
+        float frameTime { 0.f };
+        for (unsigned int i = 0; i < nrFrames; ++i)
+            frameTime += mFrameTimes[(mNrFrames - 1 - i) % NR_GRAPH_FRAMES];
+        frameTime /= std::max(1u, nrFrames);
+        std::snprintf(line, sizeof(line), "Frame %6.2f ms  %6.1f FPS", frameTime,
+                      frameTime > 0.f ? 1000.f / frameTime : 0.f);
+        addText(mTextInstances, position, line, getFrameTimeColor(frameTime));
+        newLine();
+
+        std::snprintf(line, sizeof(line), "p50 %.2f  p95 %.2f  p99 %.2f ms",
+                      RenderStats::getFrameTimePercentile(50.), RenderStats::getFrameTimePercentile(95.),
+                      RenderStats::getFrameTimePercentile(99.));
+        addText(mTextInstances, position, line, TEXT_COLOR);
+        newLine();
+
+        if (mGPUProfiler && mGPUProfiler->hasResults())
+        {
+            const GPUProfileFrame& frame { mGPUProfiler->getLastFrame() };
+            std::snprintf(line, sizeof(line), "GPU   %6.2f ms  CPU %6.2f ms", frame.gpuEndMs - frame.gpuStartMs,
+                          frame.cpuEndMs - frame.cpuStartMs);
+            addText(mTextInstances, position, line, TEXT_COLOR);
+        }
+        newLine();
+
+        // Render statistics of the last frame
+        std::snprintf(line, sizeof(line), "Draws %u  Tris %u  Programs %u",
+                      (unsigned int)RenderStats::get(RENDER_STAT_DRAW_CALLS),
+                      (unsigned int)RenderStats::get(RENDER_STAT_TRIANGLES),
+                      (unsigned int)RenderStats::get(RENDER_STAT_STATE_CHANGES));
+        addText(mTextInstances, position, line, TEXT_COLOR);
+        newLine();
+        std::snprintf(line, sizeof(line), "Uniforms %u  Upload %.1f KB  Shadows %u",
+                      (unsigned int)RenderStats::get(RENDER_STAT_UNIFORM_UPLOADS),
+                      RenderStats::get(RENDER_STAT_BYTES_UPLOADED) / 1024.,
+                      (unsigned int)RenderStats::get(RENDER_STAT_SHADOW_MAP_RENDERS));
+        addText(mTextInstances, position, line, TEXT_COLOR);
+        newLine();
+
+        // Memory of the process, and of the GPU if the driver gives it
+        int length { std::snprintf(line, sizeof(line), "Memory %.1f MB", getProcessMemory()) };
+        if (mNVXMemoryInfo)
+        {
+            GLint total { 0 };
+            GLint available { 0 };
+            glGetIntegerv(GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+            glGetIntegerv(GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+            std::snprintf(line + length, sizeof(line) - length, "  GPU %d / %d MB",
+                          (total - available) / 1024, total / 1024);
+        }
+        else if (mATIMemInfo)
+        {
+            GLint free[4] { 0, 0, 0, 0 };
+            glGetIntegerv(TEXTURE_FREE_MEMORY_ATI, free);
+            std::snprintf(line + length, sizeof(line) - length, "  GPU free %d MB", free[0] / 1024);
+        }
+        addText(mTextInstances, position, line, TEXT_COLOR);
+        newLine();
+
+        // Cost of the HUD
+        std::snprintf(line, sizeof(line), "HUD %.3f ms CPU", mCPUTime);
+        addText(mTextInstances, position, line, mCPUTime > HUD_BUDGET_MS ? BAD_COLOR : LABEL_COLOR);
+        if (mGPUTime >= 0.)
+        {
+            std::snprintf(line, sizeof(line), "  %.3f ms GPU", mGPUTime);
+            addText(mTextInstances, position, line, mGPUTime > HUD_BUDGET_MS ? BAD_COLOR : LABEL_COLOR);
+        }
+        newLine();
+
+        // Leave the space of the graphs, with their labels
+        position.y += (LINE_HEIGHT + GRAPH_HEIGHT + GRAPH_GAP) * scale;
+        const float graphsWidth { (mGPUProfiler ? 2.f : 1.f) * NR_GRAPH_FRAMES * scale + GRAPH_GAP * scale };
+        maxX = std::max(maxX, left + graphsWidth);
+
+        // Bars of the passes and their scopes, with their GPU time relative to
+        // the one of the frame
+        if (mGPUProfiler && mGPUProfiler->hasResults())
+        {
+            const GPUProfileFrame& frame { mGPUProfiler->getLastFrame() };
+            const double frameTime { std::max(1e-3, frame.gpuEndMs - frame.gpuStartMs) };
+            for (const auto& scope : frame.scopes)
+            {
+                if (scope.depth > 1)
+                    continue;
+                const double time { scope.gpuEndMs - scope.gpuStartMs };
+                std::snprintf(line, sizeof(line), "%*s%.*s", 2 * scope.depth, "",
+                              (int)PASS_NAME_LENGTH - 2 * scope.depth, scope.name.c_str());
+                glm::vec2 namePosition { position };
+                addText(mTextInstances, namePosition, line, scope.depth == 0 ? TEXT_COLOR : LABEL_COLOR);
+
+                const float barX { left + (PASS_NAME_LENGTH + 1.f) * GLYPH_ADVANCE * scale };
+                const float barWidth { std::max(1.f, (float)(time / frameTime) * PASS_BAR_WIDTH * scale) };
+                addRect(mTextInstances, barX, position.y, barWidth, GLYPH_HEIGHT * scale,
+                        scope.depth == 0 ? BAR_COLOR : LABEL_COLOR);
+
+                std::snprintf(line, sizeof(line), "%.3f ms", time);
+                position.x = barX + (PASS_BAR_WIDTH + 4.f) * scale;
+                addText(mTextInstances, position, line, TEXT_COLOR);
+                newLine();
+            }
+        }
+
+        mPanelSize = { maxX - PANEL_MARGIN + PANEL_PADDING * scale,
+                       position.y - PANEL_MARGIN + (PANEL_PADDING - LINE_HEIGHT + GLYPH_HEIGHT) * scale };
+    }
+
+    // Method to add the quads of a graph of the frame times of a ring
+    // The scale goes up to 33 ms, or to the multiple of 16.7 ms above the
+    // longest frame, with lines at the times of 60 and 30 FPS
+    void PerformanceHUD::addGraph(const float* times, float x, float y, const char* label)
+    {
+        const float scale { (float)mScale };
+        const float height { GRAPH_HEIGHT * scale };
+
+        float maxTime { 0.f };
+        for (unsigned int i = 0; i < NR_GRAPH_FRAMES; ++i)
+            maxTime = std::max(maxTime, times[i]);
+        const float nrReferences { std::max(2.f, std::ceil(maxTime / FRAME_TIME_60)) };
+        const float graphMax { nrReferences * FRAME_TIME_60 };
+
+        char line[64];
+        std::snprintf(line, sizeof(line), "%s (max %.0f ms)", label, graphMax);
+        glm::vec2 position { x, y };
+        addText(mInstances, position, line, LABEL_COLOR);
+        y += LINE_HEIGHT * scale;
+
+        addRect(mInstances, x, y, NR_GRAPH_FRAMES * scale, height, GRAPH_BACKGROUND_COLOR);
+        // Columns from the oldest frame to the newest
+        for (unsigned int i = 0; i < NR_GRAPH_FRAMES; ++i)
+        {
+            const float time { times[(mNrFrames + i) % NR_GRAPH_FRAMES] };
+            if (time <= 0.f)
+                continue;
+            const float columnHeight { std::min(1.f, time / graphMax) * height };
+            addRect(mInstances, x + i * scale, y + height - columnHeight, scale, columnHeight,
+                    getFrameTimeColor(time));
+        }
+        // Lines of the references
+        addRect(mInstances, x, y + height * (1.f - FRAME_TIME_60 / graphMax), NR_GRAPH_FRAMES * scale, 1.f,
+                REFERENCE_COLOR);
+        addRect(mInstances, x, y + height * (1.f - FRAME_TIME_30 / graphMax), NR_GRAPH_FRAMES * scale, 1.f,
+                REFERENCE_COLOR);
+    }
+
+    // Method to read the results of the timer queries that are available
+    void PerformanceHUD::collectQueries()
+    {
+        while (mNrQueriesRead < mNrQueriesStarted)
+        {
+            const unsigned int query { mTimerQueries[mNrQueriesRead % NR_TIMER_QUERIES] };
+            GLint available { 0 };
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                break;
+            GLuint64 elapsed { 0 };
+            glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+            const double time { elapsed * 1e-6 };
+            mGPUTime = mGPUTime < 0. ? time : mGPUTime + COST_AVERAGE_WEIGHT * (time - mGPUTime);
+            ++mNrQueriesRead;
+        }
+    }
+
+    // Method to draw the HUD to the default framebuffer
+    void PerformanceHUD::draw(int width, int height)
+    {
+        const auto start { std::chrono::steady_clock::now() };
+
+        // Keep the time of the frame, since the previous call
+        if (mLastDraw != std::chrono::steady_clock::time_point())
+        {
+            const unsigned int index { mNrFrames % NR_GRAPH_FRAMES };
+            mFrameTimes[index] = std::chrono::duration<float, std::milli>(start - mLastDraw).count();
+            mGPUFrameTimes[index] = 0.f;
+            if (mGPUProfiler && mGPUProfiler->hasResults())
+            {
+                const GPUProfileFrame& frame { mGPUProfiler->getLastFrame() };
+                mGPUFrameTimes[index] = (float)(frame.gpuEndMs - frame.gpuStartMs);
+            }
+            ++mNrFrames;
+        }
+        mLastDraw = start;
+
+        if (!mEnabled)
+            return;
+
+        collectQueries();
+
+        // Build the quads: the panel, the text and the bars, and the graphs
+        if (mNrFrames % TEXT_PERIOD == 0 || mTextInstances.empty())
+            buildText();
+        const float scale { (float)mScale };
+        mInstances.clear();
+        addRect(mInstances, PANEL_MARGIN, PANEL_MARGIN, mPanelSize.x, mPanelSize.y, PANEL_COLOR);
+        mInstances.insert(mInstances.end(), mTextInstances.begin(), mTextInstances.end());
+        const float graphX { PANEL_MARGIN + PANEL_PADDING * scale };
+        const float graphY { PANEL_MARGIN + (PANEL_PADDING + NR_STAT_LINES * LINE_HEIGHT) * scale };
+        addGraph(mFrameTimes, graphX, graphY, "Frame");
+        if (mGPUProfiler)
+            addGraph(mGPUFrameTimes, graphX + (NR_GRAPH_FRAMES + GRAPH_GAP) * scale, graphY, "GPU");
+
+        // Upload the quads, orphaning the storage of the previous frame
+        glBindBuffer(GL_ARRAY_BUFFER, mVBO);
+        if (mInstances.size() > mBufferCapacity)
+            mBufferCapacity = std::max(mInstances.size(), 2 * mBufferCapacity);
+        glBufferData(GL_ARRAY_BUFFER, mBufferCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, mInstances.size() * sizeof(Instance), &mInstances[0]);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, mInstances.size() * sizeof(Instance));
+
+        // Measure the cost in the GPU, if there is a query free
+        const bool measureGPU { mNrQueriesStarted - mNrQueriesRead < NR_TIMER_QUERIES };
+        if (measureGPU)
+            glBeginQuery(GL_TIME_ELAPSED, mTimerQueries[mNrQueriesStarted % NR_TIMER_QUERIES]);
+
+        // Draw all the quads over the image, blending the glyphs
+        const GLboolean depthTest { glIsEnabled(GL_DEPTH_TEST) };
+        const GLboolean stencilTest { glIsEnabled(GL_STENCIL_TEST) };
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, width, height);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_STENCIL_TEST);
+        glEnable(GL_BLEND);
+        glBlendEquation(GL_FUNC_ADD);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        mShader.use();
+        mShader.setVec2("screenSize", glm::vec2(width, height));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, mAtlas);
+        glBindVertexArray(mVAO);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)mInstances.size());
+        RenderStats::addDraw(GL_TRIANGLE_STRIP, 4, mInstances.size());
+        glBindVertexArray(0);
+
+        glDisable(GL_BLEND);
+        if (depthTest)
+            glEnable(GL_DEPTH_TEST);
+        if (stencilTest)
+            glEnable(GL_STENCIL_TEST);
+
+        if (measureGPU)
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            ++mNrQueriesStarted;
+        }
+
+        const double time { std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() };
+        mCPUTime += COST_AVERAGE_WEIGHT * (time - mCPUTime);
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef PERFORMANCEHUD_H
+#define PERFORMANCEHUD_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    class GPUProfiler;
+
+    // Overlay with the timings of the frames and the passes, the render
+    // statistics and the memory used, drawn over the final image of the frame.
+    // The font is a bitmap of 5x7 pixels baked in a texture when the HUD is
+    // created. The background, the glyphs, the graphs and the bars are all
+    // quads of the atlas, drawn with a single instanced call. The text and the
+    // bars are built again every few frames, so they can be read, and the
+    // graphs every frame.
+    // The HUD measures its own cost in the CPU, and in the GPU with a timer
+    // query read back without waiting, and shows it in red when it goes over
+    // the budget of 0.1 ms.
+    class PerformanceHUD
+    {
+        public:
+            // Constructor, with the size in pixels of the pixels of the font
+            PerformanceHUD(unsigned int scale = 2);
+
+            // Destructor
+            ~PerformanceHUD();
+
+            // Method to enable or disable the HUD
+            void setEnabled(bool enabled)
+            {
+                mEnabled = enabled;
+            }
+            bool isEnabled() const
+            {
+                return mEnabled;
+            }
+
+            // Method to set the profiler from which the timings of the GPU and
+            // the passes are taken. Without it, they are not shown
+            void setGPUProfiler(const GPUProfiler* profiler)
+            {
+                mGPUProfiler = profiler;
+            }
+
+            // Method to draw the HUD to the default framebuffer, of width x
+            // height pixels. It should be called once per frame, after the
+            // renderer has finished it. The time of the frame is the time since
+            // the previous call
+            void draw(int width, int height);
+
+            // Average cost in milliseconds of the HUD in the CPU and the GPU,
+            // over the last frames. The GPU one is negative until it is known
+            double getCPUTime() const
+            {
+                return mCPUTime;
+            }
+            double getGPUTime() const
+            {
+                return mGPUTime;
+            }
+
+        private:
+            // Quad of the HUD, with its rectangle in pixels from the top left
+            // corner of the screen, the rectangle of the atlas and the color
+            struct Instance
+            {
+                float rect[4];
+                float texRect[4];
+                unsigned char color[4];
+            };
+
+            // Number of frames in the graphs, and of frames between the updates
+            // of the text
+            static const unsigned int NR_GRAPH_FRAMES { 120 };
+            static const unsigned int TEXT_PERIOD { 15 };
+            // Number of timer queries in flight
+            static const unsigned int NR_TIMER_QUERIES { 4 };
+
+            bool mEnabled;
+            unsigned int mScale;
+
+            // Shader, buffers and atlas of the font
+            Shader mShader;
+            unsigned int mVAO;
+            unsigned int mVBO;
+            unsigned int mAtlas;
+            // Number of instances that fit in the buffer
+            size_t mBufferCapacity;
+
+            // Profiler with the timings of the GPU
+            const GPUProfiler* mGPUProfiler;
+
+            // Quads of the text and the bars, built every few frames, and of
+            // the whole frame
+            std::vector<Instance> mTextInstances;
+            std::vector<Instance> mInstances;
+            // Size of the panel behind the text
+            glm::vec2 mPanelSize;
+
+            // Times of the last frames, in the CPU and the GPU, as a ring
+            float mFrameTimes[NR_GRAPH_FRAMES];
+            float mGPUFrameTimes[NR_GRAPH_FRAMES];
+            unsigned int mNrFrames;
+            // Time of the previous call to draw()
+            std::chrono::steady_clock::time_point mLastDraw;
+
+            // Timer queries of the cost in the GPU, and number of them started
+            // and read
+            unsigned int mTimerQueries[NR_TIMER_QUERIES];
+            unsigned int mNrQueriesStarted;
+            unsigned int mNrQueriesRead;
+            // Cost of the HUD, averaged over the last frames
+            double mCPUTime;
+            double mGPUTime;
+
+            // Whether the extensions with the memory of the GPU are available
+            bool mNVXMemoryInfo;
+            bool mATIMemInfo;
+
+            // Method to bake the font in the atlas
+            void createAtlas();
+
+            // Methods to add quads. The text is in the ASCII range, and the
+            // position is updated to the end of the text
+            void addRect(std::vector<Instance>& instances, float x, float y, float width, float height,
+                         const glm::vec4& color);
+            void addText(std::vector<Instance>& instances, glm::vec2& position, const char* text,
+                         const glm::vec4& color);
+
+            // Method to build the quads of the text and the bars
+            void buildText();
+            // Method to add the quads of a graph of the frame times of a ring
+            void addGraph(const float* times, float x, float y, const char* label);
+
+            // Method to read the results of the timer queries that are available
+            void collectQueries();
+    };
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "renderStats.h"
+
+namespace GLBase
+{
+    // Range of the histogram of frame times, in milliseconds, and ratio between
+    // the limits of consecutive bins
+    static const double HISTOGRAM_MIN_MS { 0.01 };
+    static const double HISTOGRAM_MAX_MS { 10000. };
+    static const double HISTOGRAM_BIN_RATIO { 1.01 };
+
+    // Histogram of frame times with logarithmic bins. The first bin has the
+    // times below the minimum, and the last one the times above the maximum
+    class FrameTimeHistogram
+    {
+        public:
+            FrameTimeHistogram() :
+                mBins((size_t)(std::log(HISTOGRAM_MAX_MS / HISTOGRAM_MIN_MS) / std::log(HISTOGRAM_BIN_RATIO)) + 2, 0),
+                mCount { 0 }
+            {}
+
+            void add(double timeMs)
+            {
+                size_t bin { 0 };
+                if (timeMs >= HISTOGRAM_MIN_MS)
+                {
+                    bin = 1 + (size_t)(std::log(timeMs / HISTOGRAM_MIN_MS) / std::log(HISTOGRAM_BIN_RATIO));
+                    bin = std::min(bin, mBins.size() - 1);
+                }
+                ++mBins[bin];
+                ++mCount;
+            }
+
+            // Percentile between 0 and 100, as the center of its bin
+            double getPercentile(double percentile) const
+            {
+                if (mCount == 0)
+                    return 0.;
+                const std::uint64_t target { std::max<std::uint64_t>(1,
+                    (std::uint64_t)std::ceil(percentile / 100. * mCount)) };
+                std::uint64_t accumulated { 0 };
+                size_t bin { 0 };
+                for (; bin < mBins.size() - 1; ++bin)
+                {
+                    accumulated += mBins[bin];
+                    if (accumulated >= target)
+                        break;
+                }
+                if (bin == 0)
+                    return HISTOGRAM_MIN_MS;
+                return HISTOGRAM_MIN_MS * std::pow(HISTOGRAM_BIN_RATIO, bin - 0.5);
+            }
+
+            std::uint64_t getCount() const
+            {
+                return mCount;
+            }
+
+            void reset()
+            {
+                std::fill(mBins.begin(), mBins.end(), 0);
+                mCount = 0;
+            }
+
+        private:
+            std::vector<std::uint64_t> mBins;
+            std::uint64_t mCount;
+    };
+
+    // State of the statistics
+    struct RenderStats::State
+    {
+        // Counters of the last frame ended
+        std::uint64_t lastFrame[NR_RENDER_STATS] {};
+        unsigned int nrFrames { 0 };
+        // Frame times since the start or the last reset
+        FrameTimeHistogram frameTimes;
+
+        // Dump, with the sums of the counters and the frame times of the
+        // frames since the last one
+        std::string dumpPath;
+        bool dumpJSON { false };
+        unsigned int dumpPeriod { 60 };
+        std::uint64_t periodSums[NR_RENDER_STATS] {};
+        FrameTimeHistogram periodFrameTimes;
+        // Number of rows written to the JSON file
+        unsigned int nrJSONRows { 0 };
+    };
+
+    // State of the statistics, created when it is first used
+    RenderStats::State& RenderStats::getState()
+    {
+        static State state;
+        return state;
+    }
+
+    // Method to end a frame
+    void RenderStats::endFrame(double frameTimeMs)
+    {
+        State& state { getState() };
+        std::uint64_t* counters { getCounters() };
+        for (unsigned int i = 0; i < NR_RENDER_STATS; ++i)
+        {
+            state.lastFrame[i] = counters[i];
+            state.periodSums[i] += counters[i];
+            counters[i] = 0;
+        }
+        ++state.nrFrames;
+        state.frameTimes.add(frameTimeMs);
+        state.periodFrameTimes.add(frameTimeMs);
+
+        if (!state.dumpPath.empty() && state.periodFrameTimes.getCount() >= state.dumpPeriod)
+            dump(state);
+    }
+
+    // Method to get a counter of the last frame ended
+    std::uint64_t RenderStats::get(RenderStat stat)
+    {
+        return getState().lastFrame[stat];
+    }
+
+    // Method to get the name of a counter
+    const char* RenderStats::getName(RenderStat stat)
+    {
+        switch (stat)
+        {
+            case RENDER_STAT_DRAW_CALLS: return "drawCalls";
+            case RENDER_STAT_TRIANGLES: return "triangles";
+            case RENDER_STAT_STATE_CHANGES: return "stateChanges";
+            case RENDER_STAT_UNIFORM_UPLOADS: return "uniformUploads";
+            case RENDER_STAT_BYTES_UPLOADED: return "bytesUploaded";
+            case RENDER_STAT_SHADOW_MAP_RENDERS: return "shadowMapRenders";
+            default: return "unknown";
+        }
+    }
+
+    // Number of frames ended
+    unsigned int RenderStats::getNrFrames()
+    {
+        return getState().nrFrames;
+    }
+
+    // Method to get a percentile of the frame times
+    double RenderStats::getFrameTimePercentile(double percentile)
+    {
+        return getState().frameTimes.getPercentile(percentile);
+    }
+
+    // Method to reset the histogram of the frame times
+    void RenderStats::resetFrameTimes()
+    {
+        getState().frameTimes.reset();
+    }
+
+    // Method to dump the statistics every number of frames to a file
+    void RenderStats::setDump(const std::string& path, unsigned int periodFrames)
+    {
+        State& state { getState() };
+        state.dumpPath = path;
+        state.dumpJSON = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+        state.dumpPeriod = std::max(1u, periodFrames);
+        std::fill(std::begin(state.periodSums), std::end(state.periodSums), 0);
+        state.periodFrameTimes.reset();
+        state.nrJSONRows = 0;
+
+        // Start the CSV file with the header, and the JSON file with an empty
+        // array
+        if (!path.empty())
+        {
+            std::ofstream file(path, std::ios::binary);
+            if (!file)
+            {
+                std::cout << "ERROR::RENDER_STATS::FILE_NOT_WRITTEN: " << path << '\n';
+                return;
+            }
+            if (state.dumpJSON)
+                file << "[\n]\n";
+            else
+            {
+                file << "frame,frames";
+                for (unsigned int i = 0; i < NR_RENDER_STATS; ++i)
+                    file << ',' << getName((RenderStat)i);
+                file << ",p50Ms,p95Ms,p99Ms\n";
+            }
+        }
+    }
+
+    // Method to write the statistics of the frames since the last dump
+    // The counters are the averages per frame
+    void RenderStats::dump(State& state)
+    {
+        const double nrFrames { (double)state.periodFrameTimes.getCount() };
+        std::stringstream row;
+        row << std::fixed << std::setprecision(3);
+        if (state.dumpJSON)
+        {
+            row << "{\"frame\":" << state.nrFrames << ",\"frames\":" << (unsigned int)nrFrames;
+            for (unsigned int i = 0; i < NR_RENDER_STATS; ++i)
+                row << ",\"" << getName((RenderStat)i) << "\":" << state.periodSums[i] / nrFrames;
+            row << ",\"p50Ms\":" << state.periodFrameTimes.getPercentile(50.)
+                << ",\"p95Ms\":" << state.periodFrameTimes.getPercentile(95.)
+                << ",\"p99Ms\":" << state.periodFrameTimes.getPercentile(99.) << '}';
+
+            // The row is written over the end of the array, which is closed
+            // again after it, so the file is valid at any time without
+            // keeping the previous rows
+            std::fstream file(state.dumpPath, std::ios::in | std::ios::out | std::ios::binary);
+            if (file)
+            {
+                file.seekp(state.nrJSONRows == 0 ? -2 : -3, std::ios::end);
+                file << (state.nrJSONRows == 0 ? "" : ",\n") << row.str() << "\n]\n";
+                ++state.nrJSONRows;
+            }
+        }
+        else
+        {
+            row << state.nrFrames << ',' << (unsigned int)nrFrames;
+            for (unsigned int i = 0; i < NR_RENDER_STATS; ++i)
+                row << ',' << state.periodSums[i] / nrFrames;
+            row << ',' << state.periodFrameTimes.getPercentile(50.)
+                << ',' << state.periodFrameTimes.getPercentile(95.)
+                << ',' << state.periodFrameTimes.getPercentile(99.) << '\n';
+
+            std::ofstream file(state.dumpPath, std::ios::app);
+            if (file)
+                file << row.str();
+        }
+
+        std::fill(std::begin(state.periodSums), std::end(state.periodSums), 0);
+        state.periodFrameTimes.reset();
+    }
+}
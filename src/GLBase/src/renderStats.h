@@ -0,0 +1,95 @@
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Enum for the counters of the render statistics
+    enum RenderStat
+    {
+        // Draw calls, and triangles drawn by them, with all their instances
+        RENDER_STAT_DRAW_CALLS,
+        RENDER_STAT_TRIANGLES,
+        // Changes of the shader program
+        RENDER_STAT_STATE_CHANGES,
+        // Uniforms set through the shaders
+        RENDER_STAT_UNIFORM_UPLOADS,
+        // Bytes of the data of buffers and textures uploaded
+        RENDER_STAT_BYTES_UPLOADED,
+        // Shadow maps rendered: each cascade of the directional lights, and
+        // the maps of the spot and point lights
+        RENDER_STAT_SHADOW_MAP_RENDERS,
+        NR_RENDER_STATS
+    };
+
+    // Counters of the work submitted in each frame, and histogram of the
+    // frame times.
+    // The counters are added at the sites that draw and upload data, in GLBase
+    // and GLGeometry, and endFrame() keeps the ones of the frame and resets
+    // them. The frame times are kept in a histogram with logarithmic bins 1%
+    // wide, from which the percentiles are taken.
+    // The statistics can be dumped periodically to a CSV or JSON file, with
+    // the averages of the counters and the percentiles of the frame times of
+    // the frames since the last dump.
+    class RenderStats
+    {
+        public:
+            // Method to add to a counter of the current frame
+            static void add(RenderStat stat, std::uint64_t amount = 1)
+            {
+                getCounters()[stat] += amount;
+            }
+
+            // Method to add a draw call of a number of vertices (or indices)
+            // with a primitive type, like GL_TRIANGLES, and a number of instances
+            static void addDraw(GLenum mode, std::uint64_t count, std::uint64_t instances = 1)
+            {
+                std::uint64_t* counters { getCounters() };
+                ++counters[RENDER_STAT_DRAW_CALLS];
+                if (mode == GL_TRIANGLES)
+                    counters[RENDER_STAT_TRIANGLES] += count / 3 * instances;
+                else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+                    counters[RENDER_STAT_TRIANGLES] += (count > 2 ? count - 2 : 0) * instances;
+            }
+
+            // Method to end a frame, with its duration in milliseconds
+            static void endFrame(double frameTimeMs);
+
+            // Method to get a counter of the last frame ended
+            static std::uint64_t get(RenderStat stat);
+            // Method to get the name of a counter
+            static const char* getName(RenderStat stat);
+
+            // Number of frames ended
+            static unsigned int getNrFrames();
+
+            // Method to get a percentile, between 0 and 100, of the frame times
+            // in milliseconds since the start or the last reset
+            static double getFrameTimePercentile(double percentile);
+            // Method to reset the histogram of the frame times
+            static void resetFrameTimes();
+
+            // Method to dump the statistics every number of frames to a file.
+            // The format is JSON if the path ends in ".json", and CSV otherwise.
+            // An empty path disables it
+            static void setDump(const std::string& path, unsigned int periodFrames = 60);
+
+        private:
+            // Counters of the current frame
+            static std::uint64_t* getCounters()
+            {
+                static std::uint64_t counters[NR_RENDER_STATS] {};
+                return counters;
+            }
+
+            struct State;
+            // State of the statistics, created when it is first used
+            static State& getState();
+
+            // Method to write the statistics of the frames since the last dump
+            static void dump(State& state);
+    };
+}
+
+#endif
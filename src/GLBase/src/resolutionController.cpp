@@ -0,0 +1,63 @@
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Constructor
+    ResolutionController::ResolutionController(float targetFrameTimeMs, float minScale, float maxScale) :
+        mTargetFrameTime { targetFrameTimeMs }, mMinScale { minScale }, mMaxScale { maxScale },
+        mKProportional { 0.5f }, mKIntegral { 0.05f }, mKDerivative { 0.2f }
+    {
+        reset();
+    }
+
+    // Method to change the range of the scale
+    void ResolutionController::setScaleRange(float minScale, float maxScale)
+    {
+        mMinScale = minScale;
+        mMaxScale = maxScale;
+        mScale = glm::clamp(mScale, mMinScale, mMaxScale);
+    }
+
+    // Method to start again from the maximum scale
+    void ResolutionController::reset()
+    {
+        mFilteredFrameTime = mTargetFrameTime;
+        mIntegral = 0.f;
+        mLastError = 0.f;
+        mFirstUpdate = true;
+        mScale = mMaxScale;
+    }
+
+    // Method to pass the frame time of the last frame, and get the render scale
+    // for the next one
+    float ResolutionController::update(float frameTimeMs)
+    {
+        // Exponential moving average of the frame time
+        if (mFirstUpdate)
+            mFilteredFrameTime = frameTimeMs;
+        else
+            mFilteredFrameTime += 0.2f * (frameTimeMs - mFilteredFrameTime);
+
+        // Relative error, positive when there is time to spare
+        const float error { (mTargetFrameTime - mFilteredFrameTime) / mTargetFrameTime };
+        const float derivative { mFirstUpdate ? 0.f : error - mLastError };
+        mLastError = error;
+        mFirstUpdate = false;
+
+        // The integral only accumulates while the scale can still move in its
+        // direction, so it does not wind up at the limits of the range
+        const float minArea { mMinScale * mMinScale };
+        const float maxArea { mMaxScale * mMaxScale };
+        const float area { mScale * mScale };
+        if ((error > 0.f && area < maxArea) || (error < 0.f && area > minArea))
+            mIntegral += error;
+
+        // The output is the fraction of the pixels rendered, starting from all
+        // of them. The integral term holds it where the frame time is the target
+        const float output { maxArea + mKProportional * error + mKIntegral * mIntegral
+                             + mKDerivative * derivative };
+        mScale = glm::sqrt(glm::clamp(output, minArea, maxArea));
+
+        return mScale;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef RESOLUTIONCONTROLLER_H
+#define RESOLUTIONCONTROLLER_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Controller of the render scale for dynamic resolution.
+    // Each frame it receives the measured frame time, and changes the fraction
+    // of the window resolution that is rendered to hold a target frame time.
+    // It is a PID controller on the error of the frame time relative to the
+    // target. Since the cost of a frame grows with the number of pixels, the
+    // output is the fraction of pixels rendered, and the render scale is its
+    // square root.
+    class ResolutionController
+    {
+        public:
+            // Constructor
+            // The scale is kept between minScale and maxScale, both relative
+            // to the window resolution in each axis
+            ResolutionController(float targetFrameTimeMs = 16.f, float minScale = 0.5f,
+                                 float maxScale = 1.f);
+
+            // Method to change the frame time to hold
+            void setTargetFrameTime(float targetFrameTimeMs)
+            {
+                mTargetFrameTime = targetFrameTimeMs;
+            }
+
+            // Method to change the range of the scale
+            void setScaleRange(float minScale, float maxScale);
+
+            // Method to change the gains of the controller
+            void setGains(float kProportional, float kIntegral, float kDerivative)
+            {
+                mKProportional = kProportional;
+                mKIntegral = kIntegral;
+                mKDerivative = kDerivative;
+            }
+
+            // Method to pass the frame time of the last frame, and get the
+            // render scale for the next one
+            float update(float frameTimeMs);
+
+            // Method to start again from the maximum scale
+            void reset();
+
+            // Method to get the current render scale
+            float getScale() const
+            {
+                return mScale;
+            }
+
+        private:
+            // Frame time to hold, in milliseconds
+            float mTargetFrameTime;
+            // Range of the render scale
+            float mMinScale;
+            float mMaxScale;
+
+            // Gains of the controller
+            float mKProportional;
+            float mKIntegral;
+            float mKDerivative;
+
+            // Smoothed frame time, since single frames are noisy
+            float mFilteredFrameTime;
+            // Accumulated and previous error
+            float mIntegral;
+            float mLastError;
+            // True until the first frame time is received
+            bool mFirstUpdate;
+
+            // Current render scale
+            float mScale;
+    };
+}
+
+#endif
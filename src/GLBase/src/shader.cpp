@@ -6,52 +6,82 @@ namespace GLBase
     Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
     {
         // Read the shaders from the files.
+        // This goes through the virtual file system, so the sources are taken
+        // from the mounted archives if they are there, and from the disk otherwise.
 
         // Variables to hold the source read from the files given.
         std::string vertexCode;
         std::string fragmentCode;
         std::string geometryCode;
-        // Input streams to operate on the files.
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // Ensure that the input streams can throw exceptions.
-        // This is done by means of a mask, that determines the conditions
-        // on which they can throw exceptions..
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-        try
+
+        bool readSuccessfully { VirtualFileSystem::readTextFile(vertexPath, vertexCode) &&
+                                VirtualFileSystem::readTextFile(fragmentPath, fragmentCode) };
+        // If the geometry path is present, load the geometry shader too
+        if (geometryPath != nullptr)
+            readSuccessfully = readSuccessfully && VirtualFileSystem::readTextFile(geometryPath, geometryCode);
+
+        if (!readSuccessfully)
         {
-            // Open the files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            // Read the files' contents into streams.
-            std::stringstream vShaderStream, fShaderStream;
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // Close the file handlers.
-            vShaderFile.close();
-            fShaderFile.close();
-            // Convert the streams into strings.
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-            
-            // If the geometry path is present, load the geometry shader too
-            if (geometryPath != nullptr)
-            {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
         }
-        catch (std::ifstream::failure e)
+
+        build(vertexCode, fragmentCode, geometryPath != nullptr ? &geometryCode : nullptr);
+    }
+
+    // Constructor that builds the shader from the sources embedded in the library
+    Shader::Shader(EmbeddedShaderTag, const char* vertexName, const char* fragmentName,
+                   const char* geometryName)
+    {
+        std::string vertexCode;
+        std::string fragmentCode;
+        std::string geometryCode;
+
+        // Missing sources are reported by readEmbeddedSource
+        readEmbeddedSource(vertexName, vertexCode);
+        readEmbeddedSource(fragmentName, fragmentCode);
+        if (geometryName != nullptr)
+            readEmbeddedSource(geometryName, geometryCode);
+
+        build(vertexCode, fragmentCode, geometryName != nullptr ? &geometryCode : nullptr);
+    }
+
+    // Set a directory whose shaders take precedence over the embedded ones
+    void Shader::setOverrideDirectory(const std::string& directory)
+    {
+        getOverrideDirectory() = directory;
+    }
+
+    // Directory with the shaders that override the embedded ones
+    std::string& Shader::getOverrideDirectory()
+    {
+        static std::string directory { std::getenv("GLBASE_SHADER_DIR") != nullptr ?
+                                       std::getenv("GLBASE_SHADER_DIR") : "" };
+        return directory;
+    }
+
+    // Method to get the source of an embedded shader, or the file that overrides it
+    bool Shader::readEmbeddedSource(const char* name, std::string& code)
+    {
+        const std::string& overrideDirectory { getOverrideDirectory() };
+        if (!overrideDirectory.empty() &&
+            VirtualFileSystem::readTextFile(overrideDirectory + "/" + name, code))
+            return true;
+
+        const char* source { findEmbeddedShader(name) };
+        if (source == nullptr)
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+            std::cout << "ERROR::SHADER::NO_EMBEDDED_SHADER " << name << std::endl;
+            return false;
         }
+        code = source;
+        return true;
+    }
+
+    // Method to compile the stages and link the program
+    void Shader::build(const std::string& vertexCode, const std::string& fragmentCode,
+                       const std::string* geometryCode)
+    {
+        GLBASE_PROFILE_ZONE("Shader compilation");
         const char* vShaderCode { vertexCode.c_str() };
         const char* fShaderCode { fragmentCode.c_str() };
 
@@ -79,9 +109,9 @@ namespace GLBase
         checkCompileErrors(fragment, "FRAGMENT");
 
         // If the geometry shader is given, compile it
-        if (geometryPath != nullptr)
+        if (geometryCode != nullptr)
         {
-            const char* gShaderCode { geometryCode.c_str() };
+            const char* gShaderCode { geometryCode->c_str() };
             geometry = glCreateShader(GL_GEOMETRY_SHADER);
             glShaderSource(geometry, 1, &gShaderCode, NULL);
             glCompileShader(geometry);
@@ -93,7 +123,7 @@ namespace GLBase
         // Attach the shaders to the program, and link them
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
-        if (geometryPath != nullptr)
+        if (geometryCode != nullptr)
             glAttachShader(ID, geometry);
         glLinkProgram(ID); 
         // Check for linking errors
@@ -102,58 +132,99 @@ namespace GLBase
         // Once the shaders are linked in the program, we don't need the shader objects.
         glDeleteShader(vertex);
         glDeleteShader(fragment);
-        if (geometryPath != nullptr)
+        if (geometryCode != nullptr)
             glDeleteShader(geometry);
     }
 
     // Use/activate the shader
     void Shader::use()
     {
+        // Count the changes of program, against the one bound by the last
+        // call, without querying the context
+        unsigned int& currentProgram { getCurrentProgram() };
+        if (ID != currentProgram)
+        {
+            currentProgram = ID;
+            RenderStats::add(RENDER_STAT_STATE_CHANGES);
+        }
         glUseProgram(ID);
     }
 
+    // Forget the program bound by the last use()
+    void Shader::resetCurrentProgram()
+    {
+        getCurrentProgram() = 0;
+    }
+
+    // Program bound by the last use()
+    unsigned int& Shader::getCurrentProgram()
+    {
+        static unsigned int program { 0 };
+        return program;
+    }
+
     // Utility uniform functions
     void Shader::setBool(const std::string &name, bool value) const
     {
         glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     void Shader::setInt(const std::string &name, int value) const
     {
         glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
+    }
+    void Shader::setIntArray(const std::string &name, int count, const int* values) const
+    {
+        glUniform1iv(glGetUniformLocation(ID, name.c_str()), count, values);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     void Shader::setFloat(const std::string &name, float value) const
     {
         glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     // ------------------------------------------------------------------------
     void Shader::setFloat3(const std::string &name, float value1, float value2, float value3) const
     {
         glUniform3f(glGetUniformLocation(ID, name.c_str()), value1, value2, value3);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     void Shader::setFloat4(const std::string &name, float value1, float value2, float value3, float value4) const
     {
         glUniform4f(glGetUniformLocation(ID, name.c_str()), value1, value2, value3, value4);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     // ------------------------------------------------------------------------
     void Shader::setMat2(const std::string &name, const glm::mat2 &mat) const
     {
         glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
     {
         glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
     {
         glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     void Shader::setVec2(const std::string &name, const glm::vec2 &vec) const
     {
         glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &vec[0]);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
     void Shader::setVec3(const std::string &name, const glm::vec3 &vec) const
     {
         glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &vec[0]);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
+    }
+    void Shader::setVec4(const std::string &name, const glm::vec4 &vec) const
+    {
+        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &vec[0]);
+        RenderStats::add(RENDER_STAT_UNIFORM_UPLOADS);
     }
 
     // Utility function for checking compile errors for the shaders
@@ -5,6 +5,10 @@
 
 namespace GLBase
 {
+    // Tag used to select the constructor of Shader that takes embedded sources
+    struct EmbeddedShaderTag {};
+    constexpr EmbeddedShaderTag EMBEDDED_SHADER {};
+
     class Shader
     {
         public: 
@@ -14,12 +18,34 @@ namespace GLBase
             // Constructor that reads and builds the shader from files.
             Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
 
+            // Constructor that builds the shader from the sources embedded in the
+            // library, given by their names (paths relative to the shaders/ directory),
+            // for instance:
+            //      Shader(EMBEDDED_SHADER, "GLBase/defRenderQuadVertex.glsl",
+            //             "GLBase/defRenderQuadFragment.glsl")
+            // If a file with the same name exists in the override directory, it is
+            // used instead of the embedded source.
+            Shader(EmbeddedShaderTag, const char* vertexName, const char* fragmentName,
+                   const char* geometryName = nullptr);
+
+            // Set a directory whose shaders take precedence over the embedded ones,
+            // to iterate on them without rebuilding. By default it is taken from
+            // the environment variable GLBASE_SHADER_DIR.
+            static void setOverrideDirectory(const std::string& directory);
+
             // Use/activate the shader
             void use();
 
+            // Forget the program bound by the last use(), which is tracked to
+            // count the changes of program. It must be called after binding a
+            // program with glUseProgram() outside of this class, or after
+            // changing the context. The Application calls it every frame
+            static void resetCurrentProgram();
+
             // Utility uniform functions
             void setBool(const std::string &name, bool value) const;
             void setInt(const std::string &name, int value) const;
+            void setIntArray(const std::string &name, int count, const int* values) const;
             void setFloat(const std::string &name, float value) const;
             // ------------------------------------------------------------------------
             void setFloat3(const std::string &name, float value1, float value2, 
@@ -29,12 +55,26 @@ namespace GLBase
             // ------------------------------------------------------------------------
             void setVec2(const std::string &name, const glm::vec2 &vec) const;
             void setVec3(const std::string &name, const glm::vec3 &vec) const;
+            void setVec4(const std::string &name, const glm::vec4 &vec) const;
             // ------------------------------------------------------------------------
             void setMat2(const std::string &name, const glm::mat2 &mat) const;
             void setMat3(const std::string &name, const glm::mat3 &mat) const;
             void setMat4(const std::string &name, const glm::mat4 &mat) const;
 
         private:
+            // Method to compile the stages and link the program. The geometry
+            // stage is optional
+            void build(const std::string& vertexCode, const std::string& fragmentCode,
+                       const std::string* geometryCode);
+
+            // Method to get the source of an embedded shader, or the file that
+            // overrides it
+            static bool readEmbeddedSource(const char* name, std::string& code);
+            // Directory with the shaders that override the embedded ones
+            static std::string& getOverrideDirectory();
+            // Program bound by the last use(), or 0 if it is not known
+            static unsigned int& getCurrentProgram();
+
             // Utility function for checking compile errors for the shaders
             void checkCompileErrors(GLuint shader, std::string type);
     };
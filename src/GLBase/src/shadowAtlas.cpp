@@ -0,0 +1,464 @@
+#include "shadowAtlas.h"
+
+using namespace GLGeometry;
+
+namespace GLBase
+{
+    // Constructor
+    ShadowAtlas::ShadowAtlas(int size, int minTileSize) :
+        mSize { size }, mNrLevels { 1 },
+        mFBO { 0 }, mTexture { 0 }, mStaticFBO { 0 }, mStaticTexture { 0 },
+        mMomentsTexture { 0 }, mCompareSampler { 0 },
+        mFrameIndex { 0 }, mNrTiles { 0 }, mNrStaticTilesRendered { 0 },
+        mNrTilesComposited { 0 }, mNrTilesFiltered { 0 }, mNrStaticCasters { 0 }, mNrDynamicCasters { 0 }
+    {
+        // Levels of the quadtree, down to the minimum size of the tiles
+        while ((mSize >> mNrLevels) >= std::max(1, minTileSize))
+            ++mNrLevels;
+        mFreeTiles.resize(mNrLevels);
+        mFreeTiles[0].push_back(glm::ivec2(0, 0));
+
+        // Create the two layers, with the same format so the tiles can be
+        // copied from one to the other
+        unsigned int* framebuffers[2] { &mFBO, &mStaticFBO };
+        unsigned int* textures[2] { &mTexture, &mStaticTexture };
+        for (int i = 0; i < 2; ++i)
+        {
+            glGenTextures(1, textures[i]);
+            glBindTexture(GL_TEXTURE_2D, *textures[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, mSize, mSize, 0,
+                         GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+            glGenFramebuffers(1, framebuffers[i]);
+            glBindFramebuffer(GL_FRAMEBUFFER, *framebuffers[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, *textures[i], 0);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+
+            // Check if the framebuffer is complete
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            {
+                std::cout << "ERROR::SHADOWATLAS:: Framebuffer is not complete!" << std::endl;
+                throw 0;
+            }
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // Sampler for the hardware PCF, which interpolates the result of
+        // comparing the depth of the four closest texels
+        glGenSamplers(1, &mCompareSampler);
+        glSamplerParameteri(mCompareSampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glSamplerParameteri(mCompareSampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glSamplerParameteri(mCompareSampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(mCompareSampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glSamplerParameteri(mCompareSampler, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glSamplerParameteri(mCompareSampler, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+
+    // Destructor
+    ShadowAtlas::~ShadowAtlas()
+    {
+        glDeleteFramebuffers(1, &mFBO);
+        glDeleteFramebuffers(1, &mStaticFBO);
+        glDeleteTextures(1, &mTexture);
+        glDeleteTextures(1, &mStaticTexture);
+        glDeleteTextures(1, &mMomentsTexture);
+        glDeleteSamplers(1, &mCompareSampler);
+    }
+
+    // Method to bind the textures for the lighting pass
+    void ShadowAtlas::bindTextures(unsigned int firstUnit) const
+    {
+        glActiveTexture(GL_TEXTURE0 + firstUnit);
+        glBindTexture(GL_TEXTURE_2D, mTexture);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+        glBindTexture(GL_TEXTURE_2D, mTexture);
+        glBindSampler(firstUnit + 1, mCompareSampler);
+        glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+        glBindTexture(GL_TEXTURE_2D, mMomentsTexture);
+    }
+
+    // Method to render all the tiles again in the next frame
+    void ShadowAtlas::invalidate()
+    {
+        for (auto& entry : mTiles)
+            entry.second.staticValid = false;
+    }
+
+    // Method to allocate a tile of a level
+    // If there is no free tile of this level, a free tile of the level above
+    // is divided in four
+    bool ShadowAtlas::allocateTile(int level, glm::ivec2& offset)
+    {
+        if (level < 0)
+            return false;
+
+        if (!mFreeTiles[level].empty())
+        {
+            offset = mFreeTiles[level].back();
+            mFreeTiles[level].pop_back();
+            return true;
+        }
+
+        glm::ivec2 parent;
+        if (!allocateTile(level - 1, parent))
+            return false;
+        const int size { getTileSize(level) };
+        mFreeTiles[level].push_back(parent + glm::ivec2(size, size));
+        mFreeTiles[level].push_back(parent + glm::ivec2(0, size));
+        mFreeTiles[level].push_back(parent + glm::ivec2(size, 0));
+        offset = parent;
+        return true;
+    }
+
+    // Method to free a tile of a level
+    // If its three siblings are free, they are merged into the tile of the
+    // level above
+    void ShadowAtlas::freeTile(int level, const glm::ivec2& offset)
+    {
+        std::vector<glm::ivec2>& freeTiles { mFreeTiles[level] };
+        if (level > 0)
+        {
+            const int parentSize { getTileSize(level - 1) };
+            const glm::ivec2 parent { (offset / parentSize) * parentSize };
+            auto isSibling = [&](const glm::ivec2& tile)
+            {
+                return (tile / parentSize) * parentSize == parent;
+            };
+
+            if (std::count_if(freeTiles.begin(), freeTiles.end(), isSibling) == 3)
+            {
+                freeTiles.erase(std::remove_if(freeTiles.begin(), freeTiles.end(), isSibling),
+                                freeTiles.end());
+                freeTile(level - 1, parent);
+                return;
+            }
+        }
+        freeTiles.push_back(offset);
+    }
+
+    // Method to update the state of the casters, and invalidate the cached
+    // tiles of the lights affected by the changes of the static ones
+    void ShadowAtlas::updateCasters(const std::vector<GLElemObject*>& objectsWithShadow)
+    {
+        // Bounding spheres of the static casters that were added or removed
+        std::vector<glm::vec4> changes;
+
+        mNrStaticCasters = 0;
+        mNrDynamicCasters = 0;
+        for (auto object : objectsWithShadow)
+        {
+            const glm::mat4 modelMatrix { object->getModelMatrix() };
+            glm::vec3 center;
+            float radius;
+            object->getBoundingSphere(center, radius);
+
+            auto it { mCasters.find(object) };
+            if (it == mCasters.end())
+            {
+                // New casters are static until they move
+                mCasters[object] = { modelMatrix, center, radius, STATIC_FRAMES, true, mFrameIndex };
+                changes.push_back(glm::vec4(center, radius));
+                ++mNrStaticCasters;
+                continue;
+            }
+
+            Caster& caster { it->second };
+            if (modelMatrix != caster.modelMatrix)
+            {
+                // A static caster that moves is removed from the cached tiles
+                if (caster.isStatic)
+                    changes.push_back(glm::vec4(caster.center, caster.radius));
+                caster.isStatic = false;
+                caster.framesStill = 0;
+            }
+            else if (!caster.isStatic && ++caster.framesStill >= STATIC_FRAMES)
+            {
+                // A dynamic caster that stops is added to the cached tiles
+                caster.isStatic = true;
+                changes.push_back(glm::vec4(center, radius));
+            }
+            caster.modelMatrix = modelMatrix;
+            caster.center = center;
+            caster.radius = radius;
+            caster.lastFrame = mFrameIndex;
+
+            if (caster.isStatic)
+                ++mNrStaticCasters;
+            else
+                ++mNrDynamicCasters;
+        }
+
+        // Remove the casters that are not in the list anymore
+        for (auto it = mCasters.begin(); it != mCasters.end();)
+        {
+            if (it->second.lastFrame == mFrameIndex)
+            {
+                ++it;
+                continue;
+            }
+            if (it->second.isStatic)
+                changes.push_back(glm::vec4(it->second.center, it->second.radius));
+            it = mCasters.erase(it);
+        }
+
+        // Invalidate the cached tiles of the lights whose frustum contains
+        // any of the changes
+        if (changes.empty())
+            return;
+        for (auto& entry : mTiles)
+        {
+            Tile& tile { entry.second };
+            if (!tile.staticValid)
+                continue;
+            glm::vec4 planes[6];
+            GLUtils::getFrustumPlanes(tile.lightSpaceMatrix, planes);
+            for (const glm::vec4& sphere : changes)
+            {
+                if (GLUtils::sphereInFrustum(planes, glm::vec3(sphere), sphere.w))
+                {
+                    tile.staticValid = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Method to assign the tiles to the lights of this frame
+    // The size of the tile of each light is the diameter in pixels of the
+    // projection of its volume, between the minimum size and the resolution of
+    // the shadow map of the light. The lights are served in order of the area
+    // they cover, and get a smaller tile if there is no space for the one they
+    // want. A light keeps its tile until the size it wants changes by most of
+    // a level, so the tiles are not rendered again for small movements of the
+    // camera
+    void ShadowAtlas::assignTiles(const std::vector<SpotLight*>& lights, const glm::mat4& view,
+                                  const glm::mat4& projection, int screenHeight)
+    {
+        glm::vec4 frustumPlanes[6];
+        GLUtils::getFrustumPlanes(projection * view, frustumPlanes);
+        const glm::vec3 cameraPosition { glm::inverse(view)[3] };
+
+        // Lights in the frustum, with the level of the tile they want
+        struct Candidate
+        {
+            float importance;
+            float level;
+            SpotLight* light;
+        };
+        std::vector<Candidate> candidates;
+        for (auto light : lights)
+        {
+            auto it { mTiles.find(light) };
+            if (it == mTiles.end())
+                it = mTiles.insert({ light, { glm::ivec2(0, 0), -1, 0.f, glm::mat4(0.f),
+                                              false, false, false, mFrameIndex,
+                                              false, SHADOW_FILTER_PCF } }).first;
+            Tile& tile { it->second };
+            tile.lastFrame = mFrameIndex;
+
+            // The lights outside of the frustum do not need a tile
+            const float radius { light->getRadiusMax() };
+            if (!GLUtils::sphereInFrustum(frustumPlanes, light->getPosition(), radius))
+            {
+                if (tile.level >= 0)
+                    freeTile(tile.level, tile.offset);
+                tile.level = -1;
+                continue;
+            }
+
+            // Size of the projection of the volume, in pixels
+            const float distance { glm::length(light->getPosition() - cameraPosition) };
+            float texels;
+            if (distance <= radius)
+            {
+                tile.importance = std::numeric_limits<float>::max();
+                texels = (float)mSize;
+            }
+            else
+            {
+                const float projectedRadius { radius * projection[1][1]
+                                              / glm::sqrt(distance * distance - radius * radius) };
+                tile.importance = projectedRadius * projectedRadius;
+                texels = projectedRadius * (float)screenHeight;
+            }
+            candidates.push_back({ tile.importance, glm::log2((float)mSize / std::max(texels, 1.f)), light });
+        }
+
+        // Free the tiles of the lights that are not in the list anymore
+        for (auto it = mTiles.begin(); it != mTiles.end();)
+        {
+            if (it->second.lastFrame == mFrameIndex)
+            {
+                ++it;
+                continue;
+            }
+            if (it->second.level >= 0)
+                freeTile(it->second.level, it->second.offset);
+            it = mTiles.erase(it);
+        }
+
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [](const Candidate& a, const Candidate& b) { return a.importance > b.importance; });
+        for (const Candidate& candidate : candidates)
+        {
+            Tile& tile { mTiles[candidate.light] };
+
+            // Range of levels of the light, with the largest tiles at half of
+            // the atlas
+            const int maxResolution { std::min(candidate.light->getShadowMapResolution(), mSize / 2) };
+            const int minLevel { glm::clamp((int)glm::ceil(glm::log2((float)mSize / std::max(maxResolution, 1))),
+                                            1, mNrLevels - 1) };
+            const float wantedLevel { glm::clamp(candidate.level, (float)minLevel, (float)(mNrLevels - 1)) };
+            int level { (int)glm::round(wantedLevel) };
+
+            glm::ivec2 offset;
+            if (tile.level >= 0)
+            {
+                // Keep the tile, or move to a tile with the size wanted if
+                // there is space for it
+                if (glm::abs(wantedLevel - (float)tile.level) < 0.75f || !allocateTile(level, offset))
+                    continue;
+                freeTile(tile.level, tile.offset);
+            }
+            else
+            {
+                while (level < mNrLevels && !allocateTile(level, offset))
+                    ++level;
+                if (level == mNrLevels)
+                    continue;
+            }
+            tile.offset = offset;
+            tile.level = level;
+            tile.staticValid = false;
+        }
+    }
+
+    // Method to render the tile of a light, if it changed
+    void ShadowAtlas::renderTile(const Camera& camera, SpotLight* light, Tile& tile,
+                                 const std::vector<GLElemObject*>& objectsWithShadow)
+    {
+        // The cached tile is not valid if the light moved
+        const glm::mat4 lightSpaceMatrix { light->getLightSpaceMatrix() };
+        if (lightSpaceMatrix != tile.lightSpaceMatrix)
+        {
+            tile.lightSpaceMatrix = lightSpaceMatrix;
+            tile.staticValid = false;
+        }
+
+        // Casters inside of the frustum of the light
+        glm::vec4 planes[6];
+        GLUtils::getFrustumPlanes(lightSpaceMatrix, planes);
+        std::vector<GLElemObject*> staticCasters;
+        std::vector<GLElemObject*> dynamicCasters;
+        for (auto object : objectsWithShadow)
+        {
+            const Caster& caster { mCasters[object] };
+            if (!GLUtils::sphereInFrustum(planes, caster.center, caster.radius))
+                continue;
+            if (caster.isStatic)
+                staticCasters.push_back(object);
+            else
+                dynamicCasters.push_back(object);
+        }
+
+        // Only the tile is cleared and copied
+        const int size { getTileSize(tile.level) };
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(tile.offset.x, tile.offset.y, size, size);
+
+        // Render the static casters to the cached layer
+        if (!tile.staticValid)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, mStaticFBO);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            light->computeShadowMap(camera, staticCasters);
+            tile.staticValid = true;
+            tile.compositeValid = false;
+            ++mNrStaticTilesRendered;
+        }
+
+        // Copy the cached tile to the sampled layer, and draw the dynamic
+        // casters over it. The tile does not change if there are no dynamic
+        // casters now, and there were none in the last copy
+        if (!tile.compositeValid || tile.hasDynamicCasters || !dynamicCasters.empty())
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, mStaticFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mFBO);
+            glBlitFramebuffer(tile.offset.x, tile.offset.y, tile.offset.x + size, tile.offset.y + size,
+                              tile.offset.x, tile.offset.y, tile.offset.x + size, tile.offset.y + size,
+                              GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            if (!dynamicCasters.empty())
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+                light->computeShadowMap(camera, dynamicCasters);
+            }
+            tile.compositeValid = true;
+            tile.hasDynamicCasters = !dynamicCasters.empty();
+            tile.momentsValid = false;
+            ++mNrTilesComposited;
+        }
+
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    // Method to assign the tiles to the spot lights and render the ones that
+    // changed
+    void ShadowAtlas::update(const Camera& camera, const std::vector<SpotLight*>& lights,
+                             const std::vector<GLElemObject*>& objectsWithShadow,
+                             const glm::mat4& view, const glm::mat4& projection, int screenHeight,
+                        ShadowMomentsFilter& momentsFilter)
+    {
+        ++mFrameIndex;
+        updateCasters(objectsWithShadow);
+        assignTiles(lights, view, projection, screenHeight);
+
+        mNrTiles = 0;
+        mNrStaticTilesRendered = 0;
+        mNrTilesComposited = 0;
+        mNrTilesFiltered = 0;
+        for (auto light : lights)
+        {
+            Tile& tile { mTiles[light] };
+            if (tile.level < 0)
+            {
+                light->setShadowTile(glm::ivec4(0), mSize);
+                continue;
+            }
+
+            const int size { getTileSize(tile.level) };
+            light->setShadowTile(glm::ivec4(tile.offset, size, size), mSize);
+            renderTile(camera, light, tile, objectsWithShadow);
+            ++mNrTiles;
+
+            // Filter the tile to the moments if it changed, or if the light
+            // changed its filter
+            const ShadowFilter shadowFilter { light->getShadowFilter() };
+            if ((shadowFilter == SHADOW_FILTER_ESM || shadowFilter == SHADOW_FILTER_VSM)
+                && (!tile.momentsValid || tile.momentsFilter != static_cast<int>(shadowFilter)))
+            {
+                if (mMomentsTexture == 0)
+                {
+                    glGenTextures(1, &mMomentsTexture);
+                    glBindTexture(GL_TEXTURE_2D, mMomentsTexture);
+                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, mSize / 2, mSize / 2, 0, GL_RG, GL_FLOAT, NULL);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                }
+                momentsFilter.filter(mTexture, -1, glm::ivec4(tile.offset, size, size),
+                                     mMomentsTexture, -1, shadowFilter == SHADOW_FILTER_ESM);
+                tile.momentsValid = true;
+                tile.momentsFilter = static_cast<int>(shadowFilter);
+                ++mNrTilesFiltered;
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
@@ -0,0 +1,201 @@
+#ifndef SHADOWATLAS_H
+#define SHADOWATLAS_H
+
+#include "GLBase.h"
+#include "GLGeometry.h"
+
+namespace GLBase
+{
+    class SpotLight;
+    class Camera;
+    class ShadowMomentsFilter;
+
+    // Atlas with the shadow maps of the spot lights.
+    // Each spot light in the view frustum gets a square tile of a shared depth
+    // texture. The tiles are allocated in a quadtree, so their sizes are the
+    // size of the atlas divided by powers of two, and the size of each tile
+    // follows the area of the screen covered by the volume of its light.
+    //
+    // The tiles are cached between frames. The casters are classified by their
+    // model matrix: the ones that have not moved in some frames are static, and
+    // are rendered to a cached layer, which is only rendered again when the
+    // light, its tile, or a static caster inside of its frustum changes. The
+    // dynamic casters are drawn each frame over a copy of the cached tile in
+    // the layer that is sampled by the lighting pass.
+    //
+    // The tiles of the lights with exponential or variance shadow maps are
+    // also filtered to a texture of moments, with half of the size of the
+    // atlas, each time they change.
+    class ShadowAtlas
+    {
+        public:
+            // Constructor
+            // The tiles are between minTileSize and half of the size of the atlas
+            ShadowAtlas(int size = 4096, int minTileSize = 128);
+
+            // Destructor
+            ~ShadowAtlas();
+
+            // Method to assign the tiles to the spot lights and render the ones
+            // that changed. The tiles of each light are passed to it, and the
+            // lights without a tile have no shadow in this frame
+            // The shadow shader of the lights must be configured before
+            void update(const Camera& camera, const std::vector<SpotLight*>& lights,
+                        const std::vector<GLGeometry::GLElemObject*>& objectsWithShadow,
+                        const glm::mat4& view, const glm::mat4& projection, int screenHeight,
+                        ShadowMomentsFilter& momentsFilter);
+
+            // Method to render all the tiles again in the next frame, for
+            // instance after changing the meshes of the casters
+            void invalidate();
+
+            // Method to get the texture sampled by the lighting pass
+            inline unsigned int getTexture() const
+            {
+                return mTexture;
+            }
+
+            // Method to bind the textures for the lighting pass: the atlas to a
+            // texture unit, the same texture with a comparison sampler for the
+            // hardware PCF to the next one, and the moments to the one after it
+            void bindTextures(unsigned int firstUnit) const;
+
+            // Method to get the size of the atlas
+            inline int getSize() const
+            {
+                return mSize;
+            }
+
+            // Methods to get information of the last update
+            // Number of lights with a tile
+            inline unsigned int getNrTiles() const
+            {
+                return mNrTiles;
+            }
+            // Number of tiles whose cached layer was rendered again
+            inline unsigned int getNrStaticTilesRendered() const
+            {
+                return mNrStaticTilesRendered;
+            }
+            // Number of tiles copied from the cached layer, with the dynamic
+            // casters drawn over them
+            inline unsigned int getNrTilesComposited() const
+            {
+                return mNrTilesComposited;
+            }
+            // Number of tiles filtered to the moments
+            inline unsigned int getNrTilesFiltered() const
+            {
+                return mNrTilesFiltered;
+            }
+            // Number of casters of each kind
+            inline unsigned int getNrStaticCasters() const
+            {
+                return mNrStaticCasters;
+            }
+            inline unsigned int getNrDynamicCasters() const
+            {
+                return mNrDynamicCasters;
+            }
+
+        private:
+            // Tile of a spot light, and state of its cache
+            struct Tile
+            {
+                // Offset in texels, and level in the quadtree (0 is the whole
+                // atlas). The level is -1 if the light has no tile
+                glm::ivec2 offset;
+                int level;
+                // Importance of the light, from the area of the screen covered
+                float importance;
+                // Light space matrix with which the tile was rendered
+                glm::mat4 lightSpaceMatrix;
+                // True if the cached layer has the static casters of the light
+                bool staticValid;
+                // True if the sampled layer has a copy of the cached layer,
+                // and if dynamic casters were drawn over it
+                bool compositeValid;
+                bool hasDynamicCasters;
+                // Last frame in which the light was updated
+                unsigned int lastFrame;
+                // True if the moments have the sampled layer of the tile, and
+                // filter with which they were computed, as in the ShadowFilter
+                // enum, which is not declared yet when this header is parsed
+                bool momentsValid;
+                int momentsFilter;
+            };
+
+            // State of a caster
+            struct Caster
+            {
+                glm::mat4 modelMatrix;
+                // Bounding sphere
+                glm::vec3 center;
+                float radius;
+                // Number of frames without moving
+                unsigned int framesStill;
+                bool isStatic;
+                // Last frame in which it was in the list of casters
+                unsigned int lastFrame;
+            };
+
+            // Number of frames that a caster must stay still to be static
+            static const unsigned int STATIC_FRAMES { 30 };
+
+            // Size of the atlas, and number of levels of the quadtree
+            int mSize;
+            int mNrLevels;
+
+            // Layer sampled by the lighting pass, and cached layer with only the
+            // static casters, with their framebuffers
+            unsigned int mFBO;
+            unsigned int mTexture;
+            unsigned int mStaticFBO;
+            unsigned int mStaticTexture;
+            // Moments of the exponential and variance shadow maps, created the
+            // first time that they are needed
+            unsigned int mMomentsTexture;
+            // Sampler that compares the depth for the hardware PCF
+            unsigned int mCompareSampler;
+
+            // Free tiles of each level of the quadtree
+            std::vector<std::vector<glm::ivec2>> mFreeTiles;
+            // Tiles of the lights, and state of the casters
+            std::map<SpotLight*, Tile> mTiles;
+            std::map<const GLGeometry::GLElemObject*, Caster> mCasters;
+            // Number of updates
+            unsigned int mFrameIndex;
+
+            // Statistics of the last update
+            unsigned int mNrTiles;
+            unsigned int mNrStaticTilesRendered;
+            unsigned int mNrTilesComposited;
+            unsigned int mNrTilesFiltered;
+            unsigned int mNrStaticCasters;
+            unsigned int mNrDynamicCasters;
+
+            // Method to get the size of the tiles of a level
+            inline int getTileSize(int level) const
+            {
+                return mSize >> level;
+            }
+
+            // Methods to allocate and free a tile of a level
+            bool allocateTile(int level, glm::ivec2& offset);
+            void freeTile(int level, const glm::ivec2& offset);
+
+            // Method to update the state of the casters, and invalidate the
+            // cached tiles of the lights affected by the changes of the static ones
+            void updateCasters(const std::vector<GLGeometry::GLElemObject*>& objectsWithShadow);
+
+            // Method to assign the tiles to the lights of this frame
+            void assignTiles(const std::vector<SpotLight*>& lights, const glm::mat4& view,
+                             const glm::mat4& projection, int screenHeight);
+
+            // Method to render the tile of a light, if it changed
+            void renderTile(const Camera& camera, SpotLight* light, Tile& tile,
+                            const std::vector<GLGeometry::GLElemObject*>& objectsWithShadow);
+    };
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include "shadowMomentsFilter.h"
+
+namespace GLBase
+{
+    // Constructor
+    ShadowMomentsFilter::ShadowMomentsFilter() :
+        mShader(EMBEDDED_SHADER, "GLBase/shadowMomentsVertex.glsl", "GLBase/shadowMomentsFragment.glsl"),
+        mFBO { 0 }, mVAO { 0 }, mTempTexture { 0 }, mTempSize { 0, 0 }
+    {
+        glGenFramebuffers(1, &mFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        glReadBuffer(GL_NONE);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // The passes draw a triangle computed from the index of its vertices
+        glGenVertexArrays(1, &mVAO);
+
+        // Samplers of different types cannot use the same unit
+        mShader.use();
+        mShader.setInt("depthMap", 0);
+        mShader.setInt("depthMapArray", 1);
+        mShader.setInt("momentsMap", 2);
+    }
+
+    // Destructor
+    ShadowMomentsFilter::~ShadowMomentsFilter()
+    {
+        glDeleteFramebuffers(1, &mFBO);
+        glDeleteVertexArrays(1, &mVAO);
+        glDeleteTextures(1, &mTempTexture);
+    }
+
+    // Method to filter a region of a depth texture
+    void ShadowMomentsFilter::filter(unsigned int depthTexture, int depthLayer, const glm::ivec4& rect,
+                                     unsigned int momentsTexture, int momentsLayer, bool exponential)
+    {
+        const glm::ivec2 momentsOffset { rect.x / 2, rect.y / 2 };
+        const glm::ivec2 momentsSize { std::max(1, rect.z / 2), std::max(1, rect.w / 2) };
+
+        // Make the intermediate texture larger if needed
+        if (momentsSize.x > mTempSize.x || momentsSize.y > mTempSize.y)
+        {
+            mTempSize = glm::max(mTempSize, momentsSize);
+            if (mTempTexture == 0)
+                glGenTextures(1, &mTempTexture);
+            glBindTexture(GL_TEXTURE_2D, mTempTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, mTempSize.x, mTempSize.y, 0, GL_RG, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+
+        mShader.use();
+        mShader.setBool("exponential", exponential);
+        glBindFramebuffer(GL_FRAMEBUFFER, mFBO);
+        glBindVertexArray(mVAO);
+
+        // Horizontal pass, from the depth to the intermediate texture
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTempTexture, 0);
+        glViewport(0, 0, momentsSize.x, momentsSize.y);
+        if (depthLayer < 0)
+        {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, depthTexture);
+        }
+        else
+        {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+        }
+        mShader.setInt("blurPass", 0);
+        mShader.setInt("depthLayer", depthLayer);
+        mShader.setVec4("sourceRect", glm::vec4(rect));
+        mShader.setVec2("targetOffset", glm::vec2(0.f));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        RenderStats::addDraw(GL_TRIANGLES, 3);
+
+        // Vertical pass, from the intermediate texture to the moments
+        if (momentsLayer < 0)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, momentsTexture, 0);
+        else
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, momentsTexture, 0, momentsLayer);
+        glViewport(momentsOffset.x, momentsOffset.y, momentsSize.x, momentsSize.y);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, mTempTexture);
+        mShader.setInt("blurPass", 1);
+        mShader.setVec4("sourceRect", glm::vec4(0.f, 0.f, momentsSize));
+        mShader.setVec2("targetOffset", glm::vec2(momentsOffset));
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        RenderStats::addDraw(GL_TRIANGLES, 3);
+
+        glBindVertexArray(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+}
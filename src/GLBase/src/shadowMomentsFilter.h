@@ -0,0 +1,45 @@
+#ifndef SHADOWMOMENTSFILTER_H
+#define SHADOWMOMENTSFILTER_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // Filter of the exponential and variance shadow maps.
+    // The depth of a region of a shadow map is converted to its moments, with
+    // half of its resolution, and blurred with a separable gaussian, so the
+    // lighting pass can read them with a single bilinear fetch. The horizontal
+    // pass converts the depth and writes to an intermediate texture, which
+    // grows to the largest region filtered, and the vertical pass writes the
+    // result to the moments texture.
+    class ShadowMomentsFilter
+    {
+        public:
+            // Constructor
+            ShadowMomentsFilter();
+
+            // Destructor
+            ~ShadowMomentsFilter();
+
+            // Method to filter a region of a depth texture, with its offset and
+            // size in texels. The moments are written to the region with half of
+            // that offset and size of a RG32F texture. The layers are -1 for 2D
+            // textures, or the layer of a texture array
+            // The exponential shadow maps store the exponential of the depth,
+            // and the variance ones the depth and its square
+            void filter(unsigned int depthTexture, int depthLayer, const glm::ivec4& rect,
+                        unsigned int momentsTexture, int momentsLayer, bool exponential);
+
+        private:
+            // Shader of the two passes
+            Shader mShader;
+            // Framebuffer and empty vertex array for drawing the passes
+            unsigned int mFBO;
+            unsigned int mVAO;
+            // Result of the horizontal pass, and its size
+            unsigned int mTempTexture;
+            glm::ivec2 mTempSize;
+    };
+}
+
+#endif
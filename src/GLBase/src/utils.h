@@ -18,11 +18,85 @@ namespace GLUtils
         return (float)( std::rand() / (float)RAND_MAX );
     }
 
+    // Element of index (starting in 1) of the Halton sequence in a base, in the
+    // range [0,1)
+    inline float getHaltonSequence(unsigned int index, unsigned int base)
+    {
+        float result { 0.f };
+        float fraction { 1.f };
+        while (index > 0)
+        {
+            fraction /= (float)base;
+            result += fraction * (float)(index % base);
+            index /= base;
+        }
+        return result;
+    }
+
+    // Get the planes of the frustum of a view-projection matrix, as (normal, d)
+    // with the normals pointing inside and normalized
+    inline void getFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+    {
+        const glm::mat4 m { glm::transpose(viewProjection) };
+        planes[0] = m[3] + m[0];
+        planes[1] = m[3] - m[0];
+        planes[2] = m[3] + m[1];
+        planes[3] = m[3] - m[1];
+        planes[4] = m[3] + m[2];
+        planes[5] = m[3] - m[2];
+        for (int i = 0; i < 6; ++i)
+            planes[i] /= glm::length(glm::vec3(planes[i]));
+    }
+
+    // Check if a sphere intersects a frustum, given by its planes
+    inline bool sphereInFrustum(const glm::vec4 planes[6], const glm::vec3& center, float radius)
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // Fraction of the screen covered by the projection of a sphere, estimated
+    // from the radius of its projection, as an area in normalized device
+    // coordinates between 0 and 4. It is 4 if the camera is inside of it
+    inline float getSphereScreenCoverage(const glm::vec3& center, float radius,
+                                         const glm::vec3& cameraPosition, const glm::mat4& projection)
+    {
+        const float distance { glm::length(center - cameraPosition) };
+        if (distance <= radius)
+            return 4.f;
+        const float projectedRadius { radius * projection[1][1]
+                                      / glm::sqrt(distance * distance - radius * radius) };
+        return glm::min(glm::pi<float>() * projectedRadius * projectedRadius, 4.f);
+    }
+
+    // Check if the current OpenGL context supports an extension
+    inline bool hasExtension(const std::string& name)
+    {
+        int nrExtensions { 0 };
+        glGetIntegerv(GL_NUM_EXTENSIONS, &nrExtensions);
+        for (int i = 0; i < nrExtensions; ++i)
+        {
+            if (name == (const char*)glGetStringi(GL_EXTENSIONS, i))
+                return true;
+        }
+        return false;
+    }
+
     // Seed the random number generator with the clock
     inline void seedRandomGeneratorClock()
     {
         std::srand(static_cast<unsigned int>(std::time(nullptr))); 
     }
+
+    // Seed the random number generator with a value
+    inline void seedRandomGenerator(unsigned int seed)
+    {
+        std::srand(seed);
+    }
 }
 
 #endif
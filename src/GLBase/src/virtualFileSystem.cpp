@@ -0,0 +1,73 @@
+#include "GLBase.h"
+
+namespace GLBase
+{
+    // List of mounted archives
+    std::vector<std::unique_ptr<Archive>>& VirtualFileSystem::getArchives()
+    {
+        static std::vector<std::unique_ptr<Archive>> archives;
+        return archives;
+    }
+
+    // Method to mount an archive
+    bool VirtualFileSystem::mountArchive(const std::string& path)
+    {
+        std::unique_ptr<Archive> archive { new Archive() };
+        if (!archive->open(path))
+            return false;
+
+        getArchives().push_back(std::move(archive));
+        return true;
+    }
+
+    // Method to unmount all the archives
+    void VirtualFileSystem::unmountAll()
+    {
+        getArchives().clear();
+    }
+
+    // Method to check if a file exists in an archive or in the disk
+    bool VirtualFileSystem::exists(const std::string& path)
+    {
+        for (const auto& archive : getArchives())
+        {
+            if (archive->contains(path))
+                return true;
+        }
+
+        std::ifstream file(path, std::ios::binary);
+        return (bool)file;
+    }
+
+    // Method to read a whole file as binary data
+    bool VirtualFileSystem::readFile(const std::string& path, std::vector<unsigned char>& data)
+    {
+        // Look in the archives, starting with the last one mounted
+        const auto& archives { getArchives() };
+        for (auto it = archives.rbegin(); it != archives.rend(); ++it)
+        {
+            if ((*it)->read(path, data))
+                return true;
+        }
+
+        // Fall back to the disk
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+        const std::streamsize size { file.tellg() };
+        file.seekg(0, std::ios::beg);
+        data.resize(size);
+        return (bool)file.read(reinterpret_cast<char*>(data.data()), size);
+    }
+
+    // Method to read a whole file as text
+    bool VirtualFileSystem::readTextFile(const std::string& path, std::string& text)
+    {
+        std::vector<unsigned char> data;
+        if (!readFile(path, data))
+            return false;
+
+        text.assign(data.begin(), data.end());
+        return true;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef VIRTUALFILESYSTEM_H
+#define VIRTUALFILESYSTEM_H
+
+#include "GLBase.h"
+
+namespace GLBase
+{
+    class Archive;
+
+    // Layer used to read all the assets (shaders, textures, models).
+    // Files are looked up first in the mounted archives, in reverse order of
+    // mounting, and then in the disk.
+    // Paths are normalized before the lookup, so "../shaders/GLBase/a.glsl"
+    // is found as the entry "shaders/GLBase/a.glsl" of an archive.
+    class VirtualFileSystem
+    {
+        public:
+            // Method to mount an archive. Returns false if it cannot be opened
+            static bool mountArchive(const std::string& path);
+            // Method to unmount all the archives
+            static void unmountAll();
+
+            // Method to check if a file exists in an archive or in the disk
+            static bool exists(const std::string& path);
+
+            // Method to read a whole file as binary data
+            static bool readFile(const std::string& path, std::vector<unsigned char>& data);
+            // Method to read a whole file as text
+            static bool readTextFile(const std::string& path, std::string& text);
+
+        private:
+            // List of mounted archives
+            static std::vector<std::unique_ptr<Archive>>& getArchives();
+    };
+}
+
+#endif
@@ -0,0 +1,670 @@
+// Benchmark of whole frames of GLBase::DeferredRenderer, rendering scenes built
+// from parameters along a scripted camera path.
+// Each scene has a floor with a grid of objects, which are GLGeometry
+// primitives or instances of a model, a directional light, and point and spot
+// lights placed over the objects. The camera follows a closed Catmull-Rom
+// spline around the scene, advanced by the index of the frame and not by the
+// time, so every run renders the same frames. The times and counters of each
+// frame are written to a JSON file.
+//
+// Usage:
+//      bench [options]
+//
+// Options:
+//      -s, --scenario <name>       Preset of the runs (default: default):
+//                                      default     a single run with the options
+//                                      objects     64, 256, 1024 and 4096 objects
+//                                      lights      16, 64, 256 and 1024 point lights
+//                                      resolution  960x540, 1280x720, 1920x1080
+//                                                  and 2560x1440
+//      -f, --frames <n>            Frames recorded in each run (default: 300)
+//      --warmup <n>                Frames rendered before them (default: 30)
+//      -o, --objects <n>           Objects over the floor (default: 64)
+//      -p, --point-lights <n>      Point lights, at most 32 with the fullscreen
+//                                  lighting (default: 32)
+//      -l, --spot-lights <n>       Spot lights, at most 32 (default: 4)
+//      -m, --model <path>          Draw instances of a model instead of the
+//                                  primitives. They do not cast shadows
+//      --width <n>, --height <n>   Resolution (default: 1280x720)
+//      --shadows <none|sun|all>    Lights that cast shadows (default: all)
+//      --point-shadows <n>         Point lights with shadows in each frame (default: 4)
+//      --shadow-resolution <n>     Resolution of the shadow maps of the
+//                                  directional light (default: 2048)
+//      --cascades <n>              Cascades of the directional light (default: 4)
+//      --lighting <mode>           fullscreen, volumes or clustered (default: clustered).
+//                                  The lights scenario cannot use fullscreen
+//      --seed <n>                  Seed of the placement of the objects and lights
+//      --windowed                  Render to a window instead of offscreen
+//      --output <path>             JSON file with the results (default: bench.json)
+//
+// For each frame, the CPU time until the commands are submitted, the time of
+// the whole frame including the swap, the GPU time of the frame and its passes
+// and the counters of GLBase::RenderStats are written. The GPU times are read
+// without waiting, and the ones of the frames that are dropped by the profiler
+// are null. In headless mode the swap waits for the GPU, so the frame time
+// includes the GPU time.
+
+#include "GLBase.h"
+#include "GLGeometry.h"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace GLBase;
+using namespace GLGeometry;
+
+// Lights that cast shadows
+enum ShadowSetting
+{
+    SHADOWS_NONE,
+    SHADOWS_SUN,
+    SHADOWS_ALL
+};
+
+// Options of the benchmark
+struct BenchmarkOptions
+{
+    std::string scenario { "default" };
+    unsigned int frames { 300 };
+    unsigned int warmupFrames { 30 };
+    unsigned int objects { 64 };
+    unsigned int pointLights { 32 };
+    unsigned int spotLights { 4 };
+    std::string model;
+    int width { 1280 };
+    int height { 720 };
+    ShadowSetting shadows { SHADOWS_ALL };
+    unsigned int pointShadows { 4 };
+    int shadowResolution { 2048 };
+    unsigned int cascades { 4 };
+    LightingMode lightingMode { LIGHTING_CLUSTERED };
+    unsigned int seed { 1234 };
+    bool headless { true };
+    std::string output { "bench.json" };
+};
+
+// Parameters of a run, which change between the runs of a scenario
+struct RunConfig
+{
+    std::string name;
+    unsigned int objects;
+    unsigned int pointLights;
+    unsigned int spotLights;
+    int width;
+    int height;
+};
+
+// Objects and lights of a scene
+struct Scene
+{
+    // Floor and primitives, which cast shadows
+    std::vector<GLElemObject*> objects;
+    // Model matrices of the instances of the model
+    std::vector<glm::mat4> modelInstances;
+    std::vector<Light*> lights;
+    std::vector<Light*> shadowLights;
+    // Half of the size of the area with objects
+    float halfSize;
+};
+
+// Times and counters of a frame
+struct FrameResult
+{
+    double cpuMs;
+    double frameMs;
+    // Negative if the profiler dropped the frame
+    double gpuMs;
+    std::vector<std::pair<std::string, double>> passes;
+    std::uint64_t counters[NR_RENDER_STATS];
+};
+
+// Names of the passes, measured by the GPU profiler
+static const char* PASS_NAMES[] { "Shadow maps", "Geometry", "Lighting", "Present" };
+// Size of the arrays of spot and point lights in the shader of the fullscreen
+// lighting pass
+static const int NR_MAX_SHADER_LIGHTS { 32 };
+
+// Print the usage of the benchmark
+static void printUsage()
+{
+    std::cout << "Usage: bench [-s default|objects|lights|resolution] [-f frames] [--warmup frames]\n"
+                 "             [-o objects] [-p point-lights] [-l spot-lights] [-m model]\n"
+                 "             [--width w] [--height h] [--shadows none|sun|all] [--point-shadows n]\n"
+                 "             [--shadow-resolution n] [--cascades n] [--lighting fullscreen|volumes|clustered]\n"
+                 "             [--seed n] [--windowed] [--output path]\n";
+}
+
+// Parse the command line options
+static bool parseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+    // The numbers that cannot be converted are invalid options
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg { argv[i] };
+            const bool hasValue { i + 1 < argc };
+            if ((arg == "-s" || arg == "--scenario") && hasValue)
+            {
+                options.scenario = argv[++i];
+                if (options.scenario != "default" && options.scenario != "objects" &&
+                    options.scenario != "lights" && options.scenario != "resolution")
+                    return false;
+            }
+            else if ((arg == "-f" || arg == "--frames") && hasValue)
+                options.frames = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--warmup" && hasValue)
+                options.warmupFrames = std::max(0, std::stoi(argv[++i]));
+            else if ((arg == "-o" || arg == "--objects") && hasValue)
+                options.objects = std::max(0, std::stoi(argv[++i]));
+            else if ((arg == "-p" || arg == "--point-lights") && hasValue)
+                options.pointLights = std::max(0, std::stoi(argv[++i]));
+            else if ((arg == "-l" || arg == "--spot-lights") && hasValue)
+                options.spotLights = std::min(NR_MAX_SHADER_LIGHTS, std::max(0, std::stoi(argv[++i])));
+            else if ((arg == "-m" || arg == "--model") && hasValue)
+                options.model = argv[++i];
+            else if (arg == "--width" && hasValue)
+                options.width = std::max(64, std::stoi(argv[++i]));
+            else if (arg == "--height" && hasValue)
+                options.height = std::max(64, std::stoi(argv[++i]));
+            else if (arg == "--shadows" && hasValue)
+            {
+                const std::string value { argv[++i] };
+                if (value == "none")
+                    options.shadows = SHADOWS_NONE;
+                else if (value == "sun")
+                    options.shadows = SHADOWS_SUN;
+                else if (value == "all")
+                    options.shadows = SHADOWS_ALL;
+                else
+                    return false;
+            }
+            else if (arg == "--point-shadows" && hasValue)
+                options.pointShadows = std::max(0, std::stoi(argv[++i]));
+            else if (arg == "--shadow-resolution" && hasValue)
+                options.shadowResolution = std::max(64, std::stoi(argv[++i]));
+            else if (arg == "--cascades" && hasValue)
+                options.cascades = std::min(5, std::max(1, std::stoi(argv[++i])));
+            else if (arg == "--lighting" && hasValue)
+            {
+                const std::string value { argv[++i] };
+                if (value == "fullscreen")
+                    options.lightingMode = LIGHTING_FULLSCREEN;
+                else if (value == "volumes")
+                    options.lightingMode = LIGHTING_VOLUMES;
+                else if (value == "clustered")
+                    options.lightingMode = LIGHTING_CLUSTERED;
+                else
+                    return false;
+            }
+            else if (arg == "--seed" && hasValue)
+                options.seed = (unsigned int)std::stoul(argv[++i]);
+            else if (arg == "--windowed")
+                options.headless = false;
+            else if (arg == "--output" && hasValue)
+                options.output = argv[++i];
+            else
+                return false;
+        }
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+
+    // The fullscreen lighting pass only has space for a few point lights in
+    // its shader, so it cannot go through the lights scenario
+    if (options.lightingMode == LIGHTING_FULLSCREEN)
+    {
+        if (options.scenario == "lights")
+        {
+            std::cout << "ERROR::BENCH::INVALID_OPTIONS: the lights scenario needs volumes or "
+                         "clustered lighting" << '\n';
+            return false;
+        }
+        options.pointLights = std::min(options.pointLights, (unsigned int)NR_MAX_SHADER_LIGHTS);
+    }
+    return true;
+}
+
+// Build the runs of the scenario, changing one parameter of the options
+static std::vector<RunConfig> buildRuns(const BenchmarkOptions& options)
+{
+    const RunConfig base { "default", options.objects, options.pointLights, options.spotLights,
+                           options.width, options.height };
+    std::vector<RunConfig> runs;
+    if (options.scenario == "objects")
+    {
+        for (unsigned int objects : { 64u, 256u, 1024u, 4096u })
+        {
+            runs.push_back(base);
+            runs.back().name = "objects-" + std::to_string(objects);
+            runs.back().objects = objects;
+        }
+    }
+    else if (options.scenario == "lights")
+    {
+        for (unsigned int lights : { 16u, 64u, 256u, 1024u })
+        {
+            runs.push_back(base);
+            runs.back().name = "lights-" + std::to_string(lights);
+            runs.back().pointLights = lights;
+        }
+    }
+    else if (options.scenario == "resolution")
+    {
+        for (const glm::ivec2& size : { glm::ivec2(960, 540), glm::ivec2(1280, 720),
+                                        glm::ivec2(1920, 1080), glm::ivec2(2560, 1440) })
+        {
+            runs.push_back(base);
+            runs.back().name = "resolution-" + std::to_string(size.x) + "x" + std::to_string(size.y);
+            runs.back().width = size.x;
+            runs.back().height = size.y;
+        }
+    }
+    else
+        runs.push_back(base);
+    return runs;
+}
+
+// Build the scene of a run. The objects are in a grid over the floor, with
+// random offsets, and the lights are placed randomly over them
+static Scene buildScene(const RunConfig& config, const BenchmarkOptions& options, bool useModel)
+{
+    std::mt19937 generator { options.seed };
+    std::uniform_real_distribution<float> random(0.f, 1.f);
+
+    Scene scene;
+    const unsigned int side { (unsigned int)std::ceil(std::sqrt((float)std::max(1u, config.objects))) };
+    const float spacing { 3.5f };
+    scene.halfSize = 0.5f * spacing * side + 2.f;
+
+    scene.objects.push_back(new GLQuad());
+    scene.objects.back()->setModelMatrix(glm::vec3(0., -1., 0.), -90., glm::vec3(1., 0., 0.),
+                                         glm::vec3(2.f * scene.halfSize + 10.f));
+    for (unsigned int i = 0; i < config.objects; ++i)
+    {
+        const glm::vec3 position { spacing * ((i % side) + 0.5f) - 0.5f * spacing * side +
+                                       spacing * 0.3f * (random(generator) - 0.5f),
+                                   0.f,
+                                   spacing * ((i / side) + 0.5f) - 0.5f * spacing * side +
+                                       spacing * 0.3f * (random(generator) - 0.5f) };
+        const float angle { 360.f * random(generator) };
+        if (useModel)
+        {
+            glm::mat4 model { glm::translate(glm::mat4(1.f), position) };
+            model = glm::rotate(model, glm::radians(angle), glm::vec3(0.f, 1.f, 0.f));
+            scene.modelInstances.push_back(model);
+            continue;
+        }
+        GLElemObject* object;
+        switch (i % 4)
+        {
+            case 0: object = new GLCube(); break;
+            case 1: object = new GLSphere(16); break;
+            case 2: object = new GLCylinder(32); break;
+            default: object = new GLCone(32); break;
+        }
+        object->setModelMatrix(position, angle, glm::vec3(0., 1., 0.), glm::vec3(2., 2., 2.));
+        scene.objects.push_back(object);
+    }
+
+    scene.lights.push_back(new DirectionalLight( {1., 1., 1.}, {10., 10., 10.}, {-1., -1., -1.},
+                                                 0.5f, 0.f, 0.f, options.shadowResolution, options.cascades) );
+    if (options.shadows != SHADOWS_NONE)
+        scene.shadowLights.push_back(scene.lights.back());
+    for (unsigned int i = 0; i < config.pointLights; ++i)
+    {
+        scene.lights.push_back(new PointLight( {random(generator), random(generator), random(generator)},
+                                               {scene.halfSize * (2.f * random(generator) - 1.f),
+                                                0.5f + 3.f * random(generator),
+                                                scene.halfSize * (2.f * random(generator) - 1.f)},
+                                               0.5f, 0.1f, 0.2f ) );
+        if (options.shadows == SHADOWS_ALL)
+            scene.shadowLights.push_back(scene.lights.back());
+    }
+    for (unsigned int i = 0; i < config.spotLights; ++i)
+    {
+        scene.lights.push_back(new SpotLight( {random(generator), random(generator), random(generator)},
+                                              {scene.halfSize * (2.f * random(generator) - 1.f),
+                                               4.f + 2.f * random(generator),
+                                               scene.halfSize * (2.f * random(generator) - 1.f)},
+                                              {0., -1., 0.}, 25.f, 40.f, 3.f, 0.05f, 0.1f ) );
+        if (options.shadows == SHADOWS_ALL)
+            scene.shadowLights.push_back(scene.lights.back());
+    }
+
+    return scene;
+}
+
+// Delete the objects and lights of a scene
+static void destroyScene(Scene& scene)
+{
+    for (Light* light : scene.lights)
+        delete light;
+    for (GLElemObject* object : scene.objects)
+        delete object;
+    scene = Scene();
+}
+
+// Point of a closed Catmull-Rom spline through some points, with the
+// parameter between 0 and 1 going once around it
+static glm::vec3 evaluateSpline(const std::vector<glm::vec3>& points, float t)
+{
+    const unsigned int nrPoints { (unsigned int)points.size() };
+    const float position { (t - std::floor(t)) * nrPoints };
+    const unsigned int segment { std::min((unsigned int)position, nrPoints - 1) };
+    const float s { position - segment };
+    const glm::vec3& p0 { points[(segment + nrPoints - 1) % nrPoints] };
+    const glm::vec3& p1 { points[segment] };
+    const glm::vec3& p2 { points[(segment + 1) % nrPoints] };
+    const glm::vec3& p3 { points[(segment + 2) % nrPoints] };
+    return 0.5f * (2.f * p1 + (p2 - p0) * s + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * s * s +
+                   (3.f * p1 - p0 - 3.f * p2 + p3) * s * s * s);
+}
+
+// Build the control points of the path of the camera and of the point it
+// looks at. The camera goes around the scene, closer and farther from it and
+// at different heights, looking at points near the center
+static void buildCameraPath(const Scene& scene, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& targets)
+{
+    const unsigned int nrPoints { 8 };
+    for (unsigned int i = 0; i < nrPoints; ++i)
+    {
+        const float angle { glm::two_pi<float>() * i / nrPoints };
+        const float radius { scene.halfSize * (i % 2 == 0 ? 1.1f : 0.6f) + 4.f };
+        positions.push_back({ radius * std::cos(angle), 2.f + 2.f * (i % 3), radius * std::sin(angle) });
+        targets.push_back({ 0.3f * scene.halfSize * std::cos(angle + 1.f), 0.f,
+                            0.3f * scene.halfSize * std::sin(angle + 1.f) });
+    }
+}
+
+// Render a run, and get the results of its frames
+static std::vector<FrameResult> runScene(const RunConfig& config, const BenchmarkOptions& options,
+                                         Application& application, Model* model)
+{
+    Scene scene { buildScene(config, options, model != nullptr) };
+    std::vector<glm::vec3> pathPositions;
+    std::vector<glm::vec3> pathTargets;
+    buildCameraPath(scene, pathPositions, pathTargets);
+
+    Camera camera(config.width, config.height);
+    camera.setFrustum(0.1f, 4.f * scene.halfSize + 20.f);
+    GLCubemap skymap;
+
+    DeferredRenderer renderer(config.width, config.height, 1.f);
+    renderer.configureLights(scene.lights);
+    renderer.setLightingMode(options.lightingMode);
+    renderer.setPointShadows(options.pointShadows);
+    Shader gPassShader(EMBEDDED_SHADER, "GLBase/defGeometryPassVertex.glsl",
+                       "GLBase/defGeometryPassFragment.glsl");
+    renderer.configureGeometryShader(gPassShader);
+
+    std::vector<Material> materials;
+    materials.push_back(Material( {1., 1., 0.}, 1.0 ));
+    materials.push_back(Material( {1., 0., 0.}, 1.0 ));
+    materials.push_back(Material( {0., 0., 1.}, 0.5 ));
+    materials.push_back(Material( {0., 1., 1.}, 0.2 ));
+
+    // The ring of the profiler is deeper than the default, so it does not
+    // drop frames when the GPU falls behind
+    const unsigned int nrFrames { options.warmupFrames + options.frames };
+    GPUProfiler profiler(8, nrFrames + 1);
+    renderer.setGPUProfiler(&profiler);
+
+    std::vector<FrameResult> results;
+    results.reserve(options.frames);
+    for (unsigned int frame = 0; frame < nrFrames; ++frame)
+    {
+        const auto start { std::chrono::steady_clock::now() };
+        profiler.beginFrame();
+        renderer.startFrame();
+
+        // The camera stays at the start of the path during the warmup
+        const float t { frame < options.warmupFrames ? 0.f
+                        : (float)(frame - options.warmupFrames) / options.frames };
+        camera.Position = evaluateSpline(pathPositions, t);
+        camera.lookAt(evaluateSpline(pathTargets, t));
+        glm::mat4 view { camera.getViewMatrix() };
+        glm::mat4 projection { camera.getProjectionMatrix() };
+        skymap.setViewProjection(view, projection);
+        renderer.setViewProjection(view, projection);
+        renderer.updateLightVisibility(scene.lights);
+
+        {
+            GPUProfileScope scope(&profiler, PASS_NAMES[0]);
+            if (!scene.shadowLights.empty())
+                renderer.computeShadowMaps(camera, scene.shadowLights, scene.objects);
+        }
+        {
+            GPUProfileScope scope(&profiler, PASS_NAMES[1]);
+            renderer.startGeometryPass();
+            gPassShader.use();
+            gPassShader.setMat4("view", view);
+            gPassShader.setMat4("projection", projection);
+            for (unsigned int i = 0; i < scene.objects.size(); ++i)
+            {
+                gPassShader.setMat4("model", scene.objects[i]->getModelMatrix());
+                materials[i % materials.size()].configShader(gPassShader);
+                scene.objects[i]->draw();
+            }
+            for (unsigned int i = 0; i < scene.modelInstances.size(); ++i)
+            {
+                gPassShader.setMat4("model", scene.modelInstances[i]);
+                materials[i % materials.size()].configShader(gPassShader);
+                model->draw(gPassShader);
+            }
+        }
+        {
+            GPUProfileScope scope(&profiler, PASS_NAMES[2]);
+            renderer.processGBuffer(camera.Position, scene.lights);
+        }
+        {
+            GPUProfileScope scope(&profiler, PASS_NAMES[3]);
+            renderer.endFrame(&skymap);
+        }
+        profiler.endFrame();
+        const auto submitted { std::chrono::steady_clock::now() };
+        application.updateWindow();
+        const auto end { std::chrono::steady_clock::now() };
+
+        const double frameMs { std::chrono::duration<double, std::milli>(end - start).count() };
+        RenderStats::endFrame(frameMs);
+        if (frame < options.warmupFrames)
+            continue;
+        FrameResult result;
+        result.cpuMs = std::chrono::duration<double, std::milli>(submitted - start).count();
+        result.frameMs = frameMs;
+        result.gpuMs = -1.;
+        for (unsigned int i = 0; i < NR_RENDER_STATS; ++i)
+            result.counters[i] = RenderStats::get((RenderStat)i);
+        results.push_back(result);
+    }
+
+    // Wait for the GPU, and read the frames still in flight starting an empty
+    // one. The frames of the profiler are numbered from the first one
+    glFinish();
+    profiler.beginFrame();
+    profiler.endFrame();
+    for (const GPUProfileFrame& frame : profiler.getHistory())
+    {
+        if (frame.index < options.warmupFrames || frame.index >= nrFrames)
+            continue;
+        FrameResult& result { results[frame.index - options.warmupFrames] };
+        result.gpuMs = frame.gpuEndMs - frame.gpuStartMs;
+        for (const auto& scope : frame.scopes)
+        {
+            if (scope.depth == 0)
+                result.passes.push_back({ scope.name, scope.gpuEndMs - scope.gpuStartMs });
+        }
+    }
+    if (profiler.getNrDroppedFrames() > 0)
+        std::cout << "The GPU times of " << profiler.getNrDroppedFrames() << " frames were dropped\n";
+
+    renderer.setGPUProfiler(nullptr);
+    destroyScene(scene);
+    return results;
+}
+
+// Mean of some values, skipping the negative ones
+static double getMean(const std::vector<double>& values)
+{
+    double sum { 0. };
+    unsigned int count { 0 };
+    for (double value : values)
+    {
+        if (value < 0.)
+            continue;
+        sum += value;
+        ++count;
+    }
+    return count > 0 ? sum / count : -1.;
+}
+
+// Percentile of some values with the nearest rank, skipping the negative ones
+static double getPercentile(std::vector<double> values, double percentile)
+{
+    values.erase(std::remove_if(values.begin(), values.end(), [](double value) { return value < 0.; }),
+                 values.end());
+    if (values.empty())
+        return -1.;
+    std::sort(values.begin(), values.end());
+    const size_t rank { (size_t)std::ceil(percentile / 100. * values.size()) };
+    return values[std::min(values.size(), std::max<size_t>(1, rank)) - 1];
+}
+
+// Write a time, which is null if it is negative
+static void writeTime(std::ostream& out, double time)
+{
+    if (time < 0.)
+        out << "null";
+    else
+        out << time;
+}
+
+// Write the results of a run as an object of JSON
+static void writeRun(std::ostream& out, const RunConfig& config, const BenchmarkOptions& options,
+                     const std::vector<FrameResult>& results)
+{
+    std::vector<double> cpuTimes;
+    std::vector<double> frameTimes;
+    std::vector<double> gpuTimes;
+    for (const FrameResult& result : results)
+    {
+        cpuTimes.push_back(result.cpuMs);
+        frameTimes.push_back(result.frameMs);
+        gpuTimes.push_back(result.gpuMs);
+    }
+
+    const char* shadows[] { "none", "sun", "all" };
+    out << "{\"name\":\"" << config.name << "\",\"width\":" << config.width << ",\"height\":" << config.height
+        << ",\"objects\":" << config.objects << ",\"model\":" << (options.model.empty() ? "false" : "true")
+        << ",\"pointLights\":" << config.pointLights << ",\"spotLights\":" << config.spotLights
+        << ",\"shadows\":\"" << shadows[options.shadows] << "\",\"pointShadows\":" << options.pointShadows
+        << ",\"shadowResolution\":" << options.shadowResolution << ",\"cascades\":" << options.cascades
+        << ",\"frames\":" << results.size() << ",\n\"summary\":{";
+    out << "\"cpuMsMean\":";
+    writeTime(out, getMean(cpuTimes));
+    out << ",\"frameMsMean\":";
+    writeTime(out, getMean(frameTimes));
+    out << ",\"gpuMsMean\":";
+    writeTime(out, getMean(gpuTimes));
+    for (double percentile : { 50., 95., 99. })
+    {
+        out << ",\"frameMsP" << (int)percentile << "\":";
+        writeTime(out, getPercentile(frameTimes, percentile));
+        out << ",\"gpuMsP" << (int)percentile << "\":";
+        writeTime(out, getPercentile(gpuTimes, percentile));
+    }
+    out << "},\n\"frames\":[";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const FrameResult& result { results[i] };
+        out << (i == 0 ? "\n" : ",\n") << "{\"frame\":" << i << ",\"cpuMs\":" << result.cpuMs
+            << ",\"frameMs\":" << result.frameMs << ",\"gpuMs\":";
+        writeTime(out, result.gpuMs);
+        out << ",\"passes\":{";
+        for (size_t pass = 0; pass < result.passes.size(); ++pass)
+        {
+            out << (pass == 0 ? "" : ",") << '"' << result.passes[pass].first << "\":"
+                << result.passes[pass].second;
+        }
+        out << '}';
+        for (unsigned int stat = 0; stat < NR_RENDER_STATS; ++stat)
+            out << ",\"" << RenderStats::getName((RenderStat)stat) << "\":" << result.counters[stat];
+        out << '}';
+    }
+    out << "\n]}";
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+    const std::vector<RunConfig> runs { buildRuns(options) };
+
+    // The context is created with the largest resolution of the runs, and each
+    // one renders to the bottom left corner of the default framebuffer
+    int width { 0 };
+    int height { 0 };
+    for (const RunConfig& run : runs)
+    {
+        width = std::max(width, run.width);
+        height = std::max(height, run.height);
+    }
+    Application application(width, height, "Benchmark", options.headless);
+    // Do not wait for the vertical synchronization in the window
+    if (!application.isHeadless())
+        glfwSwapInterval(0);
+
+    Model* model { options.model.empty() ? nullptr : new Model(options.model) };
+
+    std::ofstream file(options.output);
+    if (!file)
+    {
+        std::cout << "ERROR::BENCH::FILE_NOT_WRITTEN: " << options.output << '\n';
+        return 1;
+    }
+    file << std::fixed << std::setprecision(4);
+    file << "{\"scenario\":\"" << options.scenario << "\",\"headless\":" << (application.isHeadless() ? "true" : "false")
+         << ",\"renderer\":\"" << (const char*)glGetString(GL_RENDERER) << "\",\"seed\":" << options.seed
+         << ",\"runs\":[\n";
+
+    std::cout << "Scenario: " << options.scenario << ", frames: " << options.frames
+              << (application.isHeadless() ? ", headless" : ", windowed") << "\n\n";
+    std::cout << std::setw(24) << "run" << std::setw(12) << "CPU ms" << std::setw(12) << "frame ms"
+              << std::setw(12) << "GPU ms" << std::setw(12) << "p99 ms" << std::setw(10) << "draws" << '\n';
+    for (size_t i = 0; i < runs.size(); ++i)
+    {
+        const std::vector<FrameResult> results { runScene(runs[i], options, application, model) };
+        file << (i == 0 ? "" : ",\n");
+        writeRun(file, runs[i], options, results);
+
+        std::vector<double> cpuTimes;
+        std::vector<double> frameTimes;
+        std::vector<double> gpuTimes;
+        for (const FrameResult& result : results)
+        {
+            cpuTimes.push_back(result.cpuMs);
+            frameTimes.push_back(result.frameMs);
+            gpuTimes.push_back(result.gpuMs);
+        }
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::setw(24) << runs[i].name
+                  << std::setw(12) << getMean(cpuTimes)
+                  << std::setw(12) << getMean(frameTimes)
+                  << std::setw(12) << getMean(gpuTimes)
+                  << std::setw(12) << getPercentile(frameTimes, 99.)
+                  << std::setw(10) << results.back().counters[RENDER_STAT_DRAW_CALLS] << '\n';
+    }
+    file << "\n]}\n";
+    std::cout << "\nResults written to " << options.output << '\n';
+
+    delete model;
+
+    return 0;
+}
@@ -0,0 +1,182 @@
+// Benchmark of the paths that render the cascades of the directional lights
+// in GLBase::DeferredRenderer. The same shadow maps are rendered with a
+// geometry shader, which copies each triangle to the layers of the cascades,
+// and with the layer written by the vertex shader, drawing one instance of
+// each object for each cascade that it touches.
+//
+// Usage:
+//      cascadeShadowBenchmark [options]
+//
+// Options:
+//      -f, --frames <n>        Frames timed for each path (default: 200)
+//      -o, --objects <n>       Objects in each side of the grid (default: 20)
+//      -c, --cascades <n>      Levels of the cascade, at most 5, which are the
+//                              invocations of the geometry shader (default: 4)
+//      -r, --resolution <n>    Resolution of the shadow map (default: 2048)
+//
+// All the cascades are rendered in every frame, without staggering. The GPU
+// time is measured with a timer query around the shadow pass, and the CPU
+// time includes the culling of the objects against each cascade.
+
+#include "GLBase.h"
+#include "GLGeometry.h"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace GLBase;
+using namespace GLGeometry;
+
+// Options of the benchmark
+struct BenchmarkOptions
+{
+    unsigned int frames { 200 };
+    unsigned int objects { 20 };
+    unsigned int cascades { 4 };
+    int resolution { 2048 };
+};
+
+// Results of a path
+struct PathResult
+{
+    double gpuMs;
+    double cpuMs;
+};
+
+// Print the usage of the benchmark
+static void printUsage()
+{
+    std::cout << "Usage: cascadeShadowBenchmark [-f frames] [-o objects] [-c cascades] "
+                 "[-r resolution]\n";
+}
+
+// Parse the command line options
+static bool parseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg { argv[i] };
+        const bool hasValue { i + 1 < argc };
+        if ((arg == "-f" || arg == "--frames") && hasValue)
+            options.frames = std::max(1, std::stoi(argv[++i]));
+        else if ((arg == "-o" || arg == "--objects") && hasValue)
+            options.objects = std::max(1, std::stoi(argv[++i]));
+        else if ((arg == "-c" || arg == "--cascades") && hasValue)
+            options.cascades = std::min(5, std::max(1, std::stoi(argv[++i])));
+        else if ((arg == "-r" || arg == "--resolution") && hasValue)
+            options.resolution = std::max(64, std::stoi(argv[++i]));
+        else
+            return false;
+    }
+    return true;
+}
+
+// Render the shadow maps with a path, and measure them
+static PathResult runPath(CascadeRenderPath path, const BenchmarkOptions& options, Application& application,
+                          DeferredRenderer& renderer, Camera& camera, const std::vector<Light*>& lights,
+                          const std::vector<GLElemObject*>& objects)
+{
+    renderer.setCascadeRenderPath(path);
+
+    unsigned int query;
+    glGenQueries(1, &query);
+
+    // The first frames are not timed, so the shaders are ready
+    const unsigned int warmupFrames { 10 };
+    GLuint64 gpuTime { 0 };
+    double cpuTime { 0. };
+    for (unsigned int frame = 0; frame < warmupFrames + options.frames; ++frame)
+    {
+        const auto start { std::chrono::steady_clock::now() };
+        glBeginQuery(GL_TIME_ELAPSED, query);
+        renderer.computeShadowMaps(camera, lights, objects);
+        glEndQuery(GL_TIME_ELAPSED);
+        const auto end { std::chrono::steady_clock::now() };
+        application.updateWindow();
+
+        // Wait for the result, so the next frame does not overwrite it
+        GLuint64 time;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &time);
+        if (frame >= warmupFrames)
+        {
+            gpuTime += time;
+            cpuTime += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+    }
+
+    glDeleteQueries(1, &query);
+
+    return { gpuTime * 1e-6 / options.frames, cpuTime / options.frames };
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const int width { 1280 };
+    const int height { 720 };
+    Application application(width, height, "Cascade shadow benchmark");
+    Camera camera(width, height, glm::vec3(0.f, 4.f, 8.f), glm::vec3(0.f, 1.f, 0.f), -90.f, -10.f);
+
+    // Grid of objects in front of the camera, over a floor, so the far
+    // cascades contain many more objects than the near ones
+    std::vector<GLElemObject*> objects;
+    objects.push_back(new GLQuad());
+    objects.back()->setModelMatrix(glm::vec3(0., -1., -45.), -90., glm::vec3(1., 0., 0.),
+                                   glm::vec3(100., 100., 100.));
+    const float spacing { 90.f / options.objects };
+    for (unsigned int i = 0; i < options.objects * options.objects; ++i)
+    {
+        GLElemObject* object;
+        switch (i % 4)
+        {
+            case 0: object = new GLCube(); break;
+            case 1: object = new GLSphere(16); break;
+            case 2: object = new GLCylinder(32); break;
+            default: object = new GLCone(32); break;
+        }
+        object->setModelMatrix(glm::vec3(spacing * (i % options.objects) - 45., 0.,
+                                         -spacing * (i / options.objects)),
+                               0., glm::vec3(1., 0., 0.), glm::vec3(1.5, 1.5, 1.5));
+        objects.push_back(object);
+    }
+
+    DirectionalLight* light { new DirectionalLight( {1., 1., 1.}, {10., 10., 10.}, {-1., -1., -1.},
+                                                    0.5f, 0.f, 0.f, options.resolution, options.cascades) };
+    light->setStaggeredCascades(false);
+    const std::vector<Light*> lights { light };
+
+    DeferredRenderer renderer(width, height, 1.f);
+    renderer.configureLights(lights);
+    const bool vertexLayerSupported { renderer.getCascadeRenderPath() == CASCADES_VERTEX_LAYER };
+
+    std::cout << "Objects: " << objects.size() << ", cascades: " << options.cascades
+              << ", resolution: " << options.resolution << ", frames: " << options.frames << "\n\n";
+    std::cout << std::setw(18) << "path" << std::setw(12) << "GPU ms" << std::setw(12) << "CPU ms" << '\n';
+
+    for (CascadeRenderPath path : { CASCADES_GEOMETRY_SHADER, CASCADES_VERTEX_LAYER })
+    {
+        const char* name { path == CASCADES_GEOMETRY_SHADER ? "geometry shader" : "vertex layer" };
+        if (path == CASCADES_VERTEX_LAYER && !vertexLayerSupported)
+        {
+            std::cout << std::setw(18) << name << "  not supported by this context\n";
+            continue;
+        }
+        const PathResult result { runPath(path, options, application, renderer, camera, lights, objects) };
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::setw(18) << name
+                  << std::setw(12) << result.gpuMs
+                  << std::setw(12) << result.cpuMs << '\n';
+    }
+
+    delete light;
+    for (GLElemObject* object : objects)
+        delete object;
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+// Benchmark of the assignment of lights to clusters done by
+// GLBase::ClusteredLights, sweeping the number of lights.
+//
+// Usage:
+//      clusteredLightsBenchmark [options]
+//
+// Options:
+//      -t, --threads <n>       Number of threads (default: one per core)
+//      -i, --iterations <n>    Assignments timed for each light count (default: 50)
+//      --spots <fraction>      Fraction of spot lights (default: 0.2)
+//      --verify                Check that every light is in the clusters of
+//                              random points inside its volume
+//
+// The lights are placed randomly in a box in front of the camera, with the
+// same frustum as the default camera of GLBase. This does not need an OpenGL
+// context, since only the CPU assignment is measured.
+
+#include "GLBase.h"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace GLBase;
+
+// Options of the benchmark
+struct BenchmarkOptions
+{
+    unsigned int threads { 0 };
+    unsigned int iterations { 50 };
+    float spotFraction { 0.2f };
+    bool verify { false };
+};
+
+// Get the current time in milliseconds
+static double getTimeMs()
+{
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Print the usage of the benchmark
+static void printUsage()
+{
+    std::cout << "Usage: clusteredLightsBenchmark [-t threads] [-i iterations] "
+                 "[--spots fraction] [--verify]\n";
+}
+
+// Parse the command line options
+static bool parseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg { argv[i] };
+        const bool hasValue { i + 1 < argc };
+        if ((arg == "-t" || arg == "--threads") && hasValue)
+            options.threads = std::stoi(argv[++i]);
+        else if ((arg == "-i" || arg == "--iterations") && hasValue)
+            options.iterations = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--spots" && hasValue)
+            options.spotFraction = std::stof(argv[++i]);
+        else if (arg == "--verify")
+            options.verify = true;
+        else
+            return false;
+    }
+    return true;
+}
+
+// Create random lights in front of the camera, which looks along -z from the origin
+static std::vector<ClusterLight> createLights(unsigned int count, float spotFraction, std::mt19937& generator)
+{
+    std::uniform_real_distribution<float> random(0.f, 1.f);
+    std::vector<ClusterLight> lights(count);
+    int spotIndex { 0 };
+    for (ClusterLight& light : lights)
+    {
+        light.position = glm::vec3(80.f * random(generator) - 40.f, 20.f * random(generator) - 10.f,
+                                   -90.f * random(generator));
+        light.radius = 1.f + 4.f * random(generator);
+        light.color = glm::vec3(random(generator), random(generator), random(generator));
+        light.intensity = 1.f;
+        light.kLinear = 0.1f;
+        light.kQuadratic = 0.1f;
+        light.spotIndex = -1;
+        light.shadowSlot = -1;
+        light.cosAngleInner = -1.f;
+        light.cosAngleOuter = -1.f;
+        light.direction = glm::vec3(0.f, -1.f, 0.f);
+        if (random(generator) < spotFraction)
+        {
+            const float angleOuter { glm::radians(10.f + 60.f * random(generator)) };
+            light.cosAngleOuter = glm::cos(angleOuter);
+            light.cosAngleInner = glm::cos(0.5f * angleOuter);
+            light.direction = glm::normalize(glm::vec3(random(generator) - 0.5f, random(generator) - 0.5f,
+                                                       random(generator) - 0.5f));
+            light.spotIndex = spotIndex++;
+        }
+    }
+    return lights;
+}
+
+// Check that each light is in the cluster of random points inside its volume
+// and inside the frustum, computing the cluster as the lighting shader does.
+// Returns the number of points whose cluster misses the light
+static unsigned int verifyAssignment(const std::vector<ClusterLight>& lights, const glm::mat4& view,
+                                     const glm::mat4& projection, const std::vector<unsigned int>& grid,
+                                     const std::vector<unsigned int>& indices, unsigned int tilesX,
+                                     unsigned int tilesY, unsigned int slicesZ, std::mt19937& generator)
+{
+    const float near { projection[3][2] / (projection[2][2] - 1.f) };
+    const float far { projection[3][2] / (projection[2][2] + 1.f) };
+    const float sliceScale { slicesZ / glm::log(far / near) };
+
+    std::uniform_real_distribution<float> random(-1.f, 1.f);
+    unsigned int failures { 0 };
+    for (unsigned int l = 0; l < lights.size(); ++l)
+    {
+        const ClusterLight& light { lights[l] };
+        for (int sample = 0; sample < 64; ++sample)
+        {
+            // Random point inside the sphere, and inside the cone of spot lights
+            glm::vec3 offset { random(generator), random(generator), random(generator) };
+            if (glm::length(offset) > 1.f)
+                continue;
+            offset *= light.radius;
+            if (light.spotIndex >= 0 && glm::dot(glm::normalize(offset), light.direction) < light.cosAngleOuter)
+                continue;
+            const glm::vec4 point { light.position + offset, 1.f };
+
+            // Skip the points outside of the frustum
+            const glm::vec4 clip { projection * view * point };
+            if (clip.w <= 0.f || glm::abs(clip.x) >= clip.w || glm::abs(clip.y) >= clip.w
+                || glm::abs(clip.z) >= clip.w)
+                continue;
+
+            // Cluster of the point
+            const float distance { -(view * point).z };
+            const int slice { glm::clamp((int)(glm::log(distance / near) * sliceScale), 0, (int)slicesZ - 1) };
+            const int tileX { std::min((int)((clip.x / clip.w * 0.5f + 0.5f) * tilesX), (int)tilesX - 1) };
+            const int tileY { std::min((int)((clip.y / clip.w * 0.5f + 0.5f) * tilesY), (int)tilesY - 1) };
+            const unsigned int cluster { tileX + tilesX * (tileY + tilesY * slice) };
+
+            const auto begin { indices.begin() + grid[2 * cluster] };
+            const auto end { begin + grid[2 * cluster + 1] };
+            if (std::find(begin, end, l) == end)
+                ++failures;
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Same frustum as the default camera
+    const unsigned int tilesX { 16 };
+    const unsigned int tilesY { 9 };
+    const unsigned int slicesZ { 24 };
+    const glm::mat4 view { glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f)) };
+    const glm::mat4 projection { glm::perspective(glm::radians(45.f), 16.f / 9.f, 0.1f, 100.f) };
+
+    ClusteredLights clusteredLights(tilesX, tilesY, slicesZ, options.threads);
+    std::mt19937 generator { 1234 };
+
+    std::cout << "Clusters: " << tilesX << "x" << tilesY << "x" << slicesZ
+              << ", threads: " << clusteredLights.getNrThreads()
+              << ", spot lights: " << options.spotFraction * 100.f << "%\n\n";
+    std::cout << std::setw(8) << "lights" << std::setw(12) << "avg ms" << std::setw(12) << "min ms"
+              << std::setw(14) << "lights/clus" << std::setw(10) << "max" << std::setw(12) << "indices";
+    if (options.verify)
+        std::cout << std::setw(10) << "misses";
+    std::cout << '\n';
+
+    bool allVerified { true };
+    for (unsigned int count : { 10u, 100u, 500u, 1000u, 2500u, 5000u, 10000u })
+    {
+        const std::vector<ClusterLight> lights { createLights(count, options.spotFraction, generator) };
+
+        // Warm up, so the buffers are already allocated
+        clusteredLights.assignLights(view, projection, lights);
+
+        double totalTime { 0. };
+        double minTime { 1e30 };
+        for (unsigned int i = 0; i < options.iterations; ++i)
+        {
+            const double start { getTimeMs() };
+            clusteredLights.assignLights(view, projection, lights);
+            const double time { getTimeMs() - start };
+            totalTime += time;
+            minTime = std::min(minTime, time);
+        }
+
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::setw(8) << count
+                  << std::setw(12) << totalTime / options.iterations
+                  << std::setw(12) << minTime
+                  << std::setprecision(2)
+                  << std::setw(14) << (double)clusteredLights.getNrIndices() / clusteredLights.getNrClusters()
+                  << std::setw(10) << clusteredLights.getMaxLightsPerCluster()
+                  << std::setw(12) << clusteredLights.getNrIndices();
+
+        if (options.verify)
+        {
+            const unsigned int failures { verifyAssignment(lights, view, projection,
+                clusteredLights.getClusterGrid(), clusteredLights.getLightIndices(),
+                tilesX, tilesY, slicesZ, generator) };
+            std::cout << std::setw(10) << failures;
+            allVerified = allVerified && failures == 0;
+        }
+        std::cout << '\n';
+    }
+
+    return allVerified ? 0 : 1;
+}
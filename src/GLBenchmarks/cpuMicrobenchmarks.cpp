@@ -0,0 +1,470 @@
+// Microbenchmarks of functions of GLBase and GLGeometry that only run on the
+// CPU, so their cost can be followed without an OpenGL context:
+//      - Generation of the meshes of GLSphere, GLCylinder and GLCone
+//      - Camera::getFrustumCornersWorldSpace
+//      - DirectionalLight::computeLightSpaceMatrix
+//      - Model::convertMesh, the conversion done by Model::processMesh
+//      - Light::getUniformName, with the names of the uniforms that the
+//        light classes set when they are passed to the lighting shader
+//
+// Usage:
+//      cpuMicrobenchmarks [options]
+//
+// Options:
+//      -f, --filter <text>     Run only the benchmarks whose name contains it
+//      -r, --repetitions <n>   Samples of each benchmark (default: 15)
+//      --min-time <ms>         Minimum time of each sample (default: 5)
+//      --warmup <ms>           Time run before the samples (default: 50)
+//      --json <path>           Write the results to a JSON file
+//      --list                  List the benchmarks without running them
+//
+// The number of operations of each sample is chosen in the warmup so it lasts
+// at least the minimum time. For each benchmark, the median, the minimum and
+// the relative standard deviation of the time per operation of the samples
+// are reported, with the allocations and the bytes allocated per operation,
+// which are counted by replacing the global operator new.
+
+#include "GLBase.h"
+#include "GLGeometry.h"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace GLBase;
+using namespace GLGeometry;
+
+// Allocations since the start of the program, and bytes allocated by them
+static std::atomic<std::uint64_t> gNrAllocations { 0 };
+static std::atomic<std::uint64_t> gBytesAllocated { 0 };
+
+// Replacement of the global operator new, counting the allocations. The array
+// and nothrow versions call it
+void* operator new(std::size_t size)
+{
+    gNrAllocations.fetch_add(1, std::memory_order_relaxed);
+    gBytesAllocated.fetch_add(size, std::memory_order_relaxed);
+    void* pointer { std::malloc(size > 0 ? size : 1) };
+    if (!pointer)
+        throw std::bad_alloc();
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// Keep the compiler from removing a value that is not used
+template <typename T>
+static void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+// Options of the benchmark
+struct BenchmarkOptions
+{
+    std::string filter;
+    unsigned int repetitions { 15 };
+    double minSampleMs { 5. };
+    double warmupMs { 50. };
+    std::string jsonPath;
+    bool list { false };
+};
+
+// Microbenchmark, with the function that runs its kernel a number of times
+struct Microbenchmark
+{
+    std::string name;
+    std::function<void(std::uint64_t)> run;
+};
+
+// Statistics of the samples of a microbenchmark
+struct MicrobenchmarkResult
+{
+    std::string name;
+    std::uint64_t operationsPerSample;
+    double medianNs;
+    double minNs;
+    double meanNs;
+    double stddevNs;
+    double allocationsPerOp;
+    double bytesPerOp;
+};
+
+// Print the usage of the benchmark
+static void printUsage()
+{
+    std::cout << "Usage: cpuMicrobenchmarks [-f filter] [-r repetitions] [--min-time ms] [--warmup ms]\n"
+                 "                          [--json path] [--list]\n";
+}
+
+// Parse the command line options
+static bool parseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg { argv[i] };
+        const bool hasValue { i + 1 < argc };
+        if ((arg == "-f" || arg == "--filter") && hasValue)
+            options.filter = argv[++i];
+        else if ((arg == "-r" || arg == "--repetitions") && hasValue)
+            options.repetitions = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--min-time" && hasValue)
+            options.minSampleMs = std::max(0.01, std::stod(argv[++i]));
+        else if (arg == "--warmup" && hasValue)
+            options.warmupMs = std::max(0., std::stod(argv[++i]));
+        else if (arg == "--json" && hasValue)
+            options.jsonPath = argv[++i];
+        else if (arg == "--list")
+            options.list = true;
+        else
+            return false;
+    }
+    return true;
+}
+
+// Get the current time in nanoseconds
+static double getTimeNs()
+{
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Run a microbenchmark
+// The warmup increases the operations of a sample until one lasts the minimum
+// time, and keeps running them until the warmup time has passed
+static MicrobenchmarkResult runMicrobenchmark(const Microbenchmark& benchmark, const BenchmarkOptions& options)
+{
+    const double minSampleNs { 1e6 * options.minSampleMs };
+    std::uint64_t operations { 1 };
+    const double warmupStart { getTimeNs() };
+    while (true)
+    {
+        const double start { getTimeNs() };
+        benchmark.run(operations);
+        const double elapsed { getTimeNs() - start };
+        const bool calibrated { elapsed >= minSampleNs };
+        if (calibrated && getTimeNs() - warmupStart >= 1e6 * options.warmupMs)
+            break;
+        if (!calibrated)
+        {
+            // Grow towards the minimum time, at most 10 times in each step
+            const double factor { elapsed > 0. ? std::min(10., 1.2 * minSampleNs / elapsed) : 10. };
+            operations = std::max(operations + 1, (std::uint64_t)(operations * factor));
+        }
+    }
+
+    std::vector<double> times;
+    times.reserve(options.repetitions);
+    std::uint64_t nrAllocations { 0 };
+    std::uint64_t bytesAllocated { 0 };
+    for (unsigned int i = 0; i < options.repetitions; ++i)
+    {
+        const std::uint64_t allocationsStart { gNrAllocations.load(std::memory_order_relaxed) };
+        const std::uint64_t bytesStart { gBytesAllocated.load(std::memory_order_relaxed) };
+        const double start { getTimeNs() };
+        benchmark.run(operations);
+        const double elapsed { getTimeNs() - start };
+        nrAllocations += gNrAllocations.load(std::memory_order_relaxed) - allocationsStart;
+        bytesAllocated += gBytesAllocated.load(std::memory_order_relaxed) - bytesStart;
+        times.push_back(elapsed / operations);
+    }
+
+    MicrobenchmarkResult result;
+    result.name = benchmark.name;
+    result.operationsPerSample = operations;
+    double sum { 0. };
+    for (double time : times)
+        sum += time;
+    result.meanNs = sum / times.size();
+    double sumSquares { 0. };
+    for (double time : times)
+        sumSquares += (time - result.meanNs) * (time - result.meanNs);
+    result.stddevNs = times.size() > 1 ? std::sqrt(sumSquares / (times.size() - 1)) : 0.;
+    std::sort(times.begin(), times.end());
+    result.minNs = times.front();
+    result.medianNs = times.size() % 2 == 1 ? times[times.size() / 2]
+                      : 0.5 * (times[times.size() / 2 - 1] + times[times.size() / 2]);
+    const double totalOperations { (double)operations * options.repetitions };
+    result.allocationsPerOp = nrAllocations / totalOperations;
+    result.bytesPerOp = bytesAllocated / totalOperations;
+    return result;
+}
+
+// Create a mesh of Assimp with a grid of side x side vertices, with normals and
+// texture coordinates, and two triangles in each cell
+// Its arrays are allocated as Assimp does, so the mesh can delete them
+static aiMesh* createGridMesh(unsigned int side)
+{
+    aiMesh* mesh { new aiMesh() };
+    mesh->mNumVertices = side * side;
+    mesh->mVertices = new aiVector3D[mesh->mNumVertices];
+    mesh->mNormals = new aiVector3D[mesh->mNumVertices];
+    mesh->mTextureCoords[0] = new aiVector3D[mesh->mNumVertices];
+    for (unsigned int i = 0; i < mesh->mNumVertices; ++i)
+    {
+        const float u { (float)(i % side) / (side - 1) };
+        const float v { (float)(i / side) / (side - 1) };
+        mesh->mVertices[i].x = u;
+        mesh->mVertices[i].y = 0.1f * std::sin(10.f * u) * std::cos(10.f * v);
+        mesh->mVertices[i].z = v;
+        mesh->mNormals[i].x = 0.f;
+        mesh->mNormals[i].y = 1.f;
+        mesh->mNormals[i].z = 0.f;
+        mesh->mTextureCoords[0][i].x = u;
+        mesh->mTextureCoords[0][i].y = v;
+        mesh->mTextureCoords[0][i].z = 0.f;
+    }
+
+    mesh->mNumFaces = 2 * (side - 1) * (side - 1);
+    mesh->mFaces = new aiFace[mesh->mNumFaces];
+    unsigned int face { 0 };
+    for (unsigned int y = 0; y + 1 < side; ++y)
+    {
+        for (unsigned int x = 0; x + 1 < side; ++x)
+        {
+            const unsigned int corner { y * side + x };
+            const unsigned int triangles[2][3] { { corner, corner + side, corner + 1 },
+                                                 { corner + 1, corner + side, corner + side + 1 } };
+            for (const auto& triangle : triangles)
+            {
+                mesh->mFaces[face].mNumIndices = 3;
+                mesh->mFaces[face].mIndices = new unsigned int[3] { triangle[0], triangle[1], triangle[2] };
+                ++face;
+            }
+        }
+    }
+    return mesh;
+}
+
+// Build the names of the uniforms of the lights passed to the lighting shader
+// with Light::getUniformName(), with the members set by configureShader() and
+// configureShaderForLightingPass() of each light, and get their total length
+static size_t buildLightUniformNames(unsigned int nrCascades, unsigned int nrSpotLights, unsigned int nrPointLights)
+{
+    size_t length { 0 };
+    auto addName = [&length](const std::string& name)
+    {
+        doNotOptimize(name);
+        length += name.size();
+    };
+    for (const char* member : { "color", "position", "direction", "intensity", "kLinear", "kQuadratic",
+                                "lightSpaceMatrix", "shadowMap", "shadowMapCompare", "shadowMoments",
+                                "shadowFilter" })
+        addName(Light::getUniformName(LIGHT_DIRECTIONAL, 0, member));
+    for (unsigned int i = 0; i < nrCascades + 1; ++i)
+        addName(Light::getUniformName(LIGHT_DIRECTIONAL, 0, "cascadeDistances") + "[" + std::to_string(i) + "]");
+    for (unsigned int light = 0; light < nrSpotLights; ++light)
+    {
+        for (const char* member : { "color", "position", "direction", "upDirection", "intensity", "kLinear",
+                                    "kQuadratic", "cosAngleInner", "cosAngleOuter", "radiusMax",
+                                    "lightSpaceMatrix", "atlasRect", "shadowFilter" })
+            addName(Light::getUniformName(LIGHT_SPOT, light, member));
+    }
+    for (unsigned int light = 0; light < nrPointLights; ++light)
+    {
+        for (const char* member : { "color", "position", "intensity", "kLinear", "kQuadratic",
+                                    "radiusMax", "shadowSlot" })
+            addName(Light::getUniformName(LIGHT_POINT, light, member));
+    }
+    return length;
+}
+
+// Create the microbenchmarks, over the sizes of their inputs used by the
+// sandbox and the benchmarks
+static std::vector<Microbenchmark> createMicrobenchmarks(std::vector<std::unique_ptr<aiMesh>>& meshes)
+{
+    std::vector<Microbenchmark> benchmarks;
+
+    for (int nrVertices : { 8, 16, 32, 64 })
+    {
+        benchmarks.push_back({ "GLSphere::generateMesh/" + std::to_string(nrVertices),
+            [nrVertices](std::uint64_t operations)
+            {
+                for (std::uint64_t i = 0; i < operations; ++i)
+                {
+                    std::vector<Vertex> vertices;
+                    std::vector<unsigned int> indices;
+                    GLSphere::generateMesh(nrVertices, vertices, indices);
+                    doNotOptimize(vertices);
+                    doNotOptimize(indices);
+                }
+            } });
+    }
+    for (int nrVertices : { 16, 32, 64, 256 })
+    {
+        benchmarks.push_back({ "GLCylinder::generateMesh/" + std::to_string(nrVertices),
+            [nrVertices](std::uint64_t operations)
+            {
+                for (std::uint64_t i = 0; i < operations; ++i)
+                {
+                    std::vector<Vertex> vertices;
+                    std::vector<unsigned int> indices;
+                    GLCylinder::generateMesh(nrVertices, vertices, indices);
+                    doNotOptimize(vertices);
+                    doNotOptimize(indices);
+                }
+            } });
+    }
+    for (int nrVertices : { 16, 32, 64, 256 })
+    {
+        benchmarks.push_back({ "GLCone::generateMesh/" + std::to_string(nrVertices),
+            [nrVertices](std::uint64_t operations)
+            {
+                for (std::uint64_t i = 0; i < operations; ++i)
+                {
+                    std::vector<Vertex> vertices;
+                    std::vector<unsigned int> indices;
+                    GLCone::generateMesh(nrVertices, vertices, indices);
+                    doNotOptimize(vertices);
+                    doNotOptimize(indices);
+                }
+            } });
+    }
+
+    // The camera of the sandbox, looking at the scene from above
+    auto camera { std::make_shared<Camera>(1280, 720, glm::vec3(0., 4., 8.)) };
+    camera->lookAt(glm::vec3(0.f));
+    benchmarks.push_back({ "Camera::getFrustumCornersWorldSpace",
+        [camera](std::uint64_t operations)
+        {
+            for (std::uint64_t i = 0; i < operations; ++i)
+                doNotOptimize(camera->getFrustumCornersWorldSpace());
+        } });
+    benchmarks.push_back({ "Camera::getFrustumCornersWorldSpace/subfrustum",
+        [camera](std::uint64_t operations)
+        {
+            for (std::uint64_t i = 0; i < operations; ++i)
+                doNotOptimize(camera->getFrustumCornersWorldSpace(0.1f + (i & 3), 10.f + (i & 3)));
+        } });
+
+    // The four cascades of a light with a shadow map of 2048 texels
+    benchmarks.push_back({ "DirectionalLight::computeLightSpaceMatrix",
+        [camera](std::uint64_t operations)
+        {
+            const float distances[5] { 0.1f, 5.f, 15.f, 40.f, 100.f };
+            const glm::vec3 direction { glm::normalize(glm::vec3(-1.f, -1.f, -1.f)) };
+            const glm::vec3 upDirection { glm::normalize(glm::cross(glm::vec3(0.f, 1.f, 0.f), direction)) };
+            for (std::uint64_t i = 0; i < operations; ++i)
+            {
+                const unsigned int cascade { (unsigned int)(i & 3) };
+                doNotOptimize(DirectionalLight::computeLightSpaceMatrix(*camera, distances[cascade],
+                                                                        distances[cascade + 1], direction,
+                                                                        upDirection, 2048));
+            }
+        } });
+
+    for (unsigned int side : { 32u, 128u, 512u })
+    {
+        meshes.emplace_back(createGridMesh(side));
+        const aiMesh* mesh { meshes.back().get() };
+        benchmarks.push_back({ "Model::convertMesh/" + std::to_string(side * side),
+            [mesh](std::uint64_t operations)
+            {
+                for (std::uint64_t i = 0; i < operations; ++i)
+                {
+                    std::vector<Vertex> vertices;
+                    std::vector<unsigned int> indices;
+                    Model::convertMesh(mesh, vertices, indices);
+                    doNotOptimize(vertices);
+                    doNotOptimize(indices);
+                }
+            } });
+    }
+
+    // A directional light with four cascades, and the spot and point lights
+    // that fit in the arrays of the lighting shader
+    for (unsigned int nrLights : { 4u, 32u })
+    {
+        benchmarks.push_back({ "Light::getUniformName/" + std::to_string(nrLights),
+            [nrLights](std::uint64_t operations)
+            {
+                for (std::uint64_t i = 0; i < operations; ++i)
+                    doNotOptimize(buildLightUniformNames(4, nrLights, nrLights));
+            } });
+    }
+
+    return benchmarks;
+}
+
+// Write the results to a JSON file
+static void writeJSON(const std::string& path, const std::vector<MicrobenchmarkResult>& results)
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "ERROR::CPU_MICROBENCHMARKS::FILE_NOT_WRITTEN: " << path << '\n';
+        return;
+    }
+    file << std::fixed << std::setprecision(3) << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const MicrobenchmarkResult& result { results[i] };
+        file << "{\"name\":\"" << result.name << "\",\"operationsPerSample\":" << result.operationsPerSample
+             << ",\"nsPerOp\":" << result.medianNs << ",\"nsPerOpMin\":" << result.minNs
+             << ",\"nsPerOpMean\":" << result.meanNs << ",\"nsPerOpStddev\":" << result.stddevNs
+             << ",\"allocationsPerOp\":" << result.allocationsPerOp << ",\"bytesPerOp\":" << result.bytesPerOp
+             << (i + 1 < results.size() ? "},\n" : "}\n");
+    }
+    file << "]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<aiMesh>> meshes;
+    const std::vector<Microbenchmark> benchmarks { createMicrobenchmarks(meshes) };
+
+    if (options.list)
+    {
+        for (const Microbenchmark& benchmark : benchmarks)
+            std::cout << benchmark.name << '\n';
+        return 0;
+    }
+
+    std::cout << std::left << std::setw(48) << "benchmark" << std::right << std::setw(14) << "ns/op"
+              << std::setw(14) << "min ns/op" << std::setw(10) << "stddev" << std::setw(12) << "allocs/op"
+              << std::setw(14) << "bytes/op" << '\n';
+    std::vector<MicrobenchmarkResult> results;
+    for (const Microbenchmark& benchmark : benchmarks)
+    {
+        if (benchmark.name.find(options.filter) == std::string::npos)
+            continue;
+        results.push_back(runMicrobenchmark(benchmark, options));
+        const MicrobenchmarkResult& result { results.back() };
+        std::cout << std::fixed << std::setprecision(1)
+                  << std::left << std::setw(48) << result.name << std::right
+                  << std::setw(14) << result.medianNs
+                  << std::setw(14) << result.minNs
+                  << std::setw(9) << 100. * result.stddevNs / result.meanNs << '%'
+                  << std::setprecision(2)
+                  << std::setw(12) << result.allocationsPerOp
+                  << std::setprecision(0)
+                  << std::setw(14) << result.bytesPerOp << '\n';
+    }
+
+    if (!options.jsonPath.empty())
+    {
+        writeJSON(options.jsonPath, results);
+        std::cout << "\nResults written to " << options.jsonPath << '\n';
+    }
+
+    return 0;
+}
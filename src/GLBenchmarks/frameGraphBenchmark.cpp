@@ -0,0 +1,198 @@
+// Benchmark of GLBase::FrameGraph.
+// A synthetic post-processing chain (bright pass, blur, bloom downsampling and
+// upsampling, and a composite) is built each frame, with a luminance pass and a
+// debug view whose outputs are not used. The passes culled, the number of
+// transient textures and of textures of the pool that they use, and the CPU time
+// of building and compiling the graph are reported.
+//
+// Usage:
+//      frameGraphBenchmark [options]
+//
+// Options:
+//      -f, --frames <n>        Frames built and executed (default: 200)
+//      -o, --output <path>     File where the graph of the last frame is written
+//                              in the Graphviz format (default: frameGraphBenchmark.dot)
+//
+// Each pass only clears the texture that it writes, so the GPU times in the
+// graph show the cost of touching the memory of the textures.
+
+#include "GLBase.h"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace GLBase;
+
+// Options of the benchmark
+struct BenchmarkOptions
+{
+    unsigned int frames { 200 };
+    std::string output { "frameGraphBenchmark.dot" };
+};
+
+// Resources of the chain, kept out of the graph so the execution of each pass
+// can find the resource it writes
+struct ChainResources
+{
+    unsigned int backbuffer;
+    unsigned int scene;
+    unsigned int bright;
+    unsigned int blurHorizontal;
+    unsigned int blurVertical;
+    unsigned int downsample4;
+    unsigned int downsample8;
+    unsigned int upsample4;
+    unsigned int upsample2;
+    unsigned int luminance;
+    unsigned int debugView;
+};
+
+// Print the usage of the benchmark
+static void printUsage()
+{
+    std::cout << "Usage: frameGraphBenchmark [-f frames] [-o output]\n";
+}
+
+// Parse the command line options
+static bool parseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg { argv[i] };
+        const bool hasValue { i + 1 < argc };
+        if ((arg == "-f" || arg == "--frames") && hasValue)
+            options.frames = std::max(1, std::stoi(argv[++i]));
+        else if ((arg == "-o" || arg == "--output") && hasValue)
+            options.output = argv[++i];
+        else
+            return false;
+    }
+    return true;
+}
+
+// Clear a texture, attaching it to a framebuffer
+static void clearTexture(unsigned int framebuffer, unsigned int texture, const FrameGraphTextureDesc& desc)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+    glViewport(0, 0, desc.width, desc.height);
+    glClearColor(0.f, 0.f, 0.f, 1.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// Add a pass that reads some resources and creates a transient texture
+static void addChainPass(FrameGraph& graph, unsigned int framebuffer, const std::string& name,
+                         const std::vector<unsigned int>& inputs, const FrameGraphTextureDesc& desc,
+                         unsigned int& output)
+{
+    graph.addPass(name,
+        [&](FrameGraphBuilder& builder)
+        {
+            for (unsigned int input : inputs)
+                builder.read(input);
+            output = builder.create(name, desc);
+        },
+        [framebuffer, &output](const FrameGraphResources& resources)
+        {
+            clearTexture(framebuffer, resources.getTexture(output), resources.getDesc(output));
+        });
+}
+
+// Add the passes of the chain to the graph
+static void buildGraph(FrameGraph& graph, ChainResources& chain, unsigned int framebuffer,
+                       int width, int height)
+{
+    graph.reset();
+
+    chain.backbuffer = graph.importTexture("Backbuffer", 0, { width, height, GL_RGBA8 });
+    graph.markOutput(chain.backbuffer);
+
+    const FrameGraphTextureDesc full { width, height, GL_RGBA16F };
+    const FrameGraphTextureDesc half { width / 2, height / 2, GL_RGBA16F };
+    const FrameGraphTextureDesc quarter { width / 4, height / 4, GL_RGBA16F };
+    const FrameGraphTextureDesc eighth { width / 8, height / 8, GL_RGBA16F };
+
+    addChainPass(graph, framebuffer, "Scene", {}, full, chain.scene);
+    // Luminance and a debug view of it, which nothing reads
+    addChainPass(graph, framebuffer, "Luminance", { chain.scene }, { width, height, GL_R32F }, chain.luminance);
+    addChainPass(graph, framebuffer, "Debug view", { chain.luminance }, full, chain.debugView);
+    // Bloom
+    addChainPass(graph, framebuffer, "Bright", { chain.scene }, half, chain.bright);
+    addChainPass(graph, framebuffer, "Blur horizontal", { chain.bright }, half, chain.blurHorizontal);
+    addChainPass(graph, framebuffer, "Blur vertical", { chain.blurHorizontal }, half, chain.blurVertical);
+    addChainPass(graph, framebuffer, "Downsample 1/4", { chain.blurVertical }, quarter, chain.downsample4);
+    addChainPass(graph, framebuffer, "Downsample 1/8", { chain.downsample4 }, eighth, chain.downsample8);
+    addChainPass(graph, framebuffer, "Upsample 1/4", { chain.downsample8, chain.downsample4 }, quarter,
+                 chain.upsample4);
+    addChainPass(graph, framebuffer, "Upsample 1/2", { chain.upsample4, chain.blurVertical }, half,
+                 chain.upsample2);
+
+    // Composite to the window
+    graph.addPass("Composite",
+        [&](FrameGraphBuilder& builder)
+        {
+            builder.read(chain.scene);
+            builder.read(chain.upsample2);
+            builder.write(chain.backbuffer);
+        },
+        [width, height](const FrameGraphResources&)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glViewport(0, 0, width, height);
+            glClearColor(0.f, 0.f, 0.f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        });
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const int width { 1280 };
+    const int height { 720 };
+    Application application(width, height, "Frame graph benchmark");
+
+    unsigned int framebuffer;
+    glGenFramebuffers(1, &framebuffer);
+
+    FrameGraph graph;
+    ChainResources chain;
+    double buildTime { 0. };
+    double compileTime { 0. };
+    for (unsigned int frame = 0; frame < options.frames; ++frame)
+    {
+        const auto start { std::chrono::steady_clock::now() };
+        buildGraph(graph, chain, framebuffer, width, height);
+        const auto built { std::chrono::steady_clock::now() };
+        if (!graph.compile())
+            return 1;
+        const auto compiled { std::chrono::steady_clock::now() };
+        graph.execute();
+        application.updateWindow();
+
+        buildTime += std::chrono::duration<double, std::micro>(built - start).count();
+        compileTime += std::chrono::duration<double, std::micro>(compiled - built).count();
+    }
+    graph.saveGraphviz(options.output);
+
+    std::cout << "Resolution: " << width << "x" << height << ", frames: " << options.frames << "\n\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Passes:                  " << graph.getNrPasses() << " (" << graph.getNrCulledPasses()
+              << " culled)\n";
+    std::cout << "Transient textures:      " << graph.getNrTransientTextures() << '\n';
+    std::cout << "Physical textures:       " << graph.getNrPhysicalTextures() << " (" << graph.getNrPooledTextures()
+              << " in the pool)\n";
+    std::cout << "Build time per frame:    " << buildTime / options.frames << " us\n";
+    std::cout << "Compile time per frame:  " << compileTime / options.frames << " us\n";
+    std::cout << "Graph of the last frame: " << options.output << '\n';
+
+    glDeleteFramebuffers(1, &framebuffer);
+
+    return 0;
+}
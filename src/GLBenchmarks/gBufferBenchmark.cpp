@@ -0,0 +1,219 @@
+// Benchmark of the layouts of the G-buffer of GLBase::DeferredRenderer.
+// The same scene is rendered with the standard and the compact layouts, and
+// the memory of the render targets and the GPU time of the geometry and
+// lighting passes are reported for each one.
+//
+// Usage:
+//      gBufferBenchmark [options]
+//
+// Options:
+//      -f, --frames <n>        Frames timed for each layout (default: 200)
+//      -l, --lights <n>        Number of point lights (default: 24). The lighting
+//                              shader holds at most 32 without --volumes or --clustered
+//      --volumes               Compute the point and spot lights with their volumes
+//      --clustered             Compute the point and spot lights with the clusters
+//
+// The times are measured with timestamp queries around each pass, so they do
+// not include the time spent by the CPU in the rest of the frame.
+
+#include "GLBase.h"
+#include "GLGeometry.h"
+
+#include <iomanip>
+
+using namespace GLBase;
+using namespace GLGeometry;
+
+// Options of the benchmark
+struct BenchmarkOptions
+{
+    unsigned int frames { 200 };
+    unsigned int lights { 24 };
+    LightingMode lightingMode { LIGHTING_FULLSCREEN };
+};
+
+// Results of a layout
+struct LayoutResult
+{
+    unsigned int bytesPerPixel;
+    double geometryMs;
+    double lightingMs;
+};
+
+// Print the usage of the benchmark
+static void printUsage()
+{
+    std::cout << "Usage: gBufferBenchmark [-f frames] [-l lights] [--volumes | --clustered]\n";
+}
+
+// Parse the command line options
+static bool parseOptions(int argc, char* argv[], BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg { argv[i] };
+        const bool hasValue { i + 1 < argc };
+        if ((arg == "-f" || arg == "--frames") && hasValue)
+            options.frames = std::max(1, std::stoi(argv[++i]));
+        else if ((arg == "-l" || arg == "--lights") && hasValue)
+            options.lights = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--volumes")
+            options.lightingMode = LIGHTING_VOLUMES;
+        else if (arg == "--clustered")
+            options.lightingMode = LIGHTING_CLUSTERED;
+        else
+            return false;
+    }
+    return true;
+}
+
+// Render the scene with a layout of the G-buffer, and measure the passes
+static LayoutResult runLayout(GBufferLayout layout, const BenchmarkOptions& options, Application& application,
+                              Camera& camera, GLCubemap& skymap, const std::vector<Light*>& lights,
+                              const std::vector<GLElemObject*>& objects, std::vector<Material>& materials)
+{
+    DeferredRenderer renderer(application.getWidth(), application.getHeight(), 1.f, layout);
+    renderer.configureLights(lights);
+    renderer.setLightingMode(options.lightingMode);
+
+    Shader gPassShader(EMBEDDED_SHADER, "GLBase/defGeometryPassVertex.glsl",
+                       "GLBase/defGeometryPassFragment.glsl");
+    renderer.configureGeometryShader(gPassShader);
+
+    glm::mat4 view { camera.getViewMatrix() };
+    glm::mat4 projection { camera.getProjectionMatrix() };
+    skymap.setViewProjection(view, projection);
+    renderer.setViewProjection(view, projection);
+
+    // Timestamps at the start of the geometry pass, and at the end of the
+    // geometry and lighting passes
+    unsigned int queries[3];
+    glGenQueries(3, queries);
+
+    // The first frames are not timed, so the shaders and targets are ready
+    const unsigned int warmupFrames { 10 };
+    GLuint64 geometryTime { 0 };
+    GLuint64 lightingTime { 0 };
+    for (unsigned int frame = 0; frame < warmupFrames + options.frames; ++frame)
+    {
+        application.clearWindow();
+        renderer.startFrame();
+        renderer.computeShadowMaps(camera, lights, objects);
+
+        glQueryCounter(queries[0], GL_TIMESTAMP);
+        renderer.startGeometryPass();
+        gPassShader.use();
+        gPassShader.setMat4("view", view);
+        gPassShader.setMat4("projection", projection);
+        for (unsigned int i = 0; i < objects.size(); ++i)
+        {
+            gPassShader.setMat4("model", objects[i]->getModelMatrix());
+            materials[i % materials.size()].configShader(gPassShader);
+            objects[i]->draw();
+        }
+        glQueryCounter(queries[1], GL_TIMESTAMP);
+        renderer.processGBuffer(camera.Position, lights);
+        glQueryCounter(queries[2], GL_TIMESTAMP);
+
+        renderer.endFrame(&skymap);
+        application.updateWindow();
+
+        // Wait for the results, so the next frame does not overwrite them
+        GLuint64 timestamps[3];
+        for (int i = 0; i < 3; ++i)
+            glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &timestamps[i]);
+        if (frame >= warmupFrames)
+        {
+            geometryTime += timestamps[1] - timestamps[0];
+            lightingTime += timestamps[2] - timestamps[1];
+        }
+    }
+
+    glDeleteQueries(3, queries);
+
+    return { renderer.getBytesPerPixel(),
+             geometryTime * 1e-6 / options.frames,
+             lightingTime * 1e-6 / options.frames };
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const int width { 1280 };
+    const int height { 720 };
+    Application application(width, height, "G-buffer benchmark");
+    Camera camera(width, height, glm::vec3(0.f, 2.f, 8.f), glm::vec3(0.f, 1.f, 0.f), -90.f, -10.f);
+
+    GLCubemap skymap;
+
+    // Scene similar to the one of the sandbox, with a floor and a grid of objects
+    std::vector<GLElemObject*> objects;
+    objects.push_back(new GLQuad());
+    objects.back()->setModelMatrix(glm::vec3(0., -1., 0.), -90., glm::vec3(1., 0., 0.), glm::vec3(30., 30., 30.));
+    for (int i = 0; i < 25; ++i)
+    {
+        GLElemObject* object;
+        switch (i % 4)
+        {
+            case 0: object = new GLCube(); break;
+            case 1: object = new GLSphere(16); break;
+            case 2: object = new GLCylinder(32); break;
+            default: object = new GLCone(32); break;
+        }
+        object->setModelMatrix(glm::vec3(3. * (i % 5) - 6., 0., -3. * (i / 5)), 0., glm::vec3(1., 0., 0.),
+                               glm::vec3(1.5, 1.5, 1.5));
+        objects.push_back(object);
+    }
+
+    std::vector<Material> materials;
+    materials.push_back(Material( {1., 1., 0.}, 1.0 ));
+    materials.push_back(Material( {1., 0., 0.}, 1.0 ));
+    materials.push_back(Material( {0., 0., 1.}, 0.5 ));
+    materials.push_back(Material( {0., 1., 1.}, 0.2 ));
+
+    // Random point lights over the objects, with a directional and a spot light
+    std::mt19937 generator { 1234 };
+    std::uniform_real_distribution<float> random(0.f, 1.f);
+    std::vector<Light*> lights;
+    for (unsigned int i = 0; i < options.lights; ++i)
+    {
+        lights.push_back(new PointLight( {random(generator), random(generator), random(generator)},
+                                         {16.f * random(generator) - 8.f, 3.f * random(generator),
+                                          -16.f * random(generator) + 2.f},
+                                         0.5f, 0.1f, 0.2f ) );
+    }
+    lights.push_back(new DirectionalLight( {1., 1., 1.}, {10., 10., 10.}, {-1., -1., -1.}, 0.5f, 0.f, 0.f) );
+    lights.push_back(new SpotLight( {0., 1., 0.}, {0., 4., 0.}, {0., -1., 0.}, 25.f, 90.f, 3.f, 0.05f, 0.1f) );
+
+    std::cout << "Resolution: " << width << "x" << height << ", point lights: " << options.lights
+              << ", frames: " << options.frames << "\n\n";
+    std::cout << std::setw(10) << "layout" << std::setw(12) << "bytes/px" << std::setw(12) << "MB"
+              << std::setw(14) << "geometry ms" << std::setw(14) << "lighting ms" << '\n';
+
+    for (GBufferLayout layout : { GBUFFER_STANDARD, GBUFFER_COMPACT })
+    {
+        const LayoutResult result { runLayout(layout, options, application, camera, skymap, lights,
+                                              objects, materials) };
+        std::cout << std::fixed << std::setprecision(3)
+                  << std::setw(10) << (layout == GBUFFER_STANDARD ? "standard" : "compact")
+                  << std::setw(12) << result.bytesPerPixel
+                  << std::setw(12) << std::setprecision(1)
+                  << result.bytesPerPixel * (double)width * height / (1024. * 1024.)
+                  << std::setprecision(3)
+                  << std::setw(14) << result.geometryMs
+                  << std::setw(14) << result.lightingMs << '\n';
+    }
+
+    for (Light* light : lights)
+        delete light;
+    for (GLElemObject* object : objects)
+        delete object;
+
+    return 0;
+}
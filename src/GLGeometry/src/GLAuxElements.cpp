@@ -10,9 +10,9 @@ namespace GLGeometry
     
     // Constructor
     GLAuxElements::GLAuxElements(int width, int height) :
-        mPointShader("../shaders/GLGeometry/pointVertex.glsl", "../shaders/GLGeometry/pointFragment.glsl",
-                "../shaders/GLGeometry/pointGeometry.glsl"),
-        mLineShader("../shaders/GLGeometry/lineVertex.glsl", "../shaders/GLGeometry/lineFragment.glsl")
+        mPointShader(EMBEDDED_SHADER, "GLGeometry/pointVertex.glsl", "GLGeometry/pointFragment.glsl",
+                "GLGeometry/pointGeometry.glsl"),
+        mLineShader(EMBEDDED_SHADER, "GLGeometry/lineVertex.glsl", "GLGeometry/lineFragment.glsl")
     {
         // Set the number of vertices in each circle of the cylinder
         mNrVerticesCylinder = 16;
@@ -72,6 +72,7 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mPointVBO);
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, 3 * sizeof(float), &vertex[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, 3 * sizeof(float));
 
         // Set the vertex attribute pointers
         // Vertex position
@@ -113,6 +114,7 @@ namespace GLGeometry
         // Draw the point
         glBindVertexArray(mPointVAO);
         glDrawArrays(GL_POINTS, 0, 1);
+        RenderStats::addDraw(GL_POINTS, 1);
         glBindVertexArray(0);
         // Enable face culling again
         glEnable(GL_CULL_FACE);
@@ -143,6 +145,7 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mLineVBO);
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(vertices));
 
         // Set the vertex attribute pointers
         // Vertex position
@@ -179,6 +182,7 @@ namespace GLGeometry
         // Draw the two vertices of the line
         glBindVertexArray(mLineVAO);
         glDrawArrays(GL_LINES, 0, 2);
+        RenderStats::addDraw(GL_LINES, 2);
         glBindVertexArray(0);
     }
 
@@ -212,11 +216,13 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mRectangleVBO);
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(vertices));
 
         // Bind the EBO as an element array buffer
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mRectangleEBO);
         // Add the data to the EBO
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), &indices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(indices));
 
         // Set the vertex attribute pointers
         // Vertex position
@@ -248,6 +254,7 @@ namespace GLGeometry
         // Draw the two vertices of the line
         glBindVertexArray(mRectangleVAO);
         glDrawElements(GL_LINES, 8, GL_UNSIGNED_INT, 0);
+        RenderStats::addDraw(GL_LINES, 8);
         glBindVertexArray(0);
     }
 
@@ -305,11 +312,13 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mBoxVBO);
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(vertices));
 
         // Bind the EBO as an element array buffer
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mBoxEBO);
         // Add the data to the EBO
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), &indices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(indices));
 
         // Set the vertex attribute pointers
         // Vertex position
@@ -341,6 +350,7 @@ namespace GLGeometry
         // Draw the two vertices of the line
         glBindVertexArray(mBoxVAO);
         glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0);
+        RenderStats::addDraw(GL_LINES, 24);
         glBindVertexArray(0);
     }
 
@@ -396,11 +406,13 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mCylinderVBO);
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(float) * vertices.size());
 
         // Bind the EBO as an element array buffer
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mCylinderEBO);
         // Add the data to the EBO
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), &indices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(int) * indices.size());
 
         // Set the vertex attribute pointers
         // Vertex position
@@ -432,6 +444,7 @@ namespace GLGeometry
         // Draw the two vertices of the line
         glBindVertexArray(mCylinderVAO);
         glDrawElements(GL_LINES, 3 * 2 * mNrVerticesCylinder, GL_UNSIGNED_INT, 0);
+        RenderStats::addDraw(GL_LINES, 3 * 2 * mNrVerticesCylinder);
         glBindVertexArray(0);
     }
 
@@ -516,11 +529,13 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mSphereVBO);
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(float) * vertices.size());
 
         // Bind the EBO as an element array buffer
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mSphereEBO);
         // Add the data to the EBO
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), &indices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(int) * indices.size());
 
         // Set the vertex attribute pointers
         // Vertex position
@@ -553,6 +568,7 @@ namespace GLGeometry
         glBindVertexArray(mSphereVAO);
         glDrawElements(GL_LINES, 2 * 2 * mNrVerticesSphere * (2 * mNrVerticesSphere - 1), 
                        GL_UNSIGNED_INT, 0);
+        RenderStats::addDraw(GL_LINES, 2 * 2 * mNrVerticesSphere * (2 * mNrVerticesSphere - 1));
         glBindVertexArray(0);
     }
 
@@ -605,11 +621,13 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mConeVBO);
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices.size(), &vertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(float) * vertices.size());
 
         // Bind the EBO as an element array buffer
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mConeEBO);
         // Add the data to the EBO
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(int) * indices.size(), &indices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(int) * indices.size());
 
         // Set the vertex attribute pointers
         // Vertex position
@@ -641,6 +659,7 @@ namespace GLGeometry
         // Draw the two vertices of the line
         glBindVertexArray(mConeVAO);
         glDrawElements(GL_LINES, 3 * 2 * mNrVerticesCone, GL_UNSIGNED_INT, 0);
+        RenderStats::addDraw(GL_LINES, 3 * 2 * mNrVerticesCone);
         glBindVertexArray(0);
     }
 }
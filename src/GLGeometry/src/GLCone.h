@@ -25,8 +25,22 @@ namespace GLGeometry
             // Constructor
             GLCone(int nrVerticesCircle);
 
+            // Function to generate the vertices and indices of the mesh of the
+            // cone, without creating the buffers
+            static void generateMesh(int nrVerticesCircle, std::vector<Vertex>& vertices,
+                                     std::vector<unsigned int>& indices);
+
             // Function to render
             void draw();
+
+            // Function to render several instances of the cone
+            void drawInstanced(int nrInstances);
+
+            // Function to get the number of vertices in the circle of the base
+            int getNrVertices()
+            {
+                return mNrVertices;
+            }
     };
 }
 
@@ -75,6 +75,7 @@ namespace GLGeometry
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), 
                      &mVertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, mVertices.size() * sizeof(Vertex));
 
         // Set the vertex attribute pointers
         // Vertex positions
@@ -101,6 +102,16 @@ namespace GLGeometry
         glBindVertexArray(mVAO); // This also binds the corresponding EBO
         // glDrawArrays(GL_TRIANGLES, 0, 36);
         glDrawArrays(GL_TRIANGLES, 0, 36);
+        RenderStats::addDraw(GL_TRIANGLES, 36);
+        glBindVertexArray(0);
+    }
+
+    // Function to render several instances of the cube
+    void GLCube::drawInstanced(int nrInstances)
+    {
+        glBindVertexArray(mVAO);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, nrInstances);
+        RenderStats::addDraw(GL_TRIANGLES, 36, nrInstances);
         glBindVertexArray(0);
     }
 }
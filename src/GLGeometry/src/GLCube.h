@@ -21,6 +21,9 @@ namespace GLGeometry
 
             // Function to render
             void draw();
+
+            // Function to render several instances of the cube
+            void drawInstanced(int nrInstances);
     };
 }
 
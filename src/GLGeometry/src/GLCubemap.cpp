@@ -5,9 +5,9 @@ using namespace GLBase;
 namespace GLGeometry
 {
     // Constructor
-    GLCubemap::GLCubemap(const std::string& texturesPath, const char* vertexShaderPath,
-                      const char* fragmentShaderPath) :
-        mShader(vertexShaderPath, fragmentShaderPath)
+    GLCubemap::GLCubemap(const std::string& texturesPath, const char* vertexShaderName,
+                      const char* fragmentShaderName) :
+        mShader(EMBEDDED_SHADER, vertexShaderName, fragmentShaderName)
     {
         // Load the textures
         loadCubemap(texturesPath);
@@ -20,8 +20,8 @@ namespace GLGeometry
         setupScreenQuad();
     }
     // Constructor without textures
-    GLCubemap::GLCubemap(const char* vertexShaderPath, const char* fragmentShaderPath) :
-        mShader(vertexShaderPath, fragmentShaderPath)
+    GLCubemap::GLCubemap(const char* vertexShaderName, const char* fragmentShaderName) :
+        mShader(EMBEDDED_SHADER, vertexShaderName, fragmentShaderName)
     {
         // No textures to load, if no path for them is given
 
@@ -51,6 +51,7 @@ namespace GLGeometry
         glBindBuffer(GL_ARRAY_BUFFER, mScreenVBO);
         // Set the data in the VBO
         glBufferData(GL_ARRAY_BUFFER, sizeof(screenQuadVertices), &screenQuadVertices, GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, sizeof(screenQuadVertices));
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
         glEnableVertexAttribArray(1);
@@ -84,6 +85,7 @@ namespace GLGeometry
         // Draw the skybox quad
         glBindVertexArray(mScreenVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        RenderStats::addDraw(GL_TRIANGLES, 6);
 
         // Set again the depth function to LESS, and enable face culling
         // glDepthFunc(GL_LESS);
@@ -106,6 +108,7 @@ namespace GLGeometry
         // Draw the skybox quad
         glBindVertexArray(mScreenVAO);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        RenderStats::addDraw(GL_TRIANGLES, 6);
 
         // Set again the depth function to LESS, and enable face culling
         // glDepthFunc(GL_LESS);
@@ -134,17 +137,36 @@ namespace GLGeometry
         //  right - left - top - bottom - back - front
         int width, height, nrChannels;
         unsigned char* data;
+        std::vector<unsigned char> fileData;
+        std::vector<unsigned char> cookedPixels;
         // The textures should not be flipped, since cubemap images are expected to 
         // start at the top left, instead of the bottom left.
         stbi_set_flip_vertically_on_load(false);
         // Iterate over the faces
         for (int i = 0; i < sidesPaths.size(); ++i)
         {
-            // Load the data in each face
-            data = stbi_load(sidesPaths[i].c_str(), &width, &height, &nrChannels, 0);
+            // Load the data in each face, through the virtual file system
+            data = nullptr;
+            if (VirtualFileSystem::readFile(sidesPaths[i], fileData))
+            {
+                // Faces cooked by the assetcook tool are already decoded
+                if (readCookedTexture(fileData, false, 3, cookedPixels, width, height, nrChannels))
+                    data = cookedPixels.data();
+                else
+                    data = stbi_load_from_memory(fileData.data(), (int)fileData.size(), &width, &height,
+                                                 &nrChannels, 3);
+            }
+            if (data == nullptr)
+            {
+                std::cout << "Failed to load the cubemap face " << sidesPaths[i] << ".\n";
+                continue;
+            }
             // Generate the texture from the loaded data, in the corresponding face
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height,
                          0, GL_RGB, GL_UNSIGNED_BYTE, data);
+            RenderStats::add(RENDER_STAT_BYTES_UPLOADED, (std::uint64_t)width * height * 3);
+            if (data != cookedPixels.data())
+                stbi_image_free(data);
         }
         // Specify the wrapping and filtering methods for the cubemap texture.
         // The R dimension corresponds to the tird dimension, z.
@@ -13,12 +13,13 @@ namespace GLGeometry
             // Constructor
             // The default path for the textures is
             //      ../resources/textures/skybox
+            // The shaders are given by the names of embedded shaders
             GLCubemap(const std::string& texturesPath, 
-                      const char* vertexShaderPath = "../shaders/GLGeometry/skyboxVertex.glsl",
-                      const char* fragmentShaderPath = "../shaders/GLGeometry/skyboxFragment.glsl");
+                      const char* vertexShaderName = "GLGeometry/skyboxVertex.glsl",
+                      const char* fragmentShaderName = "GLGeometry/skyboxFragment.glsl");
             // Constructor without textures
-            GLCubemap(const char* vertexShaderPath = "../shaders/GLGeometry/skyboxVertex.glsl",
-                      const char* fragmentShaderPath = "../shaders/GLGeometry/skyboxFragmentFlat.glsl");
+            GLCubemap(const char* vertexShaderName = "GLGeometry/skyboxVertex.glsl",
+                      const char* fragmentShaderName = "GLGeometry/skyboxFragmentFlat.glsl");
 
             // Setup the screen quad
             void setupScreenQuad();
@@ -25,8 +25,16 @@ namespace GLGeometry
             // Constructor
             GLCylinder(int nrVerticesCircle);
 
+            // Function to generate the vertices and indices of the mesh of the
+            // cylinder, without creating the buffers
+            static void generateMesh(int nrVerticesCircle, std::vector<Vertex>& vertices,
+                                     std::vector<unsigned int>& indices);
+
             // Function to render
             void draw();
+
+            // Function to render several instances of the cylinder
+            void drawInstanced(int nrInstances);
     };
 }
 
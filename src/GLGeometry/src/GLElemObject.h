@@ -48,8 +48,31 @@ namespace GLGeometry
                 return mModelMatrix;
             }
 
+            // Function to get a sphere containing the object in world space
+            // The meshes of the elementary objects fit in the unit cube centered
+            // at the origin, so it is the sphere around that cube
+            void getBoundingSphere(glm::vec3& center, float& radius)
+            {
+                center = glm::vec3(mModelMatrix[3]);
+                const float maxScale { glm::max(glm::length(glm::vec3(mModelMatrix[0])),
+                                       glm::max(glm::length(glm::vec3(mModelMatrix[1])),
+                                                glm::length(glm::vec3(mModelMatrix[2])))) };
+                radius = 0.5f * glm::sqrt(3.f) * maxScale;
+            }
+
+            // Function to get the vertex array object, for instance to add
+            // per-instance attributes to it
+            unsigned int getVAO()
+            {
+                return mVAO;
+            }
+
             // // Function to render
             // virtual void draw() = 0;
+
+            // Function to render several instances of the object, which the
+            // shader can tell apart with gl_InstanceID
+            virtual void drawInstanced(int nrInstances) = 0;
     };
 }
 
@@ -9,6 +9,9 @@ namespace GLGeometry
     {
         public:
             GLObject() {};
+            // Destructor, virtual so the objects can be deleted through a
+            // pointer to this class
+            virtual ~GLObject() {};
             // Function to render
             virtual void draw() = 0;
 
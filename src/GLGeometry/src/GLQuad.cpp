@@ -42,12 +42,14 @@ namespace GLGeometry
         // Add the data to the VBO
         glBufferData(GL_ARRAY_BUFFER, mVertices.size() * sizeof(Vertex), 
                      &mVertices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, mVertices.size() * sizeof(Vertex));
 
         // Bind the EBO as an element array buffer
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mEBO);
         // Add the data to the EBO
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, mIndices.size() * sizeof(unsigned int),
                      &mIndices[0], GL_STATIC_DRAW);
+        RenderStats::add(RENDER_STAT_BYTES_UPLOADED, mIndices.size() * sizeof(unsigned int));
 
         // Set the vertex attribute pointers
         // Vertex positions
@@ -75,6 +77,20 @@ namespace GLGeometry
         // Draw the quad
         glBindVertexArray(mVAO); // This also binds the corresponding EBO
         glDrawElements(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0);
+        RenderStats::addDraw(GL_TRIANGLES, mIndices.size());
+        glBindVertexArray(0);
+        // Enable face culling again
+        glEnable(GL_CULL_FACE);
+    }
+
+    // Function to render several instances of the quad
+    void GLQuad::drawInstanced(int nrInstances)
+    {
+        // Disable face culling for drawing the plane
+        glDisable(GL_CULL_FACE);
+        glBindVertexArray(mVAO); // This also binds the corresponding EBO
+        glDrawElementsInstanced(GL_TRIANGLES, mIndices.size(), GL_UNSIGNED_INT, 0, nrInstances);
+        RenderStats::addDraw(GL_TRIANGLES, mIndices.size(), nrInstances);
         glBindVertexArray(0);
         // Enable face culling again
         glEnable(GL_CULL_FACE);
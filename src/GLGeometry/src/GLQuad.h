@@ -24,6 +24,9 @@ namespace GLGeometry
 
             // Function to render
             void draw();
+
+            // Function to render several instances of the quad
+            void drawInstanced(int nrInstances);
     };
 }
 
@@ -23,8 +23,22 @@ namespace GLGeometry
             // Constructor
             GLSphere(int nrVertices);
 
+            // Function to generate the vertices and indices of the mesh of the
+            // sphere, without creating the buffers
+            static void generateMesh(int nrVertices, std::vector<Vertex>& vertices,
+                                     std::vector<unsigned int>& indices);
+
             // Function to render
             void draw();
+
+            // Function to render several instances of the sphere
+            void drawInstanced(int nrInstances);
+
+            // Function to get the number of vertices in each circle
+            int getNrVertices()
+            {
+                return mNrVertices;
+            }
     };
 }
 
@@ -39,11 +39,13 @@ void GLSandbox::setupScene()
     mElementaryObjects.push_back(new GLCone(32));
 
     // Load a shader
-    mShaders.push_back(Shader("../shaders/vertex.glsl", "../shaders/fragment.glsl"));
+    mShaders.push_back(Shader(EMBEDDED_SHADER, "vertex.glsl", "fragment.glsl"));
 
     // Load a shader for the geometry pass
-    mGPassShaders.push_back(Shader("../shaders/GLBase/defGeometryPassVertex.glsl",
-                                   "../shaders/GLBase/defGeometryPassFragment.glsl"));
+    mGPassShaders.push_back(Shader(EMBEDDED_SHADER, "GLBase/defGeometryPassVertex.glsl",
+                                   "GLBase/defGeometryPassFragment.glsl"));
+    // Configure it for the layout of the G-buffer of the renderer
+    mRenderer.configureGeometryShader(mGPassShaders[0]);
 
     // Add some point lights
     for (int i = 0; i < 10; ++i)
@@ -80,6 +82,13 @@ void GLSandbox::setupApplication()
     mApplication.setCamera(&mCamera);
     // Pass a pointer to the input handler
     mApplication.setInputHandler(&mInputHandler);
+    // Pass a pointer to the renderer, so it is resized with the window
+    mApplication.setRenderer(&mRenderer);
+    // Measure the GPU time of the passes of the frame graph and the renderer
+    mFrameGraph.setGPUProfiler(&mGPUProfiler);
+    mRenderer.setGPUProfiler(&mGPUProfiler);
+    // Show the timings of the passes in the HUD
+    mHUD.setGPUProfiler(&mGPUProfiler);
     // // Configure the frustum of the camera
     // mCamera.setFrustum(0.1f, 50.f);
 
@@ -90,6 +99,24 @@ void GLSandbox::setupApplication()
 
     // Pass the list of lights to the renderer, to configure the lighting shader
     mRenderer.configureLights(mLights);
+    // Compute only the point and spot lights in the cluster of each pixel
+    mRenderer.setLightingMode(LIGHTING_CLUSTERED);
+    // // Filter the shadows of the directional light and the spot light with
+    // // variance shadow maps, blurred when they are rendered
+    // mLights[10]->setShadowFilter(SHADOW_FILTER_VSM);
+    // mLights[11]->setShadowFilter(SHADOW_FILTER_VSM);
+    // // Place the cascades of the directional light in the range of depth of
+    // // the visible pixels, instead of between the near and far planes
+    // mRenderer.setCascadeSplitMode(CASCADE_SPLITS_SDSM);
+    // // Shade at most 8 point and spot lights, and only 2 of them with shadows
+    // mRenderer.setLightBudgets(8, 2);
+    // // Change the render resolution to hold a GPU frame time of 16 ms, rendering
+    // // at least half of the window resolution in each axis
+    // mRenderer.setDynamicResolution(true, 16.f, 0.5f);
+    // // Render at 60% of the window resolution, and reconstruct the full resolution
+    // // with the temporal upscaling
+    // mRenderer.setTemporalUpscaling(true);
+    // mRenderer.setRenderScale(0.6f);
 }
 
 // Method to run on each frame, to update the scene
@@ -98,12 +125,19 @@ void GLSandbox::updateScene()
     // // Set the camera to be orthographic
     // mCamera.setOrthographic();
 
+    // Pass the jitter of the temporal upscaling to the camera, if it is enabled
+    mCamera.setJitter(mRenderer.getJitter());
+
     // Get the view and projection matrices
     mProjection = mCamera.getProjectionMatrix();
     mView = mCamera.getViewMatrix();
 
     // Update the skymap
     mSkymap->setViewProjection(mView, mProjection);
+    // Pass the matrices to the renderer, for drawing the light volumes
+    mRenderer.setViewProjection(mView, mProjection);
+    // Cull the point and spot lights outside of the view frustum
+    mRenderer.updateLightVisibility(mLights);
 
     // Move the quad
     mElementaryObjects[0]->setModelMatrix(glm::vec3(0., -1., 0.), -90., glm::vec3(1.,0.,0.), glm::vec3(15.,15.,15.));
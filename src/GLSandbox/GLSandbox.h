@@ -26,6 +26,12 @@ class GLSandbox
 
         // Renderer
         DeferredRenderer mRenderer;
+        // Graph of the passes of each frame
+        FrameGraph mFrameGraph;
+        // Profiler of the GPU time of the passes
+        GPUProfiler mGPUProfiler;
+        // Overlay with the timings and statistics of the frames
+        PerformanceHUD mHUD;
         // Reference to the shader of the Lighting pass
         Shader& mLightingShader;
         // Shaders for the geometry pass
@@ -88,6 +94,9 @@ class GLSandbox
         // Render the geometry that will use forward rendering
         void renderForward();
 
+        // Build the graph of the passes of the frame
+        void buildFrameGraph();
+
     public:
         // Constructor
         GLSandbox(int width, int height, const char* title);
@@ -14,7 +14,9 @@ GLSandbox::GLSandbox(int width, int height, const char* title) :
     mLightingShader ( mRenderer.getLightingShader() ) // Reference to the G-pass shader of the renderer
 {
     // Seed a random number generator, with the function defined in utils.h
-    GLUtils::seedRandomGeneratorClock();
+    // The seed is taken from the clock by the recorder of the input, which
+    // stores it with the recording, so a replay builds the same scene
+    GLUtils::seedRandomGenerator(mApplication.getInputRecorder().getSeed());
 
     // Setup the scene
     setupScene();
@@ -26,50 +28,66 @@ GLSandbox::GLSandbox(int width, int height, const char* title) :
 // Start the application's loop
 void GLSandbox::run()
 {
+    GLBASE_PROFILE_THREAD("Main");
+    // // Write the last frames of the CPU profiler to a trace when a frame
+    // // takes more than 50 ms
+    // CPUProfiler::setSpikeDetection(50.);
+    // The render statistics, the frame graph and the profiles are only written
+    // if the environment variable GLBASE_DUMP_DIR is set, to that directory
+    const char* dumpVariable { std::getenv("GLBASE_DUMP_DIR") };
+    const std::string dumpDirectory { dumpVariable != nullptr ? std::string(dumpVariable) + "/" : "" };
+    // Write the render statistics every 60 frames
+    if (dumpVariable != nullptr)
+        RenderStats::setDump(dumpDirectory + "renderStats.csv", 60);
+
     while(!mApplication.mShouldClose)
     {
+        // Start the frame of the CPU and GPU profilers
+        GLBASE_PROFILE_FRAME();
+        mGPUProfiler.beginFrame();
+
         // Start the renderer
         // This also clears the window
         mRenderer.startFrame();
 
         // Compute the time since the last frame
-        float currentFrame = glfwGetTime();
+        float currentFrame = mApplication.getTime();
         mDeltaTime = currentFrame - mLastFrame;
         mLastFrame = currentFrame;
 
         // Process input for all the objects in the scene
-        mApplication.processKeyboardInput(mDeltaTime);
+        // When the input is replayed, the time step is the recorded one
+        mDeltaTime = mApplication.processKeyboardInput(mDeltaTime);
 
         // Store in memory the time at the beginning of the drawing
-        float thisFrameTime { (float)glfwGetTime() };
+        float thisFrameTime { (float)mApplication.getTime() };
 
         // Update the scene
-        updateScene();
-
-        // Compute the shadow maps
-        mRenderer.computeShadowMaps(mCamera, mLights, mElementaryObjects);
-
-        // Start the geometry pass
-        mRenderer.startGeometryPass();
-
-        // Render the geometry that will use deferred rendering
-        renderDeferred();
-
-        // Do the shading pass
-        mRenderer.processGBuffer(mCamera.Position, mLights);
-
-        // Render the geometry that will use forward rendering
-        renderForward();
+        {
+            GLBASE_PROFILE_ZONE("Update scene");
+            updateScene();
+        }
 
-        // End the renderer, which produces the final scene from the g-buffer
-        mRenderer.endFrame(mSkymap);
-        // mRenderer.endFrame(mSkymap, mAuxElements);
+        // Build the graph of the passes of this frame, and execute it
+        {
+            GLBASE_PROFILE_ZONE("Frame graph");
+            buildFrameGraph();
+            if (mFrameGraph.compile())
+                mFrameGraph.execute();
+        }
+        mGPUProfiler.endFrame();
 
         // Update the window, swapping the buffers
-        mApplication.updateWindow();
+        {
+            GLBASE_PROFILE_ZONE("Update window");
+            mApplication.updateWindow();
+        }
 
         // Add the duration of this frame to the counter
-        mTotalTime += (float)glfwGetTime() - thisFrameTime;
+        const float frameTime { (float)mApplication.getTime() - thisFrameTime };
+        mTotalTime += frameTime;
+        // End the frame of the render statistics
+        RenderStats::endFrame(frameTime * 1000.);
         // Add one to the counter
         ++mFrameCounter;
         // Every 60 frames, print the amount of time that each of them takes
@@ -79,12 +97,30 @@ void GLSandbox::run()
             // std::cout << "Average frame duration: " << mTotalTime * 1000 / mFrameCounter << " ms\n";
             ss << "Averate frame time: " << mTotalTime * 1000 / mFrameCounter << " ms - ";
             ss << "FPS: " << 1000. / (mTotalTime * 1000 / mFrameCounter);
+            if (mGPUProfiler.hasResults())
+            {
+                const GPUProfileFrame& frame { mGPUProfiler.getLastFrame() };
+                ss << " - GPU: " << frame.gpuEndMs - frame.gpuStartMs << " ms";
+            }
+            ss << " - Draw calls: " << RenderStats::get(RENDER_STAT_DRAW_CALLS);
+            ss << " - p99: " << RenderStats::getFrameTimePercentile(99.) << " ms";
             // Reset the variables
             mFrameCounter = 0;
             mTotalTime = 0;
 
             // Change the title of the application
             mApplication.setTitle(ss.str().c_str());
+
+            if (dumpVariable != nullptr)
+            {
+                // Write the graph of this frame, with the GPU time of each pass
+                mFrameGraph.saveGraphviz(dumpDirectory + "frameGraph.dot");
+                // Write the CPU and GPU timings of the last frames as a trace
+                mGPUProfiler.saveChromeTrace(dumpDirectory + "gpuProfile.json");
+#ifdef GLBASE_CPU_PROFILER
+                CPUProfiler::saveChromeTrace(dumpDirectory + "cpuProfile.json");
+#endif
+            }
         }
 
         // // Wait for the use to press a key
@@ -96,3 +132,86 @@ void GLSandbox::run()
 
     std::cout << "Execution stopped\n";
 }
+
+// Build the graph of the passes of the frame
+// The render targets of the renderer are imported, since they are shared
+// between its passes, and the resources only express the order of the passes
+void GLSandbox::buildFrameGraph()
+{
+    mFrameGraph.reset();
+
+    const FrameGraphTextureDesc renderDesc { mRenderer.getRenderWidth(), mRenderer.getRenderHeight(), 0 };
+    const unsigned int shadowMaps { mFrameGraph.importTexture("Shadow maps", 0) };
+    const unsigned int gBuffer { mFrameGraph.importTexture("G-buffer", 0, renderDesc) };
+    const unsigned int litTarget { mFrameGraph.importTexture("Lit target", 0, renderDesc) };
+    const unsigned int backbuffer { mFrameGraph.importTexture("Backbuffer", 0) };
+    mFrameGraph.markOutput(backbuffer);
+
+    // Compute the shadow maps
+    mFrameGraph.addPass("Shadow maps",
+        [&](FrameGraphBuilder& builder) { builder.write(shadowMaps); },
+        [this](const FrameGraphResources&)
+        {
+            mRenderer.computeShadowMaps(mCamera, mLights, mElementaryObjects);
+        });
+
+    // Render the geometry that will use deferred rendering to the G-buffer
+    mFrameGraph.addPass("Geometry",
+        [&](FrameGraphBuilder& builder) { builder.write(gBuffer); },
+        [this](const FrameGraphResources&)
+        {
+            mRenderer.startGeometryPass();
+            renderDeferred();
+        });
+
+    // Do the shading pass
+    mFrameGraph.addPass("Lighting",
+        [&](FrameGraphBuilder& builder)
+        {
+            builder.read(gBuffer);
+            builder.read(shadowMaps);
+            builder.write(litTarget);
+        },
+        [this](const FrameGraphResources&)
+        {
+            mRenderer.processGBuffer(mCamera.Position, mLights);
+        });
+
+    // Render the geometry that will use forward rendering, over the lit image
+    mFrameGraph.addPass("Forward",
+        [&](FrameGraphBuilder& builder)
+        {
+            builder.read(litTarget);
+            builder.write(litTarget);
+        },
+        [this](const FrameGraphResources&)
+        {
+            renderForward();
+        });
+
+    // Produce the final image of the frame in the window
+    mFrameGraph.addPass("Present",
+        [&](FrameGraphBuilder& builder)
+        {
+            builder.read(litTarget);
+            builder.write(backbuffer);
+            builder.setSideEffect();
+        },
+        [this](const FrameGraphResources&)
+        {
+            mRenderer.endFrame(mSkymap);
+            // mRenderer.endFrame(mSkymap, mAuxElements);
+        });
+
+    // Draw the HUD over the final image
+    mFrameGraph.addPass("HUD",
+        [&](FrameGraphBuilder& builder)
+        {
+            builder.read(backbuffer);
+            builder.write(backbuffer);
+        },
+        [this](const FrameGraphResources&)
+        {
+            mHUD.draw(mApplication.getWidth(), mApplication.getHeight());
+        });
+}
@@ -0,0 +1,855 @@
+// Tool to cook the assets of an application into an archive that can be
+// mounted with GLBase::VirtualFileSystem.
+//
+// Usage:
+//      assetcook [options] <asset directory>...
+//
+// Options:
+//      -o, --output <file>     Archive to create (default: assets.glba)
+//      --root <directory>      Directory the names of the entries are relative
+//                              to (default: the current directory)
+//      --db <file>             Database of the cooked assets (default: the
+//                              archive followed by .db)
+//      -j, --jobs <n>          Number of threads (default: one per core)
+//      -n, --dry-run           Only report the assets that would be cooked
+//      -f, --force             Cook all the assets
+//      --no-compress           Store the entries of the archive without LZ4
+//      -v, --verbose           Print every asset, even if it is up to date
+//
+// Each asset is cooked to the format its loader consumes at runtime:
+//      Shaders         comments and blank lines removed
+//      Textures        decoded to a cooked texture (no PNG/JPG decoding when loaded)
+//      Models          imported with Assimp to a cooked model (Assimp not used when loaded)
+//      Anything else   copied as is
+// Cooked assets keep the name of their source, so the application finds them
+// at the same paths once the archive is mounted.
+//
+// The database stores the content hash of the inputs of every asset (the
+// file itself and, for models, every file Assimp opened while importing it)
+// together with a hash of the cook parameters. Only the assets whose hashes
+// changed are cooked again. The cooked outputs are kept in a cache directory
+// next to the archive, so the archive can be rebuilt without cooking the
+// assets that did not change.
+
+#include "GLBase.h"
+
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <set>
+
+using namespace GLBase;
+
+namespace fs = std::filesystem;
+
+// Version of the cooker. Changing it invalidates all the cooked assets
+constexpr uint32_t COOKER_VERSION { 1 };
+
+// Kinds of assets
+enum AssetKind
+{
+    ASSET_SHADER,
+    ASSET_TEXTURE,
+    ASSET_MODEL,
+    ASSET_COPY,
+    NR_ASSET_KINDS
+};
+
+// Names of the kinds of assets, used in the database and the reports
+const char* ASSET_KIND_NAMES[NR_ASSET_KINDS] { "shader", "texture", "model", "copy" };
+
+// Options given in the command line
+struct CookOptions
+{
+    std::vector<std::string> assetDirectories;
+    std::string output { "assets.glba" };
+    std::string root { "." };
+    std::string database;
+    unsigned int jobs { 0 };
+    bool dryRun { false };
+    bool force { false };
+    bool compress { true };
+    bool verbose { false };
+};
+
+// Input of an asset, identified by its path in the disk
+struct Dependency
+{
+    std::string path;
+    uint64_t size;
+    int64_t modificationTime;
+    uint64_t hash;
+};
+
+// Record of the database for a cooked asset
+struct DatabaseEntry
+{
+    AssetKind kind;
+    uint64_t parametersHash;
+    // The first dependency is the asset itself
+    std::vector<Dependency> dependencies;
+};
+
+// Asset found in the asset directories
+struct Asset
+{
+    // Name of the entry in the archive and path in the disk
+    std::string name;
+    std::string path;
+    AssetKind kind;
+    uint64_t parametersHash;
+
+    // Reason to cook the asset. Empty if it is up to date
+    std::string reason;
+
+    // Result of the cook
+    bool failed { false };
+    std::string error;
+    double cookTime { 0.0 };
+    size_t cookedSize { 0 };
+    DatabaseEntry record;
+};
+
+// Mutex used to print from several threads
+std::mutex gOutputMutex;
+
+//==============================
+// Utilities
+//==============================
+
+// Get the current time, in seconds
+double getTime()
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// 64 bit FNV-1a hash of some data
+uint64_t hashData(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Hash of a string
+uint64_t hashString(const std::string& text)
+{
+    return hashData(reinterpret_cast<const unsigned char*>(text.data()), text.size());
+}
+
+// Write a hash as hexadecimal
+std::string toHex(uint64_t value)
+{
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << value;
+    return stream.str();
+}
+
+// Read a whole file from the disk
+bool readDiskFile(const std::string& path, std::vector<unsigned char>& data)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+    const std::streamsize size { file.tellg() };
+    file.seekg(0, std::ios::beg);
+    data.resize(size);
+    return (bool)file.read(reinterpret_cast<char*>(data.data()), size);
+}
+
+// Write a whole file to the disk
+bool writeDiskFile(const std::string& path, const std::vector<unsigned char>& data)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return (bool)file;
+}
+
+// Get the size and modification time of a file. Returns false if it does not exist
+bool getFileStamp(const std::string& path, uint64_t& size, int64_t& modificationTime)
+{
+    std::error_code error;
+    size = fs::file_size(path, error);
+    if (error)
+        return false;
+    modificationTime = fs::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+}
+
+// Create a dependency from the data of a file that has been read
+Dependency makeDependency(const std::string& path, const std::vector<unsigned char>& data)
+{
+    Dependency dependency { path, data.size(), 0, hashData(data.data(), data.size()) };
+    uint64_t size;
+    getFileStamp(path, size, dependency.modificationTime);
+    return dependency;
+}
+
+// Get the kind of an asset from its extension
+AssetKind getAssetKind(const fs::path& path)
+{
+    std::string extension { path.extension().string() };
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return (char)std::tolower(c); });
+
+    if (extension == ".glsl" || extension == ".vert" || extension == ".frag" ||
+        extension == ".geom" || extension == ".vs" || extension == ".fs" || extension == ".gs")
+        return ASSET_SHADER;
+    if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" ||
+        extension == ".tga" || extension == ".bmp")
+        return ASSET_TEXTURE;
+    if (extension == ".obj" || extension == ".fbx" || extension == ".dae" || extension == ".gltf" ||
+        extension == ".glb" || extension == ".3ds" || extension == ".blend" || extension == ".ply")
+        return ASSET_MODEL;
+    return ASSET_COPY;
+}
+
+// Run a function for the indices [0, count) in several threads
+template <typename Function>
+void runParallel(size_t count, unsigned int nrThreads, Function function)
+{
+    std::atomic<size_t> next { 0 };
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+            function(i);
+    };
+
+    nrThreads = (unsigned int)std::min<size_t>(nrThreads, count);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < nrThreads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+//==============================
+// Database
+//==============================
+
+// Load the database. The format is a text file with one line per asset,
+// followed by one line per dependency:
+//      asset <kind> <parameters hash> <number of dependencies> <name>
+//      dep <size> <modification time> <hash> <path>
+std::map<std::string, DatabaseEntry> loadDatabase(const std::string& path)
+{
+    std::map<std::string, DatabaseEntry> database;
+    std::ifstream file(path);
+    if (!file)
+        return database;
+
+    std::string line;
+    std::getline(file, line);
+    if (line != "assetcook " + std::to_string(COOKER_VERSION))
+    {
+        std::cout << "The database " << path << " is from another version and will be ignored.\n";
+        return database;
+    }
+
+    // A malformed line invalidates the whole database, so every asset is
+    // cooked again
+    DatabaseEntry* current { nullptr };
+    unsigned int lineNumber { 1 };
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+        std::istringstream stream(line);
+        std::string tag;
+        stream >> tag;
+        try
+        {
+            if (tag == "asset")
+            {
+                std::string kind, parametersHash, name;
+                size_t nrDependencies;
+                stream >> kind >> parametersHash >> nrDependencies;
+                std::getline(stream >> std::ws, name);
+                if (!stream && name.empty())
+                    throw std::invalid_argument("incomplete asset");
+
+                DatabaseEntry entry { ASSET_COPY, std::stoull(parametersHash, nullptr, 16), {} };
+                for (int i = 0; i < NR_ASSET_KINDS; ++i)
+                {
+                    if (kind == ASSET_KIND_NAMES[i])
+                        entry.kind = (AssetKind)i;
+                }
+                current = &(database[name] = entry);
+            }
+            else if (tag == "dep" && current != nullptr)
+            {
+                Dependency dependency;
+                std::string hash;
+                stream >> dependency.size >> dependency.modificationTime >> hash;
+                std::getline(stream >> std::ws, dependency.path);
+                if (!stream && dependency.path.empty())
+                    throw std::invalid_argument("incomplete dependency");
+                dependency.hash = std::stoull(hash, nullptr, 16);
+                current->dependencies.push_back(dependency);
+            }
+        }
+        catch (const std::exception& exception)
+        {
+            std::cout << "ERROR::ASSETCOOK::INVALID_DATABASE " << path << ":" << lineNumber
+                      << ": " << exception.what() << std::endl;
+            database.clear();
+            return database;
+        }
+    }
+
+    return database;
+}
+
+// Save the database
+bool saveDatabase(const std::string& path, const std::map<std::string, DatabaseEntry>& database)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+        return false;
+
+    file << "assetcook " << COOKER_VERSION << '\n';
+    for (const auto& [name, entry] : database)
+    {
+        file << "asset " << ASSET_KIND_NAMES[entry.kind] << ' ' << toHex(entry.parametersHash) << ' '
+             << entry.dependencies.size() << ' ' << name << '\n';
+        for (const Dependency& dependency : entry.dependencies)
+            file << "dep " << dependency.size << ' ' << dependency.modificationTime << ' '
+                 << toHex(dependency.hash) << ' ' << dependency.path << '\n';
+    }
+    return (bool)file;
+}
+
+// Check if a dependency changed since it was recorded. The content is only
+// hashed again when the size or the modification time of the file changed
+bool dependencyChanged(const Dependency& dependency)
+{
+    uint64_t size;
+    int64_t modificationTime;
+    if (!getFileStamp(dependency.path, size, modificationTime))
+        return true;
+    if (size != dependency.size)
+        return true;
+    if (modificationTime == dependency.modificationTime)
+        return false;
+
+    std::vector<unsigned char> data;
+    if (!readDiskFile(dependency.path, data))
+        return true;
+    return hashData(data.data(), data.size()) != dependency.hash;
+}
+
+//==============================
+// Cookers
+//==============================
+
+// Cook a shader, removing the comments, the indentation and the blank lines
+void cookShader(const std::vector<unsigned char>& source, std::vector<unsigned char>& output)
+{
+    // Remove the comments, keeping the line breaks
+    std::string code;
+    code.reserve(source.size());
+    for (size_t i = 0; i < source.size(); ++i)
+    {
+        if (source[i] == '/' && i + 1 < source.size() && source[i + 1] == '/')
+        {
+            while (i < source.size() && source[i] != '\n')
+                ++i;
+            if (i < source.size())
+                code += '\n';
+        }
+        else if (source[i] == '/' && i + 1 < source.size() && source[i + 1] == '*')
+        {
+            i += 2;
+            while (i + 1 < source.size() && !(source[i] == '*' && source[i + 1] == '/'))
+            {
+                if (source[i] == '\n')
+                    code += '\n';
+                ++i;
+            }
+            ++i;
+            // A block comment separates tokens
+            code += ' ';
+        }
+        else
+        {
+            code += (char)source[i];
+        }
+    }
+
+    // Remove the whitespace at both ends of each line, and the blank lines
+    output.clear();
+    std::istringstream stream(code);
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        const size_t first { line.find_first_not_of(" \t\r") };
+        if (first == std::string::npos)
+            continue;
+        const size_t last { line.find_last_not_of(" \t\r") };
+        output.insert(output.end(), line.begin() + first, line.begin() + last + 1);
+        output.push_back('\n');
+    }
+}
+
+// Cook a texture, decoding it
+bool cookTexture(const std::vector<unsigned char>& source, std::vector<unsigned char>& output,
+                 std::string& error)
+{
+    // The vertical flip is global in stb_image, so it is never enabled here.
+    // The cooked texture stores the rows in the order loadTexture needs.
+    int width, height, nrChannels;
+    unsigned char* pixels { stbi_load_from_memory(source.data(), (int)source.size(),
+                                                  &width, &height, &nrChannels, 0) };
+    if (pixels == nullptr)
+    {
+        error = stbi_failure_reason();
+        return false;
+    }
+    writeCookedTexture(pixels, width, height, nrChannels, output);
+    stbi_image_free(pixels);
+    return true;
+}
+
+// File system used by Assimp while cooking a model, that records every file
+// opened so they can be tracked as dependencies
+class RecordingIOSystem : public Assimp::IOSystem
+{
+    public:
+        std::vector<Dependency> openedFiles;
+
+        bool Exists(const char* path) const
+        {
+            return fs::is_regular_file(path);
+        }
+
+        char getOsSeparator() const
+        {
+            return '/';
+        }
+
+        Assimp::IOStream* Open(const char* path, const char* mode = "rb")
+        {
+            if (std::strchr(mode, 'w') != nullptr || std::strchr(mode, 'a') != nullptr)
+                return nullptr;
+
+            std::vector<unsigned char> data;
+            if (!readDiskFile(path, data))
+                return nullptr;
+
+            // The same file can be opened several times
+            const std::string normalized { fs::path(path).lexically_normal().generic_string() };
+            bool recorded { false };
+            for (const Dependency& dependency : openedFiles)
+                recorded = recorded || dependency.path == normalized;
+            if (!recorded)
+                openedFiles.push_back(makeDependency(normalized, data));
+
+            return new VFSAssimpStream(std::move(data));
+        }
+
+        void Close(Assimp::IOStream* stream)
+        {
+            delete stream;
+        }
+};
+
+// Get the textures of a type in a material
+void getMaterialTextures(aiMaterial* material, aiTextureType type, const std::string& typeName,
+                         std::vector<CookedTextureReference>& textures)
+{
+    for (unsigned int i = 0; i < material->GetTextureCount(type); ++i)
+    {
+        aiString path;
+        material->GetTexture(type, i, &path);
+        textures.push_back({ typeName, path.C_Str() });
+    }
+}
+
+// Recursively convert the meshes of a node and its children, in the same
+// order as Model::processNode
+void convertNode(aiNode* node, const aiScene* scene, std::vector<CookedMesh>& meshes)
+{
+    for (unsigned int i = 0; i < node->mNumMeshes; ++i)
+    {
+        aiMesh* mesh { scene->mMeshes[node->mMeshes[i]] };
+        CookedMesh cooked;
+
+        cooked.vertices.resize(mesh->mNumVertices);
+        for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+        {
+            Vertex& vertex { cooked.vertices[v] };
+            vertex.Position = glm::vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+            if (mesh->mNormals)
+                vertex.Normal = glm::vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z);
+            else
+                vertex.Normal = glm::vec3(0.f);
+            if (mesh->mTextureCoords[0])
+                vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y);
+            else
+                vertex.TexCoords = glm::vec2(0.f);
+        }
+
+        for (unsigned int f = 0; f < mesh->mNumFaces; ++f)
+        {
+            const aiFace& face { mesh->mFaces[f] };
+            cooked.indices.insert(cooked.indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
+        }
+
+        aiMaterial* material { scene->mMaterials[mesh->mMaterialIndex] };
+        getMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", cooked.textures);
+        getMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", cooked.textures);
+        getMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal", cooked.textures);
+        getMaterialTextures(material, aiTextureType_AMBIENT, "texture_height", cooked.textures);
+
+        meshes.push_back(std::move(cooked));
+    }
+
+    for (unsigned int i = 0; i < node->mNumChildren; ++i)
+        convertNode(node->mChildren[i], scene, meshes);
+}
+
+// Cook a model, importing it with the same options as Model::loadModel
+bool cookModel(const std::string& path, std::vector<unsigned char>& output,
+               std::vector<Dependency>& dependencies, std::string& error)
+{
+    RecordingIOSystem* ioSystem { new RecordingIOSystem() };
+    Assimp::Importer importer;
+    // The importer takes ownership of the IO system
+    importer.SetIOHandler(ioSystem);
+    const aiScene* scene { importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs) };
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+    {
+        error = importer.GetErrorString();
+        return false;
+    }
+
+    std::vector<CookedMesh> meshes;
+    convertNode(scene->mRootNode, scene, meshes);
+    writeCookedModel(meshes, output);
+
+    // The model itself is already the first dependency
+    for (const Dependency& dependency : ioSystem->openedFiles)
+    {
+        if (dependency.path != dependencies[0].path)
+            dependencies.push_back(dependency);
+    }
+    return true;
+}
+
+// Cook an asset, and store the result in the cache
+void cookAsset(Asset& asset, const std::string& cacheFile)
+{
+    const double start { getTime() };
+
+    std::vector<unsigned char> source;
+    if (!readDiskFile(asset.path, source))
+    {
+        asset.failed = true;
+        asset.error = "cannot read the file";
+        return;
+    }
+    asset.record = { asset.kind, asset.parametersHash, { makeDependency(asset.path, source) } };
+
+    std::vector<unsigned char> output;
+    bool success { true };
+    switch (asset.kind)
+    {
+        case ASSET_SHADER:
+            cookShader(source, output);
+            break;
+        case ASSET_TEXTURE:
+            success = cookTexture(source, output, asset.error);
+            break;
+        case ASSET_MODEL:
+            success = cookModel(asset.path, output, asset.record.dependencies, asset.error);
+            break;
+        default:
+            output = std::move(source);
+            break;
+    }
+
+    if (success && !writeDiskFile(cacheFile, output))
+    {
+        success = false;
+        asset.error = "cannot write " + cacheFile;
+    }
+
+    asset.failed = !success;
+    asset.cookedSize = output.size();
+    asset.cookTime = getTime() - start;
+}
+
+//==============================
+// Main program
+//==============================
+
+// Print the usage of the tool
+void printUsage()
+{
+    std::cout << "Usage: assetcook [options] <asset directory>...\n"
+              << "  -o, --output <file>   archive to create (default: assets.glba)\n"
+              << "  --root <directory>    directory the names are relative to (default: .)\n"
+              << "  --db <file>           database of cooked assets (default: <output>.db)\n"
+              << "  -j, --jobs <n>        number of threads (default: one per core)\n"
+              << "  -n, --dry-run         only report what would be cooked\n"
+              << "  -f, --force           cook all the assets\n"
+              << "  --no-compress         do not compress the entries of the archive\n"
+              << "  -v, --verbose         print also the assets that are up to date\n";
+}
+
+// Parse the command line. Returns false if it is not valid
+bool parseOptions(int argc, char* argv[], CookOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument { argv[i] };
+        const bool hasValue { i + 1 < argc };
+        if ((argument == "-o" || argument == "--output") && hasValue)
+            options.output = argv[++i];
+        else if (argument == "--root" && hasValue)
+            options.root = argv[++i];
+        else if (argument == "--db" && hasValue)
+            options.database = argv[++i];
+        else if ((argument == "-j" || argument == "--jobs") && hasValue)
+            options.jobs = (unsigned int)std::max(1, std::atoi(argv[++i]));
+        else if (argument == "-n" || argument == "--dry-run")
+            options.dryRun = true;
+        else if (argument == "-f" || argument == "--force")
+            options.force = true;
+        else if (argument == "--no-compress")
+            options.compress = false;
+        else if (argument == "-v" || argument == "--verbose")
+            options.verbose = true;
+        else if (!argument.empty() && argument[0] != '-')
+            options.assetDirectories.push_back(argument);
+        else
+            return false;
+    }
+
+    if (options.database.empty())
+        options.database = options.output + ".db";
+    if (options.jobs == 0)
+        options.jobs = std::max(1u, std::thread::hardware_concurrency());
+    return !options.assetDirectories.empty();
+}
+
+// Find the assets in the asset directories
+std::vector<Asset> findAssets(const CookOptions& options)
+{
+    std::vector<Asset> assets;
+    const fs::path root { fs::absolute(options.root).lexically_normal() };
+    for (const std::string& directory : options.assetDirectories)
+    {
+        std::error_code error;
+        for (fs::recursive_directory_iterator it(directory, error), end; it != end; it.increment(error))
+        {
+            if (error)
+                break;
+            // Skip hidden files and directories
+            if (it->path().filename().string()[0] == '.')
+            {
+                if (it->is_directory())
+                    it.disable_recursion_pending();
+                continue;
+            }
+            if (!it->is_regular_file())
+                continue;
+
+            Asset asset;
+            asset.path = it->path().lexically_normal().generic_string();
+            asset.name = normalizeArchivePath(
+                fs::absolute(it->path()).lexically_normal().lexically_relative(root).generic_string());
+            asset.kind = getAssetKind(it->path());
+            asset.parametersHash = hashString(std::string(ASSET_KIND_NAMES[asset.kind]) + "/" +
+                                              std::to_string(COOKER_VERSION) + "/" +
+                                              std::to_string(COOKED_FORMAT_VERSION));
+            assets.push_back(asset);
+        }
+        if (error)
+            std::cout << "ERROR::ASSETCOOK::CANNOT_READ_DIRECTORY " << directory << ": "
+                      << error.message() << std::endl;
+    }
+
+    // Sort the assets by name, and remove the ones found in several directories
+    std::sort(assets.begin(), assets.end(),
+              [](const Asset& a, const Asset& b) { return a.name < b.name; });
+    assets.erase(std::unique(assets.begin(), assets.end(),
+                             [](const Asset& a, const Asset& b) { return a.name == b.name; }),
+                 assets.end());
+    return assets;
+}
+
+// Get the file of the cache where an asset is stored
+std::string getCacheFile(const std::string& cacheDirectory, const std::string& name)
+{
+    return cacheDirectory + "/" + toHex(hashArchivePath(name)) + ".bin";
+}
+
+int main(int argc, char* argv[])
+{
+    CookOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    const double startTime { getTime() };
+    const std::string cacheDirectory { options.output + ".cache" };
+
+    // Find the assets, and check which ones have to be cooked
+    std::vector<Asset> assets { findAssets(options) };
+    std::map<std::string, DatabaseEntry> database { loadDatabase(options.database) };
+
+    runParallel(assets.size(), options.jobs, [&](size_t i)
+    {
+        Asset& asset { assets[i] };
+        const auto record { database.find(asset.name) };
+        if (options.force)
+            asset.reason = "forced";
+        else if (record == database.end() || record->second.dependencies.empty())
+            asset.reason = "new asset";
+        else if (record->second.parametersHash != asset.parametersHash ||
+                 record->second.kind != asset.kind)
+            asset.reason = "cook parameters changed";
+        else if (!fs::exists(getCacheFile(cacheDirectory, asset.name)))
+            asset.reason = "cooked output missing";
+        else if (dependencyChanged(record->second.dependencies[0]))
+            asset.reason = "source changed";
+        else
+        {
+            for (size_t d = 1; d < record->second.dependencies.size() && asset.reason.empty(); ++d)
+            {
+                if (dependencyChanged(record->second.dependencies[d]))
+                    asset.reason = "dependency changed (" + record->second.dependencies[d].path + ")";
+            }
+        }
+    });
+
+    // Assets in the database that no longer exist
+    std::vector<std::string> removed;
+    std::set<std::string> names;
+    for (const Asset& asset : assets)
+        names.insert(asset.name);
+    for (const auto& entry : database)
+    {
+        if (names.count(entry.first) == 0)
+            removed.push_back(entry.first);
+    }
+
+    std::vector<Asset*> dirty;
+    for (Asset& asset : assets)
+    {
+        if (!asset.reason.empty())
+            dirty.push_back(&asset);
+    }
+    const double scanTime { getTime() - startTime };
+
+    // Report of the assets that need to be cooked
+    for (const Asset& asset : assets)
+    {
+        if (!asset.reason.empty() || options.verbose)
+            std::cout << (asset.reason.empty() ? "  up to date  " : "  cook        ")
+                      << std::left << std::setw(8) << ASSET_KIND_NAMES[asset.kind] << ' '
+                      << asset.name << (asset.reason.empty() ? "" : "  [" + asset.reason + "]") << '\n';
+    }
+    for (const std::string& name : removed)
+        std::cout << "  remove      " << name << '\n';
+
+    const bool archiveMissing { !fs::exists(options.output) };
+    const bool repack { !dirty.empty() || !removed.empty() || archiveMissing };
+    std::cout << assets.size() << " assets, " << dirty.size() << " to cook, "
+              << removed.size() << " removed, archive "
+              << (repack ? "will be rebuilt" : "is up to date") << " ("
+              << std::fixed << std::setprecision(3) << scanTime << " s to check).\n";
+
+    if (options.dryRun)
+        return 0;
+
+    // Cook the assets that changed
+    fs::create_directories(cacheDirectory);
+    const double cookStart { getTime() };
+    runParallel(dirty.size(), options.jobs, [&](size_t i)
+    {
+        Asset& asset { *dirty[i] };
+        cookAsset(asset, getCacheFile(cacheDirectory, asset.name));
+
+        std::lock_guard<std::mutex> lock { gOutputMutex };
+        if (asset.failed)
+            std::cout << "ERROR::ASSETCOOK::" << asset.name << ": " << asset.error << std::endl;
+        else if (options.verbose)
+            std::cout << "  cooked " << asset.name << " (" << asset.cookedSize << " bytes, "
+                      << std::setprecision(1) << asset.cookTime * 1000.0 << " ms)\n";
+    });
+    const double cookTime { getTime() - cookStart };
+
+    // Update the database. Assets that failed are removed, so they are cooked
+    // again in the next run
+    int nrFailed { 0 };
+    for (Asset* asset : dirty)
+    {
+        if (asset->failed)
+        {
+            database.erase(asset->name);
+            ++nrFailed;
+        }
+        else
+        {
+            database[asset->name] = asset->record;
+        }
+    }
+    for (const std::string& name : removed)
+    {
+        database.erase(name);
+        fs::remove(getCacheFile(cacheDirectory, name));
+    }
+    if (!saveDatabase(options.database, database))
+        std::cout << "ERROR::ASSETCOOK::CANNOT_WRITE_DATABASE " << options.database << std::endl;
+
+    // Pack the cooked assets in the archive
+    const double packStart { getTime() };
+    if (repack)
+    {
+        ArchiveWriter writer;
+        for (const Asset& asset : assets)
+        {
+            if (asset.failed)
+                continue;
+            if (!writer.addFileFromDisk(asset.name, getCacheFile(cacheDirectory, asset.name),
+                                        options.compress))
+                std::cout << "ERROR::ASSETCOOK::MISSING_COOKED_ASSET " << asset.name << std::endl;
+        }
+        if (!writer.write(options.output))
+        {
+            std::cout << "ERROR::ASSETCOOK::CANNOT_WRITE_ARCHIVE " << options.output << std::endl;
+            return 1;
+        }
+    }
+    const double packTime { getTime() - packStart };
+
+    // Summary, with the slowest assets
+    std::sort(dirty.begin(), dirty.end(),
+              [](const Asset* a, const Asset* b) { return a->cookTime > b->cookTime; });
+    double totalCookTime { 0.0 };
+    for (const Asset* asset : dirty)
+        totalCookTime += asset->cookTime;
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "Cooked " << dirty.size() - nrFailed << " assets (" << nrFailed << " failed) with "
+              << options.jobs << " threads.\n"
+              << "  check " << scanTime << " s, cook " << cookTime << " s (" << totalCookTime
+              << " s of work), pack " << packTime << " s, total " << getTime() - startTime << " s\n";
+    for (size_t i = 0; i < dirty.size() && i < 5; ++i)
+        std::cout << "  " << std::right << std::setw(8) << dirty[i]->cookTime * 1000.0 << " ms  " << dirty[i]->name << '\n';
+
+    return nrFailed == 0 ? 0 : 1;
+}
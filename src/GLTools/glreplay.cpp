@@ -0,0 +1,308 @@
+// Tool to replay a capture of the calls to OpenGL of GLBase::GLCapture, and
+// measure the time of its frames and passes without the application or its
+// assets.
+// The capture is made running any application with the environment variable
+// GLBASE_CAPTURE_GL set to the path of the file, and GLBASE_CAPTURE_GL_FRAMES
+// to the frames captured, as first:count.
+//
+// Usage:
+//      glreplay [options] <capture>
+//
+// Options:
+//      -l, --loops <n>             Times the frames are replayed and measured
+//                                  (default: 10)
+//      --warmup <n>                Times they are replayed before (default: 1)
+//      --passes <names>            Replay only the work of these passes,
+//                                  separated by commas
+//      --skip-passes <names>       Skip the work of these passes
+//      --windowed                  Replay in a window instead of offscreen
+//      -o, --output <path>         JSON file with the times of every frame
+//
+// The calls before the first frame, which create the objects and render the
+// contents that the frames reuse, are replayed once. Then the frames are
+// replayed as fast as possible. The work of the passes that are skipped is not
+// replayed, but their changes of the state are, so the other passes render the
+// same, and its time is only the one of those changes. The work outside the
+// passes is always replayed.
+// For each frame, the CPU time to submit its calls, the time of the whole
+// frame, waiting for the GPU, and the GPU time of the frame and its passes
+// are measured. The mean of each of them is printed.
+
+#include "GLBase.h"
+
+#include <chrono>
+#include <iomanip>
+
+using namespace GLBase;
+
+// Options of the replay
+struct ReplayOptions
+{
+    std::string capture;
+    unsigned int loops { 10 };
+    unsigned int warmupLoops { 1 };
+    std::vector<std::string> passes;
+    std::vector<std::string> skippedPasses;
+    bool headless { true };
+    std::string output;
+};
+
+// Times of a frame replayed
+struct FrameResult
+{
+    unsigned int loop;
+    unsigned int frame;
+    double cpuMs;
+    double frameMs;
+    // Negative if the profiler dropped the frame
+    double gpuMs;
+    unsigned int nrCalls;
+    unsigned int nrDraws;
+    std::vector<GPUProfileScopeTiming> passes;
+};
+
+// Print the usage of the tool
+static void printUsage()
+{
+    std::cout << "Usage: glreplay [-l loops] [--warmup loops] [--passes names] [--skip-passes names]\n"
+                 "                [--windowed] [-o output] <capture>\n";
+}
+
+// Split a list of names separated by commas
+static std::vector<std::string> splitNames(const std::string& list)
+{
+    std::vector<std::string> names;
+    std::stringstream stream(list);
+    std::string name;
+    while (std::getline(stream, name, ','))
+    {
+        if (!name.empty())
+            names.push_back(name);
+    }
+    return names;
+}
+
+// Parse the options. Returns false if they are not valid
+static bool parseOptions(int argc, char* argv[], ReplayOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg { argv[i] };
+        const bool hasValue { i + 1 < argc };
+        if ((arg == "-l" || arg == "--loops") && hasValue)
+            options.loops = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue)
+            options.warmupLoops = std::max(0, std::stoi(argv[++i]));
+        else if (arg == "--passes" && hasValue)
+            options.passes = splitNames(argv[++i]);
+        else if (arg == "--skip-passes" && hasValue)
+            options.skippedPasses = splitNames(argv[++i]);
+        else if (arg == "--windowed")
+            options.headless = false;
+        else if ((arg == "-o" || arg == "--output") && hasValue)
+            options.output = argv[++i];
+        else if (arg[0] != '-' && options.capture.empty())
+            options.capture = arg;
+        else
+            return false;
+    }
+    return !options.capture.empty();
+}
+
+// Mean of some values, skipping the negative ones, or -1 if there is none
+static double getMean(const std::vector<double>& values)
+{
+    double sum { 0. };
+    unsigned int count { 0 };
+    for (double value : values)
+    {
+        if (value < 0.)
+            continue;
+        sum += value;
+        ++count;
+    }
+    return count > 0 ? sum / count : -1.;
+}
+
+// Write a time, which is null if it is negative
+static void writeTime(std::ostream& out, double time)
+{
+    if (time < 0.)
+        out << "null";
+    else
+        out << time;
+}
+
+// Write a list of names as a JSON array
+static void writeNames(std::ostream& out, const std::vector<std::string>& names)
+{
+    out << '[';
+    for (size_t i = 0; i < names.size(); ++i)
+        out << (i == 0 ? "" : ",") << '"' << names[i] << '"';
+    out << ']';
+}
+
+// Write the results to a JSON file
+static bool writeResults(const ReplayOptions& options, const GLCaptureReplay& replay, bool headless,
+                         const std::vector<FrameResult>& results)
+{
+    std::ofstream out(options.output);
+    if (!out)
+    {
+        std::cout << "ERROR::GLREPLAY::FILE_NOT_WRITTEN: " << options.output << '\n';
+        return false;
+    }
+    out << std::fixed << std::setprecision(4);
+    out << "{\"capture\":\"" << options.capture << "\",\"capturedRenderer\":\"" << replay.getRenderer()
+        << "\",\"renderer\":\"" << (const char*)glGetString(GL_RENDERER) << "\",\"headless\":"
+        << (headless ? "true" : "false") << ",\"width\":" << replay.getWidth() << ",\"height\":"
+        << replay.getHeight() << ",\"passes\":";
+    writeNames(out, options.passes);
+    out << ",\"skippedPasses\":";
+    writeNames(out, options.skippedPasses);
+    out << ",\"frames\":[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const FrameResult& result { results[i] };
+        out << (i == 0 ? "" : ",\n") << "{\"loop\":" << result.loop << ",\"frame\":" << result.frame
+            << ",\"cpuMs\":" << result.cpuMs << ",\"frameMs\":" << result.frameMs << ",\"gpuMs\":";
+        writeTime(out, result.gpuMs);
+        out << ",\"calls\":" << result.nrCalls << ",\"draws\":" << result.nrDraws << ",\"passes\":[";
+        for (size_t pass = 0; pass < result.passes.size(); ++pass)
+        {
+            const GPUProfileScopeTiming& timing { result.passes[pass] };
+            out << (pass == 0 ? "" : ",") << "{\"name\":\"" << timing.name << "\",\"depth\":" << timing.depth
+                << ",\"gpuMs\":" << timing.gpuEndMs - timing.gpuStartMs << '}';
+        }
+        out << "]}";
+    }
+    out << "\n]}\n";
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    ReplayOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    GLCaptureReplay replay;
+    if (!replay.load(options.capture))
+        return 1;
+    if (replay.getNrFrames() == 0)
+    {
+        std::cout << "ERROR::GLREPLAY::NO_FRAMES: " << options.capture << '\n';
+        return 1;
+    }
+
+    Application application(replay.getWidth(), replay.getHeight(), "GL replay", options.headless);
+    // Do not wait for the vertical synchronization in the window
+    if (!application.isHeadless())
+        glfwSwapInterval(0);
+    replay.setEnabledPasses(options.passes);
+    replay.setSkippedPasses(options.skippedPasses);
+
+    std::cout << "Capture: " << options.capture << ", " << replay.getWidth() << "x" << replay.getHeight()
+              << ", " << replay.getNrFrames() << " frames, captured on " << replay.getRenderer() << '\n';
+
+    // Create the objects, and wait for them before measuring
+    replay.playSetup();
+    glFinish();
+
+    // The ring of the profiler is deep, so it does not drop frames when the
+    // GPU falls behind
+    const unsigned int nrFrames { (options.warmupLoops + options.loops) * replay.getNrFrames() };
+    GPUProfiler profiler(8, nrFrames + 1);
+    replay.setGPUProfiler(&profiler);
+
+    std::vector<FrameResult> results;
+    results.reserve(options.loops * replay.getNrFrames());
+    for (unsigned int frame = 0; frame < nrFrames; ++frame)
+    {
+        const auto start { std::chrono::steady_clock::now() };
+        profiler.beginFrame();
+        replay.playFrame();
+        profiler.endFrame();
+        const auto submitted { std::chrono::steady_clock::now() };
+        application.updateWindow();
+        const auto end { std::chrono::steady_clock::now() };
+
+        const unsigned int loop { frame / replay.getNrFrames() };
+        if (loop < options.warmupLoops)
+            continue;
+        FrameResult result;
+        result.loop = loop - options.warmupLoops;
+        result.frame = frame % replay.getNrFrames();
+        result.cpuMs = std::chrono::duration<double, std::milli>(submitted - start).count();
+        result.frameMs = std::chrono::duration<double, std::milli>(end - start).count();
+        result.gpuMs = -1.;
+        result.nrCalls = replay.getNrCalls();
+        result.nrDraws = replay.getNrDraws();
+        results.push_back(result);
+    }
+
+    // Wait for the GPU, and read the frames still in flight starting an empty
+    // one. The frames of the profiler are numbered from the first one
+    glFinish();
+    profiler.beginFrame();
+    profiler.endFrame();
+    const unsigned int firstMeasured { options.warmupLoops * replay.getNrFrames() };
+    for (const GPUProfileFrame& frame : profiler.getHistory())
+    {
+        if (frame.index < firstMeasured || frame.index >= nrFrames)
+            continue;
+        FrameResult& result { results[frame.index - firstMeasured] };
+        result.gpuMs = frame.gpuEndMs - frame.gpuStartMs;
+        result.passes = frame.scopes;
+    }
+    if (profiler.getNrDroppedFrames() > 0)
+        std::cout << "The GPU times of " << profiler.getNrDroppedFrames() << " frames were dropped\n";
+    replay.setGPUProfiler(nullptr);
+
+    // Means of the frames, and of the passes by name
+    std::vector<double> cpuTimes;
+    std::vector<double> frameTimes;
+    std::vector<double> gpuTimes;
+    std::map<std::string, std::vector<double>> passTimes;
+    std::map<std::string, unsigned int> passDepths;
+    for (const FrameResult& result : results)
+    {
+        cpuTimes.push_back(result.cpuMs);
+        frameTimes.push_back(result.frameMs);
+        gpuTimes.push_back(result.gpuMs);
+        for (const GPUProfileScopeTiming& timing : result.passes)
+        {
+            passTimes[timing.name].push_back(timing.gpuEndMs - timing.gpuStartMs);
+            passDepths[timing.name] = timing.depth;
+        }
+    }
+
+    std::cout << "Replayed " << options.loops << " times" << (application.isHeadless() ? ", headless" : ", windowed")
+              << ", on " << (const char*)glGetString(GL_RENDERER) << "\n\n"
+              << std::fixed << std::setprecision(3)
+              << std::left << std::setw(28) << "frame" << std::right << std::setw(12) << "CPU ms"
+              << std::setw(12) << "frame ms" << std::setw(12) << "GPU ms" << '\n'
+              << std::left << std::setw(28) << "all" << std::right << std::setw(12) << getMean(cpuTimes)
+              << std::setw(12) << getMean(frameTimes) << std::setw(12) << getMean(gpuTimes) << "\n\n"
+              << std::left << std::setw(28) << "pass" << std::right << std::setw(12) << "GPU ms" << '\n';
+    for (const std::string& name : replay.getPassNames())
+    {
+        if (passTimes.count(name) == 0)
+            continue;
+        const std::string label { std::string(2 * passDepths[name], ' ') + name };
+        const bool skipped { std::find(options.skippedPasses.begin(), options.skippedPasses.end(), name) !=
+                                 options.skippedPasses.end() ||
+                             (!options.passes.empty() && passDepths[name] == 0 &&
+                              std::find(options.passes.begin(), options.passes.end(), name) == options.passes.end()) };
+        std::cout << std::left << std::setw(28) << label << std::right << std::setw(12) << getMean(passTimes[name])
+                  << (skipped ? "  (skipped)" : "") << '\n';
+    }
+
+    if (!options.output.empty() && writeResults(options, replay, application.isHeadless(), results))
+        std::cout << "\nResults written to " << options.output << '\n';
+
+    return 0;
+}